@@ -0,0 +1,462 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BARCODE.c
+Purpose : Assembles the characters typed by a barcode scanner into
+          complete scans and passes them to a consumer task.
+
+Additional information:
+  Barcode scanners in keyboard mode type the content of a code and
+  usually end it with Enter. Scanners without an Enter suffix are
+  handled with a timeout: a scan ends when no character has been
+  received for BARCODE_CONFIG.Timeout ms. The producer (MainTask of
+  the sample) calls
+
+    BARCODE_AddChar(&Asm, c);              // For every character.
+    BARCODE_Poll(&Asm);                    // After waiting at most BARCODE_GetTimeout() ms.
+
+  The characters are stored in chunks of BARCODE_CHUNK_SIZE bytes
+  taken from a common pool, so a 2 KB PDF417 or DataMatrix code does
+  not need a 2 KB buffer per scanner. A complete scan is passed to the
+  consumer as a BARCODE_SCAN which refers to the chunks, the data is
+  not copied. The consumer task calls
+
+    BARCODE_WaitScan(&Scan);
+    p = BARCODE_GetData(&Scan, Off, &NumBytes);   // Contiguous part at Off.
+    ...
+    BARCODE_FreeScan(&Scan);
+
+  Scans which do not fit into the pool or the queue are dropped and
+  counted, see BARCODE_GetStat().
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <string.h>
+#include "RTOS.h"
+#include "SEGGER.h"
+#include "BARCODE.h"
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static BARCODE_CHUNK   _aChunk[BARCODE_NUM_CHUNKS];
+static BARCODE_CHUNK * _pFreeChunk;
+static U32             _NumChunksUsed;
+static OS_MAILBOX      _ScanMailbox;
+static BARCODE_SCAN    _aScan[BARCODE_MAX_SCANS];
+static BARCODE_STAT    _Stat;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _AllocChunk
+*
+*  Function description
+*    Takes a chunk from the pool.
+*
+*  Return value
+*    Chunk or NULL if all chunks are in use.
+*/
+static BARCODE_CHUNK * _AllocChunk(void) {
+  BARCODE_CHUNK * pChunk;
+
+  OS_EnterRegion();                     // The pool is shared by the producer and the consumer task.
+  pChunk = _pFreeChunk;
+  if (pChunk != NULL) {
+    _pFreeChunk = pChunk->pNext;
+    _NumChunksUsed++;
+    if (_NumChunksUsed > _Stat.MaxChunksUsed) {
+      _Stat.MaxChunksUsed = _NumChunksUsed;
+    }
+  }
+  OS_LeaveRegion();
+  if (pChunk != NULL) {
+    pChunk->pNext = NULL;
+  }
+  return pChunk;
+}
+
+/*********************************************************************
+*
+*       _FreeChunks
+*
+*  Function description
+*    Returns a list of chunks to the pool.
+*/
+static void _FreeChunks(BARCODE_CHUNK * pFirst) {
+  BARCODE_CHUNK * pLast;
+  U32             NumChunks;
+
+  if (pFirst == NULL) {
+    return;
+  }
+  NumChunks = 1;
+  pLast     = pFirst;
+  while (pLast->pNext != NULL) {
+    pLast = pLast->pNext;
+    NumChunks++;
+  }
+  OS_EnterRegion();
+  pLast->pNext    = _pFreeChunk;
+  _pFreeChunk     = pFirst;
+  _NumChunksUsed -= NumChunks;
+  OS_LeaveRegion();
+}
+
+/*********************************************************************
+*
+*       _Reset
+*
+*  Function description
+*    Prepares an assembly for the next scan. The chunks have been
+*    passed on or freed.
+*/
+static void _Reset(BARCODE_ASM * pAsm) {
+  pAsm->pFirst     = NULL;
+  pAsm->pLast      = NULL;
+  pAsm->NumBytes   = 0;
+  pAsm->NumChunks  = 0;
+  pAsm->IsOverflow = 0;
+}
+
+/*********************************************************************
+*
+*       _RemoveChar
+*
+*  Function description
+*    Removes the last character (backspace on a keyboard).
+*/
+static void _RemoveChar(BARCODE_ASM * pAsm) {
+  BARCODE_CHUNK * pChunk;
+
+  if (pAsm->NumBytes == 0u) {
+    return;
+  }
+  pAsm->NumBytes--;
+  if (pAsm->NumBytes == (pAsm->NumChunks - 1u) * BARCODE_CHUNK_SIZE) {
+    //
+    // Last chunk is empty now, return it.
+    //
+    if (pAsm->NumChunks == 1u) {
+      _FreeChunks(pAsm->pFirst);
+      _Reset(pAsm);
+      return;
+    }
+    pChunk = pAsm->pFirst;
+    while (pChunk->pNext != pAsm->pLast) {
+      pChunk = pChunk->pNext;
+    }
+    pChunk->pNext = NULL;
+    _FreeChunks(pAsm->pLast);
+    pAsm->pLast = pChunk;
+    pAsm->NumChunks--;
+  }
+}
+
+/*********************************************************************
+*
+*       _IsEqual
+*
+*  Function description
+*    Checks whether the scan contains a string at an offset.
+*/
+static int _IsEqual(const BARCODE_SCAN * pScan, U32 Off, const char * s, unsigned Len) {
+  const U8 * pData;
+  unsigned   NumBytes;
+
+  while (Len > 0u) {
+    pData = BARCODE_GetData(pScan, Off, &NumBytes);
+    if (NumBytes > Len) {
+      NumBytes = Len;
+    }
+    if (memcmp(pData, s, NumBytes) != 0) {
+      return 0;
+    }
+    s   += NumBytes;
+    Off += NumBytes;
+    Len -= NumBytes;
+  }
+  return 1;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       BARCODE_Init
+*
+*  Function description
+*    Initializes the chunk pool and the scan queue.
+*    Has to be called once before any other function.
+*/
+void BARCODE_Init(void) {
+  unsigned i;
+
+  for (i = 0; i < BARCODE_NUM_CHUNKS - 1u; i++) {
+    _aChunk[i].pNext = &_aChunk[i + 1u];
+  }
+  _aChunk[BARCODE_NUM_CHUNKS - 1u].pNext = NULL;
+  _pFreeChunk    = &_aChunk[0];
+  _NumChunksUsed = 0;
+  memset(&_Stat, 0, sizeof(_Stat));
+  OS_MAILBOX_Create(&_ScanMailbox, sizeof(BARCODE_SCAN), BARCODE_MAX_SCANS, _aScan);
+}
+
+/*********************************************************************
+*
+*       BARCODE_Create
+*
+*  Function description
+*    Initializes the assembly for one scanner.
+*
+*  Parameters
+*    pAsm    : Assembly to initialize.
+*    pConfig : Configuration, has to remain valid.
+*    Id      : Passed on with each scan, for example the interface ID of the scanner.
+*/
+void BARCODE_Create(BARCODE_ASM * pAsm, const BARCODE_CONFIG * pConfig, U32 Id) {
+  memset(pAsm, 0, sizeof(*pAsm));
+  pAsm->pConfig = pConfig;
+  pAsm->Id      = Id;
+}
+
+/*********************************************************************
+*
+*       BARCODE_AddChar
+*
+*  Function description
+*    Adds a character to the scan in assembly.
+*    CR and LF end the scan, backspace removes the last character.
+*/
+void BARCODE_AddChar(BARCODE_ASM * pAsm, char c) {
+  BARCODE_CHUNK * pChunk;
+
+  pAsm->LastTime = OS_GetTime32();
+  if ((c == '\r') || (c == '\n')) {
+    BARCODE_End(pAsm);
+    return;
+  }
+  if (c == '\b') {
+    _RemoveChar(pAsm);
+    return;
+  }
+  if (pAsm->IsOverflow) {
+    return;
+  }
+  if (pAsm->NumBytes == pAsm->NumChunks * BARCODE_CHUNK_SIZE) {
+    pChunk = _AllocChunk();
+    if (pChunk == NULL) {
+      pAsm->IsOverflow = 1;
+      return;
+    }
+    if (pAsm->pLast != NULL) {
+      pAsm->pLast->pNext = pChunk;
+    } else {
+      pAsm->pFirst = pChunk;
+    }
+    pAsm->pLast = pChunk;
+    pAsm->NumChunks++;
+  }
+  pAsm->pLast->abData[pAsm->NumBytes - (pAsm->NumChunks - 1u) * BARCODE_CHUNK_SIZE] = (U8)c;
+  pAsm->NumBytes++;
+}
+
+/*********************************************************************
+*
+*       BARCODE_End
+*
+*  Function description
+*    Ends the scan in assembly, removes prefix and suffix and passes
+*    it to the consumer. Empty scans are ignored.
+*/
+void BARCODE_End(BARCODE_ASM * pAsm) {
+  BARCODE_SCAN Scan;
+  unsigned     Len;
+
+  if (pAsm->IsOverflow) {
+    _Stat.NumOverflows++;
+    _FreeChunks(pAsm->pFirst);
+    _Reset(pAsm);
+    return;
+  }
+  if (pAsm->NumBytes == 0u) {
+    return;
+  }
+  Scan.pFirst   = pAsm->pFirst;
+  Scan.Off      = 0;
+  Scan.NumBytes = pAsm->NumBytes;
+  Scan.Time     = pAsm->LastTime;
+  Scan.Id       = pAsm->Id;
+  if (pAsm->pConfig->sPrefix != NULL) {
+    Len = strlen(pAsm->pConfig->sPrefix);
+    if ((Len <= Scan.NumBytes) && _IsEqual(&Scan, 0, pAsm->pConfig->sPrefix, Len)) {
+      Scan.Off       = Len;
+      Scan.NumBytes -= Len;
+    }
+  }
+  if (pAsm->pConfig->sSuffix != NULL) {
+    Len = strlen(pAsm->pConfig->sSuffix);
+    if ((Len <= Scan.NumBytes) && _IsEqual(&Scan, Scan.NumBytes - Len, pAsm->pConfig->sSuffix, Len)) {
+      Scan.NumBytes -= Len;
+    }
+  }
+  _Reset(pAsm);
+  if (OS_MAILBOX_Put(&_ScanMailbox, &Scan) != 0) {
+    _Stat.NumDropped++;
+    _FreeChunks(Scan.pFirst);
+    return;
+  }
+  _Stat.NumScans++;
+}
+
+/*********************************************************************
+*
+*       BARCODE_Discard
+*
+*  Function description
+*    Discards the scan in assembly, for example because the scanner
+*    has been removed, and returns its chunks to the pool.
+*/
+void BARCODE_Discard(BARCODE_ASM * pAsm) {
+  _FreeChunks(pAsm->pFirst);
+  _Reset(pAsm);
+}
+
+/*********************************************************************
+*
+*       BARCODE_GetTimeout
+*
+*  Function description
+*    Returns the time until the scan in assembly ends by timeout.
+*
+*  Return value
+*    >= 0: Time in ms, call BARCODE_Poll() after it.
+*    <  0: No scan in assembly or no timeout configured.
+*/
+I32 BARCODE_GetTimeout(const BARCODE_ASM * pAsm) {
+  U32 t;
+
+  if ((pAsm->pConfig->Timeout == 0u) || ((pAsm->NumBytes == 0u) && (pAsm->IsOverflow == 0u))) {
+    return -1;
+  }
+  t = OS_GetTime32() - pAsm->LastTime;
+  return (t >= pAsm->pConfig->Timeout) ? 0 : (I32)(pAsm->pConfig->Timeout - t);
+}
+
+/*********************************************************************
+*
+*       BARCODE_Poll
+*
+*  Function description
+*    Ends the scan in assembly if its timeout has expired.
+*/
+void BARCODE_Poll(BARCODE_ASM * pAsm) {
+  if (BARCODE_GetTimeout(pAsm) == 0) {
+    BARCODE_End(pAsm);
+  }
+}
+
+/*********************************************************************
+*
+*       BARCODE_GetScan
+*
+*  Function description
+*    Takes the oldest complete scan, never blocks.
+*
+*  Return value
+*    1: Scan taken.
+*    0: No scan queued.
+*/
+int BARCODE_GetScan(BARCODE_SCAN * pScan) {
+  return (OS_MAILBOX_Get(&_ScanMailbox, pScan) == 0) ? 1 : 0;
+}
+
+/*********************************************************************
+*
+*       BARCODE_WaitScan
+*
+*  Function description
+*    Takes the oldest complete scan, waits for one if none is queued.
+*/
+void BARCODE_WaitScan(BARCODE_SCAN * pScan) {
+  OS_MAILBOX_GetBlocked(&_ScanMailbox, pScan);
+}
+
+/*********************************************************************
+*
+*       BARCODE_GetData
+*
+*  Function description
+*    Returns the contiguous part of a scan at an offset.
+*
+*  Parameters
+*    pScan     : Scan.
+*    Off       : Offset in the scan, 0 is the first byte behind the prefix.
+*    pNumBytes : Receives the number of bytes which can be read at the
+*                returned address, 0 at the end of the scan.
+*/
+const U8 * BARCODE_GetData(const BARCODE_SCAN * pScan, U32 Off, unsigned * pNumBytes) {
+  const BARCODE_CHUNK * pChunk;
+  U32                   NumBytes;
+
+  if (Off >= pScan->NumBytes) {
+    *pNumBytes = 0;
+    return NULL;
+  }
+  NumBytes = pScan->NumBytes - Off;
+  Off     += pScan->Off;
+  pChunk   = pScan->pFirst;
+  while (Off >= BARCODE_CHUNK_SIZE) {
+    pChunk = pChunk->pNext;
+    Off   -= BARCODE_CHUNK_SIZE;
+  }
+  if (NumBytes > BARCODE_CHUNK_SIZE - Off) {
+    NumBytes = BARCODE_CHUNK_SIZE - Off;
+  }
+  *pNumBytes = NumBytes;
+  return &pChunk->abData[Off];
+}
+
+/*********************************************************************
+*
+*       BARCODE_FreeScan
+*
+*  Function description
+*    Returns the chunks of a scan to the pool.
+*/
+void BARCODE_FreeScan(BARCODE_SCAN * pScan) {
+  _FreeChunks(pScan->pFirst);
+  pScan->pFirst = NULL;
+}
+
+/*********************************************************************
+*
+*       BARCODE_GetStat
+*
+*  Function description
+*    Returns the counters of the scan assembly.
+*/
+void BARCODE_GetStat(BARCODE_STAT * pStat) {
+  *pStat = _Stat;
+}
+
+/*************************** End of file ****************************/
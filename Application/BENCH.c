@@ -0,0 +1,369 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BENCH.c
+Purpose : Micro benchmark runner for hot paths of the application,
+          the RTT terminal and the emUSB-Host log output.
+          Each case is timed with the embOS cycle counter and
+          reported as ns/op and bytes/s via USBH_Logf_Application().
+
+Additional information:
+  Enable with USE_BENCH=1 in the preprocessor definitions of the
+  project. The sample applications then call BENCH_RunCommon() and
+  their own cases from MainTask before emUSB-Host is started.
+  Task switches are suppressed while a case is measured,
+  interrupts stay enabled.
+
+  Sample output:
+    0:012 MainTask - BENCH SEGGER_RTT_WriteNoLock 16B: 412 ns/op, 38834951 bytes/s, 10000 ops
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include "RTOS.h"
+#include "USBH.h"
+#include "SEGGER.h"
+#include "SEGGER_RTT.h"
+#include "BENCH.h"
+#include "BINLOG.h"
+#include "HID_PLAN.h"
+
+/*********************************************************************
+*
+*       Defines configurable
+*
+**********************************************************************
+*/
+#define BENCH_RTT_BUFFER_SIZE   1024
+#define BENCH_NUM_OPS_LOG       100u    // USBH_Logf_Application() outputs to the terminal, keep the number of lines low.
+#define BENCH_RECORD_SIZE       16u     // Size of the binary trace record used by the reserve/commit cases.
+#define BENCH_HID_REPORT_SIZE   64u     // Size of the HID report used by the decode cases.
+#define BENCH_HID_NUM_FIELDS    24u
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static char _acRTTBuffer[BENCH_RTT_BUFFER_SIZE];
+static const char _acMsg[64] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcde";
+static char _acFormatBuffer[64];
+static U8   _abHIDReport[BENCH_HID_REPORT_SIZE];
+static USBH_HID_GENERIC_DATA _aHIDField[BENCH_HID_NUM_FIELDS];
+static HID_PLAN _HIDPlan;
+static I32  _aHIDValue[BENCH_HID_NUM_FIELDS];
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _DrainRTT
+*
+*  Function description
+*    Simulates a debug probe which has read all data of the
+*    benchmark channel so each operation sees the same free space.
+*/
+static void _DrainRTT(void) {
+  _SEGGER_RTT.aUp[BENCH_RTT_CHANNEL].RdOff = _SEGGER_RTT.aUp[BENCH_RTT_CHANNEL].WrOff;
+}
+
+/*********************************************************************
+*
+*       _OpRTTWriteNoLock
+*/
+static void _OpRTTWriteNoLock(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(Index);
+  SEGGER_RTT_WriteNoLock(BENCH_RTT_CHANNEL, _acMsg, (unsigned)(SEGGER_PTR2ADDR(pContext)));
+  _DrainRTT();
+}
+
+/*********************************************************************
+*
+*       _OpRTTWrite
+*/
+static void _OpRTTWrite(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(Index);
+  SEGGER_RTT_Write(BENCH_RTT_CHANNEL, _acMsg, (unsigned)(SEGGER_PTR2ADDR(pContext)));
+  _DrainRTT();
+}
+
+/*********************************************************************
+*
+*       _OpRTTWriteMP
+*/
+static void _OpRTTWriteMP(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(Index);
+  SEGGER_RTT_WriteMP(BENCH_RTT_CHANNEL, _acMsg, (unsigned)(SEGGER_PTR2ADDR(pContext)));
+  _DrainRTT();
+}
+
+/*********************************************************************
+*
+*       _EncodeRecord
+*
+*  Function description
+*    Encodes bytes [Off, Off + NumBytes) of a binary trace record,
+*    as a URB or HID event tracer would do.
+*/
+static void _EncodeRecord(char * pDest, unsigned Off, unsigned NumBytes, unsigned Index) {
+  while (NumBytes--) {
+    *pDest++ = (char)((Off < 4u) ? (Index >> (8u * Off)) : Off);
+    Off++;
+  }
+}
+
+/*********************************************************************
+*
+*       _OpRTTEncodeWrite
+*
+*  Function description
+*    Encodes a record into a local buffer and copies it with SEGGER_RTT_Write().
+*/
+static void _OpRTTEncodeWrite(void * pContext, unsigned Index) {
+  char acRecord[BENCH_RECORD_SIZE];
+
+  SEGGER_USE_PARA(pContext);
+  _EncodeRecord(acRecord, 0, BENCH_RECORD_SIZE, Index);
+  SEGGER_RTT_Write(BENCH_RTT_CHANNEL, acRecord, BENCH_RECORD_SIZE);
+  _DrainRTT();
+}
+
+/*********************************************************************
+*
+*       _OpRTTReserveCommit
+*
+*  Function description
+*    Encodes a record directly into the RTT buffer.
+*/
+static void _OpRTTReserveCommit(void * pContext, unsigned Index) {
+  SEGGER_RTT_RESERVATION Res;
+  unsigned               NumBytes;
+
+  SEGGER_USE_PARA(pContext);
+  SEGGER_RTT_LOCK();
+  NumBytes = SEGGER_RTT_ReserveNoLock(BENCH_RTT_CHANNEL, BENCH_RECORD_SIZE, &Res);
+  if (NumBytes == BENCH_RECORD_SIZE) {
+    _EncodeRecord(Res.pData0, 0, Res.NumBytes0, Index);
+    _EncodeRecord(Res.pData1, Res.NumBytes0, Res.NumBytes1, Index);
+    SEGGER_RTT_CommitNoLock(BENCH_RTT_CHANNEL, NumBytes);
+  }
+  SEGGER_RTT_UNLOCK();
+  _DrainRTT();
+}
+
+/*********************************************************************
+*
+*       _OpSnprintf
+*/
+static void _OpSnprintf(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(pContext);
+  SEGGER_snprintf(_acFormatBuffer, sizeof(_acFormatBuffer), "**** receive KB  code [%d] Value=[%d] InterfaceID[%d]", Index & 0xFFu, Index & 1u, 1);
+}
+
+/*********************************************************************
+*
+*       _OpLogf
+*/
+static void _OpLogf(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(pContext);
+  USBH_Logf_Application("BENCH code [%d] Value=[%d] InterfaceID[%d]", Index & 0xFFu, Index & 1u, 1);
+}
+
+/*********************************************************************
+*
+*       _OpBinLog
+*/
+static void _OpBinLog(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(pContext);
+  BINLOG_LOG(BINLOG_ID_KEYBOARD_RECEIVE, Index & 0xFFu, Index & 1u, 1);
+}
+
+/*********************************************************************
+*
+*       _InitHIDReport
+*
+*  Function description
+*    Sets up the layout of a 64-byte report as sent by a game controller
+*    or a sensor: buttons, 8- and 16-bit axes and fields not aligned
+*    to bytes, and compiles the plan for it.
+*/
+static void _InitHIDReport(void) {
+  static const U8 _aNumBits[] = { 1, 1, 1, 1, 4, 8, 8, 16, 16, 16, 12, 12, 10, 6, 16, 16, 32, 3, 5, 8, 16, 16, 24, 32 };
+  unsigned BitPos;
+  unsigned i;
+
+  BitPos = 0;
+  for (i = 0; i < BENCH_HID_NUM_FIELDS; i++) {
+    _aHIDField[i].Usage       = 0x00010030u + i;
+    _aHIDField[i].NumBits     = _aNumBits[i];
+    _aHIDField[i].BitPosStart = (U16)BitPos;
+    _aHIDField[i].Signed      = (U8)(i & 1u);
+    BitPos += _aNumBits[i];
+  }
+  for (i = 0; i < BENCH_HID_REPORT_SIZE; i++) {
+    _abHIDReport[i] = (U8)(i * 0x35u + 7u);
+  }
+  (void)HID_PLAN_Compile(&_HIDPlan, _aHIDField, BENCH_HID_NUM_FIELDS);
+}
+
+/*********************************************************************
+*
+*       _OpHIDExtract
+*
+*  Function description
+*    Extracts each field of the report bit by bit.
+*/
+static void _OpHIDExtract(void * pContext, unsigned Index) {
+  const USBH_HID_GENERIC_DATA * pField;
+  unsigned                      BitPos;
+  unsigned                      i;
+  unsigned                      j;
+  U32                           v;
+
+  SEGGER_USE_PARA(pContext);
+  _abHIDReport[0] = (U8)Index;
+  pField = _aHIDField;
+  for (i = 0; i < BENCH_HID_NUM_FIELDS; i++) {
+    v = 0;
+    for (j = 0; j < pField->NumBits; j++) {
+      BitPos = pField->BitPosStart + j;
+      v     |= (U32)((_abHIDReport[BitPos >> 3] >> (BitPos & 7u)) & 1u) << j;
+    }
+    if (pField->Signed && (pField->NumBits < 32u) && (v & (1uL << (pField->NumBits - 1u)))) {
+      v |= 0xFFFFFFFFuL << pField->NumBits;
+    }
+    _aHIDValue[i] = (I32)v;
+    pField++;
+  }
+}
+
+/*********************************************************************
+*
+*       _OpHIDPlanDecode
+*/
+static void _OpHIDPlanDecode(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(pContext);
+  _abHIDReport[0] = (U8)Index;
+  (void)HID_PLAN_Decode(&_HIDPlan, _abHIDReport, BENCH_HID_REPORT_SIZE, _aHIDValue);
+}
+
+/*********************************************************************
+*
+*       _aCommonCase
+*/
+static const BENCH_CASE _aCommonCase[] = {
+  { "SEGGER_RTT_WriteNoLock 16B",  _OpRTTWriteNoLock,   SEGGER_ADDR2PTR(void, 16),                16, 0 },
+  { "SEGGER_RTT_WriteNoLock 63B",  _OpRTTWriteNoLock,   SEGGER_ADDR2PTR(void, 63),                63, 0 },
+  { "SEGGER_RTT_Write 16B",        _OpRTTWrite,         SEGGER_ADDR2PTR(void, 16),                16, 0 },
+  { "SEGGER_RTT_Write 63B",        _OpRTTWrite,         SEGGER_ADDR2PTR(void, 63),                63, 0 },
+  { "Encode+SEGGER_RTT_Write 16B", _OpRTTEncodeWrite,   NULL,                      BENCH_RECORD_SIZE, 0 },
+  { "Encode+Reserve/Commit 16B",   _OpRTTReserveCommit, NULL,                      BENCH_RECORD_SIZE, 0 },
+  { "SEGGER_snprintf",             _OpSnprintf,         NULL,                                      0, 0 },
+  { "USBH_Logf_Application",       _OpLogf,             NULL,                                      0, BENCH_NUM_OPS_LOG },
+  { "BINLOG_LOG 3 args",           _OpBinLog,           NULL,                                      0, BENCH_NUM_OPS_LOG },
+  { "HID bit extract 64B",         _OpHIDExtract,       NULL,                  BENCH_HID_REPORT_SIZE, 0 },
+  { "HID_PLAN_Decode 64B",         _OpHIDPlanDecode,    NULL,                  BENCH_HID_REPORT_SIZE, 0 },
+};
+
+/*********************************************************************
+*
+*       _aMPCase
+*
+*  Function description
+*    Cases measured with the RTT channel in multi-producer mode.
+*/
+static const BENCH_CASE _aMPCase[] = {
+  { "SEGGER_RTT_WriteMP 16B",      _OpRTTWriteMP,       SEGGER_ADDR2PTR(void, 16),                16, 0 },
+  { "SEGGER_RTT_WriteMP 63B",      _OpRTTWriteMP,       SEGGER_ADDR2PTR(void, 63),                63, 0 },
+};
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       BENCH_Run
+*
+*  Function description
+*    Measures one benchmark case.
+*
+*  Parameters
+*    pCase   : Case to measure.
+*    pResult : Receives the result. May be NULL, the result is always logged.
+*/
+void BENCH_Run(const BENCH_CASE * pCase, BENCH_RESULT * pResult) {
+  BENCH_RESULT Result;
+  U32          NumOps;
+  U32          t;
+  U32          i;
+  U64          v;
+
+  NumOps = pCase->NumOps ? pCase->NumOps : BENCH_NUM_OPS;
+  OS_EnterRegion();
+  t = OS_GetTime_Cycles();
+  for (i = 0; i < NumOps; i++) {
+    pCase->pfOp(pCase->pContext, i);
+  }
+  t = OS_GetTime_Cycles() - t;
+  OS_LeaveRegion();
+  Result.NumOps       = NumOps;
+  Result.TotalTime_us = OS_ConvertCycles2us(t);
+  if (Result.TotalTime_us == 0u) {
+    Result.TotalTime_us = 1u;                  // Below timer resolution, avoid division by zero.
+  }
+  Result.Time_ns      = (U32)(((U64)Result.TotalTime_us * 1000u) / NumOps);
+  v                   = (U64)pCase->NumBytesPerOp * NumOps * 1000000u;
+  Result.BytesPerSec  = (U32)(v / Result.TotalTime_us);
+  USBH_Logf_Application("BENCH %s: %u ns/op, %u bytes/s, %u ops", pCase->sName, Result.Time_ns, Result.BytesPerSec, Result.NumOps);
+  if (pResult) {
+    *pResult = Result;
+  }
+}
+
+/*********************************************************************
+*
+*       BENCH_RunList
+*
+*  Function description
+*    Measures an array of benchmark cases.
+*/
+void BENCH_RunList(const BENCH_CASE * paCase, unsigned NumCases) {
+  unsigned i;
+
+  for (i = 0; i < NumCases; i++) {
+    BENCH_Run(&paCase[i], NULL);
+  }
+}
+
+/*********************************************************************
+*
+*       BENCH_RunCommon
+*
+*  Function description
+*    Measures the cases which are shared by all sample applications:
+*    RTT terminal output (locked and multi-producer), SEGGER_snprintf()
+*    USBH_Logf_Application() and the decoding of HID reports.
+*/
+void BENCH_RunCommon(void) {
+  _InitHIDReport();
+  SEGGER_RTT_ConfigUpBuffer(BENCH_RTT_CHANNEL, "Bench", &_acRTTBuffer[0], sizeof(_acRTTBuffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+  BENCH_RunList(_aCommonCase, SEGGER_COUNTOF(_aCommonCase));
+  SEGGER_RTT_SetFlagsUpBuffer(BENCH_RTT_CHANNEL, SEGGER_RTT_MODE_MULTI_PRODUCER);
+  BENCH_RunList(_aMPCase, SEGGER_COUNTOF(_aMPCase));
+}
+
+/*************************** End of file ****************************/
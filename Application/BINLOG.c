@@ -0,0 +1,234 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BINLOG.c
+Purpose : Binary log output via a dedicated RTT channel.
+          Application messages are sent as format ID plus raw
+          arguments, formatting is deferred to the host.
+
+Additional information:
+  Enable with USE_BINLOG=1 in the preprocessor definitions of the
+  project. USBH_Log() and USBH_Warn() in USBH_ConfigIO.c then send the
+  messages of emUSB-Host as text records without time-stamp and task
+  name formatting, and BINLOG_LOG() sends application messages as
+  ID plus arguments. All records go to RTT channel BINLOG_RTT_CHANNEL
+  ("BinLog") in multi-producer mode, so no lock is taken.
+  The record layout is described in BINLOG.h, the host rebuilds the
+  text of application messages from BINLOG_Formats.h.
+
+  emUSB-Host applies its log and warn filters before calling USBH_Log()
+  and USBH_Warn(). BINLOG_LOG() uses the same log filter, set with
+  USBH_SetLogFilter() or USBH_AddLogFilter(): emUSB-Host has no function
+  to read it back, so BINLOG_LogArgs() passes a probe message to
+  USBH_Logf_Application(), which reaches BINLOG_WriteText() only if
+  USBH_MTYPE_APPLICATION passes the filter.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <string.h>
+#include "RTOS.h"
+#include "USBH.h"
+#include "SEGGER.h"
+#include "SEGGER_RTT.h"
+#include "BINLOG.h"
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define HEADER_SIZE             8u
+#define MAX_TEXT_LEN            255u
+#define PROBE_CHAR              '\x01'   // Probe message of _IsAppLogEnabled(), never sent.
+
+#if (USE_BINLOG == 0) && (BINLOG_MAX_ARGS > 6)
+  #error BINLOG_MAX_ARGS > 6 is not supported without USE_BINLOG, extend BINLOG_LogArgs()
+#endif
+
+/*********************************************************************
+*
+*       Static const data
+*
+**********************************************************************
+*/
+#if (USE_BINLOG == 0)
+#define BINLOG_FORMAT(Id, sFormat)  sFormat,
+static const char * const _asFormat[BINLOG_NUM_FORMATS] = {
+  #include "BINLOG_Formats.h"
+};
+#undef BINLOG_FORMAT
+#endif
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+#if USE_BINLOG
+static char         _acBuffer[BINLOG_BUFFER_SIZE];
+static char         _IsInited;
+static volatile U32 _NumProbes;
+#endif
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+#if USE_BINLOG
+/*********************************************************************
+*
+*       _IsAppLogEnabled
+*
+*  Function description
+*    Checks whether USBH_MTYPE_APPLICATION passes the log filter of
+*    emUSB-Host. The probe passes USBH_Logf_Application() and USBH_Log()
+*    and is counted by BINLOG_WriteText(). A probe of another task
+*    which passes at the same time has seen the same filter.
+*/
+static int _IsAppLogEnabled(void) {
+  static const char _sProbe[] = { PROBE_CHAR, 0 };
+  U32 NumProbes;
+
+  NumProbes = _NumProbes;
+  USBH_Logf_Application(_sProbe);
+  return (_NumProbes != NumProbes) ? 1 : 0;
+}
+#endif
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       BINLOG_Init
+*
+*  Function description
+*    Configures the RTT channel for the binary records.
+*    Records written before are discarded.
+*/
+void BINLOG_Init(void) {
+#if USE_BINLOG
+  SEGGER_RTT_ConfigUpBuffer(BINLOG_RTT_CHANNEL, "BinLog", &_acBuffer[0], sizeof(_acBuffer), SEGGER_RTT_MODE_MULTI_PRODUCER);
+  _IsInited = 1;
+#endif
+}
+
+/*********************************************************************
+*
+*       BINLOG_SetLogFilter
+*
+*  Function description
+*    Same as USBH_SetLogFilter(), which also applies to BINLOG_LOG().
+*/
+void BINLOG_SetLogFilter(U32 FilterMask) {
+  USBH_SetLogFilter(FilterMask);
+}
+
+/*********************************************************************
+*
+*       BINLOG_AddLogFilter
+*
+*  Function description
+*    Same as USBH_AddLogFilter(), which also applies to BINLOG_LOG().
+*/
+void BINLOG_AddLogFilter(U32 FilterMask) {
+  USBH_AddLogFilter(FilterMask);
+}
+
+/*********************************************************************
+*
+*       BINLOG_LogArgs
+*
+*  Function description
+*    Logs an application message. Normally called via BINLOG_LOG().
+*
+*  Parameters
+*    Id      : Format ID from BINLOG_Formats.h.
+*    paArg   : Integer arguments of the format.
+*    NumArgs : Number of arguments, at most BINLOG_MAX_ARGS are output.
+*/
+void BINLOG_LogArgs(unsigned Id, const U32 * paArg, unsigned NumArgs) {
+#if USE_BINLOG
+  U32      aRecord[(HEADER_SIZE / 4u) + BINLOG_MAX_ARGS];
+  unsigned i;
+
+  if ((_IsInited == 0) || (_IsAppLogEnabled() == 0)) {
+    return;
+  }
+  if (NumArgs > BINLOG_MAX_ARGS) {
+    NumArgs = BINLOG_MAX_ARGS;
+  }
+  aRecord[0] = BINLOG_TYPE_APP | ((NumArgs * 4u) << 8) | ((U32)Id << 16);
+  aRecord[1] = BINLOG_GET_TIMESTAMP();
+  for (i = 0; i < NumArgs; i++) {
+    aRecord[2 + i] = paArg[i];
+  }
+  SEGGER_RTT_WriteMP(BINLOG_RTT_CHANNEL, aRecord, HEADER_SIZE + (NumArgs * 4u));
+#else
+  U32      a[6] = { 0 };
+  unsigned i;
+
+  if (Id >= BINLOG_NUM_FORMATS) {
+    return;
+  }
+  for (i = 0; (i < NumArgs) && (i < BINLOG_MAX_ARGS); i++) {
+    a[i] = paArg[i];
+  }
+  USBH_Logf_Application(_asFormat[Id], a[0], a[1], a[2], a[3], a[4], a[5]);
+#endif
+}
+
+/*********************************************************************
+*
+*       BINLOG_WriteText
+*
+*  Function description
+*    Outputs a message which has already been formatted, such as the
+*    log and warn messages of emUSB-Host. Called from USBH_ConfigIO.c.
+*    The probe message of _IsAppLogEnabled() is counted, not sent.
+*
+*  Parameters
+*    Type : BINLOG_TYPE_LOG or BINLOG_TYPE_WARN.
+*    s    : Message, truncated to 255 characters.
+*/
+void BINLOG_WriteText(unsigned Type, const char * s) {
+#if USE_BINLOG
+  U32      aRecord[(HEADER_SIZE + MAX_TEXT_LEN + 3u) / 4u];
+  unsigned Len;
+
+  if ((s[0] == PROBE_CHAR) && (s[1] == '\0')) {
+    _NumProbes++;
+    return;
+  }
+  if (_IsInited == 0) {
+    return;
+  }
+  Len = (unsigned)strlen(s);
+  if (Len > MAX_TEXT_LEN) {
+    Len = MAX_TEXT_LEN;
+  }
+  aRecord[0] = Type | (Len << 8);
+  aRecord[1] = BINLOG_GET_TIMESTAMP();
+  memcpy(&aRecord[2], s, Len);
+  SEGGER_RTT_WriteMP(BINLOG_RTT_CHANNEL, aRecord, HEADER_SIZE + Len);
+#else
+  SEGGER_USE_PARA(Type);
+  SEGGER_USE_PARA(s);
+#endif
+}
+
+/*************************** End of file ****************************/
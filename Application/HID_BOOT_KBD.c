@@ -0,0 +1,151 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_BOOT_KBD.c
+Purpose : Comparison of two boot protocol keyboard reports, yields
+          all key changes of a report in one delta.
+
+Additional information:
+  A boot protocol keyboard sends an 8-byte report with the modifier
+  byte, a reserved byte and up to 6 key codes of the keys pressed.
+  emUSB-Host turns every change into a separate keyboard callback,
+  for a barcode scanner this is two callbacks per character.
+  HID_BOOT_KBD_Diff() compares the report with the previous one of
+  the device and returns all changes at once.
+
+  Both reports are compared as two 32-bit words. Identical reports,
+  as sent by keyboards with an idle rate, cost two XORs. Otherwise
+  the XOR yields a mask of the key slots which differ, and only the
+  key codes in these slots are looked up in the other report, so a
+  key which moves to another slot when an earlier key is released
+  is not reported. A report which only reorders the keys yields no
+  change.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <string.h>
+#include "SEGGER.h"
+#include "HID_BOOT_KBD.h"
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define OFF_MODIFIERS             0u
+#define OFF_KEYS                  2u
+#define KEY_CODE_FIRST            0x04u   // 0x00: no key, 0x01..0x03: error codes.
+#define KEY_CODE_ERROR_ROLL_OVER  0x01u   // Too many keys pressed, the keyboard reports this in all slots.
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _ContainsKey
+*/
+static int _ContainsKey(const U8 * pKeys, unsigned Code) {
+  unsigned i;
+
+  for (i = 0; i < HID_BOOT_KBD_NUM_KEYS; i++) {
+    if (pKeys[i] == Code) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_BOOT_KBD_Diff
+*
+*  Function description
+*    Compares a boot protocol report with the previous one of the device.
+*
+*  Parameters
+*    pPrevReport : Previous report, HID_BOOT_KBD_REPORT_SIZE bytes, all zero for the first report.
+*    pReport     : New report, HID_BOOT_KBD_REPORT_SIZE bytes.
+*    pDelta      : Receives the changes.
+*
+*  Return value
+*    > 0: Report differs, pDelta holds the changes.
+*    = 0: No change, also if only the order of the keys changed.
+*    < 0: Roll-over error report, has to be ignored. The previous
+*         report stays valid.
+*/
+int HID_BOOT_KBD_Diff(const U8 * pPrevReport, const U8 * pReport, HID_BOOT_KBD_DELTA * pDelta) {
+  U32      aPrev[2];
+  U32      aCur[2];
+  U32      Diff0;
+  U32      Diff1;
+  unsigned SlotMask;
+  unsigned Slot;
+  unsigned Code;
+
+  memcpy(aPrev, pPrevReport, HID_BOOT_KBD_REPORT_SIZE);
+  memcpy(aCur,  pReport,     HID_BOOT_KBD_REPORT_SIZE);
+  Diff0 = (aPrev[0] ^ aCur[0]) & ~0xFF00uL;     // Ignore the reserved byte.
+  Diff1 =  aPrev[1] ^ aCur[1];
+  if ((Diff0 | Diff1) == 0u) {
+    return 0;
+  }
+  if (pReport[OFF_KEYS] == KEY_CODE_ERROR_ROLL_OVER) {
+    return -1;
+  }
+  pDelta->Modifiers        = pReport[OFF_MODIFIERS];
+  pDelta->ModifiersChanged = (U8)Diff0;         // Reports are little endian, byte 0 is the modifier byte.
+  pDelta->NumPressed       = 0;
+  pDelta->NumReleased      = 0;
+  //
+  // Bit n of SlotMask is set if key slot n differs.
+  //
+  SlotMask = 0;
+  for (Slot = 0; Slot < 2u; Slot++) {
+    if ((Diff0 >> (16u + 8u * Slot)) & 0xFFu) {
+      SlotMask |= 1u << Slot;
+    }
+  }
+  for (Slot = 2; Slot < HID_BOOT_KBD_NUM_KEYS; Slot++) {
+    if ((Diff1 >> (8u * (Slot - 2u))) & 0xFFu) {
+      SlotMask |= 1u << Slot;
+    }
+  }
+  Slot = 0;
+  while (SlotMask != 0u) {
+    if (SlotMask & 1u) {
+      Code = pReport[OFF_KEYS + Slot];
+      if ((Code >= KEY_CODE_FIRST) && (_ContainsKey(pPrevReport + OFF_KEYS, Code) == 0)) {
+        pDelta->aPressed[pDelta->NumPressed++] = (U8)Code;
+      }
+      Code = pPrevReport[OFF_KEYS + Slot];
+      if ((Code >= KEY_CODE_FIRST) && (_ContainsKey(pReport + OFF_KEYS, Code) == 0)) {
+        pDelta->aReleased[pDelta->NumReleased++] = (U8)Code;
+      }
+    }
+    SlotMask >>= 1;
+    Slot++;
+  }
+  if ((pDelta->ModifiersChanged | pDelta->NumPressed | pDelta->NumReleased) == 0u) {
+    return 0;                                   // Keys only moved to other slots.
+  }
+  return 1;
+}
+
+/*************************** End of file ****************************/
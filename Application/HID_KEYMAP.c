@@ -0,0 +1,321 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_KEYMAP.c
+Purpose : Translation of keyboard scan codes into characters for
+          several keyboard layouts, selectable per interface.
+
+Additional information:
+  Each layout is described in Inc/HID_Keymap_<Layout>.h, one
+  KEY(Code, Normal, Shift, AltGr) entry per key. The description is
+  expanded at compile time into a table with HID_KEYMAP_NUM_LEVELS
+  entries per scan code, so translating a key is a single indexed load:
+
+    Entry = paEntry[Code * HID_KEYMAP_NUM_LEVELS + Level]
+
+  where Level is derived from the modifier byte: bit 0 for Shift,
+  bit 1 for AltGr (right Alt, or Ctrl + Alt). Codes and levels not in
+  the description are 0 and produce no character.
+
+  A dead key produces no character but is remembered in the
+  HID_KEYMAP_STATE of the keyboard. The next character is combined
+  with it (^ and e give e circumflex), a space produces the accent
+  alone, any other character produces the accent followed by the
+  character.
+
+  To add a layout, copy one of the descriptions, add a table and a
+  HID_KEYMAP_LAYOUT for it below and declare the layout in HID_KEYMAP.h.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <string.h>
+#include "SEGGER.h"
+#include "HID_KEYMAP.h"
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define MODIFIER_MASK_SHIFT       0x22u   // LeftShift, RightShift
+#define MODIFIER_MASK_ALTGR       0x40u   // RightAlt
+#define MODIFIER_MASK_CTRL_ALT    0x05u   // LeftControl + LeftAlt, same as AltGr.
+
+#define LEVEL_SHIFT               1u
+#define LEVEL_ALTGR               2u
+
+//
+// Character constants such as '\xE4' are negative if char is signed,
+// keep the lower 8 bits unless the entry is marked as dead key.
+//
+#define ENTRY(c)                  (U16)(((c) >= (int)HID_KEYMAP_FLAG_DEAD) ? (c) : ((c) & 0xFF))
+#define DEAD(c)                   (int)(HID_KEYMAP_FLAG_DEAD | ((c) & 0xFFu))
+#define KEY(Code, Normal, Shift, AltGr) \
+  [(Code) * HID_KEYMAP_NUM_LEVELS] = ENTRY(Normal), ENTRY(Shift), ENTRY(AltGr), 0,
+
+/*********************************************************************
+*
+*       Local data definitions
+*
+**********************************************************************
+*/
+typedef struct {
+  U8           Accent;
+  const char * sBase;            // Characters which can be combined with the accent ...
+  const char * sResult;          // ... and the combined characters, Windows-1252.
+} DEAD_KEY;
+
+typedef struct {
+  USBH_INTERFACE_ID         InterfaceID;
+  const HID_KEYMAP_LAYOUT * pLayout;    // NULL if the entry is unused.
+} INTERFACE_LAYOUT;
+
+/*********************************************************************
+*
+*       Static const data
+*
+**********************************************************************
+*/
+static const U16 _aEntryUS[HID_KEYMAP_NUM_CODES * HID_KEYMAP_NUM_LEVELS] = {
+  #include "HID_Keymap_US.h"
+};
+
+static const U16 _aEntryDE[HID_KEYMAP_NUM_CODES * HID_KEYMAP_NUM_LEVELS] = {
+  #include "HID_Keymap_DE.h"
+};
+
+static const U16 _aEntryFR[HID_KEYMAP_NUM_CODES * HID_KEYMAP_NUM_LEVELS] = {
+  #include "HID_Keymap_FR.h"
+};
+
+static const DEAD_KEY _aDeadKey[] = {
+  { '^',    "aeiouAEIOU",   "\xE2\xEA\xEE\xF4\xFB\xC2\xCA\xCE\xD4\xDB"         },
+  { '`',    "aeiouAEIOU",   "\xE0\xE8\xEC\xF2\xF9\xC0\xC8\xCC\xD2\xD9"         },
+  { '\xB4', "aeiouyAEIOUY", "\xE1\xE9\xED\xF3\xFA\xFD\xC1\xC9\xCD\xD3\xDA\xDD" },   // Acute accent
+  { '\xA8', "aeiouyAEIOU",  "\xE4\xEB\xEF\xF6\xFC\xFF\xC4\xCB\xCF\xD6\xDC"     },   // Diaeresis
+  { '~',    "anoANO",       "\xE3\xF1\xF5\xC3\xD1\xD5"                         },
+};
+
+/*********************************************************************
+*
+*       Public const data
+*
+**********************************************************************
+*/
+const HID_KEYMAP_LAYOUT HID_KEYMAP_US = { "US", _aEntryUS };
+const HID_KEYMAP_LAYOUT HID_KEYMAP_DE = { "DE", _aEntryDE };
+const HID_KEYMAP_LAYOUT HID_KEYMAP_FR = { "FR", _aEntryFR };
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static const HID_KEYMAP_LAYOUT * _pDefaultLayout = &HID_KEYMAP_US;
+static INTERFACE_LAYOUT          _aInterfaceLayout[HID_KEYMAP_MAX_INTERFACES];
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _GetLevel
+*/
+static unsigned _GetLevel(unsigned Modifiers) {
+  unsigned Level;
+
+  Level = (Modifiers & MODIFIER_MASK_SHIFT) ? LEVEL_SHIFT : 0u;
+  if ((Modifiers & MODIFIER_MASK_ALTGR) || ((Modifiers & MODIFIER_MASK_CTRL_ALT) == MODIFIER_MASK_CTRL_ALT)) {
+    Level |= LEVEL_ALTGR;
+  }
+  return Level;
+}
+
+/*********************************************************************
+*
+*       _Combine
+*
+*  Function description
+*    Combines an accent with a character.
+*
+*  Return value
+*    Combined character, 0 if there is none.
+*/
+static U8 _Combine(U8 Accent, U8 c) {
+  const DEAD_KEY * pDeadKey;
+  const char     * s;
+  unsigned         i;
+
+  pDeadKey = &_aDeadKey[0];
+  for (i = 0; i < SEGGER_COUNTOF(_aDeadKey); i++) {
+    if (pDeadKey->Accent == Accent) {
+      s = strchr(pDeadKey->sBase, (char)c);
+      if ((s != NULL) && (c != 0u)) {
+        return (U8)pDeadKey->sResult[s - pDeadKey->sBase];
+      }
+      break;
+    }
+    pDeadKey++;
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _FindInterface
+*/
+static INTERFACE_LAYOUT * _FindInterface(USBH_INTERFACE_ID InterfaceID) {
+  INTERFACE_LAYOUT * pEntry;
+  unsigned           i;
+
+  pEntry = &_aInterfaceLayout[0];
+  for (i = 0; i < HID_KEYMAP_MAX_INTERFACES; i++) {
+    if ((pEntry->pLayout != NULL) && (pEntry->InterfaceID == InterfaceID)) {
+      return pEntry;
+    }
+    pEntry++;
+  }
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_KEYMAP_Translate
+*
+*  Function description
+*    Translates a key press into characters.
+*
+*  Parameters
+*    pLayout   : Layout of the keyboard.
+*    pState    : Translation state of the keyboard, zero-initialized before the first call.
+*    Code      : Scan code of the key pressed.
+*    Modifiers : Modifier keys pressed, bit n is scan code 0xE0 + n.
+*    pChar     : Receives up to HID_KEYMAP_MAX_CHARS characters, not terminated.
+*
+*  Return value
+*    Number of characters stored at pChar.
+*/
+unsigned HID_KEYMAP_Translate(const HID_KEYMAP_LAYOUT * pLayout, HID_KEYMAP_STATE * pState, unsigned Code, unsigned Modifiers, char * pChar) {
+  unsigned Entry;
+  unsigned NumChars;
+  U8       Accent;
+  U8       Combined;
+  U8       c;
+
+  if (Code >= HID_KEYMAP_NUM_CODES) {
+    return 0;
+  }
+  Entry = pLayout->paEntry[Code * HID_KEYMAP_NUM_LEVELS + _GetLevel(Modifiers)];
+  if (Entry == 0u) {
+    return 0;
+  }
+  c        = (U8)Entry;
+  NumChars = 0;
+  Accent   = pState->DeadKey;
+  if (Entry & HID_KEYMAP_FLAG_DEAD) {
+    if (Accent != 0u) {
+      pChar[NumChars++] = (char)Accent;   // Second dead key, the first one is typed alone.
+    }
+    pState->DeadKey = c;
+    return NumChars;
+  }
+  if (Accent != 0u) {
+    pState->DeadKey = 0;
+    Combined = (c == ' ') ? Accent : _Combine(Accent, c);
+    if (Combined != 0u) {
+      c = Combined;
+    } else {
+      pChar[NumChars++] = (char)Accent;
+    }
+  }
+  pChar[NumChars++] = (char)c;
+  return NumChars;
+}
+
+/*********************************************************************
+*
+*       HID_KEYMAP_SetDefaultLayout
+*
+*  Function description
+*    Sets the layout of all interfaces without a layout of their own.
+*    The default is HID_KEYMAP_US.
+*/
+void HID_KEYMAP_SetDefaultLayout(const HID_KEYMAP_LAYOUT * pLayout) {
+  _pDefaultLayout = pLayout;
+}
+
+/*********************************************************************
+*
+*       HID_KEYMAP_SetLayout
+*
+*  Function description
+*    Sets the layout of one keyboard interface.
+*    Has to be called by the task which translates the keys.
+*    USBH_HID_Keyboard.c looks the layout up when the keyboard is
+*    attached, a change applies from the next attach on.
+*
+*  Parameters
+*    InterfaceID : Interface of the keyboard.
+*    pLayout     : Layout, NULL to use the default layout again.
+*
+*  Return value
+*    = 0: O.K.
+*    < 0: HID_KEYMAP_MAX_INTERFACES interfaces have a layout already.
+*/
+int HID_KEYMAP_SetLayout(USBH_INTERFACE_ID InterfaceID, const HID_KEYMAP_LAYOUT * pLayout) {
+  INTERFACE_LAYOUT * pEntry;
+  unsigned           i;
+
+  pEntry = _FindInterface(InterfaceID);
+  if (pEntry != NULL) {
+    pEntry->pLayout = pLayout;
+    return 0;
+  }
+  if (pLayout == NULL) {
+    return 0;
+  }
+  pEntry = &_aInterfaceLayout[0];
+  for (i = 0; i < HID_KEYMAP_MAX_INTERFACES; i++) {
+    if (pEntry->pLayout == NULL) {
+      pEntry->InterfaceID = InterfaceID;
+      pEntry->pLayout     = pLayout;
+      return 0;
+    }
+    pEntry++;
+  }
+  return -1;
+}
+
+/*********************************************************************
+*
+*       HID_KEYMAP_GetLayout
+*
+*  Function description
+*    Returns the layout of a keyboard interface.
+*/
+const HID_KEYMAP_LAYOUT * HID_KEYMAP_GetLayout(USBH_INTERFACE_ID InterfaceID) {
+  const INTERFACE_LAYOUT * pEntry;
+
+  pEntry = _FindInterface(InterfaceID);
+  return (pEntry != NULL) ? pEntry->pLayout : _pDefaultLayout;
+}
+
+/*************************** End of file ****************************/
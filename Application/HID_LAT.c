@@ -0,0 +1,276 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_LAT.c
+Purpose : Latency histograms of HID reports from the USB interrupt
+          to the application task.
+
+Additional information:
+  Enable with USE_HID_LAT=1 in the preprocessor definitions of the
+  project. Each report is timestamped at three points:
+
+    OTG_FS_IRQHandler()   HID_LAT_OnIRQ()       Entry of a channel interrupt (BSP_USB.c).
+    HID callback          HID_LAT_Stamp()       Stored with the queued event.
+    Application task      HID_LAT_OnDequeue()   After the event has been taken.
+
+  The interrupt does not know which report it completes, the callback
+  takes the time of the last channel interrupt before it. Replayed
+  reports (USE_HID_REPLAY) have no interrupt, the replay task calls
+  HID_LAT_OnIRQ() in its place.
+
+  The time between two points is counted in a histogram per stage
+  with logarithmic buckets: bucket 0 for less than 1 us, bucket n for
+  2^(n-1) .. 2^n - 1 us. Each histogram is written by one task only.
+  HID_LAT_Print() outputs the histograms with USBH_Logf_Application(),
+  HID_LAT_Poll() does so when a key has been sent on the RTT terminal:
+
+    0:812 MainTask - HID_LAT IRQ->callback: 5120 reports, min 18 us, max 161 us
+    0:812 MainTask - HID_LAT  16..31 us: 4870
+    0:812 MainTask - HID_LAT  32..63 us: 231
+    0:812 MainTask - HID_LAT  128..255 us: 19
+
+  On the target the time is taken from the DWT cycle counter,
+  in a host build from the monotonic clock in ns.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <string.h>
+#include "SEGGER.h"
+#include "SEGGER_RTT.h"
+#include "USBH.h"
+#include "HID_LAT.h"
+#if defined(__arm__) || defined(__ICCARM__)
+  #include "stm32f4xx.h"
+  #define HID_LAT_TARGET  1
+#else
+  #include <time.h>
+  #define HID_LAT_TARGET  0
+#endif
+
+/*********************************************************************
+*
+*       Static const data
+*
+**********************************************************************
+*/
+static const char * const _asStageName[HID_LAT_NUM_STAGES] = {
+  "IRQ->callback",
+  "callback->task",
+  "IRQ->task"
+};
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static HID_LAT_HIST  _aHist[HID_LAT_NUM_STAGES];
+static volatile U32  _IrqTime;          // Written by the interrupt only.
+static U32           _TicksPerUs;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _GetTicks
+*
+*  Function description
+*    Returns the free-running time stamp counter.
+*/
+static U32 _GetTicks(void) {
+#if HID_LAT_TARGET
+  return DWT->CYCCNT;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (U32)((U64)ts.tv_sec * 1000000000u + (U64)ts.tv_nsec);
+#endif
+}
+
+/*********************************************************************
+*
+*       _GetBucket
+*
+*  Function description
+*    Returns the histogram bucket of a latency.
+*/
+static unsigned _GetBucket(U32 Latency_us) {
+  unsigned Bucket;
+
+  Bucket = 0;
+  while ((Latency_us != 0u) && (Bucket < HID_LAT_NUM_BUCKETS - 1u)) {
+    Latency_us >>= 1;
+    Bucket++;
+  }
+  return Bucket;
+}
+
+/*********************************************************************
+*
+*       _Add
+*
+*  Function description
+*    Counts the time from Start to End in the histogram of a stage.
+*/
+static void _Add(unsigned Stage, U32 Start, U32 End) {
+  HID_LAT_HIST * pHist;
+  U32            Latency_us;
+
+  pHist      = &_aHist[Stage];
+  Latency_us = (End - Start) / _TicksPerUs;
+  if ((pHist->NumReports == 0u) || (Latency_us < pHist->Min_us)) {
+    pHist->Min_us = Latency_us;
+  }
+  if (Latency_us > pHist->Max_us) {
+    pHist->Max_us = Latency_us;
+  }
+  pHist->aCount[_GetBucket(Latency_us)]++;
+  pHist->NumReports++;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_LAT_Init
+*
+*  Function description
+*    Starts the cycle counter and clears the histograms.
+*    Has to be called before the USB host is initialized.
+*/
+void HID_LAT_Init(void) {
+#if HID_LAT_TARGET
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT       = 0;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+  _TicksPerUs       = SystemCoreClock / 1000000u;
+#else
+  _TicksPerUs       = 1000u;
+#endif
+  _IrqTime = 0;
+  memset(_aHist, 0, sizeof(_aHist));
+}
+
+/*********************************************************************
+*
+*       HID_LAT_OnIRQ
+*
+*  Function description
+*    Called on entry of a USB interrupt which may complete a report.
+*/
+void HID_LAT_OnIRQ(void) {
+  U32 t;
+
+  t = _GetTicks();
+  _IrqTime = (t != 0u) ? t : 1u;          // 0 marks "no interrupt".
+}
+
+/*********************************************************************
+*
+*       HID_LAT_Stamp
+*
+*  Function description
+*    Takes the timestamps of a report in the HID callback and counts
+*    the time since the interrupt.
+*/
+void HID_LAT_Stamp(HID_LAT_STAMP * pStamp) {
+  pStamp->IrqTime      = _IrqTime;
+  pStamp->CallbackTime = _GetTicks();
+  if (pStamp->IrqTime != 0u) {
+    _Add(HID_LAT_STAGE_IRQ_CALLBACK, pStamp->IrqTime, pStamp->CallbackTime);
+  }
+}
+
+/*********************************************************************
+*
+*       HID_LAT_OnDequeue
+*
+*  Function description
+*    Called by the application task after an event has been taken
+*    from the queue, counts the time since the callback and the
+*    interrupt.
+*/
+void HID_LAT_OnDequeue(const HID_LAT_STAMP * pStamp) {
+  U32 t;
+
+  t = _GetTicks();
+  _Add(HID_LAT_STAGE_CALLBACK_TASK, pStamp->CallbackTime, t);
+  if (pStamp->IrqTime != 0u) {
+    _Add(HID_LAT_STAGE_IRQ_TASK, pStamp->IrqTime, t);
+  }
+}
+
+/*********************************************************************
+*
+*       HID_LAT_GetHist
+*
+*  Function description
+*    Returns the histogram of a stage, HID_LAT_STAGE_*.
+*/
+void HID_LAT_GetHist(unsigned Stage, HID_LAT_HIST * pHist) {
+  *pHist = _aHist[Stage];
+}
+
+/*********************************************************************
+*
+*       HID_LAT_Print
+*
+*  Function description
+*    Outputs the histograms of all stages, one line per bucket in use.
+*/
+void HID_LAT_Print(void) {
+  HID_LAT_HIST Hist;
+  unsigned     Stage;
+  unsigned     i;
+
+  for (Stage = 0; Stage < HID_LAT_NUM_STAGES; Stage++) {
+    HID_LAT_GetHist(Stage, &Hist);
+    USBH_Logf_Application("HID_LAT %s: %u reports, min %u us, max %u us", _asStageName[Stage], Hist.NumReports, Hist.Min_us, Hist.Max_us);
+    for (i = 0; i < HID_LAT_NUM_BUCKETS; i++) {
+      if (Hist.aCount[i] == 0u) {
+        continue;
+      }
+      if (i == 0u) {
+        USBH_Logf_Application("HID_LAT  <1 us: %u", Hist.aCount[i]);
+      } else if (i == HID_LAT_NUM_BUCKETS - 1u) {
+        USBH_Logf_Application("HID_LAT  >= %u us: %u", 1uL << (i - 1u), Hist.aCount[i]);
+      } else {
+        USBH_Logf_Application("HID_LAT  %u..%u us: %u", 1uL << (i - 1u), (1uL << i) - 1u, Hist.aCount[i]);
+      }
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       HID_LAT_Poll
+*
+*  Function description
+*    Outputs the histograms if a key has been sent on the RTT terminal.
+*    Called periodically by the application task.
+*/
+void HID_LAT_Poll(void) {
+  if (SEGGER_RTT_HasKey()) {
+    (void)SEGGER_RTT_GetKey();
+    HID_LAT_Print();
+  }
+}
+
+/*************************** End of file ****************************/
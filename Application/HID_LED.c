@@ -0,0 +1,255 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_LED.c
+Purpose : Coalesced update of the keyboard indicators (LEDs) from a
+          low priority task.
+
+Additional information:
+  Updating the LEDs of a keyboard is a SET_REPORT control transfer.
+  Done from the task which decodes the keys, every Caps Lock press
+  would hold up decoding until the transfer has completed, and a burst
+  of lock keys would occupy the control pipe while the interrupt IN
+  endpoints are polled. Instead the application only records the
+  requested indicators:
+
+    HID_LED_Add(&Led, hDevice);            // Once the keyboard is opened.
+    HID_LED_Set(&Led, Mask);               // Never blocks.
+    HID_LED_Remove(&Led);                  // Before the keyboard is closed.
+
+  The task "HID_LED" runs below the application task. It updates one
+  keyboard at a time with USBH_HID_SetIndicators(), so there is never
+  more than one transfer of this module on the control pipe, and each
+  keyboard at most once per HID_LED_INTERVAL ms with the mask requested
+  last. Lock keys toggled faster are coalesced, a mask which ends where
+  it started is not sent at all. A failed update is repeated after
+  the interval.
+
+  Before each SET_REPORT, HID_LED_X_IsControlIdle() of the hardware
+  configuration checks that no control transfer of the stack, such as
+  an enumeration or a hub request, is in progress on the host
+  controller. Otherwise the update is retried after HID_LED_BUSY_DELAY
+  ms, the interval of the keyboard does not restart.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include "RTOS.h"
+#include "SEGGER.h"
+#include "USBH.h"
+#include "USBH_HID.h"
+#include "HID_LED.h"
+
+/*********************************************************************
+*
+*       Defines configurable
+*
+**********************************************************************
+*/
+#define LED_STACK_SIZE          768
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define EVENT_REQUEST           (1u << 0)   // HID_LED_Set() has changed a mask.
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static OS_STACKPTR int    _StackLed[LED_STACK_SIZE/sizeof(int)];
+static OS_TASK            _TCBLed;
+static OS_MUTEX           _Mutex;           // Protects the list and the device handles while an update is in progress.
+static HID_LED          * _pFirst;
+static HID_LED_STAT       _Stat;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _Update
+*
+*  Function description
+*    Sends the requested mask of a keyboard if it differs from the one
+*    sent last, the interval has expired and the control pipe is idle.
+*    Called with the mutex held.
+*
+*  Return value
+*    >  0: Time in ms until the keyboard can be updated.
+*    == 0: Nothing to do.
+*/
+static U32 _Update(HID_LED * pLed, U32 Now) {
+  U32 t;
+  U8  Mask;
+
+  Mask = pLed->Mask;
+  if (Mask == pLed->MaskSent) {
+    return 0;
+  }
+  t = Now - pLed->LastTime;
+  if (t < HID_LED_INTERVAL) {
+    return HID_LED_INTERVAL - t;
+  }
+  if (HID_LED_X_IsControlIdle() == 0) {
+    _Stat.NumDeferred++;
+    return HID_LED_BUSY_DELAY;
+  }
+  pLed->LastTime = Now;
+  _Stat.NumUpdates++;
+  if (USBH_HID_SetIndicators(pLed->hDevice, Mask) != USBH_STATUS_SUCCESS) {
+    _Stat.NumErrors++;
+    return HID_LED_INTERVAL;            // MaskSent is unchanged, retried after the interval.
+  }
+  pLed->MaskSent = Mask;
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _LedTask
+*/
+static void _LedTask(void) {
+  HID_LED * pLed;
+  U32       Timeout;
+  U32       t;
+
+  while (1) {
+    Timeout = 0;
+    OS_MUTEX_LockBlocked(&_Mutex);
+    for (pLed = _pFirst; pLed != NULL; pLed = pLed->pNext) {
+      t = _Update(pLed, OS_GetTime32());
+      if ((t != 0u) && ((Timeout == 0u) || (t < Timeout))) {
+        Timeout = t;
+      }
+    }
+    OS_MUTEX_Unlock(&_Mutex);
+    if (Timeout != 0u) {
+      OS_TASKEVENT_GetTimed(EVENT_REQUEST, (OS_TIME)Timeout);
+    } else {
+      OS_TASKEVENT_GetBlocked(EVENT_REQUEST);
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_LED_Init
+*
+*  Function description
+*    Starts the LED task. Has to be called once before any other function.
+*/
+void HID_LED_Init(void) {
+  OS_MUTEX_Create(&_Mutex);
+  _pFirst = NULL;
+  OS_CREATETASK(&_TCBLed, "HID_LED", _LedTask, HID_LED_TASK_PRIO, _StackLed);
+}
+
+/*********************************************************************
+*
+*       HID_LED_Add
+*
+*  Function description
+*    Adds an opened keyboard. The indicators of a keyboard are off
+*    after enumeration.
+*
+*  Parameters
+*    pLed    : Indicator state of the keyboard, has to remain valid until HID_LED_Remove().
+*    hDevice : Handle of the keyboard.
+*/
+void HID_LED_Add(HID_LED * pLed, USBH_HID_HANDLE hDevice) {
+  pLed->hDevice  = hDevice;
+  pLed->Mask     = 0;
+  pLed->MaskSent = 0;
+  pLed->LastTime = OS_GetTime32() - HID_LED_INTERVAL;   // The first update is not delayed.
+  OS_MUTEX_LockBlocked(&_Mutex);
+  pLed->pNext = _pFirst;
+  _pFirst     = pLed;
+  OS_MUTEX_Unlock(&_Mutex);
+  OS_TASKEVENT_Set(&_TCBLed, EVENT_REQUEST);
+}
+
+/*********************************************************************
+*
+*       HID_LED_Remove
+*
+*  Function description
+*    Removes a keyboard. Waits for an update of the keyboard which is
+*    in progress, the handle can be closed afterwards.
+*/
+void HID_LED_Remove(HID_LED * pLed) {
+  HID_LED ** ppLed;
+
+  OS_MUTEX_LockBlocked(&_Mutex);
+  for (ppLed = &_pFirst; *ppLed != NULL; ppLed = &(*ppLed)->pNext) {
+    if (*ppLed == pLed) {
+      *ppLed = pLed->pNext;
+      break;
+    }
+  }
+  OS_MUTEX_Unlock(&_Mutex);
+}
+
+/*********************************************************************
+*
+*       HID_LED_Set
+*
+*  Function description
+*    Requests new indicators for a keyboard. Never blocks, the update
+*    is sent by the LED task.
+*
+*  Parameters
+*    pLed : Indicator state of the keyboard.
+*    Mask : USBH_HID_IND_* or'ed.
+*/
+void HID_LED_Set(HID_LED * pLed, U8 Mask) {
+  if (Mask != pLed->Mask) {
+    pLed->Mask = Mask;
+    _Stat.NumRequests++;
+    OS_TASKEVENT_Set(&_TCBLed, EVENT_REQUEST);
+  }
+}
+
+/*********************************************************************
+*
+*       HID_LED_Get
+*
+*  Function description
+*    Returns the indicators requested last.
+*/
+U8 HID_LED_Get(const HID_LED * pLed) {
+  return pLed->Mask;
+}
+
+/*********************************************************************
+*
+*       HID_LED_GetStat
+*
+*  Function description
+*    Returns the counters of the LED task.
+*/
+void HID_LED_GetStat(HID_LED_STAT * pStat) {
+  *pStat = _Stat;
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,319 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_PLAN.c
+Purpose : Extraction plans for the fields of HID input reports.
+          A plan is compiled once from the field layout reported by
+          USBH_HID_SetOnGenericEvent() and decodes a complete raw
+          report in one pass.
+
+Additional information:
+  USBH_HID_GENERIC_DATA describes every field by ReportID, BitPosStart,
+  NumBits and Signed, and emUSB-Host extracts the fields one by one.
+  For devices with many fields and a high report rate, the application
+  compiles these descriptions once:
+
+    HID_PLAN_Compile(&Plan, pGenericData, NumGenericInfos);
+
+  and then decodes raw reports read with USBH_HID_GetReport():
+
+    HID_PLAN_Decode(&Plan, pReport, NumBytes, aValue);
+
+  aValue[i] receives the value of the usage i of the array passed to
+  USBH_HID_SetOnGenericEvent(), so a struct of I32 members in usage
+  order can be used instead of the array. Fields of other reports
+  are left unchanged.
+
+  The plan sorts the fields of each report by bit position and
+  assigns them to 32-bit words. Each word is loaded once with a single
+  (unaligned) load, all fields inside it are extracted with a shift
+  and a mask, signed fields are sign-extended with two shifts.
+  Loads at the end of a report are moved back so they never read
+  beyond the last field. Fields which span 5 bytes use a 64-bit load.
+  Reports are little endian, as is the CPU.
+
+  BitPosStart is taken as relative to the first byte after the report
+  ID. If any field has a ReportID other than 0, every report is
+  expected to start with its report ID byte.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <string.h>
+#include "SEGGER.h"
+#include "USBH_HID.h"
+#include "HID_PLAN.h"
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define FLAG_LOAD               (1u << 0)       // Load a new word before extracting the field.
+#define FLAG_WIDE               (1u << 1)       // Field spans 5 bytes, use a 64-bit word.
+#define FLAG_SIGNED             (1u << 2)
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _GetBitPos
+*
+*  Function description
+*    Returns the bit position of a field before the plan is finalized,
+*    where ByteOff and Shift still hold BitPosStart.
+*/
+static unsigned _GetBitPos(const HID_PLAN_FIELD * pField) {
+  return ((unsigned)pField->ByteOff << 3) + pField->Shift;
+}
+
+/*********************************************************************
+*
+*       _FindReport
+*/
+static HID_PLAN_REPORT * _FindReport(const HID_PLAN * pPlan, unsigned ReportID) {
+  const HID_PLAN_REPORT * pReport;
+  unsigned                i;
+
+  pReport = &pPlan->aReport[0];
+  for (i = 0; i < pPlan->NumReports; i++) {
+    if (pReport->ReportID == ReportID) {
+      return (HID_PLAN_REPORT *)pReport;
+    }
+    pReport++;
+  }
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       _AssignWords
+*
+*  Function description
+*    Assigns the sorted fields of a report to the words to be loaded.
+*/
+static void _AssignWords(HID_PLAN * pPlan, const HID_PLAN_REPORT * pReport) {
+  HID_PLAN_FIELD * pField;
+  unsigned         BitPos;
+  unsigned         WordOff;
+  unsigned         WordBits;
+  unsigned         i;
+
+  WordOff  = 0;
+  WordBits = 0;                           // No word loaded yet.
+  pField   = &pPlan->aField[pReport->FirstField];
+  for (i = 0; i < pReport->NumFields; i++) {
+    BitPos = _GetBitPos(pField);
+    if ((WordBits != 0u) && (BitPos >= WordOff * 8u) && (BitPos + pField->NumBits <= WordOff * 8u + WordBits)) {
+      pField->Flags &= ~FLAG_LOAD;        // Field is in the word loaded for a previous field.
+    } else {
+      pField->Flags |= FLAG_LOAD;
+      WordBits = 32;
+      if ((BitPos & 7u) + pField->NumBits > 32u) {
+        pField->Flags |= FLAG_WIDE;
+        WordBits = 64;
+      }
+      //
+      // Move the load back when it would read behind the end of the report.
+      //
+      WordOff = BitPos >> 3;
+      if (WordOff + (WordBits >> 3) > pReport->NumBytes) {
+        WordOff = (pReport->NumBytes > (WordBits >> 3)) ? (pReport->NumBytes - (WordBits >> 3)) : 0u;
+      }
+      if (pField->Flags & FLAG_WIDE) {
+        WordBits = 0;                     // Following fields load their own word.
+      }
+    }
+    pField->ByteOff = (U16)WordOff;
+    pField->Shift   = (U8)(BitPos - WordOff * 8u);
+    pField++;
+  }
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_PLAN_Compile
+*
+*  Function description
+*    Compiles the plan for the reports of an interface.
+*
+*  Parameters
+*    pPlan    : Plan to compile.
+*    paData   : Field descriptions as passed to the generic event callback.
+*    NumInfos : Number of field descriptions.
+*
+*  Return value
+*    = 0: O.K.
+*    < 0: Too many fields or reports, or a field with more than 32 bits.
+*/
+int HID_PLAN_Compile(HID_PLAN * pPlan, const USBH_HID_GENERIC_DATA * paData, unsigned NumInfos) {
+  HID_PLAN_REPORT * pReport;
+  HID_PLAN_FIELD  * pField;
+  HID_PLAN_FIELD    Field;
+  unsigned          NumBytes;
+  unsigned          Off;
+  unsigned          i;
+  unsigned          j;
+
+  memset(pPlan, 0, sizeof(*pPlan));
+  if (NumInfos > 0xFFu) {
+    return -1;                            // ValueIndex is a U8.
+  }
+  //
+  // Count the fields of each report.
+  //
+  for (i = 0; i < NumInfos; i++) {
+    if (paData[i].Usage == 0u) {
+      continue;                           // Usage not found in the report descriptor.
+    }
+    if ((paData[i].NumBits == 0u) || (paData[i].NumBits > 32u)) {
+      return -1;
+    }
+    pReport = _FindReport(pPlan, paData[i].ReportID);
+    if (pReport == NULL) {
+      if (pPlan->NumReports == HID_PLAN_MAX_REPORTS) {
+        return -1;
+      }
+      pReport = &pPlan->aReport[pPlan->NumReports++];
+      pReport->ReportID = paData[i].ReportID;
+    }
+    if (pPlan->NumFields == HID_PLAN_MAX_FIELDS) {
+      return -1;
+    }
+    pReport->NumFields++;
+    pPlan->NumFields++;
+    if (paData[i].ReportID != 0u) {
+      pPlan->UsesReportIDs = 1;
+    }
+    NumBytes = ((unsigned)paData[i].BitPosStart + paData[i].NumBits + 7u) >> 3;
+    if (NumBytes > pReport->NumBytes) {
+      pReport->NumBytes = (U16)NumBytes;
+    }
+  }
+  Off = 0;
+  for (i = 0; i < pPlan->NumReports; i++) {
+    pPlan->aReport[i].FirstField = (U16)Off;
+    Off += pPlan->aReport[i].NumFields;
+    pPlan->aReport[i].NumFields = 0;      // Counted again while sorting in.
+  }
+  //
+  // Sort the fields into their reports by bit position.
+  //
+  for (i = 0; i < NumInfos; i++) {
+    if (paData[i].Usage == 0u) {
+      continue;
+    }
+    Field.ByteOff    = (U16)(paData[i].BitPosStart >> 3);
+    Field.Shift      = (U8)(paData[i].BitPosStart & 7u);
+    Field.NumBits    = paData[i].NumBits;
+    Field.Flags      = paData[i].Signed ? FLAG_SIGNED : 0u;
+    Field.ValueIndex = (U8)i;
+    pReport = _FindReport(pPlan, paData[i].ReportID);
+    pField  = &pPlan->aField[pReport->FirstField];
+    j       = pReport->NumFields++;
+    while ((j > 0u) && (_GetBitPos(&pField[j - 1u]) > paData[i].BitPosStart)) {
+      pField[j] = pField[j - 1u];
+      j--;
+    }
+    pField[j] = Field;
+  }
+  for (i = 0; i < pPlan->NumReports; i++) {
+    _AssignWords(pPlan, &pPlan->aReport[i]);
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       HID_PLAN_Decode
+*
+*  Function description
+*    Extracts all fields of a raw input report.
+*
+*  Parameters
+*    pPlan    : Compiled plan.
+*    pReport  : Report as received, including the report ID byte if the device uses report IDs.
+*    NumBytes : Size of the report in bytes.
+*    paValue  : Values indexed by usage, only the fields of this report are written.
+*
+*  Return value
+*    >= 0: Number of fields extracted.
+*    <  0: Unknown report ID or report too short.
+*/
+int HID_PLAN_Decode(const HID_PLAN * pPlan, const U8 * pReport, unsigned NumBytes, I32 * paValue) {
+  const HID_PLAN_REPORT * pRep;
+  const HID_PLAN_FIELD  * pField;
+  U8                      abPad[8];
+  unsigned                ReportID;
+  unsigned                NumFields;
+  unsigned                n;
+  U32                     Word;
+  U32                     v;
+  U64                     Word64;
+
+  ReportID = 0;
+  if (pPlan->UsesReportIDs) {
+    if (NumBytes == 0u) {
+      return -1;
+    }
+    ReportID = *pReport++;
+    NumBytes--;
+  }
+  pRep = _FindReport(pPlan, ReportID);
+  if ((pRep == NULL) || (NumBytes < pRep->NumBytes)) {
+    return -1;
+  }
+  if (pRep->NumBytes < sizeof(abPad)) {
+    //
+    // Short report, a word load could read behind it.
+    //
+    memset(abPad, 0, sizeof(abPad));
+    memcpy(abPad, pReport, pRep->NumBytes);
+    pReport = abPad;
+  }
+  Word      = 0;
+  pField    = &pPlan->aField[pRep->FirstField];
+  NumFields = pRep->NumFields;
+  while (NumFields--) {
+    if (pField->Flags & FLAG_WIDE) {
+      memcpy(&Word64, pReport + pField->ByteOff, 8);
+      v = (U32)(Word64 >> pField->Shift);
+    } else {
+      if (pField->Flags & FLAG_LOAD) {
+        memcpy(&Word, pReport + pField->ByteOff, 4);
+      }
+      v = Word >> pField->Shift;
+    }
+    n = pField->NumBits;
+    if (n < 32u) {
+      v <<= 32u - n;                      // Drop the bits above the field, then shift back.
+      if (pField->Flags & FLAG_SIGNED) {
+        v = (U32)((I32)v >> (32u - n));
+      } else {
+        v >>= 32u - n;
+      }
+    }
+    paValue[pField->ValueIndex] = (I32)v;
+    pField++;
+  }
+  return (int)pRep->NumFields;
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,376 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_QUEUE.c
+Purpose : Single producer, single consumer event queue between the
+          HID callbacks running in USBH_Task and the application task.
+
+Additional information:
+  Replaces a mailbox with OS_PutMailCond() / OS_GetMail() per event.
+  The producer copies the event into the ring and only calls the OS
+  when the queue was empty before, so a burst of reports wakes the
+  consumer once. The consumer takes all queued events in one pass:
+
+    HID_QUEUE_Wait(&Queue);
+    while (HID_QUEUE_Get(&Queue, &Event)) {
+      ...
+    }
+
+  The read and write positions run from 0 to 2 * NumItems - 1, so a
+  full queue can be told apart from an empty one without wasting a slot.
+  Each position and counter has exactly one writer, no locking is required.
+  Events which do not fit are counted, see HID_QUEUE_GetStat().
+
+  A consumer of several producers, for example one queue per keyboard
+  interface, creates all queues with the same task event and takes
+  the events through a HID_QUEUE_MUX:
+
+    HID_QUEUE_MUX_Wait(&Mux);
+    while ((Index = HID_QUEUE_MUX_Get(&Mux, &Event)) >= 0) {
+      ...                                  // Event of queue papQueue[Index].
+    }
+
+  The multiplexer takes one event per queue in turn, so a device which
+  sends a burst of reports cannot hold back the events of the others.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <string.h>
+#include "RTOS.h"
+#include "SEGGER.h"
+#include "HID_QUEUE.h"
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+//
+// Keeps the compiler from moving the copy of an event behind the
+// update of the position which hands the slot to the other task.
+//
+#if defined(__GNUC__) || defined(__clang__)
+  #define COMPILER_BARRIER()  __asm volatile ("" : : : "memory")
+#else
+  #define COMPILER_BARRIER()
+#endif
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _GetNumUsed
+*/
+static U32 _GetNumUsed(const HID_QUEUE * pQueue, U32 WrPos, U32 RdPos) {
+  return (WrPos >= RdPos) ? (WrPos - RdPos) : (WrPos + 2u * pQueue->NumItems - RdPos);
+}
+
+/*********************************************************************
+*
+*       _GetItem
+*
+*  Function description
+*    Returns the address of the slot of a read or write position.
+*/
+static U8 * _GetItem(const HID_QUEUE * pQueue, U32 Pos) {
+  if (Pos >= pQueue->NumItems) {
+    Pos -= pQueue->NumItems;
+  }
+  return pQueue->pData + Pos * pQueue->ItemSize;
+}
+
+/*********************************************************************
+*
+*       _IncPos
+*/
+static U32 _IncPos(const HID_QUEUE * pQueue, U32 Pos) {
+  Pos++;
+  if (Pos == 2u * pQueue->NumItems) {
+    Pos = 0;
+  }
+  return Pos;
+}
+
+/*********************************************************************
+*
+*       _IsMuxEmpty
+*/
+static int _IsMuxEmpty(const HID_QUEUE_MUX * pMux) {
+  const HID_QUEUE * pQueue;
+  unsigned          i;
+
+  for (i = 0; i < pMux->NumQueues; i++) {
+    pQueue = pMux->papQueue[i];
+    if (pQueue->RdPos != pQueue->WrPos) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_QUEUE_Create
+*
+*  Function description
+*    Initializes a queue. Has to be called by the consumer task.
+*
+*  Parameters
+*    pQueue   : Queue to initialize.
+*    pBuffer  : Memory for ItemSize * NumItems bytes.
+*    ItemSize : Size of one event in bytes.
+*    NumItems : Number of events the queue can hold.
+*    Event    : Task event of the consumer task used by the queue.
+*/
+void HID_QUEUE_Create(HID_QUEUE * pQueue, void * pBuffer, unsigned ItemSize, unsigned NumItems, OS_TASKEVENT Event) {
+  memset(pQueue, 0, sizeof(*pQueue));
+  pQueue->pData    = (U8 *)pBuffer;
+  pQueue->ItemSize = ItemSize;
+  pQueue->NumItems = NumItems;
+  pQueue->Event    = Event;
+  pQueue->pTask    = OS_GetTaskID();
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_Put
+*
+*  Function description
+*    Appends an event. Called by the producer, never blocks.
+*
+*  Return value
+*    1: Event queued.
+*    0: Queue full, event dropped.
+*/
+int HID_QUEUE_Put(HID_QUEUE * pQueue, const void * pItem) {
+  U32 WrPos;
+  U32 NumUsed;
+
+  WrPos   = pQueue->WrPos;
+  NumUsed = _GetNumUsed(pQueue, WrPos, pQueue->RdPos);
+  if (NumUsed >= pQueue->NumItems) {
+    pQueue->NumDropped++;
+    return 0;
+  }
+  memcpy(_GetItem(pQueue, WrPos), pItem, pQueue->ItemSize);
+  COMPILER_BARRIER();
+  pQueue->WrPos = _IncPos(pQueue, WrPos); // Publish the event.
+  pQueue->NumPut++;
+  NumUsed++;
+  if (NumUsed > pQueue->MaxUsed) {
+    pQueue->MaxUsed = NumUsed;
+  }
+  //
+  // The consumer only waits when it has found the queue empty,
+  // so it has to be woken up for the first event of a batch only.
+  //
+  if (NumUsed == 1u) {
+    OS_TASKEVENT_Set(pQueue->pTask, pQueue->Event);
+  }
+  return 1;
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_IsFull
+*
+*  Function description
+*    Checks whether HID_QUEUE_Put() would fail. Called by the producer,
+*    which can hold back an event instead of having it counted as dropped.
+*/
+int HID_QUEUE_IsFull(const HID_QUEUE * pQueue) {
+  return (_GetNumUsed(pQueue, pQueue->WrPos, pQueue->RdPos) >= pQueue->NumItems) ? 1 : 0;
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_Get
+*
+*  Function description
+*    Takes the oldest event. Called by the consumer, never blocks.
+*
+*  Return value
+*    1: Event copied to pItem.
+*    0: Queue empty.
+*/
+int HID_QUEUE_Get(HID_QUEUE * pQueue, void * pItem) {
+  U32 RdPos;
+
+  RdPos = pQueue->RdPos;
+  if (RdPos == pQueue->WrPos) {
+    return 0;
+  }
+  memcpy(pItem, _GetItem(pQueue, RdPos), pQueue->ItemSize);
+  COMPILER_BARRIER();
+  pQueue->RdPos = _IncPos(pQueue, RdPos); // Frees the slot for the producer.
+  return 1;
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_Wait
+*
+*  Function description
+*    Suspends the consumer task until the queue is not empty
+*    or HID_QUEUE_Wakeup() has been called.
+*
+*  Additional information
+*    May also return with the queue empty when the task event was
+*    still set from an event which has already been taken. The
+*    consumer takes events with HID_QUEUE_Get() until it returns 0
+*    anyway, so this only costs one more pass.
+*/
+void HID_QUEUE_Wait(HID_QUEUE * pQueue) {
+  if (pQueue->RdPos == pQueue->WrPos) {
+    OS_TASKEVENT_GetBlocked(pQueue->Event);
+  }
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_WaitTimed
+*
+*  Function description
+*    Suspends the consumer task until the queue is not empty,
+*    HID_QUEUE_Wakeup() has been called or the timeout has expired.
+*
+*  Parameters
+*    pQueue  : Queue to wait for.
+*    Timeout : Maximum time to wait in ticks (ms).
+*
+*  Return value
+*    1: Queue not empty.
+*    0: Timeout.
+*/
+int HID_QUEUE_WaitTimed(HID_QUEUE * pQueue, OS_TIME Timeout) {
+  if (pQueue->RdPos == pQueue->WrPos) {
+    OS_TASKEVENT_GetTimed(pQueue->Event, Timeout);
+  }
+  return (pQueue->RdPos != pQueue->WrPos) ? 1 : 0;
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_Wakeup
+*
+*  Function description
+*    Resumes the consumer task waiting in HID_QUEUE_Wait() without
+*    queuing an event, for example because the producer has data
+*    which it holds back.
+*/
+void HID_QUEUE_Wakeup(HID_QUEUE * pQueue) {
+  OS_TASKEVENT_Set(pQueue->pTask, pQueue->Event);
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_GetStat
+*
+*  Function description
+*    Returns the counters of a queue.
+*/
+void HID_QUEUE_GetStat(const HID_QUEUE * pQueue, HID_QUEUE_STAT * pStat) {
+  pStat->NumPut     = pQueue->NumPut;
+  pStat->NumDropped = pQueue->NumDropped;
+  pStat->MaxUsed    = pQueue->MaxUsed;
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_MUX_Create
+*
+*  Function description
+*    Initializes a multiplexer. Has to be called by the consumer task
+*    after all queues have been created with the same task event.
+*
+*  Parameters
+*    pMux      : Multiplexer to initialize.
+*    papQueue  : Queues served, has to remain valid.
+*    NumQueues : Number of entries in papQueue, at least 1.
+*/
+void HID_QUEUE_MUX_Create(HID_QUEUE_MUX * pMux, HID_QUEUE * const * papQueue, unsigned NumQueues) {
+  pMux->papQueue  = papQueue;
+  pMux->NumQueues = NumQueues;
+  pMux->NextQueue = 0;
+  pMux->Event     = papQueue[0]->Event;
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_MUX_Get
+*
+*  Function description
+*    Takes the oldest event of the next queue in turn which is not
+*    empty. Called by the consumer, never blocks.
+*
+*  Return value
+*    >= 0: Event copied to pItem, index of the queue in papQueue.
+*    <  0: All queues empty.
+*/
+int HID_QUEUE_MUX_Get(HID_QUEUE_MUX * pMux, void * pItem) {
+  unsigned Index;
+  unsigned i;
+
+  Index = pMux->NextQueue;
+  for (i = 0; i < pMux->NumQueues; i++) {
+    if (HID_QUEUE_Get(pMux->papQueue[Index], pItem)) {
+      pMux->NextQueue = (Index + 1u < pMux->NumQueues) ? Index + 1u : 0u;
+      return (int)Index;
+    }
+    Index = (Index + 1u < pMux->NumQueues) ? Index + 1u : 0u;
+  }
+  return -1;
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_MUX_Wait
+*
+*  Function description
+*    Suspends the consumer task until one of the queues is not empty
+*    or HID_QUEUE_Wakeup() has been called for one of them.
+*/
+void HID_QUEUE_MUX_Wait(HID_QUEUE_MUX * pMux) {
+  if (_IsMuxEmpty(pMux)) {
+    OS_TASKEVENT_GetBlocked(pMux->Event);
+  }
+}
+
+/*********************************************************************
+*
+*       HID_QUEUE_MUX_WaitTimed
+*
+*  Function description
+*    Suspends the consumer task until one of the queues is not empty,
+*    HID_QUEUE_Wakeup() has been called or the timeout has expired.
+*
+*  Return value
+*    1: A queue is not empty.
+*    0: Timeout.
+*/
+int HID_QUEUE_MUX_WaitTimed(HID_QUEUE_MUX * pMux, OS_TIME Timeout) {
+  if (_IsMuxEmpty(pMux)) {
+    OS_TASKEVENT_GetTimed(pMux->Event, Timeout);
+  }
+  return _IsMuxEmpty(pMux) ? 0 : 1;
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,339 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_REPLAY.c
+Purpose : Replay of recorded or synthetic keyboard and mouse reports
+          into the HID callbacks of the sample applications.
+          Used to size the HID event queue (MAX_DATA_ITEMS) and the task
+          priorities for devices which send bursts of reports, such
+          as barcode scanners.
+
+Additional information:
+  Enable with USE_HID_REPLAY=1 in the preprocessor definitions of the
+  project. MainTask then starts the replay once its event queue exists.
+  A dedicated task calls the keyboard and mouse callbacks of the
+  application for each simulated device in a 1 ms raster, exactly as
+  USBH_Task does for real devices. The application reports queue
+  failures with HID_REPLAY_OnDropped() and passes the timestamp taken
+  in the callback to HID_REPLAY_OnReceived() after dequeuing.
+  An application which merges mouse reports calls HID_REPLAY_OnCoalesced()
+  for each report merged into another one and HID_REPLAY_OnMotion() for
+  each mouse event it processes, the sums of the movement sent and
+  received have to match.
+  Each counter has exactly one writer task, no locking is required.
+
+  Sample output:
+    5:131 HID_Replay - REPLAY 4 devices @ 1000 reports/s: 8000 sent, 12 dropped, 7988 received in 2000 ms
+    5:131 HID_Replay - REPLAY latency: min 21 us, avg 318 us, max 2040 us
+    5:131 HID_Replay - REPLAY mouse: 3600 coalesced, sent x 0 y 0 wheel 0, received x 0 y 0 wheel 0
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include "RTOS.h"
+#include "USBH.h"
+#include "USBH_HID.h"
+#include "SEGGER.h"
+#include "HID_REPLAY.h"
+#include "HID_LAT.h"
+
+/*********************************************************************
+*
+*       Defines configurable
+*
+**********************************************************************
+*/
+#define REPLAY_STACK_SIZE       1536
+#define REPLAY_DRAIN_TIMEOUT    1000    // Time [ms] the application gets to dequeue the last reports.
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define KEY_CODE_A              0x04
+#define NUM_LETTERS             26u
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static OS_STACKPTR int    _StackReplay[REPLAY_STACK_SIZE/sizeof(int)];
+static OS_TASK            _TCBReplay;
+static HID_REPLAY_CONFIG  _Config;
+static HID_REPLAY_STAT    _Stat;
+static U64                _LatencySum_us;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _SendKeyboard
+*/
+static void _SendKeyboard(unsigned Device, unsigned Code, unsigned Value) {
+  USBH_HID_KEYBOARD_DATA KeyData;
+
+  if (_Config.pfOnKeyboard != NULL) {
+    KeyData.Code        = Code;
+    KeyData.Value       = Value;
+    KeyData.InterfaceID = HID_REPLAY_INTERFACE_ID_BASE + Device;
+    _Stat.NumSent++;
+#if USE_HID_LAT
+    HID_LAT_OnIRQ();                    // No interrupt, the report starts here.
+#endif
+    _Config.pfOnKeyboard(&KeyData);
+  }
+}
+
+/*********************************************************************
+*
+*       _SendMouse
+*/
+static void _SendMouse(unsigned Device, int xChange, int yChange, int WheelChange, int ButtonState) {
+  USBH_HID_MOUSE_DATA MouseData;
+
+  if (_Config.pfOnMouse != NULL) {
+    MouseData.xChange     = xChange;
+    MouseData.yChange     = yChange;
+    MouseData.WheelChange = WheelChange;
+    MouseData.ButtonState = ButtonState;
+    MouseData.InterfaceID = HID_REPLAY_INTERFACE_ID_BASE + Device;
+    _Stat.NumSent++;
+    _Stat.xSent          += xChange;
+    _Stat.ySent          += yChange;
+    _Stat.WheelSent      += WheelChange;
+#if USE_HID_LAT
+    HID_LAT_OnIRQ();
+#endif
+    _Config.pfOnMouse(&MouseData);
+  }
+}
+
+/*********************************************************************
+*
+*       _SendReport
+*
+*  Function description
+*    Sends report number Index of one simulated device.
+*/
+static void _SendReport(unsigned Device, U32 Index) {
+  const HID_REPLAY_ITEM * pItem;
+  int                     Step;
+
+  if (_Config.paItem != NULL) {
+    pItem = &_Config.paItem[Index % _Config.NumItems];
+    if (pItem->Type == HID_REPLAY_TYPE_MOUSE) {
+      _SendMouse(Device, pItem->xChange, pItem->yChange, pItem->WheelChange, pItem->Code);
+    } else {
+      _SendKeyboard(Device, pItem->Code, pItem->Value);
+    }
+  } else if ((_Config.MouseRatio != 0u) && ((Device % _Config.MouseRatio) == 0u)) {
+    //
+    // Zigzag with a drift to the right, a wheel step and a button change every 64 reports.
+    //
+    Step = (Index & 1u) ? -1 : 1;
+    _SendMouse(Device, Step + 1, Step, ((Index & 63u) == 0u) ? 1 : 0, (int)((Index >> 6) & 1u));
+  } else {
+    //
+    // Press and release the letter keys in turn, each device starts at a different letter.
+    //
+    _SendKeyboard(Device, KEY_CODE_A + (((Index >> 1) + Device) % NUM_LETTERS), (Index & 1u) ^ 1u);
+  }
+}
+
+/*********************************************************************
+*
+*       _ReplayTask
+*/
+static void _ReplayTask(void) {
+  HID_REPLAY_STAT Stat;
+  OS_TIME         t;
+  U32             t0;
+  U32             Index;
+  unsigned        Acc;
+  unsigned        Device;
+  int             i;
+
+  Index = 0;
+  Acc   = 0;
+  t     = (OS_TIME)OS_GetTime32();
+  t0    = (U32)t;
+  while (Index < _Config.NumReports) {
+    //
+    // Distribute the reports evenly over the 1 ms raster.
+    //
+    Acc += _Config.ReportsPerSec;
+    while ((Acc >= 1000u) && (Index < _Config.NumReports)) {
+      for (Device = 0; Device < _Config.NumDevices; Device++) {
+        _SendReport(Device, Index);
+      }
+      Index++;
+      Acc -= 1000u;
+    }
+    t++;
+    OS_DelayUntil(t);
+  }
+  _Stat.Duration_ms = OS_GetTime32() - t0;
+  for (i = 0; i < REPLAY_DRAIN_TIMEOUT; i++) {
+    if (_Stat.NumReceived + _Stat.NumDropped + _Stat.NumCoalesced >= _Stat.NumSent) {
+      break;
+    }
+    OS_Delay(1);
+  }
+  HID_REPLAY_GetStat(&Stat);
+  USBH_Logf_Application("REPLAY %u devices @ %u reports/s: %u sent, %u dropped, %u received in %u ms",
+                        _Config.NumDevices, _Config.ReportsPerSec, Stat.NumSent, Stat.NumDropped, Stat.NumReceived, Stat.Duration_ms);
+  USBH_Logf_Application("REPLAY latency: min %u us, avg %u us, max %u us", Stat.LatencyMin_us, Stat.LatencyAvg_us, Stat.LatencyMax_us);
+  if (_Config.pfOnMouse != NULL) {
+    USBH_Logf_Application("REPLAY mouse: %u coalesced, sent x %d y %d wheel %d, received x %d y %d wheel %d", Stat.NumCoalesced,
+                          Stat.xSent, Stat.ySent, Stat.WheelSent, Stat.xReceived, Stat.yReceived, Stat.WheelReceived);
+  }
+  OS_TerminateTask(NULL);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_REPLAY_Start
+*
+*  Function description
+*    Starts a replay run in a separate task.
+*
+*  Parameters
+*    pConfig : Describes the run. Copied, need not remain valid.
+*/
+void HID_REPLAY_Start(const HID_REPLAY_CONFIG * pConfig) {
+  _Config = *pConfig;
+  if (_Config.NumDevices > HID_REPLAY_MAX_DEVICES) {
+    _Config.NumDevices = HID_REPLAY_MAX_DEVICES;
+  }
+  if (_Config.ReportsPerSec > 1000u) {
+    _Config.ReportsPerSec = 1000u;
+  }
+  if (_Config.NumItems == 0u) {
+    _Config.paItem = NULL;
+  }
+  _Stat.NumSent       = 0;
+  _Stat.NumDropped    = 0;
+  _Stat.NumReceived   = 0;
+  _Stat.LatencyMin_us = 0xFFFFFFFFu;
+  _Stat.LatencyMax_us = 0;
+  _Stat.Duration_ms   = 0;
+  _Stat.NumCoalesced  = 0;
+  _Stat.xSent         = 0;
+  _Stat.ySent         = 0;
+  _Stat.WheelSent     = 0;
+  _Stat.xReceived     = 0;
+  _Stat.yReceived     = 0;
+  _Stat.WheelReceived = 0;
+  _LatencySum_us      = 0;
+  OS_CREATETASK(&_TCBReplay, "HID_Replay", _ReplayTask, _Config.TaskPrio, _StackReplay);
+}
+
+/*********************************************************************
+*
+*       HID_REPLAY_GetTimestamp
+*
+*  Function description
+*    Returns the timestamp to be stored with a queued report.
+*/
+U32 HID_REPLAY_GetTimestamp(void) {
+  return OS_GetTime_Cycles();
+}
+
+/*********************************************************************
+*
+*       HID_REPLAY_OnDropped
+*
+*  Function description
+*    Called from the HID callback when a report could not be queued.
+*/
+void HID_REPLAY_OnDropped(void) {
+  _Stat.NumDropped++;
+}
+
+/*********************************************************************
+*
+*       HID_REPLAY_OnReceived
+*
+*  Function description
+*    Called by the application after a report has been dequeued.
+*
+*  Parameters
+*    Timestamp : Value of HID_REPLAY_GetTimestamp() taken in the callback.
+*/
+void HID_REPLAY_OnReceived(U32 Timestamp) {
+  U32 Latency;
+
+  Latency = OS_ConvertCycles2us(OS_GetTime_Cycles() - Timestamp);
+  if (Latency < _Stat.LatencyMin_us) {
+    _Stat.LatencyMin_us = Latency;
+  }
+  if (Latency > _Stat.LatencyMax_us) {
+    _Stat.LatencyMax_us = Latency;
+  }
+  _LatencySum_us += Latency;
+  _Stat.NumReceived++;
+}
+
+/*********************************************************************
+*
+*       HID_REPLAY_OnCoalesced
+*
+*  Function description
+*    Called from the HID callback when a mouse report has been merged
+*    into a report which is still pending.
+*/
+void HID_REPLAY_OnCoalesced(void) {
+  _Stat.NumCoalesced++;
+}
+
+/*********************************************************************
+*
+*       HID_REPLAY_OnMotion
+*
+*  Function description
+*    Called by the application for each mouse event it processes.
+*/
+void HID_REPLAY_OnMotion(int xChange, int yChange, int WheelChange) {
+  _Stat.xReceived     += xChange;
+  _Stat.yReceived     += yChange;
+  _Stat.WheelReceived += WheelChange;
+}
+
+/*********************************************************************
+*
+*       HID_REPLAY_GetStat
+*
+*  Function description
+*    Returns the result of the current or last replay run.
+*/
+void HID_REPLAY_GetStat(HID_REPLAY_STAT * pStat) {
+  *pStat = _Stat;
+  if (pStat->NumReceived != 0u) {
+    pStat->LatencyAvg_us = (U32)(_LatencySum_us / pStat->NumReceived);
+  } else {
+    pStat->LatencyMin_us = 0;
+    pStat->LatencyAvg_us = 0;
+  }
+}
+
+/*************************** End of file ****************************/
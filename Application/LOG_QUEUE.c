@@ -0,0 +1,310 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : LOG_QUEUE.c
+Purpose : Log queue which decouples the log output of emUSB-Host
+          and the application from the terminal I/O.
+
+Additional information:
+  Enable with USE_LOG_QUEUE=1 in the preprocessor definitions of the
+  project. USBH_Log() and USBH_Warn() in USBH_ConfigIO.c then only copy
+  the complete line into a ring buffer and return, a task with priority
+  LOG_QUEUE_TASK_PRIO outputs the queued lines to LOG_QUEUE_SINK.
+  Terminal I/O via semihosting halts the CPU for every character,
+  with the queue this no longer happens in USBH_Task, USBH_isr or
+  MainTask but only when no other task is ready.
+
+  Interrupts are disabled only while a line is copied into the queue.
+  A line which does not fit is dropped as a whole and counted, the
+  producer never waits for the output. The drain task reports the
+  number of dropped lines as soon as there is room again:
+    *** Log queue overflow: 12 lines (734 bytes) dropped
+  The drain task is the only reader, so it updates the read offset
+  without locking. It is woken up with a task event only when the
+  queue changes from empty to non-empty.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <stdio.h>
+#include <string.h>
+#include "RTOS.h"
+#include "SEGGER.h"
+#include "LOG_QUEUE.h"
+#if (LOG_QUEUE_SINK == LOG_QUEUE_SINK_RTT)
+  #include "SEGGER_RTT.h"
+#endif
+
+#if USE_LOG_QUEUE
+
+/*********************************************************************
+*
+*       Defines configurable
+*
+**********************************************************************
+*/
+#define DRAIN_STACK_SIZE        512
+#define CHUNK_SIZE              64u     // Maximum number of bytes passed to the sink at once.
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define EVENT_DATA              (1u << 0)
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static OS_STACKPTR int    _StackDrain[DRAIN_STACK_SIZE/sizeof(int)];
+static OS_TASK            _TCBDrain;
+static char               _acQueue[LOG_QUEUE_SIZE];
+static volatile unsigned  _WrOff;       // Written by the producers with interrupts disabled.
+static volatile unsigned  _RdOff;       // Written by the drain task only.
+static LOG_QUEUE_STAT     _Stat;
+static U32                _NumLinesReported;
+static U32                _NumBytesReported;
+static char               _IsRunning;
+#if (LOG_QUEUE_SINK == LOG_QUEUE_SINK_EMBOSVIEW)
+static char               _acChunk[CHUNK_SIZE + 1u];
+#endif
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _Output
+*
+*  Function description
+*    Passes a chunk of the queue to the sink. Waits until the sink
+*    has accepted it, only the drain task is delayed by this.
+*/
+static void _Output(const char * p, unsigned NumBytes) {
+#if (LOG_QUEUE_SINK == LOG_QUEUE_SINK_RTT)
+  unsigned NumBytesWritten;
+
+  while (NumBytes != 0u) {
+    NumBytesWritten = SEGGER_RTT_Write(0, p, NumBytes);
+    if (NumBytesWritten == 0u) {
+      OS_Delay(1);                      // Terminal buffer full, wait for the host to read.
+    }
+    p        += NumBytesWritten;
+    NumBytes -= NumBytesWritten;
+  }
+#elif (LOG_QUEUE_SINK == LOG_QUEUE_SINK_EMBOSVIEW)
+  memcpy(_acChunk, p, NumBytes);
+  _acChunk[NumBytes] = 0;
+  OS_COM_SendString(_acChunk);
+#else
+  while (NumBytes--) {
+    putchar(*p++);
+  }
+#endif
+}
+
+/*********************************************************************
+*
+*       _Drain
+*
+*  Function description
+*    Outputs everything in the queue.
+*/
+static void _Drain(void) {
+  unsigned RdOff;
+  unsigned WrOff;
+  unsigned NumBytes;
+
+  RdOff = _RdOff;
+  for (;;) {
+    WrOff = _WrOff;
+    if (RdOff == WrOff) {
+      break;
+    }
+    NumBytes = (WrOff > RdOff) ? (WrOff - RdOff) : (LOG_QUEUE_SIZE - RdOff);
+    if (NumBytes > CHUNK_SIZE) {
+      NumBytes = CHUNK_SIZE;
+    }
+    _Output(&_acQueue[RdOff], NumBytes);
+    RdOff += NumBytes;
+    if (RdOff == LOG_QUEUE_SIZE) {
+      RdOff = 0;
+    }
+    _RdOff = RdOff;                     // Frees the space for the producers.
+  }
+}
+
+/*********************************************************************
+*
+*       _ReportDropped
+*
+*  Function description
+*    Outputs a line when lines have been dropped since the last report.
+*/
+static void _ReportDropped(void) {
+  char ac[80];
+  U32  NumLines;
+  U32  NumBytes;
+
+  OS_IncDI();
+  NumLines = _Stat.NumDroppedLines;
+  NumBytes = _Stat.NumDroppedBytes;
+  OS_DecRI();
+  if (NumLines != _NumLinesReported) {
+    SEGGER_snprintf(ac, sizeof(ac), "*** Log queue overflow: %u lines (%u bytes) dropped\n", NumLines - _NumLinesReported, NumBytes - _NumBytesReported);
+    _NumLinesReported = NumLines;
+    _NumBytesReported = NumBytes;
+    _Output(ac, (unsigned)strlen(ac));
+  }
+}
+
+/*********************************************************************
+*
+*       _DrainTask
+*/
+static void _DrainTask(void) {
+  for (;;) {
+    OS_TASKEVENT_GetBlocked(EVENT_DATA);
+    _Drain();
+    _ReportDropped();
+  }
+}
+
+#endif
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       LOG_QUEUE_Init
+*
+*  Function description
+*    Creates the drain task. Log lines written before are output
+*    directly by USBH_ConfigIO.c.
+*/
+void LOG_QUEUE_Init(void) {
+#if USE_LOG_QUEUE
+  if (_IsRunning == 0) {
+    OS_CREATETASK(&_TCBDrain, "LogQueue", _DrainTask, LOG_QUEUE_TASK_PRIO, _StackDrain);
+    _IsRunning = 1;
+  }
+#endif
+}
+
+/*********************************************************************
+*
+*       LOG_QUEUE_Write
+*
+*  Function description
+*    Queues a line. Never waits, may be called from any task.
+*
+*  Parameters
+*    pasPart  : Strings which are concatenated to form the line.
+*    NumParts : Number of strings.
+*
+*  Return value
+*    > 0: Number of bytes queued.
+*    = 0: Queue full, the line has been dropped.
+*    < 0: Queue not running, the caller has to output the line itself.
+*/
+int LOG_QUEUE_Write(const char * const * pasPart, unsigned NumParts) {
+#if USE_LOG_QUEUE
+  unsigned aLen[4];
+  unsigned NumBytes;
+  unsigned NumBytesFree;
+  unsigned NumBytesUsed;
+  unsigned WrOff;
+  unsigned RdOff;
+  unsigned Len;
+  unsigned i;
+  unsigned n;
+  int      WasEmpty;
+
+  if ((_IsRunning == 0) || (NumParts > SEGGER_COUNTOF(aLen))) {
+    return -1;
+  }
+  NumBytes = 0;
+  for (i = 0; i < NumParts; i++) {
+    aLen[i]   = (unsigned)strlen(pasPart[i]);
+    NumBytes += aLen[i];
+  }
+  OS_IncDI();
+  WrOff = _WrOff;
+  RdOff = _RdOff;
+  NumBytesUsed = (WrOff >= RdOff) ? (WrOff - RdOff) : (LOG_QUEUE_SIZE - RdOff + WrOff);
+  NumBytesFree = LOG_QUEUE_SIZE - 1u - NumBytesUsed;
+  if (NumBytes > NumBytesFree) {
+    _Stat.NumDroppedLines++;
+    _Stat.NumDroppedBytes += NumBytes;
+    OS_DecRI();
+    return 0;
+  }
+  WasEmpty = (NumBytesUsed == 0u);
+  for (i = 0; i < NumParts; i++) {
+    Len = aLen[i];
+    while (Len != 0u) {
+      n = LOG_QUEUE_SIZE - WrOff;
+      if (n > Len) {
+        n = Len;
+      }
+      memcpy(&_acQueue[WrOff], pasPart[i] + (aLen[i] - Len), n);
+      Len   -= n;
+      WrOff += n;
+      if (WrOff == LOG_QUEUE_SIZE) {
+        WrOff = 0;
+      }
+    }
+  }
+  _WrOff = WrOff;
+  NumBytesUsed += NumBytes;
+  if (NumBytesUsed > _Stat.MaxUsed) {
+    _Stat.MaxUsed = NumBytesUsed;
+  }
+  _Stat.NumLines++;
+  OS_DecRI();
+  if (WasEmpty) {
+    OS_TASKEVENT_Set(&_TCBDrain, EVENT_DATA);
+  }
+  return (int)NumBytes;
+#else
+  SEGGER_USE_PARA(pasPart);
+  SEGGER_USE_PARA(NumParts);
+  return -1;
+#endif
+}
+
+/*********************************************************************
+*
+*       LOG_QUEUE_GetStat
+*
+*  Function description
+*    Returns the counters of the log queue.
+*/
+void LOG_QUEUE_GetStat(LOG_QUEUE_STAT * pStat) {
+#if USE_LOG_QUEUE
+  OS_IncDI();
+  *pStat = _Stat;
+  OS_DecRI();
+#else
+  memset(pStat, 0, sizeof(*pStat));
+#endif
+}
+
+/*************************** End of file ****************************/
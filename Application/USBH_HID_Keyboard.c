@@ -35,7 +35,8 @@ Purpose : This sample is designed to present emUSBH's capability to
           to the terminal.
           Message will be shown once the ENTER key was pressed.
           Barcode scanners normally terminate their scan operation
-          with an enter key press
+          with an enter key press. For scanners without it, set
+          SCAN_TIMEOUT to end a scan after a gap between characters.
 
 Additional information:
   Preparations:
@@ -51,7 +52,35 @@ Additional information:
     <...>
     00000001:040 USBH_Task    - **** Device added [0]
 
-    00000006:881 MainTask     - The following message was entered: www.segger.com
+    00000006:881 ScanTask     - The following message was entered on interface 1: www.segger.com
+
+  Keyboard reports:
+    With USE_KEYBOARD_REPORTS=1, the sample does not register a keyboard
+    callback but reads the 8-byte boot protocol reports of each keyboard
+    with USBH_HID_GetReport(). Every report which differs from the previous
+    one is passed to MainTask as a single HID_BOOT_KBD_DELTA instead of
+    one event per key change.
+
+  Multiple keyboards:
+    Each keyboard or scanner interface, for example up to MAX_KEYBOARDS
+    scanners behind a hub, gets its own slot with event queue, key state,
+    keymap state and scan assembly. The slot is assigned when the device
+    is added and freed by MainTask when it is removed. MainTask takes the
+    events of all queues in turn, so scans of different devices never mix
+    and a scanner sending a long code cannot hold back the others.
+
+  Keyboard LEDs:
+    LED updates are off by default. Set USE_KEYBOARD_LEDS to 1 to let
+    Caps, Num and Scroll Lock toggle the LEDs of the keyboard. MainTask
+    only records the new state, the task "HID_LED" (Application/HID_LED.c)
+    sends it at most once per HID_LED_INTERVAL ms per keyboard, one
+    transfer at a time.
+
+  Latency:
+    With USE_HID_LAT=1, each keyboard event carries the time of the USB
+    interrupt and of the callback. MainTask counts the latency of each
+    stage in a histogram (Application/HID_LAT.c) and outputs the
+    histograms when a key is sent on the RTT terminal.
 */
 
 /*********************************************************************
@@ -60,11 +89,21 @@ Additional information:
 *
 **********************************************************************
 */
+#include <string.h>
 #include "RTOS.h"
 #include "BSP.h"
 #include "USBH.h"
 #include "USBH_HID.h"
 #include "SEGGER.h"
+#include "BENCH.h"
+#include "HID_REPLAY.h"
+#include "HID_QUEUE.h"
+#include "HID_BOOT_KBD.h"
+#include "BARCODE.h"
+#include "HID_KEYMAP.h"
+#include "HID_LAT.h"
+#include "HID_LED.h"
+#include "BINLOG.h"
 #include "stm32f4xx_hal.h"
 
 /*********************************************************************
@@ -73,9 +112,26 @@ Additional information:
 *
 **********************************************************************
 */
-#define MAX_DATA_ITEMS        10
-#define KEY_BUFFER_SIZE       10
-#define MESSAGE_BUFFER_SIZE   256
+#define MAX_DATA_ITEMS        10        // Events queued per keyboard.
+#define MAX_KEYBOARDS         8         // Keyboards and scanners served at the same time, for example behind a hub.
+#define MAX_HID_DEVICES       16        // HID interfaces looked up when a device is added.
+#define KEYBOARD_LAYOUT       HID_KEYMAP_US   // HID_KEYMAP_US, _DE or _FR, HID_KEYMAP_SetLayout() selects the layout per interface.
+#ifndef   SCAN_TIMEOUT
+  #define SCAN_TIMEOUT        0         // Gap between two characters in ms which ends a scan, for example 50 for scanners without Enter suffix.
+#endif                                  // 0 ends scans with Enter only, so messages can also be typed on a keyboard.
+#define SCAN_PREFIX           NULL      // Removed from the start of each scan, for example "]Q2" (AIM symbology identifier).
+#define SCAN_SUFFIX           NULL      // Removed from the end of each scan.
+#define SCAN_DISPLAY_SIZE     80        // Characters of a scan shown on the terminal.
+#define LAT_POLL_INTERVAL     100       // With USE_HID_LAT, time in ms after which MainTask checks for a key on the RTT terminal.
+
+#ifndef   USE_KEYBOARD_REPORTS
+  #define USE_KEYBOARD_REPORTS  0       // Set to 1 to read boot protocol reports instead of using the keyboard callback.
+#endif
+#define MAX_READ_ERRORS       8         // With USE_KEYBOARD_REPORTS, failed reads in a row after which a keyboard is no longer read.
+
+#ifndef   USE_KEYBOARD_LEDS
+  #define USE_KEYBOARD_LEDS     0       // Set to 1 to update the Caps, Num and Scroll Lock LEDs of the keyboards, see HID_LED.c.
+#endif
 
 /*********************************************************************
 *
@@ -83,9 +139,19 @@ Additional information:
 *
 **********************************************************************
 */
-#define KEY_VALUE_SHIFT_LEFT        0xE1
-#define KEY_VALUE_SHIFT_RIGHT       0xE5
 #define BEGIN_OF_VALID_KEYS         0x04
+#define TASK_EVENT_HID              (1u << 0)   // Task event of MainTask signaled by the queues of all keyboards.
+#define NUM_KEY_CODES               256u
+#define KEY_CODE_MODIFIER_FIRST     0xE0        // LeftControl, modifier keys are reported as 0xE0..0xE7.
+#define KEY_CODE_MODIFIER_LAST      0xE7        // Right GUI
+#define MODIFIER_MASK(Code)         (1u << ((Code) - KEY_CODE_MODIFIER_FIRST))
+#define KEY_CODE_CAPS_LOCK          0x39
+#define KEY_CODE_SCROLL_LOCK        0x47
+#define KEY_CODE_NUM_LOCK           0x53
+#define DEV_INDEX_NONE              0xFFu       // Interface without device, for example a replayed one.
+#define KEYBOARD_FREE               0u          // Slot unused, set by MainTask.
+#define KEYBOARD_ACTIVE             1u          // Slot assigned to an interface, set by USBH_Task.
+#define KEYBOARD_REMOVED            2u          // Device removed, set by USBH_Task. MainTask frees the slot.
 
 /*********************************************************************
 *
@@ -94,89 +160,64 @@ Additional information:
 **********************************************************************
 */
 enum {
-  TASK_PRIO_APP = 150,
+  TASK_PRIO_SCAN = 149,
+  TASK_PRIO_APP,
   TASK_PRIO_USBH_MAIN,
   TASK_PRIO_USBH_ISR
 };
 
 typedef struct {
-  U8  Char;
-  U8  UpperCaseChar;
-} SCANCODE_TO_CHAR;
+#if USE_KEYBOARD_REPORTS
+  HID_BOOT_KBD_DELTA      Delta;
+#else
+  USBH_HID_KEYBOARD_DATA  Data;
+#endif
+#if USE_HID_REPLAY
+  U32                     Timestamp;
+#endif
+#if USE_HID_LAT
+  HID_LAT_STAMP           Lat;
+#endif
+} KEYBOARD_EVENT;
 
-typedef struct _KEY_BUFFER {
-  U8 Code;
-  U8 ShiftState;
-} KEY_BUFFER;
+//
+// One keyboard or scanner interface. State, DevIndex, InterfaceID and
+// IsAdded are written by USBH_Task while the slot is free, everything
+// else belongs to MainTask.
+//
+typedef struct {
+  volatile U8             State;                              // KEYBOARD_FREE, KEYBOARD_ACTIVE or KEYBOARD_REMOVED.
+  U8                      DevIndex;
+  U8                      IsAdded;                            // Assigned by USBH_Task, not yet started by MainTask.
+  U8                      Modifiers;                          // Modifier keys currently pressed, bit n is scan code 0xE0 + n.
+  USBH_INTERFACE_ID       InterfaceID;
+  HID_QUEUE               Queue;
+  KEYBOARD_EVENT          aEvent[MAX_DATA_ITEMS];
+  U32                     NumDroppedReported;
+  BARCODE_ASM             Barcode;
+  const HID_KEYMAP_LAYOUT * pLayout;                          // Layout of the interface, looked up by _StartKeyboard().
+  HID_KEYMAP_STATE        KeymapState;                        // Dead key typed last.
+  U32                     aKeyPressed[NUM_KEY_CODES / 32u];   // One bit per scan code.
+  U8                      aKeyModifiers[NUM_KEY_CODES];       // State of the modifier keys when the key was pressed.
+  USBH_HID_HANDLE         hDevice;                            // Opened with USE_KEYBOARD_REPORTS or USE_KEYBOARD_LEDS.
+#if USE_KEYBOARD_LEDS
+  HID_LED                 Led;
+#endif
+#if USE_KEYBOARD_REPORTS
+  USBH_HID_RW_CONTEXT     RWContext;
+  U8                      NumReadErrors;                        // Failed reads in a row.
+  U8                      abReport[HID_BOOT_KBD_REPORT_SIZE];   // Last report, compared with the next one.
+  U8                      abBuffer[HID_BOOT_KBD_REPORT_SIZE];   // Report being received.
+#endif
+} KEYBOARD_DEVICE;
 
 /*********************************************************************
 *
-*       Static data
+*       Static const data
 *
 **********************************************************************
 */
-//
-// This table is identical to the HID US keyboard table
-// with the exception that the first four entries have been removed
-// (non-visible keys). Any other key that is not on the main field of
-// of the keyboard is also removed, (F-Keys, NumPad, Cursors etc.)
-//
-static const  SCANCODE_TO_CHAR _aScanCode2CharUS[] = 
-{
-  {'a',    'A'},                     // 0x04: Key a/A
-  {'b',    'B'},                     // 0x05: Key b/B
-  {'c',    'C'},                     // 0x06: Key c/C
-  {'d',    'D'},                     // 0x07: Key d/D
-  {'e',    'E'},                     // 0x08: Key e/E
-  {'f',    'F'},                     // 0x09: Key f/F
-  {'g',    'G'},                     // 0x0A: Key g/G
-  {'h',    'H'},                     // 0x0B: Key h/H
-  {'i',    'I'},                     // 0x0C: Key i/I
-  {'j',    'J'},                     // 0x0D: Key j/J
-  {'k',    'K'},                     // 0x0E: Key k/K
-  {'l',    'L'},                     // 0x0F: Key l/L
-  {'m',    'M'},                     // 0x10: Key m/M
-  {'n',    'N'},                     // 0x11: Key n/N
-  {'o',    'O'},                     // 0x12: Key o/O
-  {'p',    'P'},                     // 0x13: Key p/P
-  {'q',    'Q'},                     // 0x14: Key q/Q
-  {'r',    'R'},                     // 0x15: Key r/R
-  {'s',    'S'},                     // 0x16: Key s/S
-  {'t',    'T'},                     // 0x17: Key t/T
-  {'u',    'U'},                     // 0x18: Key u/U
-  {'v',    'V'},                     // 0x19: Key v/V
-  {'w',    'W'},                     // 0x1A: Key w/W
-  {'x',    'X'},                     // 0x1B: Key x/X
-  {'y',    'Y'},                     // 0x1C: Key y/Y
-  {'z',    'Z'},                     // 0x1D: Key z/Z
-  {'1',    '!'},                     // 0x1E: Key 1/!
-  {'2',    '@'},                     // 0x1F: Key 2/@
-  {'3',    '#'},                     // 0x20: Key 3/#
-  {'4',    '$'},                     // 0x21: Key 4/$
-  {'5',    '%'},                     // 0x22: Key 5/%
-  {'6',    '^'},                     // 0x23: Key 6/^
-  {'7',    '&'},                     // 0x24: Key 7/&
-  {'8',    '*'},                     // 0x25: Key 8/*
-  {'9',    '('},                     // 0x26: Key 9/(
-  {'0',    ')'},                     // 0x27: Key 0/)
-  {'\n',   '\r'},                    // 0x28: Key Return (ENTER)
-  {'\x1b', '\x1b'},                  // 0x29: Key ESCAPE
-  {'\b',   '\b'},                    // 0x2A: Key DELETE(Backspace)
-  {'\t',   '\t'},                    // 0x2B: Key Tab
-  {' ',    ' '},                     // 0x2C: Key Spacebar
-  {'-',    '_'},                     // 0x2D: Key -/(underscore)
-  {'=',    '+'},                     // 0x2E: Key =/+
-  {'[',    '{'},                     // 0x2F: Key [/{
-  {']',    '}'},                     // 0x30: Key ]/}
-  {'\\',   '|'},                     // 0x31: Key \\/|
-  {'#',    '~'},                     // 0x32: Key Non-US #/~
-  {';',    ':'},                     // 0x33: Key ;/:
-  {'\'',   '\"'},                    // 0x34: Key Apostrophe/Quotation mark
-  {'`',    '~'},                     // 0x35: Key GraveAccent/Tilde
-  {',',    '<'},                     // 0x36: Key,/<
-  {'.',    '>'},                     // 0x37: Key ./>
-  {'/',    '?'},                     // 0x38: Key //?
-};
+static const BARCODE_CONFIG    _BarcodeConfig = { SCAN_PREFIX, SCAN_SUFFIX, SCAN_TIMEOUT };
 
 /*********************************************************************
 *
@@ -188,13 +229,13 @@ static OS_STACKPTR int         _StackMain[1536/sizeof(int)];
 static OS_TASK                 _TCBMain;
 static OS_STACKPTR int         _StackIsr[1276/sizeof(int)];
 static OS_TASK                 _TCBIsr;
-static USBH_HID_KEYBOARD_DATA  _aKeyboardData[MAX_DATA_ITEMS];
-static OS_MAILBOX              _HIDMailBox;
-static U8                      _ShiftActive;
-static U8                      _aMessageBuffer[MESSAGE_BUFFER_SIZE];
-static KEY_BUFFER              _aKeys[KEY_BUFFER_SIZE];
-static int                     _NumKeys;
-static int                     _MessageBufferOff;
+static OS_STACKPTR int         _StackScan[1024/sizeof(int)];
+static OS_TASK                 _TCBScan;
+static KEYBOARD_DEVICE         _aKeyboard[MAX_KEYBOARDS];
+static HID_QUEUE             * _apQueue[MAX_KEYBOARDS];         // Queue of each keyboard, served in turn by _Mux.
+static HID_QUEUE_MUX           _Mux;
+static USBH_HID_DEVICE_INFO    _aDevInfo[MAX_HID_DEVICES];      // Used by _OnDevNotify() only.
+static U32                     _NumScansLostReported;
 
 /*********************************************************************
 *
@@ -203,91 +244,340 @@ static int                     _MessageBufferOff;
 **********************************************************************
 */
 
+/*********************************************************************
+*
+*       _FindKeyboard
+*
+*  Function description
+*    Returns the keyboard of an interface, NULL if the interface
+*    has no slot. Called from the USBH task.
+*/
+static KEYBOARD_DEVICE * _FindKeyboard(USBH_INTERFACE_ID InterfaceID) {
+  KEYBOARD_DEVICE * pKeyboard;
+  unsigned          i;
+
+  pKeyboard = &_aKeyboard[0];
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    if ((pKeyboard->State == KEYBOARD_ACTIVE) && (pKeyboard->InterfaceID == InterfaceID)) {
+      return pKeyboard;
+    }
+    pKeyboard++;
+  }
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       _AddKeyboard
+*
+*  Function description
+*    Assigns a free slot to an interface. Called from the USBH task,
+*    MainTask has a lower priority and cannot run in between.
+*
+*  Return value
+*    Keyboard or NULL if all MAX_KEYBOARDS slots are in use.
+*/
+static KEYBOARD_DEVICE * _AddKeyboard(USBH_INTERFACE_ID InterfaceID, unsigned DevIndex) {
+  KEYBOARD_DEVICE * pKeyboard;
+  unsigned          i;
+
+  pKeyboard = &_aKeyboard[0];
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    if (pKeyboard->State == KEYBOARD_FREE) {
+      pKeyboard->InterfaceID = InterfaceID;
+      pKeyboard->DevIndex    = (U8)DevIndex;
+      pKeyboard->IsAdded     = 1;
+      pKeyboard->State       = KEYBOARD_ACTIVE;
+      return pKeyboard;
+    }
+    pKeyboard++;
+  }
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       _GetKeyboard
+*
+*  Function description
+*    Returns the keyboard of an interface. An interface which has not
+*    been added by _OnDevNotify(), such as a replayed one, gets a slot
+*    with its first event. Called from the USBH task.
+*/
+static KEYBOARD_DEVICE * _GetKeyboard(USBH_INTERFACE_ID InterfaceID) {
+  KEYBOARD_DEVICE * pKeyboard;
+
+  pKeyboard = _FindKeyboard(InterfaceID);
+  if (pKeyboard == NULL) {
+    pKeyboard = _AddKeyboard(InterfaceID, DEV_INDEX_NONE);
+  }
+  return pKeyboard;
+}
+
+/*********************************************************************
+*
+*       _PutEvent
+*
+*  Function description
+*    Passes an event to MainTask through the queue of the keyboard.
+*    Called from the USBH task.
+*/
+static void _PutEvent(KEYBOARD_DEVICE * pKeyboard, KEYBOARD_EVENT * pEvent) {
+#if USE_HID_LAT
+  HID_LAT_Stamp(&pEvent->Lat);
+#endif
+#if USE_HID_REPLAY
+  pEvent->Timestamp = HID_REPLAY_GetTimestamp();
+  if ((pKeyboard == NULL) || (HID_QUEUE_Put(&pKeyboard->Queue, pEvent) == 0)) {
+    HID_REPLAY_OnDropped();
+  }
+#else
+  if (pKeyboard != NULL) {
+    HID_QUEUE_Put(&pKeyboard->Queue, pEvent);
+  }
+#endif
+}
 
 /*********************************************************************
 *
 *       _AddChar2Buffer
 */
-static void _AddChar2Buffer(U8 Code, U8 ShiftActive) 
+static void _AddChar2Buffer(KEYBOARD_DEVICE * pKeyboard, unsigned Code, unsigned Modifiers) 
 {
-  U8 Char;
-  if ((Code > (SEGGER_COUNTOF(_aScanCode2CharUS) + BEGIN_OF_VALID_KEYS)) || (Code < BEGIN_OF_VALID_KEYS)) 
-  {
-    return;
-  }
-  Code -= BEGIN_OF_VALID_KEYS;
-  if (ShiftActive) 
-  {
-    Char = _aScanCode2CharUS[Code].UpperCaseChar;
-  } 
-  else
-  {
-    Char = _aScanCode2CharUS[Code].Char;
+  char     acChar[HID_KEYMAP_MAX_CHARS];
+  unsigned NumChars;
+  unsigned i;
+
+  NumChars = HID_KEYMAP_Translate(pKeyboard->pLayout, &pKeyboard->KeymapState, Code, Modifiers, acChar);
+  for (i = 0; i < NumChars; i++) {
+    BARCODE_AddChar(&pKeyboard->Barcode, acChar[i]);   // Enter ends the scan, backspace removes the last character.
   }
-  if (Char == '\b') 
-  {
-    if (_MessageBufferOff > 0) {
-      _MessageBufferOff--;
-    }
+}
+
+#if USE_KEYBOARD_LEDS
+/*********************************************************************
+*
+*       _OnLockKey
+*
+*  Function description
+*    Toggles the LED of a lock key. The LEDs are updated by the
+*    HID_LED task, a burst of lock keys is coalesced.
+*/
+static void _OnLockKey(KEYBOARD_DEVICE * pKeyboard, unsigned Code) {
+  U8 Mask;
+
+  switch (Code) {
+  case KEY_CODE_NUM_LOCK:
+    Mask = USBH_HID_IND_NUM_LOCK;
+    break;
+  case KEY_CODE_CAPS_LOCK:
+    Mask = USBH_HID_IND_CAPS_LOCK;
+    break;
+  case KEY_CODE_SCROLL_LOCK:
+    Mask = USBH_HID_IND_SCROLL_LOCK;
+    break;
+  default:
     return;
   }
-  if (Char != '\0') {
-    if ((Char == '\r') || (Char == '\n') || (_MessageBufferOff == (sizeof(_aMessageBuffer)-1))) {
-      _aMessageBuffer[_MessageBufferOff] = 0;
-      USBH_Logf_Application("The following message was entered: %s", _aMessageBuffer);
-      //
-      // After output, reset buffer.
-      //
-      _MessageBufferOff = 0;
-      _aMessageBuffer[0] = 0;
-      return;
-    }
-    _aMessageBuffer[_MessageBufferOff++] = Char;
+  if (pKeyboard->hDevice != 0u) {
+    HID_LED_Set(&pKeyboard->Led, (U8)(HID_LED_Get(&pKeyboard->Led) ^ Mask));
   }
 }
+#endif
 
 /*********************************************************************
 *
 *       _ScanCodeOperation
 */
-static void _ScanCodeOperation(unsigned Code, unsigned State) {
+static void _ScanCodeOperation(KEYBOARD_DEVICE * pKeyboard, unsigned Code, unsigned State) {
+  U32 * pWord;
+  U32   Mask;
+
+  if (Code >= NUM_KEY_CODES) {
+    return;
+  }
   //
-  // Check whether one of the 'Shift'-Key was pressed
+  // Modifier keys only change the modifier state.
   //
-  if (Code == KEY_VALUE_SHIFT_LEFT || Code == KEY_VALUE_SHIFT_RIGHT) 
-  {
-    _ShiftActive = State;
+  if ((Code >= KEY_CODE_MODIFIER_FIRST) && (Code <= KEY_CODE_MODIFIER_LAST)) {
+    if (State) {
+      pKeyboard->Modifiers |= (U8)MODIFIER_MASK(Code);
+    } else {
+      pKeyboard->Modifiers &= (U8)~MODIFIER_MASK(Code);
+    }
     return;
   }
   //
-  // Store the value into key buffer,
-  // the once the key is released we will store the
-  // key into the message buffer
+  // Keep track of every pressed key in the bitmap, together with the
+  // modifier state at the time it was pressed. Once the key is released
+  // the character is stored into the message buffer. A repeated press
+  // or a release of a key which is not pressed is ignored.
   //
-  if (State) 
-  {
-    _aKeys[_NumKeys].Code = Code;
-    _aKeys[_NumKeys++].ShiftState = _ShiftActive;
-    //
-    // If we reached end of the buffer, go back to the begining
-    //
-    if (_NumKeys >= KEY_BUFFER_SIZE) {
-      _NumKeys = 0;
+  pWord = &pKeyboard->aKeyPressed[Code >> 5];
+  Mask  = 1uL << (Code & 31u);
+  if (State) {
+    if ((*pWord & Mask) == 0u) {
+      *pWord |= Mask;
+      pKeyboard->aKeyModifiers[Code] = pKeyboard->Modifiers;
+#if USE_KEYBOARD_LEDS
+      _OnLockKey(pKeyboard, Code);
+#endif
     }
-  } 
-  else 
-  {
-    int i;
-    for (i = 0; i < KEY_BUFFER_SIZE; i++) {
-      if (Code == _aKeys[i].Code) {
-        _AddChar2Buffer(Code, _aKeys[i].ShiftState);
-        _aKeys[i].Code = 0;
-        _aKeys[i].ShiftState = 0;
-      }
+  } else {
+    if (*pWord & Mask) {
+      *pWord &= ~Mask;
+      _AddChar2Buffer(pKeyboard, Code, pKeyboard->aKeyModifiers[Code]);
+    }
+  }
+}
+
+#if USE_KEYBOARD_REPORTS
+/*********************************************************************
+*
+*       _DeltaOperation
+*
+*  Function description
+*    Applies all key changes of one report. Released keys are handled
+*    with the modifier state of the time they were pressed, pressed
+*    keys with the modifier state of the report.
+*/
+static void _DeltaOperation(KEYBOARD_DEVICE * pKeyboard, const HID_BOOT_KBD_DELTA * pDelta) {
+  unsigned i;
+
+  for (i = 0; i < pDelta->NumReleased; i++) {
+    _ScanCodeOperation(pKeyboard, pDelta->aReleased[i], 0);
+  }
+  for (i = 0; i < 8u; i++) {
+    if (pDelta->ModifiersChanged & (1u << i)) {
+      _ScanCodeOperation(pKeyboard, KEY_CODE_MODIFIER_FIRST + i, (pDelta->Modifiers >> i) & 1u);
     }
   }
+  for (i = 0; i < pDelta->NumPressed; i++) {
+    _ScanCodeOperation(pKeyboard, pDelta->aPressed[i], 1);
+  }
 }
 
+/*********************************************************************
+*
+*       _OnKeyboardReport
+*
+*  Function description
+*    Passes the changes of a report to MainTask.
+*    Called from the USBH task.
+*
+*  Parameters
+*    pKeyboard : Keyboard, its previous report is updated.
+*    pReport   : Report received.
+*/
+static void _OnKeyboardReport(KEYBOARD_DEVICE * pKeyboard, const U8 * pReport) {
+  KEYBOARD_EVENT KeyboardEvent;
+  int            r;
+
+  r = HID_BOOT_KBD_Diff(pKeyboard->abReport, pReport, &KeyboardEvent.Delta);
+  if (r < 0) {
+    return;
+  }
+  memcpy(pKeyboard->abReport, pReport, HID_BOOT_KBD_REPORT_SIZE);
+  if (r == 0) {
+    return;
+  }
+  _PutEvent(pKeyboard, &KeyboardEvent);
+}
+
+static void _ReadReport(KEYBOARD_DEVICE * pKeyboard);
+
+/*********************************************************************
+*
+*       _OnReportRead
+*
+*  Function description
+*    Called from the USBH task when USBH_HID_GetReport() has completed.
+*    A failed transfer only drops the report. After MAX_READ_ERRORS
+*    failed transfers in a row, for example a stalled endpoint, the
+*    keyboard is no longer read instead of retrying without delay.
+*/
+static void _OnReportRead(USBH_HID_RW_CONTEXT * pContext) {
+  KEYBOARD_DEVICE * pKeyboard;
+
+  pKeyboard = (KEYBOARD_DEVICE *)pContext->pUserContext;
+  if (pContext->Status == USBH_STATUS_DEVICE_REMOVED) {
+    return;                             // The handle is closed by MainTask.
+  }
+  if (pKeyboard->hDevice == 0u) {
+    return;                             // Closed by _FreeKeyboard(), the read was canceled.
+  }
+  if (pContext->Status == USBH_STATUS_SUCCESS) {
+    pKeyboard->NumReadErrors = 0;
+    if (pContext->NumBytesTransferred == HID_BOOT_KBD_REPORT_SIZE) {
+      _OnKeyboardReport(pKeyboard, pKeyboard->abBuffer);
+    }
+  } else if (++pKeyboard->NumReadErrors >= MAX_READ_ERRORS) {
+    USBH_Warnf_Application("Reports of interface %u no longer read: %s", pKeyboard->InterfaceID, USBH_GetStatusStr(pContext->Status));
+    return;
+  }
+  if (pKeyboard->hDevice != 0u) {       // Not closed by _FreeKeyboard() meanwhile.
+    _ReadReport(pKeyboard);
+  }
+}
+
+/*********************************************************************
+*
+*       _ReadReport
+*
+*  Function description
+*    Starts reading the next report of a keyboard.
+*/
+static void _ReadReport(KEYBOARD_DEVICE * pKeyboard) {
+  pKeyboard->RWContext.pUserContext = pKeyboard;
+  USBH_HID_GetReport(pKeyboard->hDevice, pKeyboard->abBuffer, HID_BOOT_KBD_REPORT_SIZE, _OnReportRead, &pKeyboard->RWContext);
+}
+
+#if USE_HID_REPLAY
+/*********************************************************************
+*
+*       _OnReplayKey
+*
+*  Function description
+*    Builds the boot protocol report of the replayed key changes.
+*    A replayed interface has no device, its receive buffer holds
+*    the report.
+*/
+static void _OnReplayKey(USBH_HID_KEYBOARD_DATA * pKeyData) {
+  KEYBOARD_DEVICE * pKeyboard;
+  U8              * pReport;
+  unsigned          Code;
+  unsigned          i;
+
+  pKeyboard = _GetKeyboard(pKeyData->InterfaceID);
+  if (pKeyboard == NULL) {
+    HID_REPLAY_OnDropped();
+    return;
+  }
+  pReport = pKeyboard->abBuffer;
+  Code    = pKeyData->Code;
+  if ((Code >= KEY_CODE_MODIFIER_FIRST) && (Code <= KEY_CODE_MODIFIER_LAST)) {
+    if (pKeyData->Value) {
+      pReport[0] |= (U8)MODIFIER_MASK(Code);
+    } else {
+      pReport[0] &= (U8)~MODIFIER_MASK(Code);
+    }
+  } else {
+    for (i = 2; i < HID_BOOT_KBD_REPORT_SIZE; i++) {
+      if (pKeyData->Value) {
+        if (pReport[i] == 0u) {
+          pReport[i] = (U8)Code;
+          break;
+        }
+      } else if (pReport[i] == Code) {
+        pReport[i] = 0;
+        break;
+      }
+    }
+  }
+  _OnKeyboardReport(pKeyboard, pReport);
+}
+#endif
+#else
 /*********************************************************************
 *
 *       _OnKeyboardChange
@@ -297,13 +587,420 @@ static void _ScanCodeOperation(unsigned Code, unsigned State) {
 */
 static void _OnKeyboardChange(USBH_HID_KEYBOARD_DATA  * pKeyData) 
 {
-  USBH_HID_KEYBOARD_DATA KeyboardData;
+  KEYBOARD_EVENT KeyboardEvent;
+
+  KeyboardEvent.Data = *pKeyData;
+  BINLOG_LOG(BINLOG_ID_KEYBOARD_RECEIVE, KeyboardEvent.Data.Code, KeyboardEvent.Data.Value, KeyboardEvent.Data.InterfaceID);
+  _PutEvent(_GetKeyboard(pKeyData->InterfaceID), &KeyboardEvent);
+}
+#endif
+
+/*********************************************************************
+*
+*       _OnKeyboardAdded
+*
+*  Function description
+*    Assigns a slot to a HID device which has been added if it is
+*    a keyboard. Called from the USBH task.
+*/
+static void _OnKeyboardAdded(unsigned DevIndex) {
+  KEYBOARD_DEVICE      * pKeyboard;
+  USBH_HID_DEVICE_INFO * pDevInfo;
+  int                    NumDevices;
+  int                    i;
+
+  NumDevices = USBH_HID_GetNumDevices(_aDevInfo, MAX_HID_DEVICES);
+  if (NumDevices > (int)MAX_HID_DEVICES) {
+    NumDevices = (int)MAX_HID_DEVICES;
+  }
+  pDevInfo = &_aDevInfo[0];
+  for (i = 0; i < NumDevices; i++) {
+    if (pDevInfo->DevIndex == DevIndex) {
+      if (pDevInfo->DeviceType != USBH_HID_KEYBOARD) {
+        return;
+      }
+#if USE_KEYBOARD_REPORTS
+      if (pDevInfo->InputReportSize != HID_BOOT_KBD_REPORT_SIZE) {
+        return;
+      }
+#endif
+      pKeyboard = _FindKeyboard(pDevInfo->InterfaceID);
+      if (pKeyboard != NULL) {
+        pKeyboard->DevIndex = (U8)DevIndex;   // Slot assigned by its first event already.
+        return;
+      }
+      pKeyboard = _AddKeyboard(pDevInfo->InterfaceID, DevIndex);
+      if (pKeyboard == NULL) {
+        USBH_Warnf_Application("Too many keyboards, increase MAX_KEYBOARDS");
+        return;
+      }
+      HID_QUEUE_Wakeup(&pKeyboard->Queue);   // MainTask starts the keyboard.
+      return;
+    }
+    pDevInfo++;
+  }
+}
+
+/*********************************************************************
+*
+*       _OnKeyboardRemoved
+*
+*  Function description
+*    Marks the keyboard of a HID device which has been removed.
+*    The slot is freed by MainTask. Called from the USBH task.
+*/
+static void _OnKeyboardRemoved(unsigned DevIndex) {
+  KEYBOARD_DEVICE * pKeyboard;
+  unsigned          i;
+
+  pKeyboard = &_aKeyboard[0];
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    if ((pKeyboard->State == KEYBOARD_ACTIVE) && (pKeyboard->DevIndex == DevIndex)) {
+      pKeyboard->State = KEYBOARD_REMOVED;
+      HID_QUEUE_Wakeup(&pKeyboard->Queue);
+    }
+    pKeyboard++;
+  }
+}
+
+/*********************************************************************
+*
+*       _StartKeyboard
+*
+*  Function description
+*    Prepares a keyboard assigned by USBH_Task for decoding, starts
+*    reading its reports and updating its LEDs. Called from MainTask.
+*    A keyboard removed before it was started is only prepared for
+*    decoding the events queued before the removal.
+*/
+static void _StartKeyboard(KEYBOARD_DEVICE * pKeyboard) {
+  pKeyboard->IsAdded = 0;
+  pKeyboard->pLayout = HID_KEYMAP_GetLayout(pKeyboard->InterfaceID);
+  BARCODE_Create(&pKeyboard->Barcode, &_BarcodeConfig, pKeyboard->InterfaceID);
+#if (USE_KEYBOARD_REPORTS || USE_KEYBOARD_LEDS)
+  if ((pKeyboard->DevIndex != DEV_INDEX_NONE) && (pKeyboard->State == KEYBOARD_ACTIVE)) {
+    pKeyboard->hDevice = USBH_HID_Open(pKeyboard->DevIndex);
+    if (pKeyboard->hDevice != 0u) {
+#if USE_KEYBOARD_LEDS
+      HID_LED_Add(&pKeyboard->Led, pKeyboard->hDevice);
+#endif
+#if USE_KEYBOARD_REPORTS
+      _ReadReport(pKeyboard);
+#endif
+    }
+  }
+#endif
+}
+
+/*********************************************************************
+*
+*       _OnKeyboardEvent
+*
+*  Function description
+*    Decodes an event taken from the queue of a keyboard.
+*/
+static void _OnKeyboardEvent(KEYBOARD_DEVICE * pKeyboard, const KEYBOARD_EVENT * pEvent) {
+  if (pKeyboard->IsAdded) {
+    _StartKeyboard(pKeyboard);
+  }
+#if USE_HID_LAT
+  HID_LAT_OnDequeue(&pEvent->Lat);
+#endif
+#if USE_HID_REPLAY
+  HID_REPLAY_OnReceived(pEvent->Timestamp);
+#endif
+#if USE_KEYBOARD_REPORTS
+  _DeltaOperation(pKeyboard, &pEvent->Delta);
+#else
+  _ScanCodeOperation(pKeyboard, pEvent->Data.Code, pEvent->Data.Value);
+#endif
+}
+
+/*********************************************************************
+*
+*       _ResetKeyboard
+*
+*  Function description
+*    Clears the decoder state of a keyboard and discards its scan
+*    in assembly.
+*/
+static void _ResetKeyboard(KEYBOARD_DEVICE * pKeyboard) {
+  BARCODE_Discard(&pKeyboard->Barcode);
+  memset(pKeyboard->aKeyPressed, 0, sizeof(pKeyboard->aKeyPressed));
+  memset(&pKeyboard->KeymapState, 0, sizeof(pKeyboard->KeymapState));
+  pKeyboard->Modifiers = 0;
+#if USE_KEYBOARD_REPORTS
+  pKeyboard->NumReadErrors = 0;
+  memset(pKeyboard->abReport, 0, sizeof(pKeyboard->abReport));
+  memset(pKeyboard->abBuffer, 0, sizeof(pKeyboard->abBuffer));
+#endif
+}
 
-  KeyboardData = *pKeyData;
-  USBH_Logf_Application("**** receive KB  code [%d] Value=[%d] InterfaceID[%d]", KeyboardData.Code,KeyboardData.Value,KeyboardData.InterfaceID);
-  OS_PutMailCond(&_HIDMailBox, &KeyboardData);
+/*********************************************************************
+*
+*       _FreeKeyboard
+*
+*  Function description
+*    Frees the slot of a removed keyboard. The handle is closed first,
+*    so no LED update or report read is started for the slot any more.
+*    Then the events queued before the removal are decoded, a scan
+*    which has not been completed is discarded. Called from MainTask.
+*/
+static void _FreeKeyboard(KEYBOARD_DEVICE * pKeyboard) {
+  KEYBOARD_EVENT KeyboardEvent;
+
+  if (pKeyboard->hDevice != 0u) {
+#if USE_KEYBOARD_LEDS
+    HID_LED_Remove(&pKeyboard->Led);    // Waits for an LED update in progress.
+#endif
+    USBH_HID_Close(pKeyboard->hDevice);
+    pKeyboard->hDevice = 0;             // Lock keys decoded below do not touch the LEDs.
+  }
+  while (HID_QUEUE_Get(&pKeyboard->Queue, &KeyboardEvent)) {
+    _OnKeyboardEvent(pKeyboard, &KeyboardEvent);
+  }
+  _ResetKeyboard(pKeyboard);
+  OS_EnterRegion();                     // Slot has to be clean before USBH_Task can assign it again.
+  pKeyboard->IsAdded = 0;
+  pKeyboard->State   = KEYBOARD_FREE;
+  OS_LeaveRegion();
+}
+
+/*********************************************************************
+*
+*       _UpdateKeyboards
+*
+*  Function description
+*    Starts the keyboards added and frees the keyboards removed
+*    since the last call. Called from MainTask.
+*/
+static void _UpdateKeyboards(void) {
+  KEYBOARD_DEVICE * pKeyboard;
+  unsigned          i;
+
+  pKeyboard = &_aKeyboard[0];
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    if (pKeyboard->State == KEYBOARD_REMOVED) {
+      _FreeKeyboard(pKeyboard);
+    } else if ((pKeyboard->State == KEYBOARD_ACTIVE) && pKeyboard->IsAdded) {
+      _StartKeyboard(pKeyboard);
+    }
+    pKeyboard++;
+  }
 }
 
+/*********************************************************************
+*
+*       _InitKeyboards
+*
+*  Function description
+*    Creates the queues of all keyboards. Called from MainTask,
+*    which is the consumer of the queues.
+*/
+static void _InitKeyboards(void) {
+  KEYBOARD_DEVICE * pKeyboard;
+  unsigned          i;
+
+  pKeyboard = &_aKeyboard[0];
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    HID_QUEUE_Create(&pKeyboard->Queue, pKeyboard->aEvent, sizeof(KEYBOARD_EVENT), MAX_DATA_ITEMS, TASK_EVENT_HID);
+    BARCODE_Create(&pKeyboard->Barcode, &_BarcodeConfig, 0);
+    _apQueue[i] = &pKeyboard->Queue;
+    pKeyboard++;
+  }
+  HID_QUEUE_MUX_Create(&_Mux, _apQueue, MAX_KEYBOARDS);
+}
+
+/*********************************************************************
+*
+*       _GetScanTimeout
+*
+*  Function description
+*    Returns the time until the first scan in assembly ends by timeout,
+*    < 0 if there is none.
+*/
+static I32 _GetScanTimeout(void) {
+  I32      Timeout;
+  I32      t;
+  unsigned i;
+
+  Timeout = -1;
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    t = BARCODE_GetTimeout(&_aKeyboard[i].Barcode);
+    if ((t >= 0) && ((Timeout < 0) || (t < Timeout))) {
+      Timeout = t;
+    }
+  }
+  return Timeout;
+}
+
+/*********************************************************************
+*
+*       _PollScans
+*
+*  Function description
+*    Ends the scans in assembly whose timeout has expired.
+*/
+static void _PollScans(void) {
+  unsigned i;
+
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    BARCODE_Poll(&_aKeyboard[i].Barcode);
+  }
+}
+
+/*********************************************************************
+*
+*       _ShowScan
+*
+*  Function description
+*    Shows the start of a scan, reading it in place from its chunks.
+*/
+static void _ShowScan(const BARCODE_SCAN * pScan) {
+  char       acText[SCAN_DISPLAY_SIZE + 1];
+  const U8 * pData;
+  unsigned   NumBytes;
+  U32        Off;
+
+  Off = 0;
+  while (Off < SCAN_DISPLAY_SIZE) {
+    pData = BARCODE_GetData(pScan, Off, &NumBytes);
+    if (NumBytes == 0u) {
+      break;
+    }
+    if (NumBytes > SCAN_DISPLAY_SIZE - Off) {
+      NumBytes = SCAN_DISPLAY_SIZE - Off;
+    }
+    memcpy(&acText[Off], pData, NumBytes);
+    Off += NumBytes;
+  }
+  acText[Off] = '\0';
+  if (pScan->NumBytes > SCAN_DISPLAY_SIZE) {
+    USBH_Logf_Application("The following message was entered on interface %u: %s... (%u characters)", pScan->Id, acText, pScan->NumBytes);
+  } else {
+    USBH_Logf_Application("The following message was entered on interface %u: %s", pScan->Id, acText);
+  }
+}
+
+/*********************************************************************
+*
+*       _ScanTask
+*
+*  Function description
+*    Consumer of the complete scans.
+*/
+static void _ScanTask(void) {
+  BARCODE_SCAN Scan;
+  BARCODE_STAT Stat;
+  U32          NumLost;
+
+  while (1) {
+    BARCODE_WaitScan(&Scan);
+    _ShowScan(&Scan);
+    BARCODE_FreeScan(&Scan);
+    BARCODE_GetStat(&Stat);
+    NumLost = Stat.NumDropped + Stat.NumOverflows;
+    if (NumLost != _NumScansLostReported) {
+      USBH_Warnf_Application("%u scans lost, %u of %u chunks used", NumLost - _NumScansLostReported, Stat.MaxChunksUsed, BARCODE_NUM_CHUNKS);
+      _NumScansLostReported = NumLost;
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       _ShowDropped
+*
+*  Function description
+*    Reports events which have been dropped because the queue
+*    of a keyboard was full.
+*/
+static void _ShowDropped(void) {
+  KEYBOARD_DEVICE * pKeyboard;
+  HID_QUEUE_STAT    Stat;
+  unsigned          i;
+
+  pKeyboard = &_aKeyboard[0];
+  for (i = 0; i < MAX_KEYBOARDS; i++) {
+    HID_QUEUE_GetStat(&pKeyboard->Queue, &Stat);
+    if (Stat.NumDropped != pKeyboard->NumDroppedReported) {
+      USBH_Logf_Application("%u HID events of interface %u dropped, %u of %u queue entries used", Stat.NumDropped - pKeyboard->NumDroppedReported, pKeyboard->InterfaceID, Stat.MaxUsed, MAX_DATA_ITEMS);
+      pKeyboard->NumDroppedReported = Stat.NumDropped;
+    }
+    pKeyboard++;
+  }
+}
+
+#if USE_BENCH
+static volatile int _BenchResult;       // Keeps the compiler from removing the operation.
+
+/*********************************************************************
+*
+*       _BenchScanCodeOperation
+*
+*  Function description
+*    One benchmark operation: press and release of a letter key.
+*/
+static void _BenchScanCodeOperation(void * pContext, unsigned Index) {
+  unsigned Code;
+
+  Code = BEGIN_OF_VALID_KEYS + (Index % 26u);
+  _ScanCodeOperation((KEYBOARD_DEVICE *)pContext, Code, 1);
+  _ScanCodeOperation((KEYBOARD_DEVICE *)pContext, Code, 0);
+}
+
+/*********************************************************************
+*
+*       _BenchBootKbdDiff
+*
+*  Function description
+*    One benchmark operation: diff of a key press report of a barcode scanner.
+*/
+static void _BenchBootKbdDiff(void * pContext, unsigned Index) {
+  HID_BOOT_KBD_DELTA  Delta;
+  U8                  abPrev[HID_BOOT_KBD_REPORT_SIZE];
+  U8                  abReport[HID_BOOT_KBD_REPORT_SIZE];
+
+  SEGGER_USE_PARA(pContext);
+  memset(abPrev,   0, sizeof(abPrev));
+  memset(abReport, 0, sizeof(abReport));
+  abReport[0] = (U8)((Index & 1u) << 1);            // Left shift on every other character.
+  abReport[2] = (U8)(BEGIN_OF_VALID_KEYS + (Index % 26u));
+  _BenchResult = HID_BOOT_KBD_Diff(abPrev, abReport, &Delta);
+}
+
+/*********************************************************************
+*
+*       _BenchBarcodeScan
+*
+*  Function description
+*    One benchmark operation: assembly, hand-off and release of a 2 KB scan.
+*/
+static void _BenchBarcodeScan(void * pContext, unsigned Index) {
+  static const BARCODE_CONFIG _Config = { NULL, NULL, 0 };
+  BARCODE_ASM                 Asm;
+  BARCODE_SCAN                Scan;
+  unsigned                    i;
+
+  SEGGER_USE_PARA(pContext);
+  BARCODE_Create(&Asm, &_Config, 0);
+  for (i = 0; i < 2048u; i++) {
+    BARCODE_AddChar(&Asm, (char)('A' + ((Index + i) % 26u)));
+  }
+  BARCODE_AddChar(&Asm, '\n');
+  if (BARCODE_GetScan(&Scan)) {
+    _BenchResult = (int)Scan.NumBytes;
+    BARCODE_FreeScan(&Scan);
+  }
+}
+
+static const BENCH_CASE _aBenchCase[] = {
+  { "_ScanCodeOperation press+release", _BenchScanCodeOperation, &_aKeyboard[0], 2, 0 },
+  { "HID_BOOT_KBD_Diff press",          _BenchBootKbdDiff,       NULL, HID_BOOT_KBD_REPORT_SIZE, 0 },
+  { "BARCODE 2 KB scan",                _BenchBarcodeScan,       NULL, 2048, 100 },
+};
+#endif
+
 /*********************************************************************
 *
 *       _OnDevNotify
@@ -319,15 +1016,32 @@ static void _OnDevNotify(void * pContext, U8 DevIndex, USBH_DEVICE_EVENT Event)
   switch (Event) 
   {
   case USBH_DEVICE_EVENT_ADD:
-    USBH_Logf_Application("**** Device added [%d]", DevIndex);
+    BINLOG_LOG(BINLOG_ID_DEVICE_ADDED, DevIndex);
+    _OnKeyboardAdded(DevIndex);
     break;
   case USBH_DEVICE_EVENT_REMOVE:
-    USBH_Logf_Application("**** Device removed [%d]", DevIndex);
+    BINLOG_LOG(BINLOG_ID_DEVICE_REMOVED, DevIndex);
+    _OnKeyboardRemoved(DevIndex);
     break;
   default:;   // Should never happen
   }
 
 }
+
+#if USE_HID_REPLAY
+//
+// Burst of a barcode scanner: 1000 keystroke reports/s on a single device.
+//
+static const HID_REPLAY_CONFIG _ReplayConfig = {
+#if USE_KEYBOARD_REPORTS
+  _OnReplayKey, NULL,
+#else
+  _OnKeyboardChange, NULL,
+#endif
+  NULL, 0, 1, 1000, 2000, 0, TASK_PRIO_USBH_MAIN
+};
+#endif
+
 /*********************************************************************
 *
 *       Public code
@@ -347,7 +1061,9 @@ void MainTask(void);
 #endif
 void MainTask(void) 
 {
-  USBH_HID_KEYBOARD_DATA KeyboardData;
+  KEYBOARD_EVENT KeyboardEvent;
+  I32            Timeout;
+  int            Index;
 
   //SEGGER_RTT_printf(0, " RCC->CFGR  0x%x\n",RCC_CFGR_SW);    
   printf("  RCC_CFGR_SWS 0x%x\n",RCC_CFGR_SWS); 
@@ -355,6 +1071,18 @@ void MainTask(void)
   printf("  SystemCoreClock %d\n",SystemCoreClock); 
   printf("  RCC_PLLCFGR_PLLN %d\n",RCC_PLLCFGR_PLLN); 
   printf("  HSE_VALUE %d\n",HSE_VALUE); 
+  BARCODE_Init();
+  _InitKeyboards();
+  HID_KEYMAP_SetDefaultLayout(&KEYBOARD_LAYOUT);
+#if USE_BENCH
+  _aKeyboard[0].pLayout = &KEYBOARD_LAYOUT;                                            // Set by _StartKeyboard() once a keyboard is attached.
+  BENCH_RunCommon();
+  BENCH_RunList(_aBenchCase, SEGGER_COUNTOF(_aBenchCase));
+  _ResetKeyboard(&_aKeyboard[0]);                                                      // Discard the characters typed by the benchmark.
+#endif
+#if USE_HID_LAT
+  HID_LAT_Init();
+#endif
    
   USBH_Init();
 
@@ -364,31 +1092,55 @@ void MainTask(void)
                                                                                        // Tasks using emUSB-Host API should always have a lower priority than emUSB-Host main and ISR tasks.
   OS_CREATETASK(&_TCBMain, "USBH_Task", USBH_Task, TASK_PRIO_USBH_MAIN, _StackMain);   // Start USBH main task
   OS_CREATETASK(&_TCBIsr, "USBH_isr", USBH_ISRTask, TASK_PRIO_USBH_ISR, _StackIsr);    // Start USBH ISR task
+  OS_CREATETASK(&_TCBScan, "ScanTask", _ScanTask, TASK_PRIO_SCAN, _StackScan);         // Start consumer of the complete scans
+#if USE_KEYBOARD_LEDS
+  HID_LED_Init();                                                                      // Start the task which updates the keyboard LEDs
+#endif
   USBH_HID_Init();
+#if (USE_KEYBOARD_REPORTS == 0)
   USBH_HID_SetOnKeyboardStateChange(_OnKeyboardChange);
+#endif
   //
   // Some USB host controllers lack the support for multiple USB transfers at once.
   // Only one operation at a time is allowed.
   // This the case for the KINETIS FS driver with the Kinetis USBOTG (USB0) controller.
-  // If you are using a different controller you can comment the following line to
-  // enable LED update functionality for keyboards.
+  // The LED update of the stack stays disabled, with USE_KEYBOARD_LEDS the
+  // HID_LED task updates the LEDs at most once per HID_LED_INTERVAL ms per keyboard.
   //
   USBH_HID_ConfigureAllowLEDUpdate(0);
   USBH_HID_RegisterNotification(_OnDevNotify, NULL);
-  //
-  // Create mailbox to store the HID events
-  //
-  OS_CREATEMB(&_HIDMailBox, sizeof(USBH_HID_KEYBOARD_DATA), MAX_DATA_ITEMS, &_aKeyboardData);
+#if USE_HID_REPLAY
+  HID_REPLAY_Start(&_ReplayConfig);
+#endif
 
   while (1) 
   {
     BSP_ToggleLED(1);
     
-    // Get data from the mailbox, print information according to the event type.
+    // Wait for keyboard events, then decode all events queued in the meantime,
+    // one event of each keyboard in turn. While a scan is in assembly, wake up
+    // in time to end it by timeout.
     
-    OS_GetMail(&_HIDMailBox, &KeyboardData);
-    //_Add
-    _ScanCodeOperation(KeyboardData.Code, KeyboardData.Value);
+    Timeout = _GetScanTimeout();
+#if USE_HID_LAT
+    if ((Timeout < 0) || (Timeout > LAT_POLL_INTERVAL)) {
+      Timeout = LAT_POLL_INTERVAL;
+    }
+#endif
+    if (Timeout < 0) {
+      HID_QUEUE_MUX_Wait(&_Mux);
+    } else if (Timeout > 0) {
+      HID_QUEUE_MUX_WaitTimed(&_Mux, (OS_TIME)Timeout);
+    }
+    _UpdateKeyboards();
+    while ((Index = HID_QUEUE_MUX_Get(&_Mux, &KeyboardEvent)) >= 0) {
+      _OnKeyboardEvent(&_aKeyboard[Index], &KeyboardEvent);
+    }
+    _PollScans();
+    _ShowDropped();
+#if USE_HID_LAT
+    HID_LAT_Poll();                     // Outputs the latency histograms when a key has been sent on the RTT terminal.
+#endif
   }
 }
 /*************************** End of file ****************************/
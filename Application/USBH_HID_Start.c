@@ -49,18 +49,18 @@ Additional information:
     16:512 USBH_Task - 0x81      0x03      00008             10
 
     **** Device added
-    27:015 MainTask - Keyboard:  Key s/S                - pressed
-    27:132 MainTask - Keyboard:  Key s/S                - released
-    27:303 MainTask - Keyboard:  Key e/E                - pressed
-    27:384 MainTask - Keyboard:  Key e/E                - released
-    27:825 MainTask - Keyboard:  Key g/G                - pressed
-    27:888 MainTask - Keyboard:  Key g/G                - released
-    28:014 MainTask - Keyboard:  Key g/G                - pressed
-    28:095 MainTask - Keyboard:  Key g/G                - released
-    28:293 MainTask - Keyboard:  Key e/E                - pressed
-    28:383 MainTask - Keyboard:  Key e/E                - released
-    28:491 MainTask - Keyboard:  Key r/R                - pressed
-    28:581 MainTask - Keyboard:  Key r/R                - released
+    27:015 MainTask - Keyboard:  Key s/S - pressed
+    27:132 MainTask - Keyboard:  Key s/S - released
+    27:303 MainTask - Keyboard:  Key e/E - pressed
+    27:384 MainTask - Keyboard:  Key e/E - released
+    27:825 MainTask - Keyboard:  Key g/G - pressed
+    27:888 MainTask - Keyboard:  Key g/G - released
+    28:014 MainTask - Keyboard:  Key g/G - pressed
+    28:095 MainTask - Keyboard:  Key g/G - released
+    28:293 MainTask - Keyboard:  Key e/E - pressed
+    28:383 MainTask - Keyboard:  Key e/E - released
+    28:491 MainTask - Keyboard:  Key r/R - pressed
+    28:581 MainTask - Keyboard:  Key r/R - released
 
     <...>
 
@@ -78,11 +78,17 @@ Additional information:
 *
 **********************************************************************
 */
+#include <stddef.h>
+#include <string.h>
 #include "RTOS.h"
 #include "BSP.h"
 #include "USBH.h"
 #include "USBH_HID.h"
 #include "SEGGER.h"
+#include "BENCH.h"
+#include "HID_REPLAY.h"
+#include "HID_QUEUE.h"
+#include "BINLOG.h"
 
 /*********************************************************************
 *
@@ -91,6 +97,8 @@ Additional information:
 **********************************************************************
 */
 #define MAX_DATA_ITEMS        10
+#define MOUSE_FLUSH_INTERVAL  10    // [ms] Mouse movement is merged and passed to MainTask at most once per interval and mouse, and on button changes. 0 passes every report.
+#define MAX_MICE              4     // Number of mice whose movement can be merged at the same time, reports of further mice are passed unmerged.
 
 /*********************************************************************
 *
@@ -100,6 +108,7 @@ Additional information:
 */
 #define MOUSE_EVENT       (1 << 0)
 #define KEYBOARD_EVENT    (1 << 1)
+#define TASK_EVENT_HID    (1u << 0)   // Task event of MainTask signaled by _HIDQueue.
 
 /*********************************************************************
 *
@@ -119,12 +128,31 @@ typedef struct {
     USBH_HID_MOUSE_DATA     Mouse;
   } Data;
   U8 Event;
+#if USE_HID_REPLAY
+  U32 Timestamp;
+#endif
 }  HID_EVENT;
 
 typedef struct {
-  U16 KeyCode;
-  const char * sDesc;
-} SCANCODE_TO_DESC;
+  USBH_HID_MOUSE_DATA Data;           // Movement not yet passed to MainTask, button state of the last report.
+  U32                 LastFlush;      // OS_GetTime32() when the movement was last passed to MainTask.
+  U8                  IsUsed;
+  U8                  IsPending;      // Data holds movement which has not been passed to MainTask.
+#if USE_HID_REPLAY
+  U32                 Timestamp;      // Of the first report merged into Data.
+#endif
+} MOUSE_ACC;
+
+//
+// Descriptions of all scan codes packed into one string pool,
+// the member names are used to compute the offsets.
+//
+#define SCANCODE(Code, sDesc)   char ac##Code[sizeof(sDesc)];
+typedef struct {
+  char acUnknown[sizeof("Reserved or unknown code")];
+  #include "HID_ScanCodes.h"
+} SCANCODE_POOL;
+#undef SCANCODE
 
 /*********************************************************************
 *
@@ -132,227 +160,22 @@ typedef struct {
 *
 **********************************************************************
 */
-static const  SCANCODE_TO_DESC _aScanCode2StringTable[] = {
-  { 0x00, "Reserved/(no event indicated)"},
-  { 0x01, "Key ErrorRollOver            "},
-  { 0x02, "Key POSTFail                 "},
-  { 0x03, "Key ErrorUndefined           "},
-  { 0x04, "Key a/A                      "},
-  { 0x05, "Key b/B                      "},
-  { 0x06, "Key c/C                      "},
-  { 0x07, "Key d/D                      "},
-  { 0x08, "Key e/E                      "},
-  { 0x09, "Key f/F                      "},
-  { 0x0A, "Key g/G                      "},
-  { 0x0B, "Key h/H                      "},
-  { 0x0C, "Key i/I                      "},
-  { 0x0D, "Key j/J                      "},
-  { 0x0E, "Key k/K                      "},
-  { 0x0F, "Key l/L                      "},
-  { 0x10, "Key m/M                      "},
-  { 0x11, "Key n/N                      "},
-  { 0x12, "Key o/O                      "},
-  { 0x13, "Key p/P                      "},
-  { 0x14, "Key q/Q                      "},
-  { 0x15, "Key r/R                      "},
-  { 0x16, "Key s/S                      "},
-  { 0x17, "Key t/T                      "},
-  { 0x18, "Key u/U                      "},
-  { 0x19, "Key v/V                      "},
-  { 0x1A, "Key w/W                      "},
-  { 0x1B, "Key x/X                      "},
-  { 0x1C, "Key y/Y                      "},
-  { 0x1D, "Key z/Z                      "},
-  { 0x1E, "Key 1/!                      "},
-  { 0x1F, "Key 2/@                      "},
-  { 0x20, "Key 3/#                      "},
-  { 0x21, "Key 4/$                      "},
-  { 0x22, "Key 5/%                      "},
-  { 0x23, "Key 6/^                      "},
-  { 0x24, "Key 7/&                      "},
-  { 0x25, "Key 8/*                      "},
-  { 0x26, "Key 9/(                      "},
-  { 0x27, "Key 0/)                      "},
-  { 0x28, "Key Return (ENTER)           "},
-  { 0x29, "Key ESCAPE                   "},
-  { 0x2A, "Key DELETE(Backspace)        "},
-  { 0x2B, "Key Tab                      "},
-  { 0x2C, "Key Spacebar                 "},
-  { 0x2D, "Key -/(underscore)           "},
-  { 0x2E, "Key =/+                      "},
-  { 0x2F, "Key [/{                      "},
-  { 0x30, "Key ]/}                      "},
-  { 0x31, "Key \\/|                     "},
-  { 0x32, "Key Non-US #/~               "},
-  { 0x33, "Key ;/:                      "},
-  { 0x34, "Key Apostrophe/Quotation mark"},
-  { 0x35, "Key GraveAccent/Tilde        "},
-  { 0x36, "Key,/<                       "},
-  { 0x37, "Key ./>                      "},
-  { 0x38, "Key //?                      "},
-  { 0x39, "Key Caps Lock                "},
-  { 0x3A, "Key F1                       "},
-  { 0x3B, "Key F2                       "},
-  { 0x3C, "Key F3                       "},
-  { 0x3D, "Key F4                       "},
-  { 0x3E, "Key F5                       "},
-  { 0x3F, "Key F6                       "},
-  { 0x40, "Key F7                       "},
-  { 0x41, "Key F8                       "},
-  { 0x42, "Key F9                       "},
-  { 0x43, "Key F10                      "},
-  { 0x44, "Key F11                      "},
-  { 0x45, "Key F12                      "},
-  { 0x46, "Key PrintScreen              "},
-  { 0x47, "Key Scroll Lock              "},
-  { 0x48, "Key Pause                    "},
-  { 0x49, "Key Insert                   "},
-  { 0x4A, "Key Home                     "},
-  { 0x4B, "Key PageUp                   "},
-  { 0x4C, "Key Delete Forward           "},
-  { 0x4D, "Key End                      "},
-  { 0x4E, "Key PageDown                 "},
-  { 0x4F, "Key RightArrow               "},
-  { 0x50, "Key LeftArrow                "},
-  { 0x51, "Key DownArrow                "},
-  { 0x52, "Key UpArrow                  "},
-  { 0x53, "Keypad NumLock/Clear         "},
-  { 0x54, "Keypad /                     "},
-  { 0x55, "Keypad *                     "},
-  { 0x56, "Keypad -                     "},
-  { 0x57, "Keypad +                     "},
-  { 0x58, "Keypad ENTER                 "},
-  { 0x59, "Keypad 1/End                 "},
-  { 0x5A, "Keypad 2/Down Arrow          "},
-  { 0x5B, "Keypad 3/PageDn              "},
-  { 0x5C, "Keypad 4/Left Arrow          "},
-  { 0x5D, "Keypad 5                     "},
-  { 0x5E, "Keypad 6/Right Arrow         "},
-  { 0x5F, "Keypad 7/Home                "},
-  { 0x60, "Keypad 8/Up Arrow            "},
-  { 0x61, "Keypad 9/PageUp              "},
-  { 0x62, "Keypad 0/Insert              "},
-  { 0x63, "Keypad ./Delete              "},
-  { 0x64, "Key Non-US \\/|              "},
-  { 0x65, "Key Application              "},
-  { 0x66, "Key Power                    "},
-  { 0x67, "Keypad =                     "},
-  { 0x68, "Key F13                      "},
-  { 0x69, "Key F14                      "},
-  { 0x6A, "Key F15                      "},
-  { 0x6B, "Key F16                      "},
-  { 0x6C, "Key F17                      "},
-  { 0x6D, "Key F18                      "},
-  { 0x6E, "Key F19                      "},
-  { 0x6F, "Key F20                      "},
-  { 0x70, "Key F21                      "},
-  { 0x71, "Key F22                      "},
-  { 0x72, "Key F23                      "},
-  { 0x73, "Key F24                      "},
-  { 0x74, "Key Execute                  "},
-  { 0x75, "Key Help                     "},
-  { 0x76, "Key Menu                     "},
-  { 0x77, "Key Select                   "},
-  { 0x78, "Key Stop                     "},
-  { 0x79, "Key Again                    "},
-  { 0x7A, "Key Undo                     "},
-  { 0x7B, "Key Cut                      "},
-  { 0x7C, "Key Copy                     "},
-  { 0x7D, "Key Paste                    "},
-  { 0x7E, "Key Find                     "},
-  { 0x7F, "Key Mute                     "},
-  { 0x80, "Key Volume Up                "},
-  { 0x81, "Key Volume Down              "},
-  { 0x82, "Key Locking CapsLock         "},
-  { 0x83, "Key Locking NumLock          "},
-  { 0x84, "Key Locking ScrollLock       "},
-  { 0x85, "Keypad Comma                 "},
-  { 0x86, "Keypad Equal Sign            "},
-  { 0x87, "Key International1           "},
-  { 0x88, "Key International2           "},
-  { 0x89, "Key International3           "},
-  { 0x8A, "Key International4           "},
-  { 0x8B, "Key International5           "},
-  { 0x8C, "Key International6           "},
-  { 0x8D, "Key International7           "},
-  { 0x8E, "Key International8           "},
-  { 0x8F, "Key International9           "},
-  { 0x90, "Key LANG1                    "},
-  { 0x91, "Key LANG2                    "},
-  { 0x92, "Key LANG3                    "},
-  { 0x93, "Key LANG4                    "},
-  { 0x94, "Key LANG5                    "},
-  { 0x95, "Key LANG6                    "},
-  { 0x96, "Key LANG7                    "},
-  { 0x97, "Key LANG8                    "},
-  { 0x98, "Key LANG9                    "},
-  { 0x99, "Key Alternate Erase          "},
-  { 0x9A, "Key SysReq/Attention         "},
-  { 0x9B, "Key Cancel                   "},
-  { 0x9C, "Key Clear                    "},
-  { 0x9D, "Key Prior                    "},
-  { 0x9E, "Key Return                   "},
-  { 0x9F, "Key Separator                "},
-  { 0xA0, "Key Out                      "},
-  { 0xA1, "Key Oper                     "},
-  { 0xA2, "Key Clear/Again              "},
-  { 0xA3, "Key CrSel/Props              "},
-  { 0xA4, "Key ExSel                    "},
-  { 0xB0, "Keypad 00                    "},
-  { 0xB1, "Keypad 000                   "},
-  { 0xB2, "Thousands Separator          "},
-  { 0xB3, "Decimal Separator            "},
-  { 0xB4, "Currency Unit                "},
-  { 0xB5, "Currency Sub-unit            "},
-  { 0xB6, "Keypad (                     "},
-  { 0xB7, "Keypad )                     "},
-  { 0xB8, "Keypad {                     "},
-  { 0xB9, "Keypad }                     "},
-  { 0xBA, "Keypad Tab                   "},
-  { 0xBB, "Keypad Backspace             "},
-  { 0xBC, "Keypad A                     "},
-  { 0xBD, "Keypad B                     "},
-  { 0xBE, "Keypad C                     "},
-  { 0xBF, "Keypad D                     "},
-  { 0xC0, "Keypad E                     "},
-  { 0xC1, "Keypad F                     "},
-  { 0xC2, "Keypad XOR                   "},
-  { 0xC3, "Keypad ^                     "},
-  { 0xC4, "Keypad %                     "},
-  { 0xC5, "Keypad <                     "},
-  { 0xC6, "Keypad >                     "},
-  { 0xC7, "Keypad &                     "},
-  { 0xC8, "Keypad &&                    "},
-  { 0xC9, "Keypad |                     "},
-  { 0xCA, "Keypad ||                    "},
-  { 0xCB, "Keypad :                     "},
-  { 0xCC, "Keypad #                     "},
-  { 0xCD, "Keypad Space                 "},
-  { 0xCE, "Keypad @                     "},
-  { 0xCF, "Keypad !                     "},
-  { 0xD0, "Keypad Memory Store          "},
-  { 0xD1, "Keypad Memory Recall         "},
-  { 0xD2, "Keypad Memory Clear          "},
-  { 0xD3, "Keypad Memory Add            "},
-  { 0xD4, "Keypad Memory Subtract       "},
-  { 0xD5, "Keypad Memory Multiply       "},
-  { 0xD6, "Keypad Memory Divide         "},
-  { 0xD7, "Keypad +/-                   "},
-  { 0xD8, "Keypad Clear                 "},
-  { 0xD9, "Keypad Clear Entry           "},
-  { 0xDA, "Keypad Binary                "},
-  { 0xDB, "Keypad Octal                 "},
-  { 0xDC, "Keypad Decimal               "},
-  { 0xDD, "Keypad Hexadecimal           "},
-  { 0xE0, "Key LeftControl              "},
-  { 0xE1, "Key LeftShift                "},
-  { 0xE2, "Key LeftAlt                  "},
-  { 0xE3, "Key Left GUI                 "},
-  { 0xE4, "Key RightControl             "},
-  { 0xE5, "Key RightShift               "},
-  { 0xE6, "Key RightAlt                 "},
-  { 0xE7, "Key Right GUI                "}
+#define SCANCODE(Code, sDesc)   sDesc,
+static const SCANCODE_POOL _ScanCodePool = {
+  "Reserved or unknown code",
+  #include "HID_ScanCodes.h"
 };
+#undef SCANCODE
+
+//
+// Offset of the description in _ScanCodePool, indexed by scan code.
+// Codes without description are 0 and refer to acUnknown.
+//
+#define SCANCODE(Code, sDesc)   [Code] = (U16)offsetof(SCANCODE_POOL, ac##Code),
+static const U16 _aScanCodeOff[256] = {
+  #include "HID_ScanCodes.h"
+};
+#undef SCANCODE
 
 /*********************************************************************
 *
@@ -365,7 +188,11 @@ static OS_TASK         _TCBMain;
 static OS_STACKPTR int _StackIsr[1276/sizeof(int)];
 static OS_TASK         _TCBIsr;
 static HID_EVENT       _aHIDEvents[MAX_DATA_ITEMS];
-static OS_MAILBOX      _HIDMailBox;
+static HID_QUEUE       _HIDQueue;
+static U32             _NumDroppedReported;
+#if MOUSE_FLUSH_INTERVAL
+static MOUSE_ACC       _aMouseAcc[MAX_MICE];
+#endif
 
 /*********************************************************************
 *
@@ -382,29 +209,212 @@ static OS_MAILBOX      _HIDMailBox;
 *    Converts a given keyboard scan code to the key description.
 */
 static const char * _ScanCode2String(unsigned Code) {
+  unsigned Off;
+
+  Off = (Code < SEGGER_COUNTOF(_aScanCodeOff)) ? _aScanCodeOff[Code] : 0u;
+  return (const char *)&_ScanCodePool + Off;
+}
+
+/*********************************************************************
+*
+*       _PutMouse
+*
+*  Function description
+*    Passes a mouse event to MainTask.
+*
+*  Return value
+*    1: Event queued.
+*    0: Queue full.
+*/
+static int _PutMouse(const USBH_HID_MOUSE_DATA * pMouseData, U32 Timestamp) {
+  HID_EVENT HidEvent;
+
+  HidEvent.Event      = MOUSE_EVENT;
+  HidEvent.Data.Mouse = *pMouseData;
+#if USE_HID_REPLAY
+  HidEvent.Timestamp  = Timestamp;
+#else
+  SEGGER_USE_PARA(Timestamp);
+#endif
+  return HID_QUEUE_Put(&_HIDQueue, &HidEvent);
+}
+
+#if MOUSE_FLUSH_INTERVAL
+/*********************************************************************
+*
+*       _FindMouseAcc
+*
+*  Function description
+*    Returns the accumulator of a mouse. A mouse seen for the first time
+*    gets an accumulator which is unused or has no pending movement.
+*
+*  Return value
+*    Accumulator, NULL if all are in use and have pending movement.
+*/
+static MOUSE_ACC * _FindMouseAcc(USBH_INTERFACE_ID InterfaceID) {
+  MOUSE_ACC * pFree;
+  unsigned    i;
+
+  pFree = NULL;
+  for (i = 0; i < MAX_MICE; i++) {
+    if (_aMouseAcc[i].IsUsed && (_aMouseAcc[i].Data.InterfaceID == InterfaceID)) {
+      return &_aMouseAcc[i];
+    }
+    if ((pFree == NULL) && (_aMouseAcc[i].IsPending == 0u)) {
+      pFree = &_aMouseAcc[i];
+    }
+  }
+  if (pFree) {
+    memset(pFree, 0, sizeof(*pFree));
+    pFree->IsUsed           = 1;
+    pFree->Data.InterfaceID = InterfaceID;
+    pFree->LastFlush        = OS_GetTime32() - MOUSE_FLUSH_INTERVAL;
+  }
+  return pFree;
+}
+
+/*********************************************************************
+*
+*       _TakeMouseAcc
+*
+*  Function description
+*    Takes the pending movement of an accumulator.
+*    Called with task switches disabled.
+*/
+static void _TakeMouseAcc(MOUSE_ACC * pAcc, HID_EVENT * pHidEvent) {
+  pHidEvent->Event      = MOUSE_EVENT;
+  pHidEvent->Data.Mouse = pAcc->Data;
+#if USE_HID_REPLAY
+  pHidEvent->Timestamp  = pAcc->Timestamp;
+#endif
+  pAcc->Data.xChange     = 0;
+  pAcc->Data.yChange     = 0;
+  pAcc->Data.WheelChange = 0;
+  pAcc->IsPending        = 0;
+  pAcc->LastFlush        = OS_GetTime32();
+}
+
+/*********************************************************************
+*
+*       _IsMousePending
+*
+*  Function description
+*    Checks whether movement is held back for any mouse.
+*/
+static int _IsMousePending(void) {
   unsigned i;
 
-  for (i = 0; i < SEGGER_COUNTOF(_aScanCode2StringTable); i++) {
-    if (Code == _aScanCode2StringTable[i].KeyCode) {
-      return  _aScanCode2StringTable[i].sDesc;
+  for (i = 0; i < MAX_MICE; i++) {
+    if (_aMouseAcc[i].IsPending) {
+      return 1;
     }
   }
-  return "Reserved or unknown code      ";
+  return 0;
 }
 
+/*********************************************************************
+*
+*       _GetEvent
+*
+*  Function description
+*    Called by MainTask to take the next event. When the queue is empty,
+*    movement which has been held back for MOUSE_FLUSH_INTERVAL is taken,
+*    because the mouse has not sent another report which would pass it on.
+*
+*  Return value
+*    1: Event stored in pHidEvent.
+*    0: Nothing to take.
+*/
+static int _GetEvent(HID_EVENT * pHidEvent) {
+  MOUSE_ACC * pAcc;
+  unsigned    i;
+  int         r;
+
+  OS_EnterRegion();
+  r = HID_QUEUE_Get(&_HIDQueue, pHidEvent);
+  if (r == 0) {
+    for (i = 0; i < MAX_MICE; i++) {
+      pAcc = &_aMouseAcc[i];
+      if (pAcc->IsPending && ((OS_GetTime32() - pAcc->LastFlush) >= MOUSE_FLUSH_INTERVAL)) {
+        _TakeMouseAcc(pAcc, pHidEvent);
+        r = 1;
+        break;
+      }
+    }
+  }
+  OS_LeaveRegion();
+  return r;
+}
+#endif
+
 /*********************************************************************
 *
 *       _OnMouseChange
 *
 *  Function description
 *    Callback, called from the USBH task when a mouse event occurs.
+*    With MOUSE_FLUSH_INTERVAL, the movement of reports which arrive
+*    within the interval is added up, MainTask receives one event per
+*    interval instead of one per report. A change of the button state
+*    is passed on immediately together with the movement up to then.
+*    While the queue is full the movement stays pending, nothing is lost.
 */
 static void _OnMouseChange(USBH_HID_MOUSE_DATA  * pMouseData) {
-  HID_EVENT  HidEvent;
+  U32         Timestamp;
+#if MOUSE_FLUSH_INTERVAL
+  HID_EVENT   HidEvent;
+  MOUSE_ACC * pAcc;
+  int         ButtonChanged;
+  int         WasPending;
+#endif
 
-  HidEvent.Event = MOUSE_EVENT;
-  HidEvent.Data.Mouse = *pMouseData;
-  OS_PutMailCond(&_HIDMailBox, &HidEvent);
+#if USE_HID_REPLAY
+  Timestamp = HID_REPLAY_GetTimestamp();
+#else
+  Timestamp = 0;
+#endif
+#if MOUSE_FLUSH_INTERVAL
+  OS_EnterRegion();
+  pAcc = _FindMouseAcc(pMouseData->InterfaceID);
+  if (pAcc) {
+    WasPending    = pAcc->IsPending;
+    ButtonChanged = (pAcc->Data.ButtonState != pMouseData->ButtonState);
+    pAcc->Data.xChange     += pMouseData->xChange;
+    pAcc->Data.yChange     += pMouseData->yChange;
+    pAcc->Data.WheelChange += pMouseData->WheelChange;
+    pAcc->Data.ButtonState  = pMouseData->ButtonState;
+    pAcc->IsPending         = 1;
+    if (WasPending) {
+#if USE_HID_REPLAY
+      HID_REPLAY_OnCoalesced();
+#endif
+    } else {
+#if USE_HID_REPLAY
+      pAcc->Timestamp = Timestamp;
+#endif
+    }
+    if (HID_QUEUE_IsFull(&_HIDQueue)) {
+      //
+      // Keep the movement pending, MainTask is busy with the queued events anyway.
+      //
+    } else if (ButtonChanged || ((OS_GetTime32() - pAcc->LastFlush) >= MOUSE_FLUSH_INTERVAL)) {
+      _TakeMouseAcc(pAcc, &HidEvent);
+      HID_QUEUE_Put(&_HIDQueue, &HidEvent);
+    } else if (WasPending == 0) {
+      HID_QUEUE_Wakeup(&_HIDQueue);             // MainTask has to pass the movement on after the interval.
+    }
+    OS_LeaveRegion();
+    return;
+  }
+  OS_LeaveRegion();
+#endif
+#if USE_HID_REPLAY
+  if (_PutMouse(pMouseData, Timestamp) == 0) {
+    HID_REPLAY_OnDropped();
+  }
+#else
+  _PutMouse(pMouseData, Timestamp);
+#endif
 }
 
 /*********************************************************************
@@ -419,7 +429,31 @@ static void _OnKeyboardChange(USBH_HID_KEYBOARD_DATA  * pKeyData) {
 
   HidEvent.Event         = KEYBOARD_EVENT;
   HidEvent.Data.Keyboard = *pKeyData;
-  OS_PutMailCond(&_HIDMailBox, &HidEvent);
+#if USE_HID_REPLAY
+  HidEvent.Timestamp     = HID_REPLAY_GetTimestamp();
+  if (HID_QUEUE_Put(&_HIDQueue, &HidEvent) == 0) {
+    HID_REPLAY_OnDropped();
+  }
+#else
+  HID_QUEUE_Put(&_HIDQueue, &HidEvent);
+#endif
+}
+
+/*********************************************************************
+*
+*       _ShowDropped
+*
+*  Function description
+*    Reports events which have been dropped because the queue was full.
+*/
+static void _ShowDropped(void) {
+  HID_QUEUE_STAT Stat;
+
+  HID_QUEUE_GetStat(&_HIDQueue, &Stat);
+  if (Stat.NumDropped != _NumDroppedReported) {
+    USBH_Logf_Application("%u HID events dropped, %u of %u queue entries used", Stat.NumDropped - _NumDroppedReported, Stat.MaxUsed, MAX_DATA_ITEMS);
+    _NumDroppedReported = Stat.NumDropped;
+  }
 }
 
 /*********************************************************************
@@ -433,6 +467,26 @@ static const char * _KeyState2String(unsigned State) {
    return State == 1 ? "pressed" : "released";
 }
 
+#if USE_BENCH
+static const char * volatile _sBenchDesc;    // Keeps the compiler from removing the lookup.
+
+/*********************************************************************
+*
+*       _BenchScanCode2String
+*
+*  Function description
+*    One benchmark operation: description lookup, all 256 scan codes in turn.
+*/
+static void _BenchScanCode2String(void * pContext, unsigned Index) {
+  SEGGER_USE_PARA(pContext);
+  _sBenchDesc = _ScanCode2String(Index & 0xFFu);
+}
+
+static const BENCH_CASE _aBenchCase[] = {
+  { "_ScanCode2String 0x00..0xFF", _BenchScanCode2String, NULL, 0, 0 },
+};
+#endif
+
 /*********************************************************************
 *
 *       _OnDevNotify
@@ -446,15 +500,25 @@ static void _OnDevNotify(void * pContext, U8 DevIndex, USBH_DEVICE_EVENT Event)
   (void)pContext;
   switch (Event) {
   case USBH_DEVICE_EVENT_ADD:
-    USBH_Logf_Application("**** Device added [%d]", DevIndex);
+    BINLOG_LOG(BINLOG_ID_DEVICE_ADDED, DevIndex);
     break;
   case USBH_DEVICE_EVENT_REMOVE:
-    USBH_Logf_Application("**** Device removed [%d]", DevIndex);
+    BINLOG_LOG(BINLOG_ID_DEVICE_REMOVED, DevIndex);
     break;
   default:;   // Should never happen
   }
 
 }
+
+#if USE_HID_REPLAY
+//
+// 4 devices with 1000 reports/s each, every second device is a mouse.
+//
+static const HID_REPLAY_CONFIG _ReplayConfig = {
+  _OnKeyboardChange, _OnMouseChange, NULL, 0, 4, 1000, 2000, 2, TASK_PRIO_USBH_MAIN
+};
+#endif
+
 /*********************************************************************
 *
 *       Public code
@@ -476,6 +540,10 @@ void MainTask(void)
 {
   HID_EVENT  HidEvent;
 
+#if USE_BENCH
+  BENCH_RunCommon();
+  BENCH_RunList(_aBenchCase, SEGGER_COUNTOF(_aBenchCase));
+#endif
   USBH_Init();
   OS_SetPriority(OS_GetTaskID(), TASK_PRIO_APP);                                       // This task has the lowest prio for real-time application.
                                                                                        // Tasks using emUSB-Host API should always have a lower priority than emUSB-Host main and ISR tasks.
@@ -495,29 +563,49 @@ void MainTask(void)
   //
   USBH_HID_ConfigureAllowLEDUpdate(0);
   //
-  // Create mailbox to store the HID events
+  // Create queue to store the HID events
   //
-  OS_CREATEMB(&_HIDMailBox, sizeof(HID_EVENT), MAX_DATA_ITEMS, &_aHIDEvents);
+  HID_QUEUE_Create(&_HIDQueue, _aHIDEvents, sizeof(HID_EVENT), MAX_DATA_ITEMS, TASK_EVENT_HID);
+#if USE_HID_REPLAY
+  HID_REPLAY_Start(&_ReplayConfig);
+#endif
 
   while (1) 
   {
     BSP_ToggleLED(1);
     //
-    // Get data from the mailbox, print information according to the event type.
+    // Wait for HID events, then print information according to the event type
+    // for all events queued in the meantime.
     //
-    OS_GetMail(&_HIDMailBox, &HidEvent);
-
-    if ((HidEvent.Event & (MOUSE_EVENT)) == MOUSE_EVENT) 
-    {
-      HidEvent.Event &= ~(MOUSE_EVENT);
-      USBH_Logf_Application("Mouse: xRel: %d, yRel: %d, WheelRel: %d, ButtonState: %d",
-                            HidEvent.Data.Mouse.xChange, HidEvent.Data.Mouse.yChange, HidEvent.Data.Mouse.WheelChange, HidEvent.Data.Mouse.ButtonState);
-    } 
-    else if ((HidEvent.Event & (KEYBOARD_EVENT)) == KEYBOARD_EVENT) 
-    {
-      HidEvent.Event &= ~(KEYBOARD_EVENT);
-      USBH_Logf_Application("Keyboard:  %s - %s", _ScanCode2String(HidEvent.Data.Keyboard.Code), _KeyState2String(HidEvent.Data.Keyboard.Value));
+#if MOUSE_FLUSH_INTERVAL
+    if (_IsMousePending()) {
+      HID_QUEUE_WaitTimed(&_HIDQueue, MOUSE_FLUSH_INTERVAL);
+    } else {
+      HID_QUEUE_Wait(&_HIDQueue);
+    }
+    while (_GetEvent(&HidEvent)) {
+#else
+    HID_QUEUE_Wait(&_HIDQueue);
+    while (HID_QUEUE_Get(&_HIDQueue, &HidEvent)) {
+#endif
+#if USE_HID_REPLAY
+      HID_REPLAY_OnReceived(HidEvent.Timestamp);
+#endif
+      if ((HidEvent.Event & (MOUSE_EVENT)) == MOUSE_EVENT) 
+      {
+        HidEvent.Event &= ~(MOUSE_EVENT);
+#if USE_HID_REPLAY
+        HID_REPLAY_OnMotion(HidEvent.Data.Mouse.xChange, HidEvent.Data.Mouse.yChange, HidEvent.Data.Mouse.WheelChange);
+#endif
+        BINLOG_LOG(BINLOG_ID_MOUSE, HidEvent.Data.Mouse.xChange, HidEvent.Data.Mouse.yChange, HidEvent.Data.Mouse.WheelChange, HidEvent.Data.Mouse.ButtonState);
+      } 
+      else if ((HidEvent.Event & (KEYBOARD_EVENT)) == KEYBOARD_EVENT) 
+      {
+        HidEvent.Event &= ~(KEYBOARD_EVENT);
+        USBH_Logf_Application("Keyboard:  %s - %s", _ScanCode2String(HidEvent.Data.Keyboard.Code), _KeyState2String(HidEvent.Data.Keyboard.Value));
+      }
     }
+    _ShowDropped();
   }
 }
 
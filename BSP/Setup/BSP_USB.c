@@ -34,6 +34,7 @@ Purpose : BSP for SEGGER emPower V2 with Freescale K66 MCU
 #include "SEGGER.h"
 #include "RTOS.h"
 #include "stm32f4xx.h"
+#include "HID_LAT.h"
 //#include "stm32f7xx.h"     // Device specific header file, contains CMSIS
 
 /*********************************************************************
@@ -90,6 +91,11 @@ void OTG_HS_IRQHandler(void);
 */
 void OTG_FS_IRQHandler(void) 
 {
+#if USE_HID_LAT
+  if (USB_OTG_FS->GINTSTS & USB_OTG_FS->GINTMSK & USB_OTG_GINTSTS_HCINT) {
+    HID_LAT_OnIRQ();   // Channel interrupt, may complete a HID report.
+  }
+#endif
   OS_EnterInterrupt(); // Inform embOS that interrupt code is running
   if (_pfOTG_FSHandler) {
     (_pfOTG_FSHandler)();
@@ -47,6 +47,22 @@
     defined(STM32F412Rx) || defined(STM32F412Cx) || defined(STM32F413xx) || defined(STM32F423xx)
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_ll_usb.h"
+
+#ifndef USE_HAL_HCD_STATISTICS
+  #define USE_HAL_HCD_STATISTICS  0U
+#endif
+
+#ifndef USE_HAL_HCD_CHANNEL_MUX
+  #define USE_HAL_HCD_CHANNEL_MUX  0U
+#endif
+
+#ifndef HCD_MAX_PIPES
+  #define HCD_MAX_PIPES           16U    /* Logical pipes of the channel multiplexer, up to 32 */
+#endif
+
+#ifndef HCD_PERIODIC_FRAMES
+  #define HCD_PERIODIC_FRAMES     32U    /* Length of the periodic schedule in frames, longest polling interval */
+#endif
    
 /** @addtogroup STM32F4xx_HAL_Driver
   * @{
@@ -78,9 +94,137 @@ typedef USB_OTG_CfgTypeDef      HCD_InitTypeDef;
 typedef USB_OTG_HCTypeDef       HCD_HCTypeDef ;   
 typedef USB_OTG_URBStateTypeDef HCD_URBStateTypeDef ;
 typedef USB_OTG_HCStateTypeDef  HCD_HCStateTypeDef ;
+typedef USB_OTG_HostFifoCfgTypeDef HCD_FifoCfgTypeDef ;
+/**
+  * @}
+  */
+
+#if (USE_HAL_HCD_STATISTICS == 1U)
+/** @defgroup HCD_Exported_Types_Group3 HCD Statistics Structure definition
+  * @brief  Counters to compare driver variants on the target.
+  *         Average interrupt cost per transfer is IrqCycles / XferCount.
+  * @{
+  */
+typedef struct
+{
+  uint32_t IrqCount;         /*!< Number of HAL_HCD_IRQHandler() calls                  */
+  uint32_t IrqCycles;        /*!< CPU cycles (DWT CYCCNT) spent in HAL_HCD_IRQHandler() */
+  uint32_t IrqCyclesMax;     /*!< Longest single HAL_HCD_IRQHandler() run in cycles     */
+  uint32_t XferCount;        /*!< Number of URBs completed with URB_DONE                */
+  uint32_t NakCount;         /*!< NAK handshakes which raised a channel interrupt       */
+  uint32_t StallCount;       /*!< STALL handshakes                                      */
+  uint32_t BabbleCount;      /*!< Babble errors                                         */
+  uint32_t XactErrCount;     /*!< Transaction errors                                    */
+  uint32_t DisconnectCount;  /*!< Device disconnect events                              */
+} HCD_StatisticsTypeDef;
+/**
+  * @}
+  */
+#endif /* USE_HAL_HCD_STATISTICS */
+
+/** @defgroup HCD_Exported_Types_Group4 HCD Periodic Schedule Structure definition
+  * @brief  Interrupt IN channels polled by the driver in the frames of their interval.
+  * @{
+  */
+typedef struct
+{
+  uint8_t   *pbuff;          /*!< Buffer receiving the data of each poll              */
+  uint16_t  length;          /*!< Size of the buffer                                  */
+  uint8_t   interval;        /*!< Polling interval in frames, a power of 2            */
+  uint8_t   phase;           /*!< Frame within the interval the channel is polled in  */
+} HCD_PeriodicChTypeDef;
+
+typedef struct
+{
+  HCD_PeriodicChTypeDef  ch[15U];                      /*!< Schedule of each channel                  */
+  uint16_t               ScheduledMask;                /*!< Channels with a periodic schedule         */
+  uint16_t               ActiveMask;                   /*!< Scheduled channels armed and not finished */
+  uint8_t                Load[HCD_PERIODIC_FRAMES];    /*!< Channels polled in each frame of the schedule */
+} HCD_PeriodicTypeDef;
+/**
+  * @}
+  */
+
+/** @defgroup HCD_Exported_Types_Group5 HCD NAK Throttling Structure definition
+  * @brief  Retry policy and NAK counter of a channel, see HAL_HCD_HC_SetNakPolicy().
+  * @{
+  */
+typedef struct
+{
+  uint32_t  NakCount;        /*!< NAK handshakes received on the channel             */
+  uint8_t   Policy;          /*!< Retry policy, a value of @ref HCD_NAK_Policy        */
+  uint8_t   MaxFrames;       /*!< Longest back-off in frames for HCD_NAK_RETRY_BACKOFF */
+  uint8_t   Delay;           /*!< Frames to wait after the next NAK                   */
+  uint8_t   Wait;            /*!< Frames left until the channel is re-enabled         */
+} HCD_NakTypeDef;
+/**
+  * @}
+  */
+
+/** @defgroup HCD_Exported_Types_Group7 HCD FIFO Event Structure definition
+  * @brief  FIFO underrun and overrun events, a sign of an unsuitable FIFO partition.
+  * @{
+  */
+typedef struct
+{
+  uint32_t  FrameOverrunCount;           /*!< Periodic transfers not finished in their frame, Tx underrun */
+  uint32_t  IncompletePeriodicCount;     /*!< Frames ended with periodic transfers still pending          */
+  uint32_t  RxOverrunCount;              /*!< IN packets larger than the space left in the buffer         */
+} HCD_FifoStatTypeDef;
+/**
+  * @}
+  */
+
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+/** @defgroup HCD_Exported_Types_Group6 HCD Channel Multiplexer Structure definition
+  * @brief  Logical pipes sharing the host channels, see HAL_HCD_Mux_Init().
+  * @{
+  */
+typedef struct
+{
+  uint8_t   *pbuff;                      /*!< Buffer of the pending request                 */
+  uint32_t  xfer_count;                  /*!< Bytes transferred by the last request         */
+  uint16_t  length;                      /*!< Length of the pending request                 */
+  uint16_t  mps;                         /*!< Max packet size                               */
+  uint16_t  WaitStart;                   /*!< Frame the request started to wait for a channel */
+  uint8_t   epnum;                       /*!< Endpoint address including the direction bit  */
+  uint8_t   dev_address;                 /*!< Device address                                */
+  uint8_t   speed;                       /*!< Device speed                                  */
+  uint8_t   ep_type;                     /*!< Endpoint type                                 */
+  uint8_t   direction;                   /*!< Direction of the pending request              */
+  uint8_t   token;                       /*!< Token of the pending request                  */
+  uint8_t   do_ping;                     /*!< Ping flag of the pending request              */
+  uint8_t   toggle_in;                   /*!< IN data toggle while no channel is bound      */
+  uint8_t   toggle_out;                  /*!< OUT data toggle while no channel is bound     */
+  uint8_t   is_open;                     /*!< Pipe is in use                                */
+  uint8_t   is_waiting;                  /*!< Request could not get a channel at once       */
+  __IO HCD_URBStateTypeDef urb_state;    /*!< State of the last request                     */
+} HCD_PipeTypeDef;
+
+typedef struct
+{
+  uint32_t  BindCount;                   /*!< Requests started on a channel                          */
+  uint32_t  ReuseCount;                  /*!< Requests on a channel still programmed for their pipe  */
+  uint32_t  WaitCount;                   /*!< Requests which had to wait for a free channel          */
+  uint32_t  WaitFrames;                  /*!< Frames waited for a channel in total                   */
+  uint32_t  WaitFramesMax;               /*!< Longest wait for a channel in frames                   */
+} HCD_MuxStatTypeDef;
+
+typedef struct
+{
+  HCD_PipeTypeDef     pipe[HCD_MAX_PIPES];  /*!< Logical pipes                                   */
+  uint32_t            Pending[3U];          /*!< Pipes waiting for a channel per priority class  */
+  uint8_t             Last[3U];             /*!< Pipe started last per class, for round robin    */
+  uint16_t            ChMask;               /*!< Channels owned by the multiplexer               */
+  uint16_t            FreeMask;             /*!< Owned channels without a request                */
+  uint8_t             ChPipe[15U];          /*!< Pipe using the channel, HCD_PIPE_NONE if free   */
+  uint8_t             ChOwner[15U];         /*!< Pipe the channel registers are programmed for   */
+  HCD_MuxStatTypeDef  Stats;                /*!< Channel reuse and wait time                     */
+} HCD_MuxTypeDef;
 /**
   * @}
   */
+#endif /* USE_HAL_HCD_CHANNEL_MUX */
 
 /** @defgroup HCD_Exported_Types_Group2 HCD Handle Structure definition   
   * @{
@@ -93,6 +237,16 @@ typedef struct
   HAL_LockTypeDef           Lock;       /*!< HCD peripheral status    */
   __IO HCD_StateTypeDef     State;      /*!< HCD communication state  */
   void                      *pData;     /*!< Pointer Stack Handler    */     
+  HCD_PeriodicTypeDef       Periodic;   /*!< Periodic schedule of interrupt IN channels */
+  HCD_NakTypeDef            nak[15U];   /*!< NAK throttling of bulk IN channels */
+  uint16_t                  NakWaitMask; /*!< Channels waiting for their retry frame */
+  HCD_FifoStatTypeDef       FifoStats;  /*!< FIFO underrun and overrun events */
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+  HCD_MuxTypeDef            Mux;        /*!< Channel multiplexer */
+#endif
+#if (USE_HAL_HCD_STATISTICS == 1U)
+  HCD_StatisticsTypeDef     Stats;      /*!< Interrupt and transfer statistics */
+#endif
 } HCD_HandleTypeDef;
 /**
   * @}
@@ -126,6 +280,24 @@ typedef struct
   * @}
   */
 
+/** @defgroup HCD_NAK_Policy HCD NAK Policy
+  * @{
+  */
+#define HCD_NAK_RETRY_IMMEDIATE      0U   /*!< Re-enable the channel in the NAK interrupt          */
+#define HCD_NAK_RETRY_FRAME          1U   /*!< Re-enable the channel in the next frame             */
+#define HCD_NAK_RETRY_BACKOFF        2U   /*!< Double the wait after each NAK, up to MaxFrames     */
+/**
+  * @}
+  */
+
+/** @defgroup HCD_Pipe HCD Pipe
+  * @{
+  */
+#define HCD_PIPE_NONE                0xFFU  /*!< No pipe, channel is free                          */
+/**
+  * @}
+  */
+
 /**
   * @}
   */ 
@@ -190,6 +362,31 @@ HAL_StatusTypeDef   HAL_HCD_HC_SubmitRequest(HCD_HandleTypeDef *hhcd,
                                              uint8_t* pbuff, 
                                              uint16_t length,
                                              uint8_t do_ping);
+HAL_StatusTypeDef   HAL_HCD_HC_StartPeriodic(HCD_HandleTypeDef *hhcd,
+                                             uint8_t ch_num,
+                                             uint8_t interval,
+                                             uint8_t* pbuff,
+                                             uint16_t length);
+HAL_StatusTypeDef   HAL_HCD_HC_StopPeriodic(HCD_HandleTypeDef *hhcd, uint8_t ch_num);
+HAL_StatusTypeDef   HAL_HCD_HC_SetNakPolicy(HCD_HandleTypeDef *hhcd, uint8_t ch_num, uint8_t policy, uint8_t max_frames);
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+HAL_StatusTypeDef   HAL_HCD_Mux_Init(HCD_HandleTypeDef *hhcd, uint16_t ch_mask);
+HAL_StatusTypeDef   HAL_HCD_Pipe_Open(HCD_HandleTypeDef *hhcd,
+                                      uint8_t *pipe_num,
+                                      uint8_t epnum,
+                                      uint8_t dev_address,
+                                      uint8_t speed,
+                                      uint8_t ep_type,
+                                      uint16_t mps);
+HAL_StatusTypeDef   HAL_HCD_Pipe_Close(HCD_HandleTypeDef *hhcd, uint8_t pipe_num);
+HAL_StatusTypeDef   HAL_HCD_Pipe_SubmitRequest(HCD_HandleTypeDef *hhcd,
+                                               uint8_t pipe_num,
+                                               uint8_t direction,
+                                               uint8_t token,
+                                               uint8_t* pbuff,
+                                               uint16_t length,
+                                               uint8_t do_ping);
+#endif
 
 /* Non-Blocking mode: Interrupt */
 void                HAL_HCD_IRQHandler(HCD_HandleTypeDef *hhcd);
@@ -199,6 +396,11 @@ void                HAL_HCD_Disconnect_Callback(HCD_HandleTypeDef *hhcd);
 void                HAL_HCD_HC_NotifyURBChange_Callback(HCD_HandleTypeDef *hhcd, 
                                                         uint8_t chnum, 
                                                         HCD_URBStateTypeDef urb_state);
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+void                HAL_HCD_Pipe_NotifyURBChange_Callback(HCD_HandleTypeDef *hhcd,
+                                                          uint8_t pipe_num,
+                                                          HCD_URBStateTypeDef urb_state);
+#endif
 /**
   * @}
   */
@@ -210,6 +412,7 @@ void                HAL_HCD_HC_NotifyURBChange_Callback(HCD_HandleTypeDef *hhcd,
 HAL_StatusTypeDef   HAL_HCD_ResetPort(HCD_HandleTypeDef *hhcd);
 HAL_StatusTypeDef   HAL_HCD_Start(HCD_HandleTypeDef *hhcd);
 HAL_StatusTypeDef   HAL_HCD_Stop(HCD_HandleTypeDef *hhcd);
+HAL_StatusTypeDef   HAL_HCD_SetFifoConfig(HCD_HandleTypeDef *hhcd, const HCD_FifoCfgTypeDef *pCfg);
 /**
   * @}
   */
@@ -224,6 +427,19 @@ uint32_t            HAL_HCD_HC_GetXferCount(HCD_HandleTypeDef *hhcd, uint8_t chn
 HCD_HCStateTypeDef  HAL_HCD_HC_GetState(HCD_HandleTypeDef *hhcd, uint8_t chnum);
 uint32_t            HAL_HCD_GetCurrentFrame(HCD_HandleTypeDef *hhcd);
 uint32_t            HAL_HCD_GetCurrentSpeed(HCD_HandleTypeDef *hhcd);
+void                HAL_HCD_GetPeriodicLoad(HCD_HandleTypeDef *hhcd, uint8_t *pLoad);
+uint32_t            HAL_HCD_HC_GetNakCount(HCD_HandleTypeDef *hhcd, uint8_t chnum);
+void                HAL_HCD_GetFifoConfig(HCD_HandleTypeDef *hhcd, HCD_FifoCfgTypeDef *pCfg);
+void                HAL_HCD_GetFifoStatistics(HCD_HandleTypeDef *hhcd, HCD_FifoStatTypeDef *pStats);
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+HCD_URBStateTypeDef HAL_HCD_Pipe_GetURBState(HCD_HandleTypeDef *hhcd, uint8_t pipe_num);
+uint32_t            HAL_HCD_Pipe_GetXferCount(HCD_HandleTypeDef *hhcd, uint8_t pipe_num);
+void                HAL_HCD_GetMuxStatistics(HCD_HandleTypeDef *hhcd, HCD_MuxStatTypeDef *pStats);
+#endif
+#if (USE_HAL_HCD_STATISTICS == 1U)
+void                HAL_HCD_GetStatistics(HCD_HandleTypeDef *hhcd, HCD_StatisticsTypeDef *pStats);
+void                HAL_HCD_ResetStatistics(HCD_HandleTypeDef *hhcd);
+#endif
 /**
   * @}
   */
@@ -236,6 +452,11 @@ uint32_t            HAL_HCD_GetCurrentSpeed(HCD_HandleTypeDef *hhcd);
 /** @defgroup HCD_Private_Macros HCD Private Macros
  * @{
  */
+#if (USE_HAL_HCD_STATISTICS == 1U)
+  #define HCD_STAT_INC(__HANDLE__, __FIELD__)   ((__HANDLE__)->Stats.__FIELD__++)
+#else
+  #define HCD_STAT_INC(__HANDLE__, __FIELD__)
+#endif
 
 /**
   * @}
@@ -48,6 +48,18 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal_def.h"
 
+#ifndef USE_USB_FIFO_STATISTICS
+  #define USE_USB_FIFO_STATISTICS  0U
+#endif
+
+#ifndef USB_OTG_HOST_FIFO_PROFILE
+  #define USB_OTG_HOST_FIFO_PROFILE  USB_OTG_FIFO_PROFILE_BALANCED
+#endif
+
+#if (USB_OTG_HOST_FIFO_PROFILE > 2U)
+  #error "USB_OTG_HOST_FIFO_PROFILE must be USB_OTG_FIFO_PROFILE_BALANCED, _BULK or _PERIODIC"
+#endif
+
 /** @addtogroup STM32F4xx_HAL
   * @{
   */
@@ -216,6 +228,8 @@ typedef struct
 
   uint32_t  xfer_count;    /*!< Partial transfer length in case of multi packet transfer.                  */
 
+  uint32_t  fifo_count;    /*!< Bytes of an OUT transfer written to the Tx FIFO (slave mode).              */
+
   uint8_t   toggle_in;     /*!< IN transfer current toggle flag.
                                 This parameter must be a number between Min_Data = 0 and Max_Data = 1      */
 
@@ -233,6 +247,34 @@ typedef struct
                                            This parameter can be any value of @ref USB_OTG_HCStateTypeDef  */
 
 }USB_OTG_HCTypeDef;
+
+/** 
+  * @brief  Partitioning of the FIFO RAM in host mode, depths in 32-bit words.
+  *         The FIFOs are placed in this order from address 0.
+  */
+typedef struct
+{
+  uint16_t RxFifoSize;           /*!< Rx FIFO, shared by all IN channels                 */
+  uint16_t NPTxFifoSize;         /*!< Non-periodic Tx FIFO, control and bulk OUT         */
+  uint16_t PTxFifoSize;          /*!< Periodic Tx FIFO, interrupt and isochronous OUT    */
+} USB_OTG_HostFifoCfgTypeDef;
+
+#if (USE_USB_FIFO_STATISTICS == 1U)
+/** 
+  * @brief  Counters of the data FIFO copy routines.
+  *         A packet takes the slow path when its buffer is not 32-bit aligned,
+  *         a partial last word is counted as tail.
+  */
+typedef struct
+{
+  uint32_t WriteCount;           /*!< Packets written by USB_WritePacket()               */
+  uint32_t WriteUnalignedCount;  /*!< Packets written from an unaligned source buffer    */
+  uint32_t WriteTailCount;       /*!< Packets written with a partial last word           */
+  uint32_t ReadCount;            /*!< Packets read by USB_ReadPacket()                   */
+  uint32_t ReadUnalignedCount;   /*!< Packets read into an unaligned destination buffer  */
+  uint32_t ReadTailCount;        /*!< Packets read with a partial last word              */
+} USB_OTG_FifoStatTypeDef;
+#endif /* USE_USB_FIFO_STATISTICS */
   
 /* Exported constants --------------------------------------------------------*/
 
@@ -367,6 +409,29 @@ typedef struct
   * @}
   */  
    
+/** @defgroup USB_FIFO_Profile_  USB Host FIFO Profile
+  * @{
+  */
+#define USB_OTG_FIFO_PROFILE_BALANCED          0U   /*!< Default split                                     */
+#define USB_OTG_FIFO_PROFILE_BULK              1U   /*!< Large Rx and non-periodic Tx FIFO, MSD and CDC     */
+#define USB_OTG_FIFO_PROFILE_PERIODIC          2U   /*!< Large Rx FIFO for many interrupt IN endpoints, HID */
+/**
+  * @}
+  */
+
+/** @defgroup USB_FIFO_Size_  USB FIFO RAM Size
+  * @{
+  */
+#ifndef USB_OTG_FS_FIFO_WORDS
+  #define USB_OTG_FS_FIFO_WORDS                320U   /*!< 1.25 KB, smaller for the host tests of a profile which does not fit */
+#endif
+#define USB_OTG_HS_FIFO_WORDS                  1024U  /*!< 4 KB    */
+#define USB_OTG_FIFO_MIN_WORDS                 16U
+#define USB_OTG_NPTXFIFO_MAX_WORDS             256U
+/**
+  * @}
+  */
+
 #define HCCHAR_CTRL                            0U
 #define HCCHAR_ISOC                            1U
 #define HCCHAR_BULK                            2U
@@ -437,6 +502,9 @@ uint32_t          USB_ReadDevInEPInterrupt (USB_OTG_GlobalTypeDef *USBx , uint8_
 void              USB_ClearInterrupts (USB_OTG_GlobalTypeDef *USBx, uint32_t interrupt);
 
 HAL_StatusTypeDef USB_HostInit (USB_OTG_GlobalTypeDef *USBx, USB_OTG_CfgTypeDef cfg);
+HAL_StatusTypeDef USB_HostGetFifoProfile(USB_OTG_GlobalTypeDef *USBx, uint32_t profile, USB_OTG_HostFifoCfgTypeDef *pCfg);
+HAL_StatusTypeDef USB_HostSetFifoConfig(USB_OTG_GlobalTypeDef *USBx, const USB_OTG_HostFifoCfgTypeDef *pCfg);
+void              USB_HostGetFifoConfig(USB_OTG_GlobalTypeDef *USBx, USB_OTG_HostFifoCfgTypeDef *pCfg);
 HAL_StatusTypeDef USB_InitFSLSPClkSel(USB_OTG_GlobalTypeDef *USBx , uint8_t freq);
 HAL_StatusTypeDef USB_ResetPort(USB_OTG_GlobalTypeDef *USBx);
 HAL_StatusTypeDef USB_DriveVbus (USB_OTG_GlobalTypeDef *USBx, uint8_t state);
@@ -450,10 +518,15 @@ HAL_StatusTypeDef USB_HC_Init(USB_OTG_GlobalTypeDef *USBx,
                                   uint8_t ep_type,
                                   uint16_t mps);
 HAL_StatusTypeDef USB_HC_StartXfer(USB_OTG_GlobalTypeDef *USBx, USB_OTG_HCTypeDef *hc, uint8_t dma);
+uint32_t          USB_HC_FillTxFifo(USB_OTG_GlobalTypeDef *USBx, USB_OTG_HCTypeDef *hc);
 uint32_t          USB_HC_ReadInterrupt (USB_OTG_GlobalTypeDef *USBx);
 HAL_StatusTypeDef USB_HC_Halt(USB_OTG_GlobalTypeDef *USBx , uint8_t hc_num);
 HAL_StatusTypeDef USB_DoPing(USB_OTG_GlobalTypeDef *USBx , uint8_t ch_num);
 HAL_StatusTypeDef USB_StopHost(USB_OTG_GlobalTypeDef *USBx);
+#if (USE_USB_FIFO_STATISTICS == 1U)
+void              USB_GetFifoStatistics(USB_OTG_FifoStatTypeDef *pStats);
+void              USB_ResetFifoStatistics(void);
+#endif
 
 /**
   * @}
@@ -70,6 +70,7 @@
   */ 
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
 #include "stm32f4xx_hal.h"
 
 /** @addtogroup STM32F4xx_HAL_Driver
@@ -89,6 +90,9 @@
     defined(STM32F412Rx) || defined(STM32F412Cx) || defined(STM32F413xx) || defined(STM32F423xx)
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/* Interrupts which are only acknowledged in host mode */
+#define HCD_GINTSTS_ACK_ONLY   (USB_OTG_GINTSTS_PXFR_INCOMPISOOUT | USB_OTG_GINTSTS_IISOIXFR | \
+                                USB_OTG_GINTSTS_MMIS)
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
@@ -99,6 +103,17 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum);
 static void HCD_HC_OUT_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum); 
 static void HCD_RXQLVL_IRQHandler(HCD_HandleTypeDef *hhcd);
 static void HCD_Port_IRQHandler(HCD_HandleTypeDef *hhcd);
+static void HCD_TXFE_IRQHandler(HCD_HandleTypeDef *hhcd, uint32_t periodic);
+static void HCD_IRQ_Dispatch(HCD_HandleTypeDef *hhcd);
+static void HCD_Periodic_SOF(HCD_HandleTypeDef *hhcd);
+static void HCD_Periodic_Reset(HCD_HandleTypeDef *hhcd);
+static void HCD_Nak_SOF(HCD_HandleTypeDef *hhcd);
+static void HCD_NotifyURBChange(HCD_HandleTypeDef *hhcd, uint8_t chnum);
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+static void HCD_Mux_Reset(HCD_HandleTypeDef *hhcd);
+static void HCD_Mux_Schedule(HCD_HandleTypeDef *hhcd);
+static void HCD_Mux_Release(HCD_HandleTypeDef *hhcd, uint8_t chnum);
+#endif
 /**
   * @}
   */
@@ -152,8 +167,28 @@ HAL_StatusTypeDef HAL_HCD_Init(HCD_HandleTypeDef *hhcd)
   USB_SetCurrentMode(hhcd->Instance , USB_OTG_HOST_MODE);
   
   /* Init Host */
-  USB_HostInit(hhcd->Instance, hhcd->Init);
+  if (USB_HostInit(hhcd->Instance, hhcd->Init) != HAL_OK)
+  {
+    hhcd->State = HAL_HCD_STATE_ERROR;
+    return HAL_ERROR;
+  }
   
+#if (USE_HAL_HCD_STATISTICS == 1U)
+  /* Enable the DWT cycle counter used to time the interrupt handler */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  HAL_HCD_ResetStatistics(hhcd);
+#endif
+  HCD_Periodic_Reset(hhcd);
+  memset(hhcd->nak, 0, sizeof(hhcd->nak));
+  hhcd->NakWaitMask = 0U;
+  memset(&hhcd->FifoStats, 0, sizeof(hhcd->FifoStats));
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+  /* No channel is owned by the multiplexer before HAL_HCD_Mux_Init() */
+  memset(&hhcd->Mux, 0, sizeof(hhcd->Mux));
+  HCD_Mux_Reset(hhcd);
+#endif
+
   hhcd->State= HAL_HCD_STATE_READY;
   
   return HAL_OK;
@@ -202,6 +237,8 @@ HAL_StatusTypeDef HAL_HCD_HC_Init(HCD_HandleTypeDef *hhcd,
   hhcd->hc[ch_num].ep_num = epnum & 0x7F;
   hhcd->hc[ch_num].ep_is_in = ((epnum & 0x80) == 0x80);
   hhcd->hc[ch_num].speed = speed;
+  memset(&hhcd->nak[ch_num], 0, sizeof(hhcd->nak[ch_num]));
+  hhcd->NakWaitMask &= (uint16_t)~(1U << ch_num);
   
   status =  USB_HC_Init(hhcd->Instance, 
                         ch_num,
@@ -227,6 +264,7 @@ HAL_StatusTypeDef HAL_HCD_HC_Halt(HCD_HandleTypeDef *hhcd, uint8_t ch_num)
   HAL_StatusTypeDef status = HAL_OK;
   
   __HAL_LOCK(hhcd);   
+  hhcd->NakWaitMask &= (uint16_t)~(1U << ch_num);
   USB_HC_Halt(hhcd->Instance, ch_num);   
   __HAL_UNLOCK(hhcd);
   
@@ -448,108 +486,507 @@ HAL_StatusTypeDef HAL_HCD_HC_SubmitRequest(HCD_HandleTypeDef *hhcd,
 }
 
 /**
-  * @brief  Handle HCD interrupt request.
+  * @brief  Poll an interrupt IN channel in the frames its interval allows.
+  *         The channel is placed at the phase of the interval with the lowest
+  *         load, so channels with the same interval are spread across frames.
+  *         It is armed from the SOF interrupt for the next frame. A NAK ends
+  *         the poll silently, received data is reported with
+  *         HAL_HCD_HC_NotifyURBChange_Callback() and URB_DONE. pbuff is
+  *         filled again at the next poll, so the callback has to consume it.
   * @param  hhcd HCD handle
-  * @retval None
+  * @param  ch_num Channel number, initialized with HAL_HCD_HC_Init() as
+  *         interrupt IN channel.
+  * @param  interval Polling interval in frames (bInterval). It is rounded
+  *         down to a power of 2 and limited to HCD_PERIODIC_FRAMES.
+  * @param  pbuff pointer to the buffer receiving the data
+  * @param  length Size of the buffer
+  * @retval HAL status
   */
-void HAL_HCD_IRQHandler(HCD_HandleTypeDef *hhcd)
+HAL_StatusTypeDef HAL_HCD_HC_StartPeriodic(HCD_HandleTypeDef *hhcd,
+                                           uint8_t ch_num,
+                                           uint8_t interval,
+                                           uint8_t* pbuff,
+                                           uint16_t length)
 {
-  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
-  uint32_t i = 0U , interrupt = 0U;
+  HCD_PeriodicTypeDef *sched = &hhcd->Periodic;
+  uint32_t period = HCD_PERIODIC_FRAMES;
+  uint32_t phase = 0U, best_phase = 0U;
+  uint32_t frame = 0U, load = 0U, best_load = 0xFFFFFFFFU;
+  uint32_t primask;
   
-  /* Ensure that we are in device mode */
-  if (USB_GetMode(hhcd->Instance) == USB_OTG_MODE_HOST)
+  if ((hhcd->hc[ch_num].ep_type != EP_TYPE_INTR) || (hhcd->hc[ch_num].ep_is_in == 0U) ||
+      ((sched->ScheduledMask & (1U << ch_num)) != 0U))
   {
-    /* Avoid spurious interrupt */
-    if(__HAL_HCD_IS_INVALID_INTERRUPT(hhcd)) 
+    return HAL_ERROR;
+  }
+  
+  /* Round down to a power of 2 */
+  while ((period > 1U) && (period > interval))
+  {
+    period >>= 1U;
+  }
+  
+  /* Find the phase whose busiest frame has the lowest load */
+  for (phase = 0U; phase < period; phase++)
+  {
+    load = 0U;
+    for (frame = phase; frame < HCD_PERIODIC_FRAMES; frame += period)
     {
-      return;
+      if (sched->Load[frame] > load)
+      {
+        load = sched->Load[frame];
+      }
     }
-    
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_PXFR_INCOMPISOOUT))
+    if (load < best_load)
     {
-      /* Incorrect mode, acknowledge the interrupt */
-      __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_PXFR_INCOMPISOOUT);
+      best_load  = load;
+      best_phase = phase;
     }
-    
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_IISOIXFR))
+  }
+  
+  __HAL_LOCK(hhcd);
+  primask = __get_PRIMASK();
+  __disable_irq();
+  for (frame = best_phase; frame < HCD_PERIODIC_FRAMES; frame += period)
+  {
+    sched->Load[frame]++;
+  }
+  sched->ch[ch_num].pbuff    = pbuff;
+  sched->ch[ch_num].length   = length;
+  sched->ch[ch_num].interval = (uint8_t)period;
+  sched->ch[ch_num].phase    = (uint8_t)best_phase;
+  sched->ScheduledMask      |= (uint16_t)(1U << ch_num);
+  __set_PRIMASK(primask);
+  __HAL_UNLOCK(hhcd);
+  
+  return HAL_OK;
+}
+
+/**
+  * @brief  Stop polling a channel started with HAL_HCD_HC_StartPeriodic().
+  *         A poll in progress is halted without a notification.
+  * @param  hhcd HCD handle
+  * @param  ch_num Channel number.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_HCD_HC_StopPeriodic(HCD_HandleTypeDef *hhcd, uint8_t ch_num)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  HCD_PeriodicTypeDef *sched = &hhcd->Periodic;
+  uint32_t frame = 0U;
+  uint32_t primask;
+  
+  if ((sched->ScheduledMask & (1U << ch_num)) == 0U)
+  {
+    return HAL_ERROR;
+  }
+  
+  __HAL_LOCK(hhcd);
+  primask = __get_PRIMASK();
+  __disable_irq();
+  sched->ScheduledMask &= (uint16_t)~(1U << ch_num);
+  for (frame = sched->ch[ch_num].phase; frame < HCD_PERIODIC_FRAMES; frame += sched->ch[ch_num].interval)
+  {
+    sched->Load[frame]--;
+  }
+  if ((sched->ActiveMask & (1U << ch_num)) != 0U)
+  {
+    /* ActiveMask is cleared by the CHH interrupt */
+    __HAL_HCD_UNMASK_HALT_HC_INT(ch_num);
+    USB_HC_Halt(hhcd->Instance, ch_num);
+  }
+  __set_PRIMASK(primask);
+  __HAL_UNLOCK(hhcd);
+  
+  return HAL_OK;
+}
+
+/**
+  * @brief  Select how a bulk IN channel is retried after a NAK.
+  *         A slow device NAKs every retry, with HCD_NAK_RETRY_IMMEDIATE this
+  *         raises an interrupt per NAK. The other policies re-enable the
+  *         channel from the SOF interrupt instead. The back-off is reset by
+  *         each completed transfer, so a device delivering data is retried
+  *         after a single frame. HAL_HCD_HC_Init() selects
+  *         HCD_NAK_RETRY_IMMEDIATE and clears the NAK counter.
+  * @param  hhcd HCD handle
+  * @param  ch_num Channel number.
+  * @param  policy Retry policy.
+  *          This parameter can be one of these values:
+  *            HCD_NAK_RETRY_IMMEDIATE: retry in the NAK interrupt
+  *            HCD_NAK_RETRY_FRAME: retry in the next frame
+  *            HCD_NAK_RETRY_BACKOFF: wait 1, 2, 4 ... max_frames frames
+  * @param  max_frames Longest wait for HCD_NAK_RETRY_BACKOFF, 1 to 255
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_HCD_HC_SetNakPolicy(HCD_HandleTypeDef *hhcd, uint8_t ch_num, uint8_t policy, uint8_t max_frames)
+{
+  if ((policy > HCD_NAK_RETRY_BACKOFF) || ((policy == HCD_NAK_RETRY_BACKOFF) && (max_frames == 0U)))
+  {
+    return HAL_ERROR;
+  }
+  
+  __HAL_LOCK(hhcd);
+  hhcd->nak[ch_num].Policy    = policy;
+  hhcd->nak[ch_num].MaxFrames = (policy == HCD_NAK_RETRY_BACKOFF) ? max_frames : 1U;
+  hhcd->nak[ch_num].Delay     = 1U;
+  __HAL_UNLOCK(hhcd);
+  
+  return HAL_OK;
+}
+
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+/**
+  * @brief  Let logical pipes share host channels.
+  *         A pipe gets a channel for each request only and returns it when
+  *         the request ends, so more endpoints can be open than the core has
+  *         channels. Waiting requests are started by priority class: control
+  *         first, then interrupt and isochronous, then bulk, round robin
+  *         within a class. A channel is only reprogrammed when it was last
+  *         used by another pipe. The owned channels must not be used with
+  *         the HAL_HCD_HC_xxx() functions.
+  * @param  hhcd HCD handle
+  * @param  ch_mask Channels owned by the multiplexer, bit n for channel n
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_HCD_Mux_Init(HCD_HandleTypeDef *hhcd, uint16_t ch_mask)
+{
+  __HAL_LOCK(hhcd);
+  memset(&hhcd->Mux, 0, sizeof(hhcd->Mux));
+  hhcd->Mux.ChMask = ch_mask & (uint16_t)((1U << hhcd->Init.Host_channels) - 1U);
+  HCD_Mux_Reset(hhcd);
+  __HAL_UNLOCK(hhcd);
+  
+  return HAL_OK;
+}
+
+/**
+  * @brief  Open a logical pipe.
+  * @param  hhcd HCD handle
+  * @param  pipe_num Receives the pipe number
+  * @param  epnum Endpoint address including the direction bit
+  * @param  dev_address Current device address
+  * @param  speed Current device speed
+  * @param  ep_type Endpoint Type
+  * @param  mps Max Packet Size
+  * @retval HAL status, HAL_ERROR if all HCD_MAX_PIPES pipes are open,
+  *         HAL_BUSY if the free ones are closed but their channel has
+  *         not halted yet
+  */
+HAL_StatusTypeDef HAL_HCD_Pipe_Open(HCD_HandleTypeDef *hhcd,
+                                    uint8_t *pipe_num,
+                                    uint8_t epnum,
+                                    uint8_t dev_address,
+                                    uint8_t speed,
+                                    uint8_t ep_type,
+                                    uint16_t mps)
+{
+  HCD_PipeTypeDef *pipe;
+  HAL_StatusTypeDef status = HAL_ERROR;
+  uint32_t i = 0U;
+  
+  __HAL_LOCK(hhcd);
+  for (i = 0U; i < HCD_MAX_PIPES; i++)
+  {
+    pipe = &hhcd->Mux.pipe[i];
+    if (pipe->is_open != 0U)
     {
-      /* Incorrect mode, acknowledge the interrupt */
-      __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_IISOIXFR);
+      continue;
     }
-    
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_PTXFE))
+    /* A closed pipe keeps its number until the halt of its channel is reported */
+    if (memchr(hhcd->Mux.ChPipe, (int)i, sizeof(hhcd->Mux.ChPipe)) != NULL)
     {
-      /* Incorrect mode, acknowledge the interrupt */
-      __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_PTXFE);
-    }   
-    
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_MMIS))
+      status = HAL_BUSY;
+    }
+    else
     {
-      /* Incorrect mode, acknowledge the interrupt */
-      __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_MMIS);
-    }     
-    
-    /* Handle Host Disconnect Interrupts */
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_DISCINT))
+      memset(pipe, 0, sizeof(*pipe));
+      pipe->epnum       = epnum;
+      pipe->dev_address = dev_address;
+      pipe->speed       = speed;
+      pipe->ep_type     = ep_type;
+      pipe->mps         = mps;
+      pipe->is_open     = 1U;
+      *pipe_num = (uint8_t)i;
+      __HAL_UNLOCK(hhcd);
+      return HAL_OK;
+    }
+  }
+  __HAL_UNLOCK(hhcd);
+  
+  return status;
+}
+
+/**
+  * @brief  Close a logical pipe. A request in progress is halted and
+  *         not reported anymore. The pipe number is not handed out again
+  *         by HAL_HCD_Pipe_Open() before the channel has halted.
+  * @param  hhcd HCD handle
+  * @param  pipe_num Pipe number
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_HCD_Pipe_Close(HCD_HandleTypeDef *hhcd, uint8_t pipe_num)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  HCD_MuxTypeDef *mux = &hhcd->Mux;
+  uint32_t ch = 0U, cls = 0U;
+  uint32_t primask;
+  
+  if ((pipe_num >= HCD_MAX_PIPES) || (mux->pipe[pipe_num].is_open == 0U))
+  {
+    return HAL_ERROR;
+  }
+  
+  primask = __get_PRIMASK();
+  __disable_irq();
+  mux->pipe[pipe_num].is_open = 0U;
+  for (cls = 0U; cls < 3U; cls++)
+  {
+    mux->Pending[cls] &= ~(1UL << pipe_num);
+  }
+  for (ch = 0U; ch < 15U; ch++)
+  {
+    if (mux->ChOwner[ch] == pipe_num)
     {
-      
-      /* Cleanup HPRT */
-      USBx_HPRT0 &= ~(USB_OTG_HPRT_PENA | USB_OTG_HPRT_PCDET |\
-        USB_OTG_HPRT_PENCHNG | USB_OTG_HPRT_POCCHNG );
-      
-      /* Handle Host Port Interrupts */
-      HAL_HCD_Disconnect_Callback(hhcd);
-      USB_InitFSLSPClkSel(hhcd->Instance ,HCFG_48_MHZ );
-      __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_DISCINT);
+      mux->ChOwner[ch] = HCD_PIPE_NONE;
     }
+    if (mux->ChPipe[ch] == pipe_num)
+    {
+      /* Released by HCD_Mux_Release() once halted, HC_HALTED is not retried */
+      hhcd->NakWaitMask &= (uint16_t)~(1U << ch);
+      hhcd->hc[ch].state = HC_HALTED;
+      __HAL_HCD_UNMASK_HALT_HC_INT(ch);
+      USB_HC_Halt(hhcd->Instance, (uint8_t)ch);
+    }
+  }
+  __set_PRIMASK(primask);
+  
+  return HAL_OK;
+}
+
+/**
+  * @brief  Submit a new URB on a logical pipe. It is started as soon as
+  *         a channel is free, the end is reported with
+  *         HAL_HCD_Pipe_NotifyURBChange_Callback().
+  * @param  hhcd HCD handle
+  * @param  pipe_num Pipe number
+  * @param  direction 0 : Output / 1 : Input
+  * @param  token 0: HC_PID_SETUP / 1: HC_PID_DATA1
+  * @param  pbuff pointer to URB data
+  * @param  length Length of URB data
+  * @param  do_ping activate do ping protocol (for high speed only)
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_HCD_Pipe_SubmitRequest(HCD_HandleTypeDef *hhcd,
+                                             uint8_t pipe_num,
+                                             uint8_t direction,
+                                             uint8_t token,
+                                             uint8_t* pbuff,
+                                             uint16_t length,
+                                             uint8_t do_ping)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  HCD_MuxTypeDef *mux = &hhcd->Mux;
+  HCD_PipeTypeDef *pipe;
+  uint32_t cls = 0U;
+  uint32_t primask;
+  
+  if ((pipe_num >= HCD_MAX_PIPES) || (mux->pipe[pipe_num].is_open == 0U))
+  {
+    return HAL_ERROR;
+  }
+  pipe = &mux->pipe[pipe_num];
+  switch (pipe->ep_type)
+  {
+  case EP_TYPE_CTRL:
+    cls = 0U;
+    break;
+  case EP_TYPE_BULK:
+    cls = 2U;
+    break;
+  default:
+    cls = 1U;
+    break;
+  }
+  
+  primask = __get_PRIMASK();
+  __disable_irq();
+  pipe->direction  = direction;
+  pipe->token      = token;
+  pipe->pbuff      = pbuff;
+  pipe->length     = length;
+  pipe->do_ping    = do_ping;
+  pipe->xfer_count = 0U;
+  pipe->urb_state  = URB_IDLE;
+  pipe->is_waiting = 0U;
+  pipe->WaitStart  = (uint16_t)(USBx_HOST->HFNUM & USB_OTG_HFNUM_FRNUM);
+  mux->Pending[cls] |= (1UL << pipe_num);
+  HCD_Mux_Schedule(hhcd);
+  if ((mux->Pending[cls] & (1UL << pipe_num)) != 0U)
+  {
+    pipe->is_waiting = 1U;
+  }
+  __set_PRIMASK(primask);
+  
+  return HAL_OK;
+}
+#endif /* USE_HAL_HCD_CHANNEL_MUX */
+
+/**
+  * @brief  Handle HCD interrupt request.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+void HAL_HCD_IRQHandler(HCD_HandleTypeDef *hhcd)
+{
+#if (USE_HAL_HCD_STATISTICS == 1U)
+  uint32_t cycles = DWT->CYCCNT;
+
+  HCD_IRQ_Dispatch(hhcd);
+  cycles = DWT->CYCCNT - cycles;
+  hhcd->Stats.IrqCount++;
+  hhcd->Stats.IrqCycles += cycles;
+  if (cycles > hhcd->Stats.IrqCyclesMax)
+  {
+    hhcd->Stats.IrqCyclesMax = cycles;
+  }
+#else
+  HCD_IRQ_Dispatch(hhcd);
+#endif
+}
+
+/**
+  * @}
+  */
+
+/** @addtogroup HCD_Private_Functions
+  * @{
+  */
+/**
+  * @brief  Dispatch the pending HCD interrupts to their handlers.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+static void HCD_IRQ_Dispatch(HCD_HandleTypeDef *hhcd)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  uint32_t ch = 0U , interrupt = 0U;
+  uint32_t pending = 0U, bit = 0U;
+  
+  /* Ensure that we are in device mode */
+  if (USB_GetMode(hhcd->Instance) == USB_OTG_MODE_HOST)
+  {
+    /* Read the enabled pending interrupts once, GINTSTS & GINTMSK */
+    pending = USB_ReadInterrupts(USBx);
     
-    /* Handle Host Port Interrupts */
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_HPRTINT))
+    /* Avoid spurious interrupt */
+    if (pending == 0U) 
     {
-      HCD_Port_IRQHandler (hhcd);
+      return;
     }
     
-    /* Handle Host SOF Interrupts */
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_SOF))
+    /* Incorrect mode, acknowledge these interrupts with a single write */
+    if ((pending & HCD_GINTSTS_ACK_ONLY) != 0U)
     {
-      HAL_HCD_SOF_Callback(hhcd);
-      __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_SOF);
+      if ((pending & USB_OTG_GINTSTS_PXFR_INCOMPISOOUT) != 0U)
+      {
+        hhcd->FifoStats.IncompletePeriodicCount++;
+      }
+      __HAL_HCD_CLEAR_FLAG(hhcd, pending & HCD_GINTSTS_ACK_ONLY);
+      pending &= ~HCD_GINTSTS_ACK_ONLY;
     }
     
-    /* Handle Host channel Interrupts */
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_HCINT))
+    /* Handle the set bits from the highest to the lowest one */
+    while (pending != 0U)
     {
-      interrupt = USB_HC_ReadInterrupt(hhcd->Instance);
-      for (i = 0U; i < hhcd->Init.Host_channels; i++)
+      bit = 31U - __CLZ(pending);
+      pending &= ~(1U << bit);
+      switch (1U << bit)
       {
-        if (interrupt & (1U << i))
+      /* Handle Host Disconnect Interrupts */
+      case USB_OTG_GINTSTS_DISCINT:
+        /* Cleanup HPRT */
+        USBx_HPRT0 &= ~(USB_OTG_HPRT_PENA | USB_OTG_HPRT_PCDET |\
+          USB_OTG_HPRT_PENCHNG | USB_OTG_HPRT_POCCHNG );
+        
+        /* Handle Host Port Interrupts */
+        HCD_STAT_INC(hhcd, DisconnectCount);
+        HCD_Periodic_Reset(hhcd);
+        hhcd->NakWaitMask = 0U;
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+        HCD_Mux_Reset(hhcd);
+#endif
+        HAL_HCD_Disconnect_Callback(hhcd);
+        USB_InitFSLSPClkSel(hhcd->Instance ,HCFG_48_MHZ );
+        __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_DISCINT);
+        break;
+        
+      /* Handle Host channel Interrupts, walk the set bits of HAINT */
+      case USB_OTG_GINTSTS_HCINT:
+        interrupt = USB_HC_ReadInterrupt(hhcd->Instance) & ((1U << hhcd->Init.Host_channels) - 1U);
+        while (interrupt != 0U)
         {
-          if ((USBx_HC(i)->HCCHAR) &  USB_OTG_HCCHAR_EPDIR)
+          ch = 31U - __CLZ(interrupt);
+          interrupt &= ~(1U << ch);
+          if ((USBx_HC(ch)->HCCHAR) &  USB_OTG_HCCHAR_EPDIR)
           {
-            HCD_HC_IN_IRQHandler(hhcd, i);
+            HCD_HC_IN_IRQHandler(hhcd, (uint8_t)ch);
           }
           else
           {
-            HCD_HC_OUT_IRQHandler (hhcd, i);
+            HCD_HC_OUT_IRQHandler (hhcd, (uint8_t)ch);
           }
         }
+        __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_HCINT);
+        break;
+        
+      /* Handle Periodic Tx FIFO Empty Interrupts */
+      case USB_OTG_GINTSTS_PTXFE:
+        HCD_TXFE_IRQHandler(hhcd, 1U);
+        break;
+        
+      /* Handle Host Port Interrupts */
+      case USB_OTG_GINTSTS_HPRTINT:
+        HCD_Port_IRQHandler (hhcd);
+        break;
+        
+      /* Handle Rx Queue Level Interrupts */
+      case USB_OTG_GINTSTS_RXFLVL:
+        USB_MASK_INTERRUPT(hhcd->Instance, USB_OTG_GINTSTS_RXFLVL);
+        
+        HCD_RXQLVL_IRQHandler (hhcd);
+        
+        USB_UNMASK_INTERRUPT(hhcd->Instance, USB_OTG_GINTSTS_RXFLVL);
+        break;
+        
+      /* Handle Non-Periodic Tx FIFO Empty Interrupts */
+      case USB_OTG_GINTSTS_NPTXFE:
+        HCD_TXFE_IRQHandler(hhcd, 0U);
+        break;
+        
+      /* Handle Host SOF Interrupts */
+      case USB_OTG_GINTSTS_SOF:
+        HCD_Periodic_SOF(hhcd);
+        HCD_Nak_SOF(hhcd);
+        HAL_HCD_SOF_Callback(hhcd);
+        __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_SOF);
+        break;
+        
+      default:
+        break;
       }
-      __HAL_HCD_CLEAR_FLAG(hhcd, USB_OTG_GINTSTS_HCINT);
-    } 
-    
-    /* Handle Rx Queue Level Interrupts */
-    if(__HAL_HCD_GET_FLAG(hhcd, USB_OTG_GINTSTS_RXFLVL))
-    {
-      USB_MASK_INTERRUPT(hhcd->Instance, USB_OTG_GINTSTS_RXFLVL);
-      
-      HCD_RXQLVL_IRQHandler (hhcd);
-      
-      USB_UNMASK_INTERRUPT(hhcd->Instance, USB_OTG_GINTSTS_RXFLVL);
     }
   }
 }
 
+/**
+  * @}
+  */
+
+/** @addtogroup HCD_Exported_Functions_Group2
+  * @{
+  */
+
 /**
   * @brief  SOF callback.
   * @param  hhcd HCD handle
@@ -618,6 +1055,26 @@ __weak void HAL_HCD_HC_NotifyURBChange_Callback(HCD_HandleTypeDef *hhcd, uint8_t
    */
 }
 
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+/**
+  * @brief  Notify URB state change callback of a logical pipe.
+  * @param  hhcd HCD handle
+  * @param  pipe_num Pipe number
+  * @param  urb_state State of the request, see HAL_HCD_HC_NotifyURBChange_Callback()
+  * @retval None
+  */
+__weak void HAL_HCD_Pipe_NotifyURBChange_Callback(HCD_HandleTypeDef *hhcd, uint8_t pipe_num, HCD_URBStateTypeDef urb_state)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hhcd);
+  UNUSED(pipe_num);
+  UNUSED(urb_state);
+  /* NOTE : This function Should not be modified, when the callback is needed,
+            the HAL_HCD_Pipe_NotifyURBChange_Callback could be implemented in the user file
+   */
+}
+#endif /* USE_HAL_HCD_CHANNEL_MUX */
+
 /**
   * @}
   */
@@ -665,6 +1122,31 @@ HAL_StatusTypeDef HAL_HCD_Stop(HCD_HandleTypeDef *hhcd)
   return HAL_OK;
 }
 
+/**
+  * @brief  Partition the FIFO RAM of the core, replacing the profile
+  *         selected with USB_OTG_HOST_FIFO_PROFILE.
+  *         Call after HAL_HCD_Init() and before HAL_HCD_Start().
+  *         The FIFO statistics are reset, they count the events of the new
+  *         partition.
+  * @param  hhcd HCD handle
+  * @param  pCfg FIFO sizes in words, see USB_HostSetFifoConfig()
+  * @retval HAL status, HAL_ERROR if the sizes do not fit into the FIFO RAM,
+  *         the partition and the statistics are then left unchanged
+  */
+HAL_StatusTypeDef HAL_HCD_SetFifoConfig(HCD_HandleTypeDef *hhcd, const HCD_FifoCfgTypeDef *pCfg)
+{
+  HAL_StatusTypeDef status;
+  
+  __HAL_LOCK(hhcd);
+  status = USB_HostSetFifoConfig(hhcd->Instance, pCfg);
+  if (status == HAL_OK)
+  {
+    memset(&hhcd->FifoStats, 0, sizeof(hhcd->FifoStats));
+  }
+  __HAL_UNLOCK(hhcd);
+  return status;
+}
+
 /**
   * @brief  Reset the host port.
   * @param  hhcd HCD handle
@@ -778,6 +1260,126 @@ uint32_t HAL_HCD_GetCurrentSpeed(HCD_HandleTypeDef *hhcd)
   return (USB_GetHostSpeed(hhcd->Instance));
 }
 
+/**
+  * @brief  Return the number of channels polled in each frame of the
+  *         periodic schedule. Frame n of the bus is slot n % HCD_PERIODIC_FRAMES.
+  * @param  hhcd HCD handle
+  * @param  pLoad Receives HCD_PERIODIC_FRAMES entries
+  * @retval None
+  */
+void HAL_HCD_GetPeriodicLoad(HCD_HandleTypeDef *hhcd, uint8_t *pLoad)
+{
+  memcpy(pLoad, hhcd->Periodic.Load, sizeof(hhcd->Periodic.Load));
+}
+
+/**
+  * @brief  Return the number of NAKs received on a channel since HAL_HCD_HC_Init().
+  * @param  hhcd HCD handle
+  * @param  chnum Channel number.
+  * @retval NAK count
+  */
+uint32_t HAL_HCD_HC_GetNakCount(HCD_HandleTypeDef *hhcd, uint8_t chnum)
+{
+  return hhcd->nak[chnum].NakCount;
+}
+
+/**
+  * @brief  Return the current FIFO partition.
+  * @param  hhcd HCD handle
+  * @param  pCfg Receives the FIFO sizes in words
+  * @retval None
+  */
+void HAL_HCD_GetFifoConfig(HCD_HandleTypeDef *hhcd, HCD_FifoCfgTypeDef *pCfg)
+{
+  USB_HostGetFifoConfig(hhcd->Instance, pCfg);
+}
+
+/**
+  * @brief  Return a snapshot of the FIFO underrun and overrun counters.
+  * @param  hhcd HCD handle
+  * @param  pStats Receives the counters
+  * @retval None
+  */
+void HAL_HCD_GetFifoStatistics(HCD_HandleTypeDef *hhcd, HCD_FifoStatTypeDef *pStats)
+{
+  uint32_t primask = __get_PRIMASK();
+  
+  __disable_irq();
+  *pStats = hhcd->FifoStats;
+  __set_PRIMASK(primask);
+}
+
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+/**
+  * @brief  Return the URB state of a logical pipe.
+  * @param  hhcd HCD handle
+  * @param  pipe_num Pipe number
+  * @retval URB state
+  */
+HCD_URBStateTypeDef HAL_HCD_Pipe_GetURBState(HCD_HandleTypeDef *hhcd, uint8_t pipe_num)
+{
+  return hhcd->Mux.pipe[pipe_num].urb_state;
+}
+
+/**
+  * @brief  Return the last transfer size of a logical pipe.
+  * @param  hhcd HCD handle
+  * @param  pipe_num Pipe number
+  * @retval last transfer size in byte
+  */
+uint32_t HAL_HCD_Pipe_GetXferCount(HCD_HandleTypeDef *hhcd, uint8_t pipe_num)
+{
+  return hhcd->Mux.pipe[pipe_num].xfer_count;
+}
+
+/**
+  * @brief  Return a snapshot of the channel reuse and wait time counters.
+  *         Average wait per waiting request is WaitFrames / WaitCount.
+  * @param  hhcd HCD handle
+  * @param  pStats Receives the counters
+  * @retval None
+  */
+void HAL_HCD_GetMuxStatistics(HCD_HandleTypeDef *hhcd, HCD_MuxStatTypeDef *pStats)
+{
+  uint32_t primask = __get_PRIMASK();
+  
+  __disable_irq();
+  *pStats = hhcd->Mux.Stats;
+  __set_PRIMASK(primask);
+}
+#endif /* USE_HAL_HCD_CHANNEL_MUX */
+
+#if (USE_HAL_HCD_STATISTICS == 1U)
+/**
+  * @brief  Return a snapshot of the interrupt and transfer statistics.
+  * @param  hhcd HCD handle
+  * @param  pStats Receives the counters
+  * @retval None
+  */
+void HAL_HCD_GetStatistics(HCD_HandleTypeDef *hhcd, HCD_StatisticsTypeDef *pStats)
+{
+  uint32_t primask = __get_PRIMASK();
+  
+  __disable_irq();
+  *pStats = hhcd->Stats;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear all interrupt and transfer statistics.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+void HAL_HCD_ResetStatistics(HCD_HandleTypeDef *hhcd)
+{
+  uint32_t primask = __get_PRIMASK();
+  
+  __disable_irq();
+  memset(&hhcd->Stats, 0, sizeof(hhcd->Stats));
+  __set_PRIMASK(primask);
+}
+#endif /* USE_HAL_HCD_STATISTICS */
+
 /**
   * @}
   */
@@ -813,6 +1415,7 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
   
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_STALL)  
   {
+    HCD_STAT_INC(hhcd, StallCount);
     __HAL_HCD_UNMASK_HALT_HC_INT(chnum);
     hhcd->hc[chnum].state = HC_STALL;
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_NAK);
@@ -827,14 +1430,29 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
     hhcd->hc[chnum].state = HC_DATATGLERR;
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_DTERR);
   }    
+  else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_BBERR)
+  {
+    HCD_STAT_INC(hhcd, BabbleCount);
+    __HAL_HCD_UNMASK_HALT_HC_INT(chnum);
+    hhcd->hc[chnum].state = HC_BBLERR;
+    USB_HC_Halt(hhcd->Instance, chnum);
+    __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_BBERR);
+  }
   
   if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_FRMOR)
   {
+    hhcd->FifoStats.FrameOverrunCount++;
     __HAL_HCD_UNMASK_HALT_HC_INT(chnum); 
     USB_HC_Halt(hhcd->Instance, chnum);  
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_FRMOR);
   }
   
+  else if (((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_XFRC) && (hhcd->hc[chnum].state == HC_BBLERR))
+  {
+    /* Rx overrun, already halting, the CHH interrupt reports URB_ERROR */
+    __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_XFRC);
+  }
+  
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_XFRC)
   {
     
@@ -846,8 +1464,11 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
     
     hhcd->hc[chnum].state = HC_XFRC;
     hhcd->hc[chnum].ErrCnt = 0U;
+    hhcd->nak[chnum].Delay = 1U;
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_XFRC);
     
+    /* Toggle before the notification, the multiplexer saves it with the pipe */
+    hhcd->hc[chnum].toggle_in ^= 1U;
     
     if ((hhcd->hc[chnum].ep_type == EP_TYPE_CTRL)||
         (hhcd->hc[chnum].ep_type == EP_TYPE_BULK))
@@ -860,11 +1481,11 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
     else if(hhcd->hc[chnum].ep_type == EP_TYPE_INTR)
     {
       USBx_HC(chnum)->HCCHAR |= USB_OTG_HCCHAR_ODDFRM;
+      hhcd->Periodic.ActiveMask &= (uint16_t)~(1U << chnum);
       hhcd->hc[chnum].urb_state = URB_DONE; 
-      HAL_HCD_HC_NotifyURBChange_Callback(hhcd, chnum, hhcd->hc[chnum].urb_state);
+      HCD_STAT_INC(hhcd, XferCount);
+      HCD_NotifyURBChange(hhcd, chnum);
     }
-    hhcd->hc[chnum].toggle_in ^= 1U;
-    
   }
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_CHH)
   {
@@ -873,6 +1494,7 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
     if(hhcd->hc[chnum].state == HC_XFRC)
     {
       hhcd->hc[chnum].urb_state  = URB_DONE;      
+      HCD_STAT_INC(hhcd, XferCount);
     }
     
     else if (hhcd->hc[chnum].state == HC_STALL) 
@@ -880,6 +1502,12 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
       hhcd->hc[chnum].urb_state  = URB_STALL;
     }   
     
+    else if (hhcd->hc[chnum].state == HC_BBLERR) 
+    {
+      hhcd->hc[chnum].ErrCnt++;
+      hhcd->hc[chnum].urb_state  = URB_ERROR;
+    }   
+    
     else if((hhcd->hc[chnum].state == HC_XACTERR) ||
             (hhcd->hc[chnum].state == HC_DATATGLERR))
     {
@@ -900,11 +1528,31 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
       USBx_HC(chnum)->HCCHAR = tmpreg;
     }
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_CHH);
-    HAL_HCD_HC_NotifyURBChange_Callback(hhcd, chnum, hhcd->hc[chnum].urb_state);
+    
+    if ((hhcd->Periodic.ScheduledMask & (1U << chnum)) != 0U)
+    {
+      if (hhcd->hc[chnum].urb_state != URB_NOTREADY)
+      {
+        hhcd->Periodic.ActiveMask &= (uint16_t)~(1U << chnum);
+      }
+      /* NAK or frame overrun: nothing to report, polled again in its next frame */
+      if ((hhcd->hc[chnum].state == HC_NAK) || (hhcd->hc[chnum].state == HC_IDLE))
+      {
+        return;
+      }
+    }
+    else if ((hhcd->Periodic.ActiveMask & (1U << chnum)) != 0U)
+    {
+      /* Poll halted by HAL_HCD_HC_StopPeriodic(), nothing to report */
+      hhcd->Periodic.ActiveMask &= (uint16_t)~(1U << chnum);
+      return;
+    }
+    HCD_NotifyURBChange(hhcd, chnum);
   }  
   
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_TXERR)
   {
+    HCD_STAT_INC(hhcd, XactErrCount);
     __HAL_HCD_UNMASK_HALT_HC_INT(chnum); 
     hhcd->hc[chnum].ErrCnt++;
     hhcd->hc[chnum].state = HC_XACTERR;
@@ -913,6 +1561,7 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
   }
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_NAK)
   {  
+    HCD_STAT_INC(hhcd, NakCount);
     if(hhcd->hc[chnum].ep_type == EP_TYPE_INTR)
     {
       __HAL_HCD_UNMASK_HALT_HC_INT(chnum); 
@@ -921,9 +1570,22 @@ static void HCD_HC_IN_IRQHandler(HCD_HandleTypeDef *hhcd, uint8_t chnum)
     
      /* Clear the NAK flag before re-enabling the channel for new IN request */
     hhcd->hc[chnum].state = HC_NAK;
+    hhcd->nak[chnum].NakCount++;
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_NAK);
     
-    if  ((hhcd->hc[chnum].ep_type == EP_TYPE_CTRL)||
+    if ((hhcd->hc[chnum].ep_type == EP_TYPE_BULK) &&
+        (hhcd->nak[chnum].Policy != HCD_NAK_RETRY_IMMEDIATE))
+    {
+      /* re-activated by HCD_Nak_SOF() */
+      hhcd->nak[chnum].Wait = hhcd->nak[chnum].Delay;
+      if (hhcd->nak[chnum].Delay < hhcd->nak[chnum].MaxFrames)
+      {
+        hhcd->nak[chnum].Delay = (hhcd->nak[chnum].Delay > (hhcd->nak[chnum].MaxFrames / 2U)) ?
+                                  hhcd->nak[chnum].MaxFrames : (uint8_t)(hhcd->nak[chnum].Delay * 2U);
+      }
+      hhcd->NakWaitMask |= (uint16_t)(1U << chnum);
+    }
+    else if  ((hhcd->hc[chnum].ep_type == EP_TYPE_CTRL)||
               (hhcd->hc[chnum].ep_type == EP_TYPE_BULK))
     {
       /* re-activate the channel */
@@ -976,6 +1638,7 @@ static void HCD_HC_OUT_IRQHandler  (HCD_HandleTypeDef *hhcd, uint8_t chnum)
   
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_FRMOR)
   {
+    hhcd->FifoStats.FrameOverrunCount++;
     __HAL_HCD_UNMASK_HALT_HC_INT(chnum); 
     USB_HC_Halt(hhcd->Instance, chnum);  
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_FRMOR);
@@ -993,6 +1656,7 @@ static void HCD_HC_OUT_IRQHandler  (HCD_HandleTypeDef *hhcd, uint8_t chnum)
 
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_STALL)  
   {
+    HCD_STAT_INC(hhcd, StallCount);
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_STALL);  
     __HAL_HCD_UNMASK_HALT_HC_INT(chnum);
     USB_HC_Halt(hhcd->Instance, chnum);   
@@ -1001,6 +1665,8 @@ static void HCD_HC_OUT_IRQHandler  (HCD_HandleTypeDef *hhcd, uint8_t chnum)
 
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_NAK)
   {  
+    HCD_STAT_INC(hhcd, NakCount);
+    hhcd->nak[chnum].NakCount++;
     hhcd->hc[chnum].ErrCnt = 0U;  
     __HAL_HCD_UNMASK_HALT_HC_INT(chnum); 
     USB_HC_Halt(hhcd->Instance, chnum);   
@@ -1010,6 +1676,7 @@ static void HCD_HC_OUT_IRQHandler  (HCD_HandleTypeDef *hhcd, uint8_t chnum)
 
   else if ((USBx_HC(chnum)->HCINT) &  USB_OTG_HCINT_TXERR)
   {
+    HCD_STAT_INC(hhcd, XactErrCount);
     __HAL_HCD_UNMASK_HALT_HC_INT(chnum); 
     USB_HC_Halt(hhcd->Instance, chnum);      
     hhcd->hc[chnum].state = HC_XACTERR;  
@@ -1033,6 +1700,7 @@ static void HCD_HC_OUT_IRQHandler  (HCD_HandleTypeDef *hhcd, uint8_t chnum)
     if(hhcd->hc[chnum].state == HC_XFRC)
     {
       hhcd->hc[chnum].urb_state  = URB_DONE;
+      HCD_STAT_INC(hhcd, XferCount);
       if (hhcd->hc[chnum].ep_type == EP_TYPE_BULK)
       {
         hhcd->hc[chnum].toggle_out ^= 1U; 
@@ -1069,7 +1737,7 @@ static void HCD_HC_OUT_IRQHandler  (HCD_HandleTypeDef *hhcd, uint8_t chnum)
     }
     
     __HAL_HCD_CLEAR_HC_INT(chnum, USB_OTG_HCINT_CHH);
-    HAL_HCD_HC_NotifyURBChange_Callback(hhcd, chnum, hhcd->hc[chnum].urb_state);  
+    HCD_NotifyURBChange(hhcd, chnum);  
   }
 } 
 
@@ -1098,6 +1766,21 @@ static void HCD_RXQLVL_IRQHandler(HCD_HandleTypeDef *hhcd)
     /* Read the data into the host buffer. */
     if ((pktcnt > 0U) && (hhcd->hc[channelnum].xfer_buff != (void  *)0))
     {  
+      if ((hhcd->hc[channelnum].xfer_count + pktcnt) > hhcd->hc[channelnum].xfer_len)
+      {
+        /* Packet does not fit into the buffer, pop it from the FIFO, drop it
+           and end the transfer with URB_ERROR through the CHH interrupt */
+        for (tmpreg = 0U; tmpreg < ((pktcnt + 3U) / 4U); tmpreg++)
+        {
+          (void)USBx_DFIFO(0U);
+        }
+        hhcd->FifoStats.RxOverrunCount++;
+        hhcd->hc[channelnum].urb_state = URB_ERROR;
+        __HAL_HCD_UNMASK_HALT_HC_INT(channelnum);
+        hhcd->hc[channelnum].state = HC_BBLERR;
+        USB_HC_Halt(hhcd->Instance, channelnum);
+        break;
+      }
       
       USB_ReadPacket(hhcd->Instance, hhcd->hc[channelnum].xfer_buff, pktcnt);
       
@@ -1203,6 +1886,268 @@ static void HCD_Port_IRQHandler  (HCD_HandleTypeDef *hhcd)
   USBx_HPRT0 = hprt0_dup;
 }
 
+/**
+  * @brief  Handle Tx FIFO empty interrupt: continue the multi-packet OUT
+  *         transfers which did not fit into the FIFO when they were started.
+  * @param  hhcd HCD handle
+  * @param  periodic 1 for the periodic, 0 for the non-periodic Tx FIFO
+  * @retval None
+  */
+static void HCD_TXFE_IRQHandler(HCD_HandleTypeDef *hhcd, uint32_t periodic)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  HCD_HCTypeDef *hc;
+  uint32_t ch = 0U, remaining = 0U, is_periodic = 0U;
+  
+  for (ch = 0U; ch < hhcd->Init.Host_channels; ch++)
+  {
+    hc = &hhcd->hc[ch];
+    is_periodic = ((hc->ep_type == EP_TYPE_INTR) || (hc->ep_type == EP_TYPE_ISOC)) ? 1U : 0U;
+    if ((hc->ep_is_in == 0U) && (is_periodic == periodic) && (hc->fifo_count < hc->xfer_len) &&
+        ((USBx_HC(ch)->HCCHAR & USB_OTG_HCCHAR_CHENA) != 0U))
+    {
+      remaining += USB_HC_FillTxFifo(USBx, hc);
+    }
+  }
+  if (remaining == 0U)
+  {
+    USB_MASK_INTERRUPT(USBx, (periodic != 0U) ? USB_OTG_GINTMSK_PTXFEM : USB_OTG_GINTMSK_NPTXFEM);
+  }
+}
+
+/**
+  * @brief  Arm the scheduled channels which are due in the next frame.
+  *         USB_HC_StartXfer() sets ODDFRM to the parity of the next frame.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+static void HCD_Periodic_SOF(HCD_HandleTypeDef *hhcd)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  HCD_PeriodicTypeDef *sched = &hhcd->Periodic;
+  HCD_HCTypeDef *hc;
+  uint32_t pending = 0U, ch = 0U, frame = 0U;
+  
+  pending = (uint32_t)sched->ScheduledMask & ~(uint32_t)sched->ActiveMask;
+  if (pending == 0U)
+  {
+    return;
+  }
+  
+  /* FRNUM wraps at 0x4000, a multiple of HCD_PERIODIC_FRAMES */
+  frame = ((USBx_HOST->HFNUM & USB_OTG_HFNUM_FRNUM) + 1U) % HCD_PERIODIC_FRAMES;
+  while (pending != 0U)
+  {
+    ch = 31U - __CLZ(pending);
+    pending &= ~(1U << ch);
+    if ((frame & (sched->ch[ch].interval - 1U)) != sched->ch[ch].phase)
+    {
+      continue;
+    }
+    hc = &hhcd->hc[ch];
+    hc->data_pid   = (hc->toggle_in == 0U) ? HC_PID_DATA0 : HC_PID_DATA1;
+    hc->xfer_buff  = sched->ch[ch].pbuff;
+    hc->xfer_len   = sched->ch[ch].length;
+    hc->urb_state  = URB_IDLE;
+    hc->xfer_count = 0U;
+    hc->ch_num     = (uint8_t)ch;
+    hc->state      = HC_IDLE;
+    sched->ActiveMask |= (uint16_t)(1U << ch);
+    USB_HC_StartXfer(USBx, hc, hhcd->Init.dma_enable);
+  }
+}
+
+/**
+  * @brief  Remove all channels from the periodic schedule.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+static void HCD_Periodic_Reset(HCD_HandleTypeDef *hhcd)
+{
+  memset(&hhcd->Periodic, 0, sizeof(hhcd->Periodic));
+}
+
+/**
+  * @brief  Re-enable the bulk IN channels whose NAK back-off has expired.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+static void HCD_Nak_SOF(HCD_HandleTypeDef *hhcd)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  uint32_t pending = hhcd->NakWaitMask;
+  uint32_t ch = 0U, tmpreg = 0U;
+  
+  while (pending != 0U)
+  {
+    ch = 31U - __CLZ(pending);
+    pending &= ~(1U << ch);
+    if (--hhcd->nak[ch].Wait == 0U)
+    {
+      hhcd->NakWaitMask &= (uint16_t)~(1U << ch);
+      tmpreg = USBx_HC(ch)->HCCHAR;
+      tmpreg &= ~USB_OTG_HCCHAR_CHDIS;
+      tmpreg |= USB_OTG_HCCHAR_CHENA;
+      USBx_HC(ch)->HCCHAR = tmpreg;
+    }
+  }
+}
+
+/**
+  * @brief  Report the URB state of a channel, to the pipe using it if
+  *         the channel is owned by the multiplexer.
+  * @param  hhcd HCD handle
+  * @param  chnum Channel number
+  * @retval None
+  */
+static void HCD_NotifyURBChange(HCD_HandleTypeDef *hhcd, uint8_t chnum)
+{
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+  if (hhcd->Mux.ChPipe[chnum] != HCD_PIPE_NONE)
+  {
+    HCD_Mux_Release(hhcd, chnum);
+    return;
+  }
+#endif
+  HAL_HCD_HC_NotifyURBChange_Callback(hhcd, chnum, hhcd->hc[chnum].urb_state);
+}
+
+#if (USE_HAL_HCD_CHANNEL_MUX == 1U)
+/**
+  * @brief  Free all owned channels and drop the waiting requests.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+static void HCD_Mux_Reset(HCD_HandleTypeDef *hhcd)
+{
+  HCD_MuxTypeDef *mux = &hhcd->Mux;
+  
+  memset(mux->Pending, 0, sizeof(mux->Pending));
+  memset(mux->ChPipe, HCD_PIPE_NONE, sizeof(mux->ChPipe));
+  memset(mux->ChOwner, HCD_PIPE_NONE, sizeof(mux->ChOwner));
+  /* Round robin starts above the last pipe, with pipe 0 */
+  memset(mux->Last, HCD_MAX_PIPES - 1U, sizeof(mux->Last));
+  mux->FreeMask = mux->ChMask;
+}
+
+/**
+  * @brief  Start waiting requests on the free channels, by priority class.
+  *         Called with the OTG interrupt disabled or from the interrupt.
+  * @param  hhcd HCD handle
+  * @retval None
+  */
+static void HCD_Mux_Schedule(HCD_HandleTypeDef *hhcd)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  HCD_MuxTypeDef *mux = &hhcd->Mux;
+  HCD_PipeTypeDef *pipe;
+  HCD_HCTypeDef *hc;
+  uint32_t cls = 0U, pending = 0U, above = 0U;
+  uint32_t num = 0U, ch = 0U, i = 0U, free_ch = 0U, wait = 0U;
+  
+  for (cls = 0U; (cls < 3U) && (mux->FreeMask != 0U); cls++)
+  {
+    while ((mux->Pending[cls] != 0U) && (mux->FreeMask != 0U))
+    {
+      /* Round robin: next pending pipe above the one started last */
+      pending = mux->Pending[cls];
+      above   = pending & ~(0xFFFFFFFFU >> (31U - mux->Last[cls]));
+      num     = __CLZ(__RBIT((above != 0U) ? above : pending));
+      mux->Pending[cls] &= ~(1UL << num);
+      mux->Last[cls] = (uint8_t)num;
+      pipe = &mux->pipe[num];
+      
+      /* Prefer a channel still programmed for the pipe, then an unused one */
+      free_ch = mux->FreeMask;
+      ch = __CLZ(__RBIT(free_ch));
+      while (free_ch != 0U)
+      {
+        i = __CLZ(__RBIT(free_ch));
+        free_ch &= ~(1UL << i);
+        if (mux->ChOwner[i] == num)
+        {
+          ch = i;
+          break;
+        }
+        if ((mux->ChOwner[ch] != HCD_PIPE_NONE) && (mux->ChOwner[i] == HCD_PIPE_NONE))
+        {
+          ch = i;
+        }
+      }
+      
+      hc = &hhcd->hc[ch];
+      mux->FreeMask &= (uint16_t)~(1U << ch);
+      mux->ChPipe[ch] = (uint8_t)num;
+      mux->Stats.BindCount++;
+      if (mux->ChOwner[ch] == num)
+      {
+        mux->Stats.ReuseCount++;
+      }
+      else
+      {
+        /* Lazy programming: only when the channel served another pipe */
+        mux->ChOwner[ch] = (uint8_t)num;
+        hc->dev_addr   = pipe->dev_address;
+        hc->max_packet = pipe->mps;
+        hc->ch_num     = (uint8_t)ch;
+        hc->ep_type    = pipe->ep_type;
+        hc->ep_num     = pipe->epnum & 0x7FU;
+        hc->ep_is_in   = ((pipe->epnum & 0x80U) == 0x80U);
+        hc->speed      = pipe->speed;
+        memset(&hhcd->nak[ch], 0, sizeof(hhcd->nak[ch]));
+        USB_HC_Init(USBx, (uint8_t)ch, pipe->epnum, pipe->dev_address, pipe->speed, pipe->ep_type, pipe->mps);
+      }
+      if (pipe->is_waiting != 0U)
+      {
+        wait = ((USBx_HOST->HFNUM & USB_OTG_HFNUM_FRNUM) - pipe->WaitStart) & USB_OTG_HFNUM_FRNUM;
+        mux->Stats.WaitCount++;
+        mux->Stats.WaitFrames += wait;
+        if (wait > mux->Stats.WaitFramesMax)
+        {
+          mux->Stats.WaitFramesMax = wait;
+        }
+      }
+      hc->toggle_in  = pipe->toggle_in;
+      hc->toggle_out = pipe->toggle_out;
+      HAL_HCD_HC_SubmitRequest(hhcd, (uint8_t)ch, pipe->direction, pipe->ep_type,
+                               pipe->token, pipe->pbuff, pipe->length, pipe->do_ping);
+    }
+  }
+}
+
+/**
+  * @brief  Report the end of a request to its pipe and give the channel
+  *         to the next waiting request. A channel the driver re-enabled
+  *         for a retry stays with the pipe.
+  * @param  hhcd HCD handle
+  * @param  chnum Channel number
+  * @retval None
+  */
+static void HCD_Mux_Release(HCD_HandleTypeDef *hhcd, uint8_t chnum)
+{
+  USB_OTG_GlobalTypeDef *USBx = hhcd->Instance;
+  HCD_MuxTypeDef *mux = &hhcd->Mux;
+  HCD_PipeTypeDef *pipe;
+  uint8_t num = mux->ChPipe[chnum];
+  
+  pipe = &mux->pipe[num];
+  pipe->urb_state  = hhcd->hc[chnum].urb_state;
+  pipe->xfer_count = hhcd->hc[chnum].xfer_count;
+  if ((pipe->urb_state != URB_NOTREADY) || ((USBx_HC(chnum)->HCCHAR & USB_OTG_HCCHAR_CHENA) == 0U))
+  {
+    pipe->toggle_in  = hhcd->hc[chnum].toggle_in;
+    pipe->toggle_out = hhcd->hc[chnum].toggle_out;
+    mux->ChPipe[chnum] = HCD_PIPE_NONE;
+    mux->FreeMask |= (uint16_t)(1U << chnum);
+  }
+  if (pipe->is_open != 0U)
+  {
+    HAL_HCD_Pipe_NotifyURBChange_Callback(hhcd, num, pipe->urb_state);
+  }
+  HCD_Mux_Schedule(hhcd);
+}
+#endif /* USE_HAL_HCD_CHANNEL_MUX */
+
 /**
   * @}
   */
@@ -54,6 +54,7 @@
   */ 
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
 #include "stm32f4xx_hal.h"
 
 /** @addtogroup STM32F4xx_LL_USB_DRIVER
@@ -69,7 +70,29 @@
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
+#if (USE_USB_FIFO_STATISTICS == 1U)
+  #define USB_FIFO_STAT_INC(__FIELD__)   (USB_FifoStat.__FIELD__++)
+#else
+  #define USB_FIFO_STAT_INC(__FIELD__)
+#endif
 /* Private variables ---------------------------------------------------------*/
+#if (USE_USB_FIFO_STATISTICS == 1U)
+static USB_OTG_FifoStatTypeDef USB_FifoStat;
+#endif
+/* Host FIFO profiles in words: Rx, non-periodic Tx, periodic Tx.
+   Rx holds the IN packets of all channels, so HID arrays need a large one. */
+static const USB_OTG_HostFifoCfgTypeDef USB_HostFifoProfileFS[3] =
+{
+  { 0x80U, 0x80U, 0x40U },   /* Balanced: 8 bulk packets per direction */
+  { 0x90U, 0xA0U, 0x10U },   /* Bulk: 10 OUT packets, no periodic OUT  */
+  { 0xC0U, 0x40U, 0x40U },   /* Periodic                               */
+};
+static const USB_OTG_HostFifoCfgTypeDef USB_HostFifoProfileHS[3] =
+{
+  { 0x200U, 0x100U, 0xE0U },
+  { 0x280U, 0x100U, 0x80U },
+  { 0x200U, 0x80U,  0x180U },
+};
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 static HAL_StatusTypeDef USB_CoreReset(USB_OTG_GlobalTypeDef *USBx);
@@ -876,14 +899,53 @@ HAL_StatusTypeDef USB_EP0StartXfer(USB_OTG_GlobalTypeDef *USBx , USB_OTG_EPTypeD
   */
 HAL_StatusTypeDef USB_WritePacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *src, uint8_t ch_ep_num, uint16_t len, uint8_t dma)
 {
+  __IO uint32_t *fifo = &USBx_DFIFO(ch_ep_num);
   uint32_t count32b = 0U , i = 0U;
+  uint32_t remaining = 0U;
+  uint32_t data = 0U;
+  uint32_t *p32;
   
   if (dma == 0U)
   {
-    count32b =  (len + 3U) / 4U;
-    for (i = 0U; i < count32b; i++, src += 4U)
+    USB_FIFO_STAT_INC(WriteCount);
+    count32b  = len / 4U;
+    remaining = len % 4U;
+    if (((uint32_t)src & 3U) == 0U)
+    {
+      /* Aligned source: load four words at a time, the compiler uses LDM */
+      p32 = (uint32_t *)src;
+      for (; count32b >= 4U; count32b -= 4U, p32 += 4U)
+      {
+        uint32_t d0 = p32[0], d1 = p32[1], d2 = p32[2], d3 = p32[3];
+        
+        *fifo = d0;
+        *fifo = d1;
+        *fifo = d2;
+        *fifo = d3;
+      }
+      for (; count32b > 0U; count32b--)
+      {
+        *fifo = *p32++;
+      }
+      src = (uint8_t *)p32;
+    }
+    else
+    {
+      USB_FIFO_STAT_INC(WriteUnalignedCount);
+      for (; count32b > 0U; count32b--, src += 4U)
+      {
+        *fifo = __UNALIGNED_UINT32_READ(src);
+      }
+    }
+    if (remaining != 0U)
     {
-      USBx_DFIFO(ch_ep_num) = *((__packed uint32_t *)src);
+      /* Partial last word: do not read beyond the end of the buffer */
+      USB_FIFO_STAT_INC(WriteTailCount);
+      for (i = 0U; i < remaining; i++)
+      {
+        data |= (uint32_t)src[i] << (8U * i);
+      }
+      *fifo = data;
     }
   }
   return HAL_OK;
@@ -904,13 +966,53 @@ HAL_StatusTypeDef USB_WritePacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *src, uin
   */
 void *USB_ReadPacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *dest, uint16_t len)
 {
-  uint32_t i=0U;
-  uint32_t count32b = (len + 3U) / 4U;
+  __IO uint32_t *fifo = &USBx_DFIFO(0U);
+  uint32_t i = 0U;
+  uint32_t count32b = len / 4U;
+  uint32_t remaining = len % 4U;
+  uint32_t data = 0U;
+  uint32_t *p32;
   
-  for ( i = 0U; i < count32b; i++, dest += 4U )
+  USB_FIFO_STAT_INC(ReadCount);
+  if (((uint32_t)dest & 3U) == 0U)
   {
-    *(__packed uint32_t *)dest = USBx_DFIFO(0U);
-    
+    /* Aligned destination: store four words at a time, the compiler uses STM */
+    p32 = (uint32_t *)dest;
+    for (; count32b >= 4U; count32b -= 4U, p32 += 4U)
+    {
+      uint32_t d0 = *fifo;
+      uint32_t d1 = *fifo;
+      uint32_t d2 = *fifo;
+      uint32_t d3 = *fifo;
+      
+      p32[0] = d0;
+      p32[1] = d1;
+      p32[2] = d2;
+      p32[3] = d3;
+    }
+    for (; count32b > 0U; count32b--)
+    {
+      *p32++ = *fifo;
+    }
+    dest = (uint8_t *)p32;
+  }
+  else
+  {
+    USB_FIFO_STAT_INC(ReadUnalignedCount);
+    for (; count32b > 0U; count32b--, dest += 4U)
+    {
+      __UNALIGNED_UINT32_WRITE(dest, *fifo);
+    }
+  }
+  if (remaining != 0U)
+  {
+    /* Partial last word: do not write beyond the end of the buffer */
+    USB_FIFO_STAT_INC(ReadTailCount);
+    data = *fifo;
+    for (i = 0U; i < remaining; i++, data >>= 8U)
+    {
+      *dest++ = (uint8_t)data;
+    }
   }
   return ((void *)dest);
 }
@@ -1232,6 +1334,7 @@ static HAL_StatusTypeDef USB_CoreReset(USB_OTG_GlobalTypeDef *USBx)
   */
 HAL_StatusTypeDef USB_HostInit (USB_OTG_GlobalTypeDef *USBx, USB_OTG_CfgTypeDef cfg)
 {
+  USB_OTG_HostFifoCfgTypeDef fifo_cfg;
   uint32_t i;
   
   /* Restart the Phy Clock */
@@ -1280,19 +1383,11 @@ HAL_StatusTypeDef USB_HostInit (USB_OTG_GlobalTypeDef *USBx, USB_OTG_CfgTypeDef
   /* Clear any pending interrupts */
   USBx->GINTSTS = 0xFFFFFFFFU;
   
-  if(USBx == USB_OTG_FS)
-  {
-    /* set Rx FIFO size */
-    USBx->GRXFSIZ  = 0x80U; 
-    USBx->DIEPTXF0_HNPTXFSIZ = (uint32_t )(((0x60U << 16U)& USB_OTG_NPTXFD) | 0x80U);
-    USBx->HPTXFSIZ = (uint32_t )(((0x40U << 16U)& USB_OTG_HPTXFSIZ_PTXFD) | 0xE0U);
-  }
-  else
+  /* set the FIFO sizes of the profile selected in stm32f4xx_hal_conf.h */
+  if ((USB_HostGetFifoProfile(USBx, USB_OTG_HOST_FIFO_PROFILE, &fifo_cfg) != HAL_OK) ||
+      (USB_HostSetFifoConfig(USBx, &fifo_cfg) != HAL_OK))
   {
-    /* set Rx FIFO size */
-    USBx->GRXFSIZ  = 0x200U; 
-    USBx->DIEPTXF0_HNPTXFSIZ = (uint32_t )(((0x100U << 16U)& USB_OTG_NPTXFD) | 0x200U);
-    USBx->HPTXFSIZ = (uint32_t )(((0xE0U << 16U)& USB_OTG_HPTXFSIZ_PTXFD) | 0x300U);
+    return HAL_ERROR;
   }
   
   /* Enable the common interrupts */
@@ -1309,6 +1404,68 @@ HAL_StatusTypeDef USB_HostInit (USB_OTG_GlobalTypeDef *USBx, USB_OTG_CfgTypeDef
   return HAL_OK;
 }
 
+/**
+  * @brief  USB_HostGetFifoProfile : Return the FIFO partitioning of a profile
+  * @param  USBx  Selected device
+  * @param  profile  FIFO profile
+  *          This parameter can be one of these values:
+  *            @arg USB_OTG_FIFO_PROFILE_BALANCED
+  *            @arg USB_OTG_FIFO_PROFILE_BULK
+  *            @arg USB_OTG_FIFO_PROFILE_PERIODIC
+  * @param  pCfg  Receives the FIFO sizes for the core
+  * @retval HAL status
+  */
+HAL_StatusTypeDef USB_HostGetFifoProfile(USB_OTG_GlobalTypeDef *USBx, uint32_t profile, USB_OTG_HostFifoCfgTypeDef *pCfg)
+{
+  if (profile > USB_OTG_FIFO_PROFILE_PERIODIC)
+  {
+    return HAL_ERROR;
+  }
+  *pCfg = (USBx == USB_OTG_FS) ? USB_HostFifoProfileFS[profile] : USB_HostFifoProfileHS[profile];
+  return HAL_OK;
+}
+
+/**
+  * @brief  USB_HostSetFifoConfig : Partition the FIFO RAM and flush all FIFOs.
+  *         Must not be called while transfers are in progress.
+  * @param  USBx  Selected device
+  * @param  pCfg  FIFO sizes. Each FIFO needs at least USB_OTG_FIFO_MIN_WORDS,
+  *         the non-periodic Tx FIFO at most USB_OTG_NPTXFIFO_MAX_WORDS, and
+  *         all FIFOs together must fit into the FIFO RAM of the core.
+  * @retval HAL status, HAL_ERROR if the layout is invalid and was not applied
+  */
+HAL_StatusTypeDef USB_HostSetFifoConfig(USB_OTG_GlobalTypeDef *USBx, const USB_OTG_HostFifoCfgTypeDef *pCfg)
+{
+  uint32_t total = (USBx == USB_OTG_FS) ? USB_OTG_FS_FIFO_WORDS : USB_OTG_HS_FIFO_WORDS;
+  uint32_t rx = pCfg->RxFifoSize, nptx = pCfg->NPTxFifoSize, ptx = pCfg->PTxFifoSize;
+  
+  if ((rx < USB_OTG_FIFO_MIN_WORDS) || (nptx < USB_OTG_FIFO_MIN_WORDS) || (ptx < USB_OTG_FIFO_MIN_WORDS) ||
+      (nptx > USB_OTG_NPTXFIFO_MAX_WORDS) || ((rx + nptx + ptx) > total))
+  {
+    return HAL_ERROR;
+  }
+  USBx->GRXFSIZ  = rx;
+  USBx->DIEPTXF0_HNPTXFSIZ = (uint32_t )(((nptx << 16U) & USB_OTG_NPTXFD) | rx);
+  USBx->HPTXFSIZ = (uint32_t )(((ptx << 16U) & USB_OTG_HPTXFSIZ_PTXFD) | (rx + nptx));
+  
+  USB_FlushTxFifo(USBx, 0x10U); /* all Tx FIFOs */
+  USB_FlushRxFifo(USBx);
+  return HAL_OK;
+}
+
+/**
+  * @brief  USB_HostGetFifoConfig : Read the current FIFO partitioning back
+  * @param  USBx  Selected device
+  * @param  pCfg  Receives the FIFO sizes
+  * @retval None
+  */
+void USB_HostGetFifoConfig(USB_OTG_GlobalTypeDef *USBx, USB_OTG_HostFifoCfgTypeDef *pCfg)
+{
+  pCfg->RxFifoSize   = (uint16_t)(USBx->GRXFSIZ & 0xFFFFU);
+  pCfg->NPTxFifoSize = (uint16_t)((USBx->DIEPTXF0_HNPTXFSIZ & USB_OTG_NPTXFD) >> 16U);
+  pCfg->PTxFifoSize  = (uint16_t)((USBx->HPTXFSIZ & USB_OTG_HPTXFSIZ_PTXFD) >> 16U);
+}
+
 /**
   * @brief  USB_InitFSLSPClkSel : Initializes the FSLSPClkSel field of the 
   *         HCFG register on the PHY type and set the right frame interval
@@ -1525,6 +1682,52 @@ HAL_StatusTypeDef USB_HC_Init(USB_OTG_GlobalTypeDef *USBx,
   return HAL_OK; 
 }
 
+/**
+  * @brief  Write the next packets of an OUT transfer into the Tx FIFO of
+  *         the channel. As many whole packets are written as the FIFO and
+  *         the request queue have room for, a multi-packet transfer is
+  *         completed from the Tx FIFO empty interrupt.
+  * @param  USBx  Selected device
+  * @param  hc host channel structure, fifo_count is advanced
+  * @retval Number of bytes still to be written
+  */
+uint32_t USB_HC_FillTxFifo(USB_OTG_GlobalTypeDef *USBx, USB_OTG_HCTypeDef *hc)
+{
+  uint32_t txsts = 0U, space = 0U, queue = 0U;
+  uint32_t len = 0U, len_words = 0U;
+  
+  if ((hc->ep_type == EP_TYPE_INTR) || (hc->ep_type == EP_TYPE_ISOC))
+  {
+    txsts = USBx_HOST->HPTXSTS;
+  }
+  else
+  {
+    txsts = USBx->HNPTXSTS;
+  }
+  /* Both registers: free space in words [15:0], free request queue entries [23:16] */
+  space = txsts & 0xFFFFU;
+  queue = (txsts >> 16U) & 0xFFU;
+  
+  while ((hc->fifo_count < hc->xfer_len) && (queue > 0U))
+  {
+    len = hc->xfer_len - hc->fifo_count;
+    if (len > hc->max_packet)
+    {
+      len = hc->max_packet;
+    }
+    len_words = (len + 3U) / 4U;
+    if (len_words > space)
+    {
+      break;
+    }
+    USB_WritePacket(USBx, hc->xfer_buff + hc->fifo_count, hc->ch_num, (uint16_t)len, 0U);
+    hc->fifo_count += len;
+    space -= len_words;
+    queue--;
+  }
+  return (hc->xfer_len - hc->fifo_count);
+}
+
 /**
   * @brief  Start a transfer over a host channel
   * @param  USBx  Selected device
@@ -1543,9 +1746,8 @@ HAL_StatusTypeDef USB_HC_Init(USB_OTG_GlobalTypeDef *USBx,
 HAL_StatusTypeDef USB_HC_StartXfer(USB_OTG_GlobalTypeDef *USBx, USB_OTG_HCTypeDef *hc, uint8_t dma)
 {
   uint8_t  is_oddframe = 0; 
-  uint16_t len_words = 0;   
   uint16_t num_packets = 0;
-  uint16_t max_hc_pkt_count = 256;
+  uint16_t max_hc_pkt_count = (uint16_t)(USB_OTG_HCTSIZ_PKTCNT >> 19U);
   uint32_t tmpreg = 0U;
     
   if((USBx != USB_OTG_FS) && (hc->speed == USB_OTG_SPEED_HIGH))
@@ -1607,39 +1809,19 @@ HAL_StatusTypeDef USB_HC_StartXfer(USB_OTG_GlobalTypeDef *USBx, USB_OTG_HCTypeDe
   {  
     if((hc->ep_is_in == 0U) && (hc->xfer_len > 0U))
     {
-      switch(hc->ep_type) 
+      /* Write as many packets as fit, the rest from the Tx FIFO empty interrupt */
+      hc->fifo_count = 0U;
+      if (USB_HC_FillTxFifo(USBx, hc) != 0U)
       {
-        /* Non periodic transfer */
-      case EP_TYPE_CTRL:
-      case EP_TYPE_BULK:
-        
-        len_words = (hc->xfer_len + 3) / 4;
-        
-        /* check if there is enough space in FIFO space */
-        if(len_words > (USBx->HNPTXSTS & 0xFFFF))
+        if ((hc->ep_type == EP_TYPE_INTR) || (hc->ep_type == EP_TYPE_ISOC))
         {
-          /* need to process data in nptxfempty interrupt */
-          USBx->GINTMSK |= USB_OTG_GINTMSK_NPTXFEM;
+          USBx->GINTMSK |= USB_OTG_GINTMSK_PTXFEM;
         }
-        break;
-        /* Periodic transfer */
-      case EP_TYPE_INTR:
-      case EP_TYPE_ISOC:
-        len_words = (hc->xfer_len + 3) / 4;
-        /* check if there is enough space in FIFO space */
-        if(len_words > (USBx_HOST->HPTXSTS & 0xFFFF)) /* split the transfer */
+        else
         {
-          /* need to process data in ptxfempty interrupt */
-          USBx->GINTMSK |= USB_OTG_GINTMSK_PTXFEM;          
+          USBx->GINTMSK |= USB_OTG_GINTMSK_NPTXFEM;
         }
-        break;
-        
-      default:
-        break;
       }
-      
-      /* Write packet into the Tx FIFO. */
-      USB_WritePacket(USBx, hc->xfer_buff, hc->ch_num, hc->xfer_len, 0);
     }
   }
   
@@ -1795,6 +1977,35 @@ HAL_StatusTypeDef USB_StopHost(USB_OTG_GlobalTypeDef *USBx)
   USB_EnableGlobalInt(USBx);
   return HAL_OK;  
 }
+
+#if (USE_USB_FIFO_STATISTICS == 1U)
+/**
+  * @brief  Return a snapshot of the FIFO copy counters.
+  * @param  pStats Receives the counters
+  * @retval None
+  */
+void USB_GetFifoStatistics(USB_OTG_FifoStatTypeDef *pStats)
+{
+  uint32_t primask = __get_PRIMASK();
+  
+  __disable_irq();
+  *pStats = USB_FifoStat;
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear the FIFO copy counters.
+  * @retval None
+  */
+void USB_ResetFifoStatistics(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  
+  __disable_irq();
+  memset(&USB_FifoStat, 0, sizeof(USB_FifoStat));
+  __set_PRIMASK(primask);
+}
+#endif /* USE_USB_FIFO_STATISTICS */
 /**
   * @}
   */
@@ -162,6 +162,12 @@
 #define  PREFETCH_ENABLE              1U
 #define  INSTRUCTION_CACHE_ENABLE     1U
 #define  DATA_CACHE_ENABLE            1U
+#define  USE_HAL_HCD_STATISTICS       0U     /*!< Set to 1U to collect HCD interrupt and transfer statistics */
+#if !defined  (USE_HAL_HCD_CHANNEL_MUX)
+ #define  USE_HAL_HCD_CHANNEL_MUX     0U     /*!< Set to 1U to share the host channels between logical pipes */
+#endif /* USE_HAL_HCD_CHANNEL_MUX */
+#define  USB_OTG_HOST_FIFO_PROFILE    USB_OTG_FIFO_PROFILE_BALANCED  /*!< Host FIFO RAM split: _BALANCED, _BULK or _PERIODIC */
+#define  USE_USB_FIFO_STATISTICS      0U     /*!< Set to 1U to count aligned and unaligned USB FIFO copies */
 
 /* ########################## Assert Selection ############################## */
 /**
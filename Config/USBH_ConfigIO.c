@@ -37,10 +37,16 @@ Purpose     : I/O routines and configuration for emUSB-Host.
 **********************************************************************
 */
 #include <stdlib.h>
+#include <string.h>
 #include "USBH.h"
+#include "USBH_Int.h"
+#include "BINLOG.h"
+#include "LOG_QUEUE.h"
 
 #if defined (__CROSSWORKS_ARM)
   #include "__putchar.h"
+#else
+  #include <stdio.h>
 #endif
 
 /*********************************************************************
@@ -66,10 +72,19 @@ Purpose     : I/O routines and configuration for emUSB-Host.
   #define SHOW_TASK  1
 #endif
 
+#ifndef   USE_RTT_MP
+  #define USE_RTT_MP 0    // 1: Switches the RTT terminal to SEGGER_RTT_MODE_MULTI_PRODUCER, log lines are written without disabling interrupts.
+#endif
+
 #if USE_RTT
   #include "SEGGER_RTT.h"
 #endif
 
+#if (USE_RTT == 0) || USE_BINLOG
+  #undef  USE_RTT_MP
+  #define USE_RTT_MP 0    // Needs the RTT terminal for the log output.
+#endif
+
 #if USE_DCC
   #include "JLINKDCC.h"
 #endif
@@ -153,45 +168,176 @@ static char * _WriteUnsigned(char * s, U32 v, int NumDigits) {
 
 /*********************************************************************
 *
-*       _ShowStamp
+*       _FormatStamp
 *
 *  Function description
-*    Prints a time-stamp and the name of the task from which
+*    Formats a time-stamp and the name of the task from which
 *    the function was executed.
 *
+*  Parameters
+*    sBuffer - Pointer to a buffer of at least STAMP_BUFFER_SIZE bytes.
+*
+*  Return value
+*    Pointer to the terminating \0 in sBuffer.
+*
 *  Notes
 *    This function is only designed to work with embOS.
 */
-static void _ShowStamp(void) {
+#if (USE_BINLOG == 0)
+#define STAMP_BUFFER_SIZE   48
+#define MAX_TASK_NAME_LEN   24
+
+static char * _FormatStamp(char * sBuffer) {
 #if SHOW_TIME
   I32    Time;
-  char   ac[20];
-  char * sBuffer = &ac[0];
   Time           = USBH_OS_GetTime32();
   sBuffer        = _WriteUnsigned(sBuffer, Time / 1000, 0);
   *sBuffer++     = ':';
   sBuffer        = _WriteUnsigned(sBuffer, Time % 1000, 3);
   *sBuffer++     = ' ';
-  *sBuffer++     = 0;
-  _puts(ac);
 #endif
 
 #if SHOW_TASK
 {
   const char * s;
+  int          i;
 #if OS_VERSION_GENERIC == 38803
   s = OS_GetTaskName(OS_Global.pCurrentTask);
 #else
   s = OS_GetTaskName(OS_pCurrentTask);
 #endif
   if (s) {
-    _puts(s);
-    _puts(" - ");
+    for (i = 0; (i < MAX_TASK_NAME_LEN) && (*s != 0); i++) {
+      *sBuffer++ = *s++;
+    }
+    *sBuffer++ = ' ';
+    *sBuffer++ = '-';
+    *sBuffer++ = ' ';
   }
 }
 #endif
+  *sBuffer = 0;
+  return sBuffer;
+}
+#endif
+
+#if (USE_RTT_MP == 0) && (USE_BINLOG == 0)
+/*********************************************************************
+*
+*       _ShowStamp
+*
+*  Function description
+*    Prints a time-stamp and the name of the task from which
+*    the function was executed.
+*/
+static void _ShowStamp(void) {
+  char ac[STAMP_BUFFER_SIZE];
+
+  _FormatStamp(ac);
+  _puts(ac);
+}
+#endif
+
+#if USE_LOG_QUEUE && (USE_BINLOG == 0)
+/*********************************************************************
+*
+*       _WriteLineQueued
+*
+*  Function description
+*    Passes a complete log line to the log queue, see LOG_QUEUE.c.
+*
+*  Parameters
+*    sPrefix - Prefix of the message.
+*    s       - Pointer to a string holding the message.
+*
+*  Return value
+*    1 - Line has been queued or dropped because the queue is full.
+*    0 - Queue not running yet, the line has to be output directly.
+*/
+static int _WriteLineQueued(const char * sPrefix, const char * s) {
+  const char * as[4];
+  char         acStamp[STAMP_BUFFER_SIZE];
+
+  _FormatStamp(acStamp);
+  as[0] = acStamp;
+  as[1] = sPrefix;
+  as[2] = s;
+  as[3] = "\n";
+  return (LOG_QUEUE_Write(as, SEGGER_COUNTOF(as)) >= 0) ? 1 : 0;
+}
+#endif
+
+#if USE_RTT_MP
+static char _IsTerminalMP;
+
+/*********************************************************************
+*
+*       _CopyToReservation
+*
+*  Function description
+*    Copies a string to the spans of an RTT reservation.
+*
+*  Parameters
+*    pRes     - Reservation to copy to.
+*    Off      - Offset in the reservation.
+*    s        - String to copy.
+*    NumBytes - Length of s.
+*
+*  Return value
+*    Offset behind the copied string.
+*/
+static unsigned _CopyToReservation(const SEGGER_RTT_RESERVATION * pRes, unsigned Off, const char * s, unsigned NumBytes) {
+  while (NumBytes--) {
+    if (Off < pRes->NumBytes0) {
+      pRes->pData0[Off] = *s++;
+    } else {
+      pRes->pData1[Off - pRes->NumBytes0] = *s++;
+    }
+    Off++;
+  }
+  return Off;
 }
 
+/*********************************************************************
+*
+*       _WriteLineMP
+*
+*  Function description
+*    Writes a complete log line with one reservation, so lines of
+*    different tasks and interrupts never interleave and interrupts
+*    are not disabled while writing. The first line switches the
+*    terminal to multi-producer mode, which then applies to all
+*    writers of the terminal.
+*
+*  Parameters
+*    sPrefix - Optional prefix of the message, may be NULL.
+*    s       - Pointer to a string holding the message.
+*/
+static void _WriteLineMP(const char * sPrefix, const char * s) {
+  SEGGER_RTT_RESERVATION Res;
+  char                   acStamp[STAMP_BUFFER_SIZE];
+  unsigned               LenStamp;
+  unsigned               LenPrefix;
+  unsigned               Len;
+  unsigned               Off;
+
+  if (_IsTerminalMP == 0) {
+    SEGGER_RTT_SetFlagsUpBuffer(0, SEGGER_RTT_MODE_MULTI_PRODUCER);
+    _IsTerminalMP = 1;
+  }
+  LenStamp  = (unsigned)(_FormatStamp(acStamp) - acStamp);
+  LenPrefix = sPrefix ? (unsigned)strlen(sPrefix) : 0u;
+  Len       = (unsigned)strlen(s);
+  if (SEGGER_RTT_ReserveMP(0, LenStamp + LenPrefix + Len + 1u, &Res) != 0u) {
+    Off = _CopyToReservation(&Res, 0,   acStamp, LenStamp);
+    Off = _CopyToReservation(&Res, Off, sPrefix, LenPrefix);
+    Off = _CopyToReservation(&Res, Off, s,       Len);
+    _CopyToReservation(&Res, Off, "\n", 1);
+    SEGGER_RTT_CommitMP(0);
+  }
+}
+#endif
+
 /*********************************************************************
 *
 *       USBH_Panic
@@ -233,11 +379,24 @@ void USBH_Panic(const char * s) {
 *    s - Pointer to a string holding the log message.
 */
 void USBH_Log(const char * s) {
+#if USE_BINLOG
+  BINLOG_WriteText(BINLOG_TYPE_LOG, s);
+#else
+#if USE_LOG_QUEUE
+  if (_WriteLineQueued("", s)) {
+    return;
+  }
+#endif
+#if USE_RTT_MP
+  _WriteLineMP(NULL, s);
+#else
   USBH_OS_DisableInterrupt();
   _ShowStamp();
   _puts(s);
   _puts("\n");
   USBH_OS_EnableInterrupt();
+#endif
+#endif
 }
 
 /*********************************************************************
@@ -252,12 +411,25 @@ void USBH_Log(const char * s) {
 *    s - Pointer to a string holding the warning message.
 */
 void USBH_Warn(const char * s) {
+#if USE_BINLOG
+  BINLOG_WriteText(BINLOG_TYPE_WARN, s);
+#else
+#if USE_LOG_QUEUE
+  if (_WriteLineQueued("*** Warning *** ", s)) {
+    return;
+  }
+#endif
+#if USE_RTT_MP
+  _WriteLineMP("*** Warning *** ", s);
+#else
   USBH_OS_DisableInterrupt();
   _ShowStamp();
   _puts("*** Warning *** ");
   _puts(s);
   _puts("\n");
   USBH_OS_EnableInterrupt();
+#endif
+#endif
 }
 
 /*************************** End of file ****************************/
@@ -0,0 +1,35 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BENCH_Main.c
+Purpose : Micro benchmark runner of the Linux host build.
+          Runs the common cases of BENCH.c and the cases of the
+          keyboard sample, see Host/Makefile.
+
+Additional information:
+  The sample is compiled into this file so its static hot paths,
+  such as _ScanCodeOperation(), can be measured. Its MainTask is
+  not called, the USB stack is not available on the host.
+  Results are printed to stdout, one line per case:
+    0:012 MainTask - BENCH SEGGER_RTT_WriteNoLock 16B: 21 ns/op, 761904761 bytes/s, 10000 ops
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include "../Application/USBH_HID_Keyboard.c"
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  OS_InitKern();
+  USBH_SetLogFilter(USBH_MTYPE_APPLICATION);
+  BARCODE_Init();
+  _InitKeyboards();
+  HID_KEYMAP_SetDefaultLayout(&KEYBOARD_LAYOUT);
+  _aKeyboard[0].pLayout = &KEYBOARD_LAYOUT;    // Set by _StartKeyboard() once a keyboard is attached.
+  BENCH_RunCommon();
+  BENCH_RunList(_aBenchCase, SEGGER_COUNTOF(_aBenchCase));
+  return 0;
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,124 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BINLOG_Decode.c
+Purpose : Host side decoder of the binary log records of BINLOG.c.
+
+Additional information:
+  Rebuilds the text of a record as USBH_Logf_Application() would have
+  output it without USE_BINLOG. The format table is built from
+  Inc/BINLOG_Formats.h, so the decoder has to be rebuilt whenever the
+  formats of the target change. See Inc/BINLOG.h for the record layout.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <stdio.h>
+#include <string.h>
+#include "BINLOG.h"
+#include "BINLOG_Decode.h"
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define HEADER_SIZE             8u
+
+/*********************************************************************
+*
+*       Static const data
+*
+**********************************************************************
+*/
+#define BINLOG_FORMAT(Id, sFormat)  sFormat,
+static const char * const _asFormat[BINLOG_NUM_FORMATS] = {
+  #include "BINLOG_Formats.h"
+};
+#undef BINLOG_FORMAT
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _LoadU32
+*/
+static U32 _LoadU32(const U8 * p) {
+  return (U32)p[0] | ((U32)p[1] << 8) | ((U32)p[2] << 16) | ((U32)p[3] << 24);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       BINLOG_DECODE_Record
+*
+*  Function description
+*    Decodes the record at the start of pData.
+*
+*  Parameters
+*    pData      : Data read from the RTT channel, starting at a record.
+*    NumBytes   : Number of bytes at pData.
+*    pRecord    : Receives type, ID and time-stamp of the record.
+*    sText      : Receives the text, always terminated.
+*    SizeOfText : Size of sText in bytes.
+*
+*  Return value
+*    > 0: Size of the record in bytes.
+*      0: The record is not complete yet.
+*    < 0: Invalid record, the stream is out of sync.
+*/
+int BINLOG_DECODE_Record(const U8 * pData, unsigned NumBytes, BINLOG_DECODE_RECORD * pRecord, char * sText, unsigned SizeOfText) {
+  U32      aArg[6];
+  unsigned Len;
+  unsigned NumArgs;
+  unsigned i;
+
+  if (NumBytes < HEADER_SIZE) {
+    return 0;
+  }
+  Len = pData[1];
+  if (NumBytes < HEADER_SIZE + Len) {
+    return 0;
+  }
+  pRecord->Type      = pData[0];
+  pRecord->Id        = (U16)(pData[2] | (pData[3] << 8));
+  pRecord->Timestamp = _LoadU32(&pData[4]);
+  switch (pRecord->Type) {
+  case BINLOG_TYPE_LOG:
+  case BINLOG_TYPE_WARN:
+    snprintf(sText, SizeOfText, "%.*s", (int)Len, (const char *)&pData[HEADER_SIZE]);
+    break;
+  case BINLOG_TYPE_APP:
+    NumArgs = Len / 4u;
+    if (((Len % 4u) != 0u) || (NumArgs > SEGGER_COUNTOF(aArg)) || (pRecord->Id >= BINLOG_NUM_FORMATS)) {
+      return -1;
+    }
+    memset(aArg, 0, sizeof(aArg));
+    for (i = 0; i < NumArgs; i++) {
+      aArg[i] = _LoadU32(&pData[HEADER_SIZE + (i * 4u)]);
+    }
+    snprintf(sText, SizeOfText, _asFormat[pRecord->Id], aArg[0], aArg[1], aArg[2], aArg[3], aArg[4], aArg[5]);
+    break;
+  default:
+    return -1;
+  }
+  return (int)(HEADER_SIZE + Len);
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,62 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BINLOG_DecodeMain.c
+Purpose : Prints the binary log of USE_BINLOG=1 as text.
+
+Additional information:
+  Reads the data of RTT channel 2 ("BinLog") as recorded by
+  JLinkRTTLogger from a file or stdin and prints one line per record:
+    <Time-stamp> <Type> <Text>
+  Usage: BINLOG_Decode [<File>]
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "BINLOG.h"
+#include "BINLOG_Decode.h"
+
+/*********************************************************************
+*
+*       main
+*/
+int main(int argc, char * argv[]) {
+  static const char * const _asType[] = { "?", "LOG", "WARN", "APP" };
+  BINLOG_DECODE_RECORD Record;
+  FILE               * pFile;
+  U8                   ab[4096];
+  char                 acText[512];
+  unsigned             NumBytes;
+  size_t               NumRead;
+  int                  r;
+
+  pFile = (argc > 1) ? fopen(argv[1], "rb") : stdin;
+  if (pFile == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  NumBytes = 0;
+  do {
+    NumRead   = fread(&ab[NumBytes], 1, sizeof(ab) - NumBytes, pFile);
+    NumBytes += (unsigned)NumRead;
+    for (;;) {
+      r = BINLOG_DECODE_Record(ab, NumBytes, &Record, acText, sizeof(acText));
+      if (r < 0) {
+        fprintf(stderr, "Invalid record, type %u\n", ab[0]);
+        return 1;
+      }
+      if (r == 0) {
+        break;
+      }
+      printf("%10u %-4s %s\n", (unsigned)Record.Timestamp, _asType[Record.Type], acText);
+      NumBytes -= (unsigned)r;
+      memmove(ab, &ab[r], NumBytes);
+    }
+  } while (NumRead != 0u);
+  if (NumBytes != 0u) {
+    fprintf(stderr, "%u bytes of an incomplete record at the end\n", NumBytes);
+  }
+  return 0;
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,29 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BSP_POSIX.c
+Purpose : Board support stand-in for the Linux host build.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include "BSP.h"
+#include "stm32f4xx_hal.h"
+
+RCC_TypeDef HOST_RCC;
+uint32_t    SystemCoreClock = 168000000u;
+
+void BSP_Init(void) {
+}
+
+void BSP_SetLED(int Index) {
+  (void)Index;
+}
+
+void BSP_ClrLED(int Index) {
+  (void)Index;
+}
+
+void BSP_ToggleLED(int Index) {
+  (void)Index;
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,1007 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HCD_SIM.c
+Purpose : Register-level model of the STM32F4 OTG_FS core in host
+          mode for the Linux host build.
+
+Additional information:
+  The register block is a PROT_NONE mapping below 2 GB, so the
+  (uint32_t) casts of the register macros in stm32f4xx_ll_usb.h keep
+  the address. Each access of the driver faults: the SIGSEGV handler
+  stores the value of the modelled register into the page, unprotects
+  it and single-steps the instruction, the SIGTRAP handler applies the
+  value written and protects the page again. The driver runs unchanged,
+  see HCD_SIM_HAL.c, and every register and FIFO access is counted.
+
+  Modelled behaviour:
+    - GINTSTS: rc_w1 bits, CMOD, RXFLVL, NPTXFE, PTXFE, HPRTINT and
+      HCINT derived from the FIFOs, HPRT and HAINT. The Tx FIFO empty
+      bits are set when the FIFO is completely empty.
+    - GRSTCTL: resets and FIFO flushes complete at once, AHBIDL is set.
+    - GRXSTSR / GRXSTSP and DFIFO reads: the Rx FIFO with status and
+      data entries, sized by GRXFSIZ.
+    - DFIFO(n) writes, HNPTXSTS / HPTXSTS: Tx FIFO of channel n.
+    - HPRT: rc_w1 bits, connect, port reset and port enable.
+    - HCCHAR / HCINT / HCTSIZ / HAINT: channel enable and halt,
+      rc_w1 interrupt bits, packet count, transfer size and data PID.
+  HCD_SIM_Frame() is one frame: it raises SOF, completes the halt of
+  the channels being disabled and performs one transaction per enabled
+  channel with the next scripted response of the endpoint. Endpoints
+  without script answer NAK. Only slave mode (dma_enable = 0) is
+  modelled, the periodic schedule and ODDFRM are not.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#define _GNU_SOURCE
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <signal.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "HCD_SIM.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define NUM_CHANNELS            16u
+#define NUM_ENDPOINTS           16u
+#define REG_WORDS               (USB_OTG_FIFO_BASE / 4u)
+#define MAP_SIZE                (USB_OTG_FIFO_BASE + NUM_CHANNELS * USB_OTG_FIFO_SIZE)
+#define RX_FIFO_WORDS           1024u
+#define TX_FIFO_WORDS           1024u
+#define TX_QUEUE_DEPTH          8u
+#define PAGE_SIZE               4096u
+#define EFLAGS_TF               0x100
+
+#define REG(Off)                _aReg[(Off) / 4u]
+#define OFF(Member)             offsetof(USB_OTG_GlobalTypeDef, Member)
+#define HOST_OFF(Member)        (USB_OTG_HOST_BASE + offsetof(USB_OTG_HostTypeDef, Member))
+#define HC_OFF(Ch, Member)      (USB_OTG_HOST_CHANNEL_BASE + (Ch) * USB_OTG_HOST_CHANNEL_SIZE + offsetof(USB_OTG_HostChannelTypeDef, Member))
+
+//
+// GINTSTS bits cleared by writing 1, the others are derived.
+//
+#define GINTSTS_RC_W1           (USB_OTG_GINTSTS_MMIS     | USB_OTG_GINTSTS_SOF     | USB_OTG_GINTSTS_ESUSP    | \
+                                 USB_OTG_GINTSTS_USBSUSP  | USB_OTG_GINTSTS_USBRST  | USB_OTG_GINTSTS_ENUMDNE  | \
+                                 USB_OTG_GINTSTS_ISOODRP  | USB_OTG_GINTSTS_EOPF    | USB_OTG_GINTSTS_IISOIXFR | \
+                                 USB_OTG_GINTSTS_PXFR_INCOMPISOOUT | USB_OTG_GINTSTS_CIDSCHG | USB_OTG_GINTSTS_DISCINT | \
+                                 USB_OTG_GINTSTS_SRQINT   | USB_OTG_GINTSTS_WKUINT)
+#define HPRT_RC_W1              (USB_OTG_HPRT_PCDET | USB_OTG_HPRT_PENA | USB_OTG_HPRT_PENCHNG | USB_OTG_HPRT_POCCHNG)
+#define HPRT_RW                 (USB_OTG_HPRT_PRES | USB_OTG_HPRT_PSUSP | USB_OTG_HPRT_PRST | USB_OTG_HPRT_PPWR | USB_OTG_HPRT_PTCTL)
+
+//
+// Rx FIFO entries, the tag tells status from data.
+//
+#define RX_TAG_STATUS           0u
+#define RX_TAG_DATA             1u
+
+//
+// Channel states.
+//
+#define CH_IDLE                 0u
+#define CH_ACTIVE               1u      // Enabled, next transaction in the next frame.
+#define CH_HALTING              2u      // CHDIS and CHENA set, halted in the next frame.
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  uint8_t                  State;
+  uint8_t                  IsComplete;          // IN: last packet in the Rx FIFO, XFRC when its XFER_COMP status is popped.
+  uint32_t                 aTx[TX_FIFO_WORDS];
+  unsigned                 NumTxWords;
+} SIM_CHANNEL;
+
+typedef struct {
+  uint8_t                  IsUsed;
+  uint8_t                  DevAddr;
+  uint8_t                  EpAddr;
+  const HCD_SIM_RESPONSE * paResponse;
+  unsigned                 NumResponses;
+  unsigned                 iResponse;
+  uint8_t                  abOut[HCD_SIM_MAX_OUT_BYTES];
+  unsigned                 NumOutBytes;
+} SIM_ENDPOINT;
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static uint8_t          * _pMap;
+static uint32_t           _aReg[REG_WORDS];
+static uint32_t           _aRx[RX_FIFO_WORDS];
+static uint8_t            _aRxTag[RX_FIFO_WORDS];
+static unsigned           _iRxRd;
+static unsigned           _NumRxWords;
+static SIM_CHANNEL        _aChannel[NUM_CHANNELS];
+static SIM_ENDPOINT       _aEndpoint[NUM_ENDPOINTS];
+static uint32_t           _Speed;
+static uint32_t           _Frame;
+static HCD_SIM_STAT       _Stat;
+static uint32_t           _PriMask;
+static uint32_t           _Tick;
+//
+// Access being single-stepped.
+//
+static uint32_t           _PendingOff;
+static int                _PendingIsWrite;
+static int                _IsPending;
+
+/*********************************************************************
+*
+*       Static code, model
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _GetHAINT
+*/
+static uint32_t _GetHAINT(void) {
+  uint32_t HAINT;
+  unsigned Ch;
+
+  HAINT = 0;
+  for (Ch = 0; Ch < NUM_CHANNELS; Ch++) {
+    if (REG(HC_OFF(Ch, HCINT)) & REG(HC_OFF(Ch, HCINTMSK))) {
+      HAINT |= 1uL << Ch;
+    }
+  }
+  return HAINT;
+}
+
+/*********************************************************************
+*
+*       _GetTxWords
+*
+*  Function description
+*    Returns the words waiting in the periodic or non-periodic Tx FIFO.
+*/
+static unsigned _GetTxWords(int IsPeriodic) {
+  unsigned Ch;
+  unsigned NumWords;
+  uint32_t EpType;
+
+  NumWords = 0;
+  for (Ch = 0; Ch < NUM_CHANNELS; Ch++) {
+    EpType = (REG(HC_OFF(Ch, HCCHAR)) & USB_OTG_HCCHAR_EPTYP) >> 18;
+    if (((EpType == HCCHAR_INTR) || (EpType == HCCHAR_ISOC)) == (IsPeriodic != 0)) {
+      NumWords += _aChannel[Ch].NumTxWords;
+    }
+  }
+  return NumWords;
+}
+
+/*********************************************************************
+*
+*       _GetTxStatus
+*
+*  Function description
+*    Returns HNPTXSTS / HPTXSTS: free words [15:0], free request
+*    queue entries [23:16].
+*/
+static uint32_t _GetTxStatus(int IsPeriodic) {
+  uint32_t Size;
+  unsigned Used;
+
+  if (IsPeriodic) {
+    Size = REG(OFF(HPTXFSIZ)) >> 16;
+  } else {
+    Size = REG(OFF(DIEPTXF0_HNPTXFSIZ)) >> 16;
+  }
+  Used = _GetTxWords(IsPeriodic);
+  Size = (Used < Size) ? Size - Used : 0u;
+  return (TX_QUEUE_DEPTH << 16) | (Size & 0xFFFFu);
+}
+
+/*********************************************************************
+*
+*       _GetGINTSTS
+*/
+static uint32_t _GetGINTSTS(void) {
+  uint32_t v;
+
+  v = REG(OFF(GINTSTS)) & GINTSTS_RC_W1;
+  v |= USB_OTG_GINTSTS_CMOD;
+  if (_NumRxWords != 0u) {
+    v |= USB_OTG_GINTSTS_RXFLVL;
+  }
+  if (_GetTxWords(0) == 0u) {
+    v |= USB_OTG_GINTSTS_NPTXFE;
+  }
+  if (_GetTxWords(1) == 0u) {
+    v |= USB_OTG_GINTSTS_PTXFE;
+  }
+  if (REG(USB_OTG_HOST_PORT_BASE) & (USB_OTG_HPRT_PCDET | USB_OTG_HPRT_PENCHNG | USB_OTG_HPRT_POCCHNG)) {
+    v |= USB_OTG_GINTSTS_HPRTINT;
+  }
+  if (_GetHAINT() & REG(HOST_OFF(HAINTMSK))) {
+    v |= USB_OTG_GINTSTS_HCINT;
+  }
+  return v;
+}
+
+/*********************************************************************
+*
+*       _PushRx
+*/
+static void _PushRx(uint32_t Data, uint8_t Tag) {
+  unsigned i;
+
+  i = (_iRxRd + _NumRxWords) % RX_FIFO_WORDS;
+  _aRx[i]    = Data;
+  _aRxTag[i] = Tag;
+  _NumRxWords++;
+}
+
+/*********************************************************************
+*
+*       _PopRx
+*/
+static uint32_t _PopRx(uint8_t Tag) {
+  uint32_t Data;
+
+  _Stat.NumFifoReads++;
+  if (_NumRxWords == 0u) {
+    _Stat.NumFifoErrors++;
+    return 0;
+  }
+  if (_aRxTag[_iRxRd] != Tag) {
+    _Stat.NumFifoErrors++;
+  }
+  Data = _aRx[_iRxRd];
+  _iRxRd = (_iRxRd + 1u) % RX_FIFO_WORDS;
+  _NumRxWords--;
+  return Data;
+}
+
+/*********************************************************************
+*
+*       _OnStatusPopped
+*
+*  Function description
+*    The channel reports the end of an IN transfer once its
+*    XFER_COMP entry has been taken from the Rx FIFO.
+*/
+static void _OnStatusPopped(uint32_t Status) {
+  unsigned Ch;
+
+  Ch = Status & USB_OTG_GRXSTSP_EPNUM;
+  if ((((Status & USB_OTG_GRXSTSP_PKTSTS) >> 17) == GRXSTS_PKTSTS_IN_XFER_COMP) && _aChannel[Ch].IsComplete) {
+    _aChannel[Ch].IsComplete = 0;
+    REG(HC_OFF(Ch, HCINT)) |= USB_OTG_HCINT_XFRC;
+  }
+}
+
+/*********************************************************************
+*
+*       _FindEndpoint
+*/
+static SIM_ENDPOINT * _FindEndpoint(uint8_t DevAddr, uint8_t EpAddr) {
+  unsigned i;
+
+  for (i = 0; i < NUM_ENDPOINTS; i++) {
+    if (_aEndpoint[i].IsUsed && (_aEndpoint[i].DevAddr == DevAddr) && (_aEndpoint[i].EpAddr == EpAddr)) {
+      return &_aEndpoint[i];
+    }
+  }
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       _PeekResponse
+*/
+static const HCD_SIM_RESPONSE * _PeekResponse(SIM_ENDPOINT * pEP) {
+  static const HCD_SIM_RESPONSE _Nak = { HCD_SIM_NAK, 0, NULL };
+
+  if ((pEP == NULL) || (pEP->iResponse >= pEP->NumResponses)) {
+    return &_Nak;
+  }
+  return &pEP->paResponse[pEP->iResponse];
+}
+
+/*********************************************************************
+*
+*       _EndTransaction
+*
+*  Function description
+*    The channel waits for the driver, which re-enables or halts it.
+*/
+static void _EndTransaction(unsigned Ch, uint32_t HCINT) {
+  _aChannel[Ch].State = CH_IDLE;
+  REG(HC_OFF(Ch, HCCHAR)) &= ~USB_OTG_HCCHAR_CHENA;
+  REG(HC_OFF(Ch, HCINT))  |= HCINT;
+}
+
+/*********************************************************************
+*
+*       _AckPacket
+*
+*  Function description
+*    Updates HCTSIZ for one packet of NumBytes.
+*
+*  Return value
+*    1: Last packet of the transfer.
+*/
+static int _AckPacket(unsigned Ch, unsigned NumBytes, unsigned MaxPacket) {
+  uint32_t HCTSIZ;
+  uint32_t XfrSiz;
+  uint32_t PktCnt;
+  uint32_t Dpid;
+
+  HCTSIZ = REG(HC_OFF(Ch, HCTSIZ));
+  XfrSiz = HCTSIZ & USB_OTG_HCTSIZ_XFRSIZ;
+  PktCnt = (HCTSIZ & USB_OTG_HCTSIZ_PKTCNT) >> 19;
+  Dpid   = (HCTSIZ & USB_OTG_HCTSIZ_DPID) >> 29;
+  XfrSiz = (NumBytes < XfrSiz) ? XfrSiz - NumBytes : 0u;
+  PktCnt = (PktCnt != 0u) ? PktCnt - 1u : 0u;
+  if (NumBytes < MaxPacket) {
+    PktCnt = 0;                                  // Short packet ends the transfer.
+  }
+  Dpid = (Dpid == HC_PID_DATA0) ? HC_PID_DATA1 : HC_PID_DATA0;
+  REG(HC_OFF(Ch, HCTSIZ)) = (HCTSIZ & ~(USB_OTG_HCTSIZ_XFRSIZ | USB_OTG_HCTSIZ_PKTCNT | USB_OTG_HCTSIZ_DPID))
+                          | XfrSiz | (PktCnt << 19) | (Dpid << 29);
+  return (PktCnt == 0u);
+}
+
+/*********************************************************************
+*
+*       _DoInTransaction
+*/
+static void _DoInTransaction(unsigned Ch, SIM_ENDPOINT * pEP, unsigned MaxPacket) {
+  const HCD_SIM_RESPONSE * pResponse;
+  unsigned                 NumWords;
+  unsigned                 RxSize;
+  unsigned                 i;
+  uint32_t                 Data;
+  uint32_t                 Dpid;
+
+  pResponse = _PeekResponse(pEP);
+  if (pResponse->Type == HCD_SIM_ACK) {
+    //
+    // The core only sends the IN token when the packet fits into the Rx FIFO.
+    //
+    NumWords = (pResponse->NumBytes + 3u) / 4u;
+    RxSize   = REG(OFF(GRXFSIZ)) & 0xFFFFu;
+    if (RxSize > RX_FIFO_WORDS) {
+      RxSize = RX_FIFO_WORDS;
+    }
+    if ((_NumRxWords + NumWords + 2u) > RxSize) {
+      return;
+    }
+  }
+  if (pEP && (pEP->iResponse < pEP->NumResponses)) {
+    pEP->iResponse++;
+  }
+  _Stat.NumTransactions++;
+  switch (pResponse->Type) {
+  case HCD_SIM_ACK:
+    Dpid = (REG(HC_OFF(Ch, HCTSIZ)) & USB_OTG_HCTSIZ_DPID) >> 29;
+    _PushRx(Ch | ((uint32_t)pResponse->NumBytes << 4) | (Dpid << 15) | (GRXSTS_PKTSTS_IN << 17), RX_TAG_STATUS);
+    for (i = 0; i < pResponse->NumBytes; i += 4u) {
+      Data = 0;
+      for (NumWords = 0; (NumWords < 4u) && ((i + NumWords) < pResponse->NumBytes); NumWords++) {
+        Data |= (uint32_t)(pResponse->pData ? pResponse->pData[i + NumWords] : (uint8_t)(i + NumWords)) << (8u * NumWords);
+      }
+      _PushRx(Data, RX_TAG_DATA);
+    }
+    if (_AckPacket(Ch, pResponse->NumBytes, MaxPacket)) {
+      _PushRx(Ch | (GRXSTS_PKTSTS_IN_XFER_COMP << 17), RX_TAG_STATUS);
+      _aChannel[Ch].IsComplete = 1;
+    }
+    _EndTransaction(Ch, USB_OTG_HCINT_ACK);
+    break;
+  case HCD_SIM_STALL:
+    _EndTransaction(Ch, USB_OTG_HCINT_STALL);
+    break;
+  case HCD_SIM_BABBLE:
+    _EndTransaction(Ch, USB_OTG_HCINT_BBERR);
+    break;
+  case HCD_SIM_NO_RESPONSE:
+    _EndTransaction(Ch, USB_OTG_HCINT_TXERR);
+    break;
+  default:
+    _EndTransaction(Ch, USB_OTG_HCINT_NAK);
+    break;
+  }
+}
+
+/*********************************************************************
+*
+*       _DoOutTransaction
+*/
+static void _DoOutTransaction(unsigned Ch, SIM_ENDPOINT * pEP, unsigned MaxPacket) {
+  const HCD_SIM_RESPONSE * pResponse;
+  SIM_CHANNEL            * pChannel;
+  unsigned                 NumBytes;
+  unsigned                 NumWords;
+  unsigned                 i;
+
+  pChannel = &_aChannel[Ch];
+  NumBytes = REG(HC_OFF(Ch, HCTSIZ)) & USB_OTG_HCTSIZ_XFRSIZ;
+  if (NumBytes > MaxPacket) {
+    NumBytes = MaxPacket;
+  }
+  NumWords = (NumBytes + 3u) / 4u;
+  if (pChannel->NumTxWords < NumWords) {
+    return;                                      // Packet not yet in the Tx FIFO.
+  }
+  pResponse = _PeekResponse(pEP);
+  if (pEP && (pEP->iResponse < pEP->NumResponses)) {
+    pEP->iResponse++;
+  }
+  _Stat.NumTransactions++;
+  switch (pResponse->Type) {
+  case HCD_SIM_ACK:
+    for (i = 0; i < NumBytes; i++) {
+      if (pEP && (pEP->NumOutBytes < HCD_SIM_MAX_OUT_BYTES)) {
+        pEP->abOut[pEP->NumOutBytes++] = (uint8_t)(pChannel->aTx[i / 4u] >> (8u * (i % 4u)));
+      }
+    }
+    pChannel->NumTxWords -= NumWords;
+    memmove(pChannel->aTx, &pChannel->aTx[NumWords], pChannel->NumTxWords * sizeof(uint32_t));
+    REG(HC_OFF(Ch, HCINT)) |= USB_OTG_HCINT_ACK;
+    if (_AckPacket(Ch, NumBytes, MaxPacket)) {
+      _EndTransaction(Ch, USB_OTG_HCINT_XFRC);
+    }
+    break;
+  case HCD_SIM_STALL:
+    _EndTransaction(Ch, USB_OTG_HCINT_STALL);
+    break;
+  case HCD_SIM_NAK:
+    _EndTransaction(Ch, USB_OTG_HCINT_NAK);
+    break;
+  default:
+    _EndTransaction(Ch, USB_OTG_HCINT_TXERR);
+    break;
+  }
+}
+
+/*********************************************************************
+*
+*       _DoChannel
+*/
+static void _DoChannel(unsigned Ch) {
+  SIM_CHANNEL  * pChannel;
+  SIM_ENDPOINT * pEP;
+  uint32_t       HCCHAR;
+  uint8_t        EpAddr;
+
+  pChannel = &_aChannel[Ch];
+  HCCHAR   = REG(HC_OFF(Ch, HCCHAR));
+  if (pChannel->State == CH_HALTING) {
+    pChannel->State      = CH_IDLE;
+    pChannel->NumTxWords = 0;
+    pChannel->IsComplete = 0;
+    REG(HC_OFF(Ch, HCCHAR)) = HCCHAR & ~(USB_OTG_HCCHAR_CHENA | USB_OTG_HCCHAR_CHDIS);
+    REG(HC_OFF(Ch, HCINT)) |= USB_OTG_HCINT_CHH;
+    return;
+  }
+  if ((pChannel->State != CH_ACTIVE) || ((REG(USB_OTG_HOST_PORT_BASE) & USB_OTG_HPRT_PENA) == 0u)) {
+    return;
+  }
+  EpAddr = (uint8_t)((HCCHAR & USB_OTG_HCCHAR_EPNUM) >> 11);
+  if (HCCHAR & USB_OTG_HCCHAR_EPDIR) {
+    EpAddr |= 0x80u;
+  }
+  pEP = _FindEndpoint((uint8_t)((HCCHAR & USB_OTG_HCCHAR_DAD) >> 22), EpAddr);
+  if (EpAddr & 0x80u) {
+    _DoInTransaction(Ch, pEP, HCCHAR & USB_OTG_HCCHAR_MPSIZ);
+  } else {
+    _DoOutTransaction(Ch, pEP, HCCHAR & USB_OTG_HCCHAR_MPSIZ);
+  }
+}
+
+/*********************************************************************
+*
+*       _Read
+*
+*  Function description
+*    Returns the value the driver reads from a register.
+*    Popping registers only pop on a plain read, not on the
+*    read of a read-modify-write instruction.
+*/
+static uint32_t _Read(uint32_t Off, int IsPop) {
+  uint32_t Status;
+
+  if (Off >= USB_OTG_FIFO_BASE) {
+    return IsPop ? _PopRx(RX_TAG_DATA) : 0u;
+  }
+  if (Off == OFF(GINTSTS)) {
+    return _GetGINTSTS();
+  }
+  if (Off == OFF(GRSTCTL)) {
+    return REG(Off) | USB_OTG_GRSTCTL_AHBIDL;
+  }
+  if (Off == OFF(GRXSTSR)) {
+    return (_NumRxWords != 0u) ? _aRx[_iRxRd] : 0u;
+  }
+  if (Off == OFF(GRXSTSP)) {
+    if (IsPop == 0) {
+      return 0;
+    }
+    Status = _PopRx(RX_TAG_STATUS);
+    _OnStatusPopped(Status);
+    return Status;
+  }
+  if (Off == OFF(HNPTXSTS)) {
+    return _GetTxStatus(0);
+  }
+  if (Off == HOST_OFF(HPTXSTS)) {
+    return _GetTxStatus(1);
+  }
+  if (Off == HOST_OFF(HFNUM)) {
+    return _Frame & USB_OTG_HFNUM_FRNUM;
+  }
+  if (Off == HOST_OFF(HAINT)) {
+    return _GetHAINT();
+  }
+  return REG(Off);
+}
+
+/*********************************************************************
+*
+*       _WriteHCCHAR
+*/
+static void _WriteHCCHAR(unsigned Ch, uint32_t v) {
+  SIM_CHANNEL * pChannel;
+
+  pChannel = &_aChannel[Ch];
+  REG(HC_OFF(Ch, HCCHAR)) = v;
+  if ((v & (USB_OTG_HCCHAR_CHENA | USB_OTG_HCCHAR_CHDIS)) == (USB_OTG_HCCHAR_CHENA | USB_OTG_HCCHAR_CHDIS)) {
+    pChannel->State = CH_HALTING;
+  } else if ((v & USB_OTG_HCCHAR_CHENA) && (pChannel->State != CH_HALTING)) {
+    pChannel->State = CH_ACTIVE;
+  } else if ((v & USB_OTG_HCCHAR_CHENA) == 0u) {
+    if (pChannel->State == CH_HALTING) {
+      REG(HC_OFF(Ch, HCCHAR)) |= USB_OTG_HCCHAR_CHDIS;  // Halt in progress, CHENA cannot be cleared.
+      REG(HC_OFF(Ch, HCCHAR)) |= USB_OTG_HCCHAR_CHENA;
+    } else {
+      pChannel->State = CH_IDLE;
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       _WriteHPRT
+*/
+static void _WriteHPRT(uint32_t v) {
+  uint32_t Old;
+  uint32_t New;
+
+  Old = REG(USB_OTG_HOST_PORT_BASE);
+  New = (Old & ~HPRT_RW) | (v & HPRT_RW);
+  New &= ~(v & HPRT_RC_W1);
+  if ((Old & USB_OTG_HPRT_PRST) && ((New & USB_OTG_HPRT_PRST) == 0u) && (New & USB_OTG_HPRT_PCSTS)) {
+    New &= ~USB_OTG_HPRT_PSPD;
+    New |= USB_OTG_HPRT_PENA | USB_OTG_HPRT_PENCHNG | ((_Speed << 17) & USB_OTG_HPRT_PSPD);
+  }
+  REG(USB_OTG_HOST_PORT_BASE) = New;
+}
+
+/*********************************************************************
+*
+*       _Write
+*
+*  Function description
+*    Applies a value written by the driver.
+*/
+static void _Write(uint32_t Off, uint32_t v) {
+  unsigned Ch;
+
+  if (Off >= USB_OTG_FIFO_BASE) {
+    Ch = (Off - USB_OTG_FIFO_BASE) / USB_OTG_FIFO_SIZE;
+    _Stat.NumFifoWrites++;
+    if (_aChannel[Ch].NumTxWords < TX_FIFO_WORDS) {
+      _aChannel[Ch].aTx[_aChannel[Ch].NumTxWords++] = v;
+    } else {
+      _Stat.NumFifoErrors++;
+    }
+    return;
+  }
+  if (Off == OFF(GINTSTS)) {
+    REG(Off) &= ~(v & GINTSTS_RC_W1);
+    return;
+  }
+  if (Off == OFF(GRSTCTL)) {
+    if (v & USB_OTG_GRSTCTL_RXFFLSH) {
+      _NumRxWords = 0;
+    }
+    if (v & USB_OTG_GRSTCTL_TXFFLSH) {
+      for (Ch = 0; Ch < NUM_CHANNELS; Ch++) {
+        _aChannel[Ch].NumTxWords = 0;
+      }
+    }
+    REG(Off) = v & ~(USB_OTG_GRSTCTL_CSRST | USB_OTG_GRSTCTL_TXFFLSH | USB_OTG_GRSTCTL_RXFFLSH);
+    return;
+  }
+  if ((Off == OFF(GRXSTSR)) || (Off == OFF(GRXSTSP)) || (Off == OFF(HNPTXSTS)) ||
+      (Off == HOST_OFF(HPTXSTS)) || (Off == HOST_OFF(HFNUM)) || (Off == HOST_OFF(HAINT))) {
+    return;                                      // Read-only.
+  }
+  if (Off == USB_OTG_HOST_PORT_BASE) {
+    _WriteHPRT(v);
+    return;
+  }
+  for (Ch = 0; Ch < NUM_CHANNELS; Ch++) {
+    if (Off == HC_OFF(Ch, HCCHAR)) {
+      _WriteHCCHAR(Ch, v);
+      return;
+    }
+    if (Off == HC_OFF(Ch, HCINT)) {
+      REG(Off) &= ~v;
+      return;
+    }
+  }
+  REG(Off) = v;
+}
+
+/*********************************************************************
+*
+*       Static code, access trap
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _GetPage
+*/
+static void * _GetPage(uint32_t Off) {
+  return _pMap + (Off & ~(PAGE_SIZE - 1u));
+}
+
+/*********************************************************************
+*
+*       _OnSegv
+*
+*  Function description
+*    A driver access to the register block. Provides the value to be
+*    read and single-steps the access with the page unprotected.
+*/
+static void _OnSegv(int Sig, siginfo_t * pInfo, void * pContext) {
+  ucontext_t * pUC;
+  uint8_t    * pAddr;
+  uint32_t     Off;
+
+  pUC   = (ucontext_t *)pContext;
+  pAddr = (uint8_t *)pInfo->si_addr;
+  if ((_pMap == NULL) || (pAddr < _pMap) || (pAddr >= (_pMap + MAP_SIZE)) || _IsPending) {
+    signal(SIGSEGV, SIG_DFL);                    // A real crash.
+    return;
+  }
+  Off             = (uint32_t)(pAddr - _pMap) & ~3u;
+  _PendingOff     = Off;
+  _PendingIsWrite = (pUC->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+  _IsPending      = 1;
+  if (_PendingIsWrite) {
+    _Stat.NumRegWrites++;
+  } else {
+    _Stat.NumRegReads++;
+    if (Off == OFF(GINTSTS)) {
+      _Stat.NumIntReads++;
+    }
+  }
+  mprotect(_GetPage(Off), PAGE_SIZE, PROT_READ | PROT_WRITE);
+  *(volatile uint32_t *)(_pMap + Off) = _Read(Off, _PendingIsWrite == 0);
+  pUC->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+/*********************************************************************
+*
+*       _OnTrap
+*
+*  Function description
+*    The access has been executed, applies a write and protects the
+*    page again.
+*/
+static void _OnTrap(int Sig, siginfo_t * pInfo, void * pContext) {
+  ucontext_t * pUC;
+
+  pUC = (ucontext_t *)pContext;
+  pUC->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+  if (_IsPending == 0) {
+    return;
+  }
+  if (_PendingIsWrite) {
+    _Write(_PendingOff, *(volatile uint32_t *)(_pMap + _PendingOff));
+  }
+  mprotect(_GetPage(_PendingOff), PAGE_SIZE, PROT_NONE);
+  _IsPending = 0;
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HCD_SIM_Init
+*
+*  Function description
+*    Maps the register block and puts the core into its reset state,
+*    no device connected.
+*/
+void HCD_SIM_Init(void) {
+  struct sigaction Action;
+
+  if (_pMap == NULL) {
+    _pMap = (uint8_t *)mmap(NULL, MAP_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (_pMap == MAP_FAILED) {
+      perror("HCD_SIM_Init: mmap");
+      exit(1);
+    }
+    memset(&Action, 0, sizeof(Action));
+    Action.sa_flags     = SA_SIGINFO;
+    Action.sa_sigaction = _OnSegv;
+    sigaction(SIGSEGV, &Action, NULL);
+    Action.sa_sigaction = _OnTrap;
+    sigaction(SIGTRAP, &Action, NULL);
+  }
+  memset(_aReg, 0, sizeof(_aReg));
+  memset(_aChannel, 0, sizeof(_aChannel));
+  memset(_aEndpoint, 0, sizeof(_aEndpoint));
+  memset(&_Stat, 0, sizeof(_Stat));
+  _NumRxWords = 0;
+  _iRxRd      = 0;
+  _Frame      = 0;
+  _Speed      = 0;
+  REG(OFF(CID))     = 0x00001200u;
+  REG(OFF(GRXFSIZ)) = 0x200u;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_GetInstance
+*/
+USB_OTG_GlobalTypeDef * HCD_SIM_GetInstance(void) {
+  return (USB_OTG_GlobalTypeDef *)_pMap;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_Connect
+*
+*  Parameters
+*    Speed: HCD_SPEED_FULL or HCD_SPEED_LOW, reported after the port reset.
+*/
+void HCD_SIM_Connect(uint32_t Speed) {
+  _Speed = Speed;
+  REG(USB_OTG_HOST_PORT_BASE) |= USB_OTG_HPRT_PCSTS | USB_OTG_HPRT_PCDET;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_Disconnect
+*
+*  Function description
+*    Removes the device. An enabled port is disabled, PENCHNG is set.
+*/
+void HCD_SIM_Disconnect(void) {
+  uint32_t HPRT;
+
+  HPRT = REG(USB_OTG_HOST_PORT_BASE);
+  if (HPRT & USB_OTG_HPRT_PENA) {
+    HPRT |= USB_OTG_HPRT_PENCHNG;
+  }
+  REG(USB_OTG_HOST_PORT_BASE) = HPRT & ~(USB_OTG_HPRT_PCSTS | USB_OTG_HPRT_PENA | USB_OTG_HPRT_PSPD);
+  REG(OFF(GINTSTS))          |= USB_OTG_GINTSTS_DISCINT;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_SetInt
+*
+*  Function description
+*    Sets GINTSTS bits which are cleared by writing 1, such as
+*    IPXFR/INCOMPISOOUT or MMIS, which the model does not raise itself.
+*/
+void HCD_SIM_SetInt(uint32_t Mask) {
+  REG(OFF(GINTSTS)) |= Mask & GINTSTS_RC_W1;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_SetScript
+*
+*  Function description
+*    Sets the responses of an endpoint, one per transaction.
+*    When all have been used, the endpoint answers NAK.
+*    The responses are not copied. Recorded OUT data is cleared.
+*/
+void HCD_SIM_SetScript(uint8_t DevAddr, uint8_t EpAddr, const HCD_SIM_RESPONSE * paResponse, unsigned NumResponses) {
+  SIM_ENDPOINT * pEP;
+  unsigned       i;
+
+  pEP = _FindEndpoint(DevAddr, EpAddr);
+  for (i = 0; (pEP == NULL) && (i < NUM_ENDPOINTS); i++) {
+    if (_aEndpoint[i].IsUsed == 0u) {
+      pEP = &_aEndpoint[i];
+    }
+  }
+  if (pEP == NULL) {
+    fprintf(stderr, "HCD_SIM_SetScript: more than %u endpoints\n", NUM_ENDPOINTS);
+    exit(1);
+  }
+  pEP->IsUsed       = 1;
+  pEP->DevAddr      = DevAddr;
+  pEP->EpAddr       = EpAddr;
+  pEP->paResponse   = paResponse;
+  pEP->NumResponses = NumResponses;
+  pEP->iResponse    = 0;
+  pEP->NumOutBytes  = 0;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_GetOutData
+*
+*  Return value
+*    Number of OUT bytes accepted by the endpoint since HCD_SIM_SetScript().
+*/
+unsigned HCD_SIM_GetOutData(uint8_t DevAddr, uint8_t EpAddr, uint8_t * pData, unsigned MaxBytes) {
+  SIM_ENDPOINT * pEP;
+
+  pEP = _FindEndpoint(DevAddr, EpAddr);
+  if (pEP == NULL) {
+    return 0;
+  }
+  memcpy(pData, pEP->abOut, (pEP->NumOutBytes < MaxBytes) ? pEP->NumOutBytes : MaxBytes);
+  return pEP->NumOutBytes;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_Frame
+*
+*  Function description
+*    Simulates one frame: starts it with SOF, completes pending halts
+*    and performs one transaction per enabled channel.
+*/
+void HCD_SIM_Frame(void) {
+  unsigned Ch;
+
+  _Frame = (_Frame + 1u) & USB_OTG_HFNUM_FRNUM;
+  if (REG(USB_OTG_HOST_PORT_BASE) & USB_OTG_HPRT_PENA) {
+    REG(OFF(GINTSTS)) |= USB_OTG_GINTSTS_SOF;
+  }
+  for (Ch = 0; Ch < NUM_CHANNELS; Ch++) {
+    _DoChannel(Ch);
+  }
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_IsIrqPending
+*/
+int HCD_SIM_IsIrqPending(void) {
+  if ((REG(OFF(GAHBCFG)) & USB_OTG_GAHBCFG_GINT) == 0u) {
+    return 0;
+  }
+  return (_GetGINTSTS() & REG(OFF(GINTMSK))) != 0u;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_Run
+*
+*  Function description
+*    Runs the interrupt handler while an interrupt is pending, then
+*    simulates the given number of frames, each followed by the
+*    interrupt handler.
+*/
+void HCD_SIM_Run(HCD_HandleTypeDef * hhcd, unsigned NumFrames) {
+  unsigned NumCalls;
+
+  for (;;) {
+    for (NumCalls = 0; HCD_SIM_IsIrqPending(); NumCalls++) {
+      if (NumCalls > 1000u) {
+        fprintf(stderr, "HCD_SIM_Run: interrupt not acknowledged, GINTSTS = 0x%08x\n", (unsigned)_GetGINTSTS());
+        exit(1);
+      }
+      HAL_HCD_IRQHandler(hhcd);
+    }
+    if (NumFrames-- == 0u) {
+      break;
+    }
+    HCD_SIM_Frame();
+  }
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_GetStat
+*/
+void HCD_SIM_GetStat(HCD_SIM_STAT * pStat) {
+  *pStat = _Stat;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_ResetStat
+*/
+void HCD_SIM_ResetStat(void) {
+  memset(&_Stat, 0, sizeof(_Stat));
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_GetPRIMASK
+*/
+uint32_t HCD_SIM_GetPRIMASK(void) {
+  return _PriMask;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_SetPRIMASK
+*/
+void HCD_SIM_SetPRIMASK(uint32_t PriMask) {
+  _PriMask = PriMask;
+}
+
+/*********************************************************************
+*
+*       HCD_SIM_DisableIRQ
+*/
+void HCD_SIM_DisableIRQ(void) {
+  _PriMask = 1;
+}
+
+/*********************************************************************
+*
+*       assert_failed
+*
+*  Function description
+*    assert_param() of the HAL, see Application/Main.c for the target.
+*/
+void assert_failed(uint8_t * file, uint32_t line) {
+  fprintf(stderr, "%s:%u: HAL assertion failed\n", (const char *)file, (unsigned)line);
+  exit(1);
+}
+
+/*********************************************************************
+*
+*       HAL_GetTick
+*
+*  Function description
+*    HAL time base of the simulation. Every call advances it by 1 ms,
+*    so timeouts expire without waiting.
+*/
+uint32_t HAL_GetTick(void) {
+  return _Tick++;
+}
+
+/*********************************************************************
+*
+*       HAL_Delay
+*/
+void HAL_Delay(uint32_t Delay) {
+  _Tick += Delay;
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,61 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HCD_SIM_HAL.c
+Purpose : Builds stm32f4xx_hal_hcd.c and stm32f4xx_ll_usb.c for the
+          register simulator of HCD_SIM.c.
+
+Additional information:
+  The driver sources are included unchanged. Before, the OTG_FS
+  instance is moved to the register block of the simulator, the
+  Cortex-M intrinsics which use inline assembly are replaced and the
+  DWT cycle counter is a static structure.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include "stm32f4xx_hal.h"
+#include "HCD_SIM.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#undef  USB_OTG_FS
+#define USB_OTG_FS              HCD_SIM_GetInstance()
+#undef  DWT
+#define DWT                     (&_DWT)
+#undef  CoreDebug
+#define CoreDebug               (&_CoreDebug)
+
+#define __get_PRIMASK           HCD_SIM_GetPRIMASK
+#define __set_PRIMASK           HCD_SIM_SetPRIMASK
+#define __disable_irq           HCD_SIM_DisableIRQ
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+#if (USE_HAL_HCD_STATISTICS == 1U)
+static DWT_Type                 _DWT;           // CYCCNT stays 0, HCD_SIM_GetStat() counts the accesses.
+static CoreDebug_Type           _CoreDebug;
+#endif
+
+/*********************************************************************
+*
+*       Driver
+*
+**********************************************************************
+*/
+#include "../BSP/Setup/System/STM32F4xx_HAL_Driver/Src/stm32f4xx_ll_usb.c"
+#include "../BSP/Setup/System/STM32F4xx_HAL_Driver/Src/stm32f4xx_hal_hcd.c"
+
+/*************************** End of file ****************************/
@@ -0,0 +1,43 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BINLOG_Decode.h
+Purpose : Host side decoder of the binary log records of BINLOG.c.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef BINLOG_DECODE_H                 /* Avoid multiple inclusion */
+#define BINLOG_DECODE_H
+
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  U8  Type;                             // BINLOG_TYPE_LOG, BINLOG_TYPE_WARN or BINLOG_TYPE_APP.
+  U16 Id;                               // Format ID of BINLOG_TYPE_APP.
+  U32 Timestamp;
+} BINLOG_DECODE_RECORD;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int BINLOG_DECODE_Record(const U8 * pData, unsigned NumBytes, BINLOG_DECODE_RECORD * pRecord, char * sText, unsigned SizeOfText);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
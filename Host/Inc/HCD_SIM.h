@@ -0,0 +1,107 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HCD_SIM.h
+Purpose : Register-level model of the STM32F4 OTG_FS core in host
+          mode for running stm32f4xx_hal_hcd.c and stm32f4xx_ll_usb.c
+          on Linux, see HCD_SIM.c.
+
+Additional information:
+  Typical test sequence:
+
+    HCD_SIM_Init();
+    hhcd.Instance = HCD_SIM_GetInstance();
+    HAL_HCD_Init(&hhcd);
+    HAL_HCD_Start(&hhcd);
+    HCD_SIM_Connect(HCD_SPEED_FULL);
+    HCD_SIM_Run(&hhcd, 1);                  // Connect callback
+    HAL_HCD_ResetPort(&hhcd);
+    HCD_SIM_Run(&hhcd, 1);                  // Port enabled
+    HCD_SIM_SetScript(1, 0x81, _aResponse, SEGGER_COUNTOF(_aResponse));
+    HAL_HCD_HC_Init(&hhcd, 1, 0x81, 1, HCD_SPEED_FULL, EP_TYPE_BULK, 64);
+    HAL_HCD_HC_SubmitRequest(&hhcd, 1, 1, EP_TYPE_BULK, 1, abBuffer, 512, 0);
+    HCD_SIM_Run(&hhcd, 20);                 // 20 frames
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HCD_SIM_H                       /* Avoid multiple inclusion */
+#define HCD_SIM_H
+
+#include "stm32f4xx_hal_conf.h"     // Not the stand-in Inc/stm32f4xx_hal.h next to this file.
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+
+//
+// Response of the simulated device to one transaction.
+//
+#define HCD_SIM_ACK             0       // IN: NumBytes of pData are returned. OUT: the packet is accepted.
+#define HCD_SIM_NAK             1
+#define HCD_SIM_STALL           2
+#define HCD_SIM_BABBLE          3       // IN only, OUT is answered with no response.
+#define HCD_SIM_NO_RESPONSE     4       // Timeout or CRC error, HCINT.TXERR.
+
+#define HCD_SIM_MAX_OUT_BYTES   4096    // OUT data recorded per endpoint.
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct {
+  uint8_t         Type;                 // HCD_SIM_ACK, ...
+  uint16_t        NumBytes;             // IN data of an ACK.
+  const uint8_t * pData;                // NULL returns the bytes 0, 1, 2, ...
+} HCD_SIM_RESPONSE;
+
+typedef struct {
+  uint32_t        NumRegReads;          // Register reads by the driver, FIFO reads included.
+  uint32_t        NumRegWrites;         // Register writes by the driver, FIFO writes included.
+  uint32_t        NumFifoReads;         // Words read from the Rx FIFO, GRXSTSP included.
+  uint32_t        NumFifoWrites;        // Words written to a Tx FIFO.
+  uint32_t        NumFifoErrors;        // Status read as data, data read as status or read from the empty Rx FIFO.
+  uint32_t        NumIntReads;          // GINTSTS reads.
+  uint32_t        NumTransactions;      // Transactions of the simulated device.
+} HCD_SIM_STAT;
+
+/*********************************************************************
+*
+*       API functions
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void                    HCD_SIM_Init          (void);
+USB_OTG_GlobalTypeDef * HCD_SIM_GetInstance   (void);
+void                    HCD_SIM_Connect       (uint32_t Speed);
+void                    HCD_SIM_Disconnect    (void);
+void                    HCD_SIM_SetInt        (uint32_t Mask);
+void                    HCD_SIM_SetScript     (uint8_t DevAddr, uint8_t EpAddr, const HCD_SIM_RESPONSE * paResponse, unsigned NumResponses);
+unsigned                HCD_SIM_GetOutData    (uint8_t DevAddr, uint8_t EpAddr, uint8_t * pData, unsigned MaxBytes);
+void                    HCD_SIM_Frame         (void);
+int                     HCD_SIM_IsIrqPending  (void);
+void                    HCD_SIM_Run           (HCD_HandleTypeDef * hhcd, unsigned NumFrames);
+void                    HCD_SIM_GetStat       (HCD_SIM_STAT * pStat);
+void                    HCD_SIM_ResetStat     (void);
+
+//
+// Cortex-M intrinsics used by the driver, see HCD_SIM_HAL.c.
+//
+uint32_t                HCD_SIM_GetPRIMASK    (void);
+void                    HCD_SIM_SetPRIMASK    (uint32_t PriMask);
+void                    HCD_SIM_DisableIRQ    (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
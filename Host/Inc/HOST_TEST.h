@@ -0,0 +1,53 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HOST_TEST.h
+Purpose : Minimal check macros for the tests in Host/Test.
+          Each test is one program, its exit code is the number
+          of failed checks.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HOST_TEST_H                     /* Avoid multiple inclusion */
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static int HOST_TEST_NumErrors;
+
+/*********************************************************************
+*
+*       Macros
+*
+**********************************************************************
+*/
+#define HOST_TEST_CHECK(Cond)                                                  \
+  do {                                                                         \
+    if (!(Cond)) {                                                             \
+      printf("%s:%d: Check failed: %s\n", __FILE__, __LINE__, #Cond);          \
+      HOST_TEST_NumErrors++;                                                   \
+    }                                                                          \
+  } while (0)
+
+#define HOST_TEST_CHECK_EQUAL(Exp, Act)                                        \
+  do {                                                                         \
+    long _e = (long)(Exp);                                                     \
+    long _a = (long)(Act);                                                     \
+    if (_e != _a) {                                                            \
+      printf("%s:%d: Check failed: %s == %s (%ld != %ld)\n",                   \
+             __FILE__, __LINE__, #Exp, #Act, _e, _a);                          \
+      HOST_TEST_NumErrors++;                                                   \
+    }                                                                          \
+  } while (0)
+
+#define HOST_TEST_END(sName)                                                   \
+  (printf("%s: %s\n", (sName), HOST_TEST_NumErrors ? "FAILED" : "OK"), HOST_TEST_NumErrors)
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
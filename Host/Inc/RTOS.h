@@ -0,0 +1,158 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : RTOS.h
+Purpose : embOS API subset for the Linux host build, implemented
+          on POSIX threads in OS_POSIX.c. Found before OS/RTOS.h
+          through the include path of Host/Makefile.
+
+Additional information:
+  Only the calls used by the application modules, the RTT terminal
+  and USBH_ConfigIO.c are provided. Semantics which differ from embOS:
+    - Tasks are threads, priorities are ignored.
+    - OS_EnterRegion() and OS_IncDI() lock one recursive mutex shared
+      by all tasks, so a region excludes all other regions, not all
+      other tasks.
+    - Time is CLOCK_MONOTONIC in ms plus the offset set with
+      OS_HOST_AdvanceTime(), one cycle is one nanosecond.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef RTOS_H                          /* Avoid multiple inclusion */
+#define RTOS_H
+
+#include <pthread.h>
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define OS_VERSION_GENERIC      0       // Not 38803, USBH_ConfigIO.c uses OS_pCurrentTask.
+#define OS_STACKPTR
+#define OS_VIEW_DISABLED        0
+#define OS_VIEW_IFSELECT        OS_VIEW_DISABLED
+
+#define OS_pCurrentTask         OS_GetTaskID()
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef unsigned char           OS_U8;
+typedef unsigned short          OS_U16;
+typedef unsigned int            OS_U32;
+typedef int                     OS_I32;
+typedef unsigned int            OS_UINT;
+typedef int                     OS_TIME;
+typedef OS_U32                  OS_TASKEVENT;
+typedef OS_U32                  OS_PRIO;
+
+typedef struct OS_TASK_STRUCT OS_TASK;
+struct OS_TASK_STRUCT {
+  pthread_t       Thread;
+  pthread_mutex_t Mutex;
+  pthread_cond_t  Cond;
+  const char    * sName;
+  void         (* pfRoutine)(void);
+  OS_TASKEVENT    Events;
+};
+
+typedef struct {
+  pthread_mutex_t Mutex;
+  pthread_cond_t  Cond;
+  char          * pData;
+  OS_U16          SizeofMsg;
+  OS_UINT         MaxnofMsg;
+  OS_UINT         nofMsg;
+  OS_UINT         iRd;
+} OS_MAILBOX;
+
+typedef struct {
+  pthread_mutex_t Mutex;
+} OS_MUTEX;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Kernel
+//
+void         OS_InitKern           (void);
+void         OS_InitHW             (void);
+void         OS_Start              (void);
+void         OS_EnterRegion        (void);
+void         OS_LeaveRegion        (void);
+void         OS_IncDI              (void);
+void         OS_DecRI              (void);
+OS_U32       OS_GetBASEPRI         (void);
+void         OS_SetBASEPRI         (OS_U32 BasePri);
+void         OS_COM_SendString     (const char * s);
+
+//
+// Tasks
+//
+void         OS_TASK_Create        (OS_TASK * pTask, const char * sName, void (*pfRoutine)(void));
+void         OS_SetPriority        (OS_TASK * pTask, OS_PRIO Priority);
+OS_TASK    * OS_GetTaskID          (void);
+const char * OS_GetTaskName        (const OS_TASK * pTask);
+void         OS_TerminateTask      (OS_TASK * pTask);
+void         OS_Delay              (OS_TIME ms);
+void         OS_DelayUntil         (OS_TIME t);
+
+#define OS_CREATETASK(pTask, sName, pfRoutine, Priority, pStack)   ((void)(pStack), OS_TASK_Create((pTask), (sName), (pfRoutine)))
+
+//
+// Task events
+//
+void         OS_TASKEVENT_Set      (OS_TASK * pTask, OS_TASKEVENT Event);
+OS_TASKEVENT OS_TASKEVENT_GetBlocked(OS_TASKEVENT EventMask);
+OS_TASKEVENT OS_TASKEVENT_GetTimed (OS_TASKEVENT EventMask, OS_TIME Timeout);
+
+//
+// Mailboxes
+//
+void         OS_MAILBOX_Create     (OS_MAILBOX * pMB, OS_U16 SizeofMsg, OS_UINT MaxnofMsg, void * pBuffer);
+char         OS_MAILBOX_Put        (OS_MAILBOX * pMB, const void * pMail);
+char         OS_MAILBOX_Get        (OS_MAILBOX * pMB, void * pDest);
+void         OS_MAILBOX_GetBlocked (OS_MAILBOX * pMB, void * pDest);
+
+#define OS_PutMailCond             OS_MAILBOX_Put
+#define OS_GetMail                 OS_MAILBOX_GetBlocked
+
+//
+// Mutexes
+//
+void         OS_MUTEX_Create       (OS_MUTEX * pMutex);
+void         OS_MUTEX_LockBlocked  (OS_MUTEX * pMutex);
+void         OS_MUTEX_Unlock       (OS_MUTEX * pMutex);
+
+//
+// Time
+//
+OS_I32       OS_GetTime32          (void);
+OS_TIME      OS_GetTime            (void);
+OS_U32       OS_GetTime_Cycles     (void);
+OS_U32       OS_ConvertCycles2us   (OS_U32 Cycles);
+
+//
+// Host only
+//
+void         OS_HOST_AdvanceTime   (OS_TIME ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,31 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : stm32f4xx_hal.h
+Purpose : Stand-in for the STM32F4 HAL in the Linux host build.
+          Provides the few register and clock symbols the sample
+          applications print in MainTask.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef STM32F4XX_HAL_H                 /* Avoid multiple inclusion */
+#define STM32F4XX_HAL_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct {
+  volatile uint32_t CFGR;
+  volatile uint32_t PLLCFGR;
+} RCC_TypeDef;
+
+extern RCC_TypeDef  HOST_RCC;
+extern uint32_t     SystemCoreClock;
+
+#define RCC                 (&HOST_RCC)
+#define RCC_CFGR_SWS        0x0000000Cu
+#define RCC_PLLCFGR_PLLN    0x00007FC0u
+#define HSE_VALUE           8000000u
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,396 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : OS_POSIX.c
+Purpose : embOS API subset on POSIX threads for the Linux host build,
+          see Host/Inc/RTOS.h for the differences to embOS.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include "RTOS.h"
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static pthread_mutex_t   _RegionMutex;
+static pthread_once_t    _InitOnce    = PTHREAD_ONCE_INIT;
+static pthread_key_t     _TaskKey;
+static OS_TASK           _MainTask;
+static struct timespec   _StartTime;
+static volatile OS_TIME  _TimeOffset;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _InitTask
+*/
+static void _InitTask(OS_TASK * pTask, const char * sName, void (*pfRoutine)(void)) {
+  memset(pTask, 0, sizeof(*pTask));
+  pthread_mutex_init(&pTask->Mutex, NULL);
+  pthread_cond_init(&pTask->Cond, NULL);
+  pTask->sName     = sName;
+  pTask->pfRoutine = pfRoutine;
+}
+
+/*********************************************************************
+*
+*       _Init
+*
+*  Function description
+*    Registers the thread calling the first OS function as MainTask.
+*/
+static void _Init(void) {
+  pthread_mutexattr_t Attr;
+
+  pthread_mutexattr_init(&Attr);
+  pthread_mutexattr_settype(&Attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&_RegionMutex, &Attr);
+  pthread_mutexattr_destroy(&Attr);
+  clock_gettime(CLOCK_MONOTONIC, &_StartTime);
+  pthread_key_create(&_TaskKey, NULL);
+  _InitTask(&_MainTask, "MainTask", NULL);
+  _MainTask.Thread = pthread_self();
+  pthread_setspecific(_TaskKey, &_MainTask);
+}
+
+/*********************************************************************
+*
+*       _GetTime_ns
+*/
+static unsigned long long _GetTime_ns(void) {
+  struct timespec t;
+
+  pthread_once(&_InitOnce, _Init);
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (unsigned long long)(t.tv_sec - _StartTime.tv_sec) * 1000000000uLL + (unsigned long long)t.tv_nsec - (unsigned long long)_StartTime.tv_nsec;
+}
+
+/*********************************************************************
+*
+*       _GetDeadline
+*
+*  Function description
+*    Converts a timeout in ms into an absolute CLOCK_REALTIME deadline
+*    as required by pthread_cond_timedwait().
+*/
+static void _GetDeadline(struct timespec * pDeadline, OS_TIME ms) {
+  clock_gettime(CLOCK_REALTIME, pDeadline);
+  pDeadline->tv_sec  += ms / 1000;
+  pDeadline->tv_nsec += (long)(ms % 1000) * 1000000L;
+  if (pDeadline->tv_nsec >= 1000000000L) {
+    pDeadline->tv_sec++;
+    pDeadline->tv_nsec -= 1000000000L;
+  }
+}
+
+/*********************************************************************
+*
+*       _TaskEntry
+*/
+static void * _TaskEntry(void * p) {
+  OS_TASK * pTask;
+
+  pTask = (OS_TASK *)p;
+  pthread_setspecific(_TaskKey, pTask);
+  pTask->pfRoutine();
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       Public code, kernel
+*
+**********************************************************************
+*/
+void OS_InitKern(void) {
+  pthread_once(&_InitOnce, _Init);
+}
+
+void OS_InitHW(void) {
+}
+
+/*********************************************************************
+*
+*       OS_Start
+*
+*  Function description
+*    Does not return, the tasks created so far keep running.
+*/
+void OS_Start(void) {
+  for (;;) {
+    pause();
+  }
+}
+
+void OS_EnterRegion(void) {
+  pthread_once(&_InitOnce, _Init);
+  pthread_mutex_lock(&_RegionMutex);
+}
+
+void OS_LeaveRegion(void) {
+  pthread_mutex_unlock(&_RegionMutex);
+}
+
+void OS_IncDI(void) {
+  pthread_once(&_InitOnce, _Init);
+  pthread_mutex_lock(&_RegionMutex);
+}
+
+void OS_DecRI(void) {
+  pthread_mutex_unlock(&_RegionMutex);
+}
+
+OS_U32 OS_GetBASEPRI(void) {
+  return 0;
+}
+
+void OS_SetBASEPRI(OS_U32 BasePri) {
+  (void)BasePri;
+}
+
+void OS_COM_SendString(const char * s) {
+  fputs(s, stdout);
+}
+
+/*********************************************************************
+*
+*       Public code, tasks
+*
+**********************************************************************
+*/
+void OS_TASK_Create(OS_TASK * pTask, const char * sName, void (*pfRoutine)(void)) {
+  pthread_once(&_InitOnce, _Init);
+  _InitTask(pTask, sName, pfRoutine);
+  pthread_create(&pTask->Thread, NULL, _TaskEntry, pTask);
+}
+
+void OS_SetPriority(OS_TASK * pTask, OS_PRIO Priority) {
+  (void)pTask;
+  (void)Priority;
+}
+
+OS_TASK * OS_GetTaskID(void) {
+  pthread_once(&_InitOnce, _Init);
+  return (OS_TASK *)pthread_getspecific(_TaskKey);
+}
+
+const char * OS_GetTaskName(const OS_TASK * pTask) {
+  return pTask ? pTask->sName : NULL;
+}
+
+void OS_TerminateTask(OS_TASK * pTask) {
+  if ((pTask == NULL) || (pTask == OS_GetTaskID())) {
+    pthread_exit(NULL);
+  }
+  pthread_cancel(pTask->Thread);
+  pthread_join(pTask->Thread, NULL);
+}
+
+void OS_Delay(OS_TIME ms) {
+  struct timespec t;
+
+  if (ms > 0) {
+    t.tv_sec  = ms / 1000;
+    t.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&t, NULL);
+  }
+}
+
+void OS_DelayUntil(OS_TIME t) {
+  OS_Delay(t - OS_GetTime());
+}
+
+/*********************************************************************
+*
+*       Public code, task events
+*
+**********************************************************************
+*/
+void OS_TASKEVENT_Set(OS_TASK * pTask, OS_TASKEVENT Event) {
+  pthread_mutex_lock(&pTask->Mutex);
+  pTask->Events |= Event;
+  pthread_cond_broadcast(&pTask->Cond);
+  pthread_mutex_unlock(&pTask->Mutex);
+}
+
+OS_TASKEVENT OS_TASKEVENT_GetBlocked(OS_TASKEVENT EventMask) {
+  OS_TASK    * pTask;
+  OS_TASKEVENT Events;
+
+  pTask = OS_GetTaskID();
+  pthread_mutex_lock(&pTask->Mutex);
+  while ((pTask->Events & EventMask) == 0u) {
+    pthread_cond_wait(&pTask->Cond, &pTask->Mutex);
+  }
+  Events         = pTask->Events & EventMask;
+  pTask->Events &= ~EventMask;
+  pthread_mutex_unlock(&pTask->Mutex);
+  return Events;
+}
+
+OS_TASKEVENT OS_TASKEVENT_GetTimed(OS_TASKEVENT EventMask, OS_TIME Timeout) {
+  OS_TASK       * pTask;
+  OS_TASKEVENT    Events;
+  struct timespec Deadline;
+
+  pTask = OS_GetTaskID();
+  _GetDeadline(&Deadline, Timeout);
+  pthread_mutex_lock(&pTask->Mutex);
+  while ((pTask->Events & EventMask) == 0u) {
+    if (pthread_cond_timedwait(&pTask->Cond, &pTask->Mutex, &Deadline) != 0) {
+      break;
+    }
+  }
+  Events         = pTask->Events & EventMask;
+  pTask->Events &= ~EventMask;
+  pthread_mutex_unlock(&pTask->Mutex);
+  return Events;
+}
+
+/*********************************************************************
+*
+*       Public code, mailboxes
+*
+**********************************************************************
+*/
+void OS_MAILBOX_Create(OS_MAILBOX * pMB, OS_U16 SizeofMsg, OS_UINT MaxnofMsg, void * pBuffer) {
+  memset(pMB, 0, sizeof(*pMB));
+  pthread_mutex_init(&pMB->Mutex, NULL);
+  pthread_cond_init(&pMB->Cond, NULL);
+  pMB->pData     = (char *)pBuffer;
+  pMB->SizeofMsg = SizeofMsg;
+  pMB->MaxnofMsg = MaxnofMsg;
+}
+
+/*********************************************************************
+*
+*       OS_MAILBOX_Put
+*
+*  Return value
+*    0: Stored.
+*    1: Mailbox full, the message has not been stored.
+*/
+char OS_MAILBOX_Put(OS_MAILBOX * pMB, const void * pMail) {
+  OS_UINT iWr;
+
+  pthread_mutex_lock(&pMB->Mutex);
+  if (pMB->nofMsg == pMB->MaxnofMsg) {
+    pthread_mutex_unlock(&pMB->Mutex);
+    return 1;
+  }
+  iWr = (pMB->iRd + pMB->nofMsg) % pMB->MaxnofMsg;
+  memcpy(pMB->pData + iWr * pMB->SizeofMsg, pMail, pMB->SizeofMsg);
+  pMB->nofMsg++;
+  pthread_cond_broadcast(&pMB->Cond);
+  pthread_mutex_unlock(&pMB->Mutex);
+  return 0;
+}
+
+/*********************************************************************
+*
+*       OS_MAILBOX_Get
+*
+*  Return value
+*    0: Message retrieved.
+*    1: Mailbox empty.
+*/
+char OS_MAILBOX_Get(OS_MAILBOX * pMB, void * pDest) {
+  pthread_mutex_lock(&pMB->Mutex);
+  if (pMB->nofMsg == 0u) {
+    pthread_mutex_unlock(&pMB->Mutex);
+    return 1;
+  }
+  memcpy(pDest, pMB->pData + pMB->iRd * pMB->SizeofMsg, pMB->SizeofMsg);
+  pMB->iRd = (pMB->iRd + 1u) % pMB->MaxnofMsg;
+  pMB->nofMsg--;
+  pthread_mutex_unlock(&pMB->Mutex);
+  return 0;
+}
+
+void OS_MAILBOX_GetBlocked(OS_MAILBOX * pMB, void * pDest) {
+  pthread_mutex_lock(&pMB->Mutex);
+  while (pMB->nofMsg == 0u) {
+    pthread_cond_wait(&pMB->Cond, &pMB->Mutex);
+  }
+  memcpy(pDest, pMB->pData + pMB->iRd * pMB->SizeofMsg, pMB->SizeofMsg);
+  pMB->iRd = (pMB->iRd + 1u) % pMB->MaxnofMsg;
+  pMB->nofMsg--;
+  pthread_mutex_unlock(&pMB->Mutex);
+}
+
+/*********************************************************************
+*
+*       Public code, mutexes
+*
+**********************************************************************
+*/
+void OS_MUTEX_Create(OS_MUTEX * pMutex) {
+  pthread_mutexattr_t Attr;
+
+  pthread_mutexattr_init(&Attr);
+  pthread_mutexattr_settype(&Attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&pMutex->Mutex, &Attr);
+  pthread_mutexattr_destroy(&Attr);
+}
+
+void OS_MUTEX_LockBlocked(OS_MUTEX * pMutex) {
+  pthread_mutex_lock(&pMutex->Mutex);
+}
+
+void OS_MUTEX_Unlock(OS_MUTEX * pMutex) {
+  pthread_mutex_unlock(&pMutex->Mutex);
+}
+
+/*********************************************************************
+*
+*       Public code, time
+*
+**********************************************************************
+*/
+OS_I32 OS_GetTime32(void) {
+  return (OS_I32)(_GetTime_ns() / 1000000uLL) + _TimeOffset;
+}
+
+OS_TIME OS_GetTime(void) {
+  return (OS_TIME)OS_GetTime32();
+}
+
+OS_U32 OS_GetTime_Cycles(void) {
+  return (OS_U32)_GetTime_ns();
+}
+
+OS_U32 OS_ConvertCycles2us(OS_U32 Cycles) {
+  return Cycles / 1000u;
+}
+
+/*********************************************************************
+*
+*       OS_HOST_AdvanceTime
+*
+*  Function description
+*    Moves the time returned by OS_GetTime32() forward, so tests of
+*    timeouts do not have to sleep. Timed waits are not affected.
+*/
+void OS_HOST_AdvanceTime(OS_TIME ms) {
+  _TimeOffset += ms;
+}
+
+/*************************** End of file ****************************/
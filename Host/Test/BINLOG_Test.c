@@ -0,0 +1,215 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BINLOG_Test.c
+Purpose : Round trip test of BINLOG.c with USE_BINLOG=1 and the host
+          decoder BINLOG_Decode.c.
+
+Additional information:
+  BINLOG.c is compiled into this file with USE_BINLOG=1, its functions
+  renamed so they do not clash with the text build of the library.
+  Each application format is logged with BINLOG_MAX_ARGS arguments,
+  read back from the RTT channel and decoded. The text has to equal the
+  output of SEGGER_snprintf() for the same format and arguments, which
+  is what the target prints without USE_BINLOG.
+  The log filter and USBH_Logf_Application() of emUSB-Host are replaced
+  by stand-ins which pass the message to BINLOG_WriteText(), as
+  USBH_Log() of USBH_ConfigIO.c does with USE_BINLOG.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include "SEGGER.h"
+
+static U32 _Timestamp;
+
+#define USE_BINLOG              1
+#define BINLOG_GET_TIMESTAMP()  (_Timestamp++)
+#define BINLOG_Init             BINLOG_Init_Binary
+#define BINLOG_SetLogFilter     BINLOG_SetLogFilter_Binary
+#define BINLOG_AddLogFilter     BINLOG_AddLogFilter_Binary
+#define BINLOG_LogArgs          BINLOG_LogArgs_Binary
+#define BINLOG_WriteText        BINLOG_WriteText_Binary
+#define USBH_SetLogFilter       _SetLogFilter
+#define USBH_AddLogFilter       _AddLogFilter
+#define USBH_Logf_Application   _Logf_Application
+#include "../../Application/BINLOG.c"
+
+#include "BINLOG_Decode.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Static const data
+*
+**********************************************************************
+*/
+#define BINLOG_FORMAT(Id, sFormat)  sFormat,
+static const char * const _asFormatTarget[BINLOG_NUM_FORMATS] = {
+  #include "BINLOG_Formats.h"
+};
+#undef BINLOG_FORMAT
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static U8       _abStream[BINLOG_BUFFER_SIZE];
+static unsigned _NumBytes;
+static U32      _LogFilter = USBH_MTYPE_INIT;   // Default of emUSB-Host.
+
+/*********************************************************************
+*
+*       emUSB-Host stand-ins
+*
+**********************************************************************
+*/
+void _SetLogFilter(U32 FilterMask) {
+  _LogFilter = FilterMask;
+}
+
+void _AddLogFilter(U32 FilterMask) {
+  _LogFilter |= FilterMask;
+}
+
+void _Logf_Application(const char * sFormat, ...) {
+  if (_LogFilter & USBH_MTYPE_APPLICATION) {
+    BINLOG_WriteText_Binary(BINLOG_TYPE_LOG, sFormat);    // Only called with the probe, which has no arguments.
+  }
+}
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _ReadChannel
+*
+*  Function description
+*    Takes all data from the BinLog channel, as J-Link does.
+*/
+static void _ReadChannel(void) {
+  SEGGER_RTT_BUFFER_UP * pRing;
+
+  pRing = &_SEGGER_RTT.aUp[BINLOG_RTT_CHANNEL];
+  _NumBytes = 0;
+  while (pRing->RdOff != pRing->WrOff) {
+    _abStream[_NumBytes++] = (U8)pRing->pBuffer[pRing->RdOff];
+    pRing->RdOff = (pRing->RdOff + 1u) % pRing->SizeOfBuffer;
+  }
+}
+
+/*********************************************************************
+*
+*       _TestFormats
+*/
+static void _TestFormats(void) {
+  BINLOG_DECODE_RECORD Record;
+  U32                  aArg[BINLOG_MAX_ARGS];
+  char                 acExpected[256];
+  char                 acText[256];
+  unsigned             Id;
+  unsigned             i;
+  int                  r;
+
+  for (Id = 0; Id < BINLOG_NUM_FORMATS; Id++) {
+    for (i = 0; i < BINLOG_MAX_ARGS; i++) {
+      aArg[i] = (i & 1u) ? (U32)-(int)(Id * 1000u + i) : (Id * 100000u + i);
+    }
+    _Timestamp = 0x12345678u + Id;
+    BINLOG_LogArgs_Binary(Id, aArg, BINLOG_MAX_ARGS);
+    _ReadChannel();
+    HOST_TEST_CHECK_EQUAL(8u + (BINLOG_MAX_ARGS * 4u), _NumBytes);
+    HOST_TEST_CHECK_EQUAL(0, BINLOG_DECODE_Record(_abStream, _NumBytes - 1u, &Record, acText, sizeof(acText)));
+    r = BINLOG_DECODE_Record(_abStream, _NumBytes, &Record, acText, sizeof(acText));
+    HOST_TEST_CHECK_EQUAL(_NumBytes, r);
+    HOST_TEST_CHECK_EQUAL(BINLOG_TYPE_APP, Record.Type);
+    HOST_TEST_CHECK_EQUAL(Id, Record.Id);
+    HOST_TEST_CHECK_EQUAL(0x12345678u + Id, Record.Timestamp);
+    SEGGER_snprintf(acExpected, sizeof(acExpected), _asFormatTarget[Id], aArg[0], aArg[1], aArg[2], aArg[3], aArg[4], aArg[5]);
+    if (strcmp(acExpected, acText) != 0) {
+      printf("Format %u: \"%s\" decoded as \"%s\"\n", Id, acExpected, acText);
+      HOST_TEST_CHECK(0);
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       _TestText
+*/
+static void _TestText(void) {
+  BINLOG_DECODE_RECORD Record;
+  char                 acLong[400];
+  char                 acText[512];
+  int                  r;
+
+  BINLOG_WriteText_Binary(BINLOG_TYPE_WARN, "USBH: Device not responding");
+  memset(acLong, 'x', sizeof(acLong) - 1u);
+  acLong[sizeof(acLong) - 1u] = '\0';
+  BINLOG_WriteText_Binary(BINLOG_TYPE_LOG, acLong);
+  _ReadChannel();
+  r = BINLOG_DECODE_Record(_abStream, _NumBytes, &Record, acText, sizeof(acText));
+  HOST_TEST_CHECK_EQUAL(8 + 27, r);
+  HOST_TEST_CHECK_EQUAL(BINLOG_TYPE_WARN, Record.Type);
+  HOST_TEST_CHECK(strcmp(acText, "USBH: Device not responding") == 0);
+  r = BINLOG_DECODE_Record(&_abStream[8 + 27], _NumBytes - (8u + 27u), &Record, acText, sizeof(acText));
+  HOST_TEST_CHECK_EQUAL(8 + 255, r);                  // Truncated to 255 characters.
+  HOST_TEST_CHECK_EQUAL(BINLOG_TYPE_LOG, Record.Type);
+  HOST_TEST_CHECK_EQUAL(255, strlen(acText));
+  HOST_TEST_CHECK_EQUAL(-1, BINLOG_DECODE_Record((const U8 *)"\x07\x00\x00\x00\x00\x00\x00\x00", 8, &Record, acText, sizeof(acText)));
+}
+
+/*********************************************************************
+*
+*       _TestFilter
+*
+*  Function description
+*    BINLOG_LOG() follows the log filter of emUSB-Host, however it is
+*    set, and the probe is never sent.
+*/
+static void _TestFilter(void) {
+  static const U32 _aArg[] = { 1 };
+
+  USBH_SetLogFilter(USBH_MTYPE_INIT);
+  BINLOG_LogArgs_Binary(BINLOG_ID_DEVICE_ADDED, _aArg, SEGGER_COUNTOF(_aArg));
+  _ReadChannel();
+  HOST_TEST_CHECK_EQUAL(0, _NumBytes);
+  USBH_AddLogFilter(USBH_MTYPE_APPLICATION);
+  BINLOG_LogArgs_Binary(BINLOG_ID_DEVICE_ADDED, _aArg, SEGGER_COUNTOF(_aArg));
+  _ReadChannel();
+  HOST_TEST_CHECK_EQUAL(8 + 4, _NumBytes);
+  BINLOG_SetLogFilter_Binary(0);
+  BINLOG_LogArgs_Binary(BINLOG_ID_DEVICE_ADDED, _aArg, SEGGER_COUNTOF(_aArg));
+  _ReadChannel();
+  HOST_TEST_CHECK_EQUAL(0, _NumBytes);
+  BINLOG_AddLogFilter_Binary(USBH_MTYPE_APPLICATION);
+  HOST_TEST_CHECK_EQUAL(USBH_MTYPE_APPLICATION, _LogFilter);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  SEGGER_RTT_Init();
+  BINLOG_Init_Binary();
+  USBH_SetLogFilter(USBH_MTYPE_APPLICATION);
+  _TestFormats();
+  _TestText();
+  _TestFilter();
+  return HOST_TEST_END("BINLOG_Test");
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,94 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HCD_FIFO_Test.c
+Purpose : Test of HAL_HCD_Init() with a FIFO profile which does not
+          fit into the FIFO RAM, on the register simulator of
+          HCD_SIM.c.
+
+Additional information:
+  Built with USB_OTG_FS_FIFO_WORDS=256U, see Makefile. All profiles of
+  OTG_FS take 320 words, so HAL_HCD_Init() has to fail and must not
+  program the FIFO size registers. A partition which fits can still
+  be set with HAL_HCD_SetFifoConfig().
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <string.h>
+#include "HCD_SIM.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define NUM_CHANNELS       8u
+#define GRXFSIZ_RESET      0x200u       // Reset value of GRXFSIZ in HCD_SIM.c.
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static HCD_HandleTypeDef _hhcd;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _TestInit
+*/
+static void _TestInit(void) {
+  memset(&_hhcd, 0, sizeof(_hhcd));
+  _hhcd.Instance           = HCD_SIM_GetInstance();
+  _hhcd.Init.Host_channels = NUM_CHANNELS;
+  _hhcd.Init.speed         = HCD_SPEED_FULL;
+  _hhcd.Init.dma_enable    = 0;
+  _hhcd.Init.phy_itface    = HCD_PHY_EMBEDDED;
+  HOST_TEST_CHECK_EQUAL(HAL_ERROR, HAL_HCD_Init(&_hhcd));
+  HOST_TEST_CHECK_EQUAL(HAL_HCD_STATE_ERROR, HAL_HCD_GetState(&_hhcd));
+  HOST_TEST_CHECK_EQUAL(GRXFSIZ_RESET, _hhcd.Instance->GRXFSIZ);
+  HOST_TEST_CHECK_EQUAL(0, _hhcd.Instance->DIEPTXF0_HNPTXFSIZ);
+  HOST_TEST_CHECK_EQUAL(0, _hhcd.Instance->HPTXFSIZ);
+}
+
+/*********************************************************************
+*
+*       _TestSetFifoConfig
+*/
+static void _TestSetFifoConfig(void) {
+  static const HCD_FifoCfgTypeDef _CfgFit = { 0x80, 0x40, 0x40 };
+  HCD_FifoCfgTypeDef Cfg;
+
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_SetFifoConfig(&_hhcd, &_CfgFit));
+  HAL_HCD_GetFifoConfig(&_hhcd, &Cfg);
+  HOST_TEST_CHECK(memcmp(&Cfg, &_CfgFit, sizeof(Cfg)) == 0);
+  HOST_TEST_CHECK_EQUAL((0x40u << 16) | 0xC0u, _hhcd.Instance->HPTXFSIZ);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  HCD_SIM_Init();
+  _TestInit();
+  _TestSetFifoConfig();
+  return HOST_TEST_END("HCD_FIFO_Test");
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,242 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HCD_IRQ_Test.c
+Purpose : Test of the interrupt dispatch HCD_IRQ_Dispatch() of
+          stm32f4xx_hal_hcd.c on the register simulator of HCD_SIM.c.
+
+Additional information:
+  HAL_HCD_IRQHandler() is called directly, not through HCD_SIM_Run(),
+  so the effect of a single call can be checked:
+    - Without a pending interrupt only GINTSTS and GINTMSK are read.
+    - SOF, HCINT, HPRTINT, RXFLVL and an acknowledge only interrupt
+      which are pending together are all handled by one call, which reads GINTSTS once for the mode and once for the
+      interrupts.
+    - A HAINT bit of a channel beyond Init.Host_channels is not
+      handled and stays pending.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <string.h>
+#include "HCD_SIM.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define DEV_ADDR           1u
+#define MAX_PACKET         64u
+#define NUM_CHANNELS       8u
+#define COUNTOF(a)         (sizeof(a) / sizeof((a)[0]))
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static HCD_HandleTypeDef   _hhcd;
+static unsigned            _NumConnects;
+static unsigned            _NumSOFs;
+static unsigned            _aNumNotify[NUM_CHANNELS];
+static HCD_URBStateTypeDef _aURBState[NUM_CHANNELS];
+static uint8_t             _abBuffer[256];
+
+static const HCD_SIM_RESPONSE _aIn[]  = { { HCD_SIM_ACK, 13, NULL } };
+static const HCD_SIM_RESPONSE _aNak[] = { { HCD_SIM_NAK, 0,  NULL } };
+
+/*********************************************************************
+*
+*       Callbacks of stm32f4xx_hal_hcd.c
+*
+**********************************************************************
+*/
+void HAL_HCD_Connect_Callback(HCD_HandleTypeDef * hhcd) {
+  _NumConnects++;
+}
+
+void HAL_HCD_SOF_Callback(HCD_HandleTypeDef * hhcd) {
+  _NumSOFs++;
+}
+
+void HAL_HCD_HC_NotifyURBChange_Callback(HCD_HandleTypeDef * hhcd, uint8_t chnum, HCD_URBStateTypeDef urb_state) {
+  _aNumNotify[chnum]++;
+  _aURBState[chnum] = urb_state;
+}
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _Submit
+*/
+static void _Submit(uint8_t Ch, uint8_t EpAddr, uint8_t * pData, uint16_t NumBytes) {
+  _aNumNotify[Ch] = 0;
+  _aURBState[Ch]  = URB_IDLE;
+  HAL_HCD_HC_Init(&_hhcd, Ch, EpAddr, DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_BULK, MAX_PACKET);
+  HAL_HCD_HC_SubmitRequest(&_hhcd, Ch, (EpAddr & 0x80u) ? 1u : 0u, EP_TYPE_BULK, 1u, pData, NumBytes, 0u);
+}
+
+/*********************************************************************
+*
+*       _GetPending
+*
+*  Function description
+*    Returns the enabled interrupts which are pending.
+*/
+static uint32_t _GetPending(void) {
+  USB_OTG_GlobalTypeDef * USBx;
+
+  USBx = _hhcd.Instance;
+  return USBx->GINTSTS & USBx->GINTMSK;
+}
+
+/*********************************************************************
+*
+*       _Connect
+*/
+static void _Connect(void) {
+  memset(&_hhcd, 0, sizeof(_hhcd));
+  _hhcd.Instance           = HCD_SIM_GetInstance();
+  _hhcd.Init.Host_channels = NUM_CHANNELS;
+  _hhcd.Init.speed         = HCD_SPEED_FULL;
+  _hhcd.Init.dma_enable    = 0;
+  _hhcd.Init.phy_itface    = HCD_PHY_EMBEDDED;
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Init(&_hhcd));
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Start(&_hhcd));
+  HCD_SIM_Connect(HCD_SPEED_FULL);
+  HCD_SIM_Run(&_hhcd, 1);
+  HAL_HCD_ResetPort(&_hhcd);
+  HCD_SIM_Run(&_hhcd, 2);
+  HOST_TEST_CHECK_EQUAL(HCD_SPEED_FULL, HAL_HCD_GetCurrentSpeed(&_hhcd));
+}
+
+/*********************************************************************
+*
+*       _TestSpurious
+*/
+static void _TestSpurious(void) {
+  HCD_SIM_STAT Stat;
+
+  HOST_TEST_CHECK_EQUAL(0, _GetPending());
+  HCD_SIM_ResetStat();
+  HAL_HCD_IRQHandler(&_hhcd);
+  HCD_SIM_GetStat(&Stat);
+  HOST_TEST_CHECK_EQUAL(2, Stat.NumIntReads);       // USB_GetMode() and USB_ReadInterrupts().
+  HOST_TEST_CHECK_EQUAL(3, Stat.NumRegReads);       // GINTMSK
+  HOST_TEST_CHECK_EQUAL(0, Stat.NumRegWrites);
+}
+
+/*********************************************************************
+*
+*       _TestAllPending
+*
+*  Function description
+*    Channel 1 receives a short IN packet into the Rx FIFO, channel 2
+*    is NAKed, the port reports a connect and an incomplete periodic
+*    transfer is flagged, all in the same frame. The ACK of an IN
+*    channel is masked, channel 1 interrupts once its XFER_COMP status
+*    has been read from the Rx FIFO.
+*/
+static void _TestAllPending(void) {
+  USB_OTG_GlobalTypeDef * USBx;
+  HCD_SIM_STAT            Stat;
+  uint32_t                Pending;
+  unsigned                NumSOFs;
+  unsigned                NumConnects;
+  uint32_t                NumIncomplete;
+
+  USBx = _hhcd.Instance;
+  HCD_SIM_SetScript(DEV_ADDR, 0x81, _aIn,  COUNTOF(_aIn));
+  HCD_SIM_SetScript(DEV_ADDR, 0x02, _aNak, COUNTOF(_aNak));
+  _Submit(1, 0x81, _abBuffer, sizeof(_abBuffer));
+  _Submit(2, 0x02, _abBuffer, MAX_PACKET);
+  HCD_SIM_Run(&_hhcd, 0);                           // Tx FIFO of channel 2 filled.
+  HCD_SIM_Frame();
+  HCD_SIM_Connect(HCD_SPEED_FULL);
+  HCD_SIM_SetInt(USB_OTG_GINTSTS_PXFR_INCOMPISOOUT);
+  Pending = _GetPending();
+  HOST_TEST_CHECK_EQUAL(USB_OTG_GINTSTS_SOF | USB_OTG_GINTSTS_RXFLVL | USB_OTG_GINTSTS_HCINT | USB_OTG_GINTSTS_HPRTINT | USB_OTG_GINTSTS_PXFR_INCOMPISOOUT,
+                        Pending & (USB_OTG_GINTSTS_SOF | USB_OTG_GINTSTS_RXFLVL | USB_OTG_GINTSTS_HCINT | USB_OTG_GINTSTS_HPRTINT | USB_OTG_GINTSTS_PXFR_INCOMPISOOUT));
+  HOST_TEST_CHECK_EQUAL(1u << 2, USBx_HOST->HAINT & USBx_HOST->HAINTMSK);
+  NumSOFs       = _NumSOFs;
+  NumConnects   = _NumConnects;
+  NumIncomplete = _hhcd.FifoStats.IncompletePeriodicCount;
+  HCD_SIM_ResetStat();
+  HAL_HCD_IRQHandler(&_hhcd);
+  HCD_SIM_GetStat(&Stat);
+  printf("One IRQ, 5 sources:        %5u reads, %5u writes, %u GINTSTS reads\n",
+         (unsigned)Stat.NumRegReads, (unsigned)Stat.NumRegWrites, (unsigned)Stat.NumIntReads);
+  HOST_TEST_CHECK_EQUAL(2, Stat.NumIntReads);
+  HOST_TEST_CHECK_EQUAL(0, Stat.NumFifoErrors);
+  HOST_TEST_CHECK(Stat.NumFifoReads != 0u);                 // RXFLVL
+  HOST_TEST_CHECK_EQUAL(NumSOFs + 1u, _NumSOFs);
+  HOST_TEST_CHECK_EQUAL(NumConnects + 1u, _NumConnects);
+  HOST_TEST_CHECK_EQUAL(NumIncomplete + 1u, _hhcd.FifoStats.IncompletePeriodicCount);
+  HOST_TEST_CHECK_EQUAL(0, USBx_HC(2)->HCINT & USB_OTG_HCINT_NAK);
+  Pending = _GetPending();
+  HOST_TEST_CHECK_EQUAL(0, Pending & (USB_OTG_GINTSTS_SOF | USB_OTG_GINTSTS_HPRTINT | USB_OTG_GINTSTS_PXFR_INCOMPISOOUT));
+  //
+  // One Rx FIFO entry is taken per RXFLVL, the rest of the packet
+  // and the halt of channel 2 follow.
+  //
+  HCD_SIM_Run(&_hhcd, 2);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[1]);
+  HOST_TEST_CHECK_EQUAL(13, HAL_HCD_HC_GetXferCount(&_hhcd, 1));
+  HOST_TEST_CHECK_EQUAL(URB_NOTREADY, _aURBState[2]);
+}
+
+/*********************************************************************
+*
+*       _TestChannelOutOfRange
+*
+*  Function description
+*    Channel 6 is NAKed while the handle only owns 4 channels.
+*/
+static void _TestChannelOutOfRange(void) {
+  USB_OTG_GlobalTypeDef * USBx;
+
+  USBx = _hhcd.Instance;
+  HCD_SIM_SetScript(DEV_ADDR, 0x03, _aNak, COUNTOF(_aNak));
+  _Submit(6, 0x03, _abBuffer, MAX_PACKET);
+  HCD_SIM_Run(&_hhcd, 0);
+  _hhcd.Init.Host_channels = 4;
+  HCD_SIM_Frame();
+  HAL_HCD_IRQHandler(&_hhcd);
+  HOST_TEST_CHECK(USBx_HC(6)->HCINT & USB_OTG_HCINT_NAK);
+  HOST_TEST_CHECK(_GetPending() & USB_OTG_GINTSTS_HCINT);
+  HOST_TEST_CHECK_EQUAL(0, _aNumNotify[6]);
+  _hhcd.Init.Host_channels = NUM_CHANNELS;
+  HCD_SIM_Run(&_hhcd, 2);
+  HOST_TEST_CHECK_EQUAL(URB_NOTREADY, _aURBState[6]);
+  HOST_TEST_CHECK_EQUAL(0, _GetPending() & USB_OTG_GINTSTS_HCINT);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  HCD_SIM_Init();
+  _Connect();
+  _TestSpurious();
+  _TestAllPending();
+  _TestChannelOutOfRange();
+  return HOST_TEST_END("HCD_IRQ_Test");
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,252 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HCD_MUX_Test.c
+Purpose : Test of the host channel multiplexer of stm32f4xx_hal_hcd.c
+          on the register simulator of HCD_SIM.c.
+
+Additional information:
+  Built with USE_HAL_HCD_CHANNEL_MUX=1U, see Makefile. Six bulk IN
+  pipes share three channels, each request has to complete and the
+  waiting ones are started round robin. A pipe closed while its
+  channel still runs keeps its number and the channel until the halt
+  has been reported.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <string.h>
+#include "HCD_SIM.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define DEV_ADDR           1u
+#define MAX_PACKET         64u
+#define NUM_CHANNELS       8u
+#define MUX_CHANNELS       0x000Eu      // Channels 1..3, channel 0 stays with HAL_HCD_HC_xxx().
+#define NUM_PIPES          6u
+#define XFER_SIZE          (2u * MAX_PACKET)
+#define COUNTOF(a)         (sizeof(a) / sizeof((a)[0]))
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static HCD_HandleTypeDef   _hhcd;
+static unsigned            _NumConnects;
+static unsigned            _aNumNotify[HCD_MAX_PIPES];
+static HCD_URBStateTypeDef _aURBState[HCD_MAX_PIPES];
+static uint8_t             _aOrder[HCD_MAX_PIPES];
+static unsigned            _NumDone;
+static uint8_t             _aabBuffer[NUM_PIPES][XFER_SIZE];
+
+static const HCD_SIM_RESPONSE _aBulkIn[] = {
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+};
+
+static const HCD_SIM_RESPONSE _aSingleIn[] = {
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+};
+
+/*********************************************************************
+*
+*       Callbacks of stm32f4xx_hal_hcd.c
+*
+**********************************************************************
+*/
+void HAL_HCD_Connect_Callback(HCD_HandleTypeDef * hhcd) {
+  _NumConnects++;
+}
+
+void HAL_HCD_Pipe_NotifyURBChange_Callback(HCD_HandleTypeDef * hhcd, uint8_t pipe_num, HCD_URBStateTypeDef urb_state) {
+  _aNumNotify[pipe_num]++;
+  _aURBState[pipe_num] = urb_state;
+  if (urb_state == URB_DONE) {
+    _aOrder[_NumDone++] = pipe_num;
+  }
+}
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _Submit
+*/
+static void _Submit(uint8_t Pipe, uint8_t * pData, uint16_t NumBytes) {
+  _aNumNotify[Pipe] = 0;
+  _aURBState[Pipe]  = URB_IDLE;
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_SubmitRequest(&_hhcd, Pipe, 1u, 1u, pData, NumBytes, 0u));
+}
+
+/*********************************************************************
+*
+*       _TestConnect
+*/
+static void _TestConnect(void) {
+  memset(&_hhcd, 0, sizeof(_hhcd));
+  _hhcd.Instance           = HCD_SIM_GetInstance();
+  _hhcd.Init.Host_channels = NUM_CHANNELS;
+  _hhcd.Init.speed         = HCD_SPEED_FULL;
+  _hhcd.Init.dma_enable    = 0;
+  _hhcd.Init.phy_itface    = HCD_PHY_EMBEDDED;
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Init(&_hhcd));
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Mux_Init(&_hhcd, MUX_CHANNELS));
+  HOST_TEST_CHECK_EQUAL(HCD_MAX_PIPES - 1u, _hhcd.Mux.Last[2]);
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Start(&_hhcd));
+  HCD_SIM_Connect(HCD_SPEED_FULL);
+  HCD_SIM_Run(&_hhcd, 1);
+  HAL_HCD_ResetPort(&_hhcd);
+  HCD_SIM_Run(&_hhcd, 2);
+  HOST_TEST_CHECK_EQUAL(2, _NumConnects);
+}
+
+/*********************************************************************
+*
+*       _TestShare
+*
+*  Function description
+*    Six pipes, three channels. The first three requests are started
+*    at once and end in any order, the others are started in pipe
+*    order when a channel is released.
+*/
+static void _TestShare(void) {
+  HCD_MuxStatTypeDef Stat;
+  uint8_t            Pipe;
+  unsigned           i;
+  unsigned           j;
+  int                IsEqual;
+
+  for (i = 0; i < NUM_PIPES; i++) {
+    HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_Open(&_hhcd, &Pipe, (uint8_t)(0x81u + i), DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_BULK, MAX_PACKET));
+    HOST_TEST_CHECK_EQUAL(i, Pipe);
+    HCD_SIM_SetScript(DEV_ADDR, (uint8_t)(0x81u + i), _aBulkIn, COUNTOF(_aBulkIn));
+  }
+  memset(_aabBuffer, 0xEE, sizeof(_aabBuffer));
+  _NumDone = 0;
+  for (i = 0; i < NUM_PIPES; i++) {
+    _Submit((uint8_t)i, _aabBuffer[i], XFER_SIZE);
+  }
+  HOST_TEST_CHECK_EQUAL(0, _hhcd.Mux.FreeMask);
+  HCD_SIM_Run(&_hhcd, 50);
+  HOST_TEST_CHECK_EQUAL(NUM_PIPES, _NumDone);
+  for (i = 0; i < NUM_PIPES; i++) {
+    if (i < 3u) {
+      HOST_TEST_CHECK(_aOrder[i] < 3u);
+    } else {
+      HOST_TEST_CHECK_EQUAL(i, _aOrder[i]);
+    }
+    HOST_TEST_CHECK_EQUAL(1, _aNumNotify[i]);
+    HOST_TEST_CHECK_EQUAL(URB_DONE, HAL_HCD_Pipe_GetURBState(&_hhcd, (uint8_t)i));
+    HOST_TEST_CHECK_EQUAL(XFER_SIZE, HAL_HCD_Pipe_GetXferCount(&_hhcd, (uint8_t)i));
+    IsEqual = 1;
+    for (j = 0; j < XFER_SIZE; j++) {
+      if (_aabBuffer[i][j] != (uint8_t)(j % MAX_PACKET)) {
+        IsEqual = 0;
+      }
+    }
+    HOST_TEST_CHECK(IsEqual);
+  }
+  HOST_TEST_CHECK_EQUAL(MUX_CHANNELS, _hhcd.Mux.FreeMask);
+  HAL_HCD_GetMuxStatistics(&_hhcd, &Stat);
+  HOST_TEST_CHECK_EQUAL(NUM_PIPES, Stat.BindCount);
+  HOST_TEST_CHECK_EQUAL(NUM_PIPES - 3u, Stat.WaitCount);
+  HOST_TEST_CHECK(Stat.WaitFramesMax > 0u);
+  for (i = 0; i < NUM_PIPES; i++) {
+    HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_Close(&_hhcd, (uint8_t)i));
+  }
+}
+
+/*********************************************************************
+*
+*       _TestClose
+*
+*  Function description
+*    One channel only. Pipe 0 is closed while its channel retries the
+*    IN token the device NAKs. Until the channel has halted, neither
+*    the channel nor the pipe number may be handed out: pipe 1 keeps
+*    waiting and HAL_HCD_Pipe_Open() skips pipe 0.
+*/
+static void _TestClose(void) {
+  HCD_HandleTypeDef * pHCD;
+  uint8_t             Pipe;
+  uint8_t             Extra;
+  unsigned            NumOpen;
+  HAL_StatusTypeDef   Status;
+
+  pHCD = &_hhcd;
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Mux_Init(pHCD, 0x0002u));
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_Open(pHCD, &Pipe, 0x87u, DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_BULK, MAX_PACKET));
+  HOST_TEST_CHECK_EQUAL(0, Pipe);
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_Open(pHCD, &Pipe, 0x81u, DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_BULK, MAX_PACKET));
+  HOST_TEST_CHECK_EQUAL(1, Pipe);
+  HCD_SIM_SetScript(DEV_ADDR, 0x81u, _aSingleIn, COUNTOF(_aSingleIn));
+  _NumDone = 0;
+  _Submit(0, _aabBuffer[0], MAX_PACKET);
+  _Submit(1, _aabBuffer[1], MAX_PACKET);
+  HCD_SIM_Run(pHCD, 5);
+  HOST_TEST_CHECK_EQUAL(0, pHCD->Mux.ChPipe[1]);
+  HOST_TEST_CHECK_EQUAL(URB_IDLE, _aURBState[1]);
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_Close(pHCD, 0));
+  //
+  // Halt requested, not reported yet.
+  //
+  HOST_TEST_CHECK_EQUAL(0, pHCD->Mux.ChPipe[1]);
+  HOST_TEST_CHECK_EQUAL(0, pHCD->Mux.FreeMask);
+  NumOpen = 0;
+  do {
+    Status = HAL_HCD_Pipe_Open(pHCD, &Extra, 0x88u, DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_BULK, MAX_PACKET);
+    if (Status == HAL_OK) {
+      HOST_TEST_CHECK(Extra != 0u);
+      NumOpen++;
+    }
+  } while (Status == HAL_OK);
+  HOST_TEST_CHECK_EQUAL(HAL_BUSY, Status);
+  HOST_TEST_CHECK_EQUAL(HCD_MAX_PIPES - 2u, NumOpen);
+  for (Extra = 2; Extra < HCD_MAX_PIPES; Extra++) {
+    HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_Close(pHCD, Extra));
+  }
+  //
+  // The halt releases the channel to pipe 1, pipe 0 is not reported.
+  //
+  HCD_SIM_Run(pHCD, 5);
+  HOST_TEST_CHECK_EQUAL(0, _aNumNotify[0]);
+  HOST_TEST_CHECK_EQUAL(1, _aNumNotify[1]);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[1]);
+  HOST_TEST_CHECK_EQUAL(HCD_PIPE_NONE, pHCD->Mux.ChPipe[1]);
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Pipe_Open(pHCD, &Pipe, 0x88u, DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_BULK, MAX_PACKET));
+  HOST_TEST_CHECK_EQUAL(0, Pipe);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  HCD_SIM_Init();
+  _TestConnect();
+  _TestShare();
+  _TestClose();
+  return HOST_TEST_END("HCD_MUX_Test");
+}
+
+/*************************** End of file ****************************/
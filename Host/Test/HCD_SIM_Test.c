@@ -0,0 +1,565 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HCD_SIM_Test.c
+Purpose : Test of stm32f4xx_hal_hcd.c and stm32f4xx_ll_usb.c on the
+          register simulator of HCD_SIM.c.
+
+Additional information:
+  A full-speed device is connected and the port is reset. Then
+  transfers are run against scripted device responses: bulk IN with
+  NAKs, a short packet into an unaligned buffer, STALL, babble,
+  multi-packet bulk OUT with and without a refill of the Tx FIFO, an
+  interrupt IN endpoint polled from the SOF
+  interrupt, a bulk IN endpoint retried with NAK back-off and the
+  removal of the device. Finally the FIFO RAM is partitioned again. The register accesses of
+  the driver per transfer are printed.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <string.h>
+#include "HCD_SIM.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define DEV_ADDR           1u
+#define MAX_PACKET         64u
+#define NUM_CHANNELS       8u
+#define INT_PACKET         8u
+#define INT_INTERVAL       4u           // HAL_HCD_HC_StartPeriodic() rounds bInterval 5 down to 4.
+#define NAK_MAX_FRAMES     4u
+#define COUNTOF(a)         (sizeof(a) / sizeof((a)[0]))
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static HCD_HandleTypeDef   _hhcd;
+static unsigned            _NumConnects;
+static unsigned            _NumDisconnects;
+static unsigned            _aNumNotify[NUM_CHANNELS];
+static HCD_URBStateTypeDef _aURBState[NUM_CHANNELS];
+static uint8_t             _abBuffer[1024];
+
+static const HCD_SIM_RESPONSE _aBulkIn[] = {
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+};
+
+static const uint8_t _abShort[] = { 0xA5, 0x5A, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0xFF };
+
+static const HCD_SIM_RESPONSE _aShortIn[] = {
+  { HCD_SIM_ACK, MAX_PACKET,       NULL    },
+  { HCD_SIM_ACK, sizeof(_abShort), _abShort },
+};
+
+static const HCD_SIM_RESPONSE _aStall[]  = { { HCD_SIM_STALL,  0, NULL } };
+static const HCD_SIM_RESPONSE _aBabble[] = { { HCD_SIM_BABBLE, 0, NULL } };
+static const HCD_SIM_RESPONSE _aOverrun[] = { { HCD_SIM_ACK, MAX_PACKET + 16u, NULL } };
+
+static const HCD_SIM_RESPONSE _aBulkOut[] = {
+  { HCD_SIM_NAK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL },
+};
+
+static const HCD_SIM_RESPONSE _aBulkOutLarge[] = {
+  { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL },
+  { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL }, { HCD_SIM_ACK, 0, NULL },
+};
+
+static const HCD_SIM_RESPONSE _aInterruptIn[] = {
+  { HCD_SIM_ACK, INT_PACKET, NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, INT_PACKET, NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, INT_PACKET, NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, INT_PACKET, NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+};
+
+static const HCD_SIM_RESPONSE _aSlowIn[] = {
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_NAK, 0,          NULL },
+  { HCD_SIM_ACK, MAX_PACKET, NULL },
+};
+
+/*********************************************************************
+*
+*       Callbacks of stm32f4xx_hal_hcd.c
+*
+**********************************************************************
+*/
+void HAL_HCD_Connect_Callback(HCD_HandleTypeDef * hhcd) {
+  _NumConnects++;
+}
+
+void HAL_HCD_Disconnect_Callback(HCD_HandleTypeDef * hhcd) {
+  _NumDisconnects++;
+}
+
+void HAL_HCD_HC_NotifyURBChange_Callback(HCD_HandleTypeDef * hhcd, uint8_t chnum, HCD_URBStateTypeDef urb_state) {
+  _aNumNotify[chnum]++;
+  _aURBState[chnum] = urb_state;
+}
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _PrintStat
+*/
+static void _PrintStat(const char * sTransfer, unsigned NumPackets) {
+  HCD_SIM_STAT Stat;
+
+  HCD_SIM_GetStat(&Stat);
+  printf("%-28s %5u reads, %5u writes, %4u FIFO words, %3u accesses/packet\n",
+         sTransfer, (unsigned)Stat.NumRegReads, (unsigned)Stat.NumRegWrites,
+         (unsigned)(Stat.NumFifoReads + Stat.NumFifoWrites),
+         (unsigned)((Stat.NumRegReads + Stat.NumRegWrites) / NumPackets));
+  HOST_TEST_CHECK_EQUAL(0, Stat.NumFifoErrors);
+}
+
+/*********************************************************************
+*
+*       _Submit
+*/
+static void _Submit(uint8_t Ch, uint8_t EpAddr, uint8_t EpType, uint8_t * pData, uint16_t NumBytes) {
+  _aNumNotify[Ch] = 0;
+  _aURBState[Ch]  = URB_IDLE;
+  HAL_HCD_HC_Init(&_hhcd, Ch, EpAddr, DEV_ADDR, HCD_SPEED_FULL, EpType, MAX_PACKET);
+  HAL_HCD_HC_SubmitRequest(&_hhcd, Ch, (EpAddr & 0x80u) ? 1u : 0u, EpType, 1u, pData, NumBytes, 0u);
+}
+
+/*********************************************************************
+*
+*       _TestConnect
+*/
+static void _TestConnect(void) {
+  memset(&_hhcd, 0, sizeof(_hhcd));
+  _hhcd.Instance           = HCD_SIM_GetInstance();
+  _hhcd.Init.Host_channels = NUM_CHANNELS;
+  _hhcd.Init.speed         = HCD_SPEED_FULL;
+  _hhcd.Init.dma_enable    = 0;
+  _hhcd.Init.phy_itface    = HCD_PHY_EMBEDDED;
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Init(&_hhcd));
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Start(&_hhcd));
+  HCD_SIM_Run(&_hhcd, 1);
+  HOST_TEST_CHECK_EQUAL(0, _NumConnects);
+  HCD_SIM_Connect(HCD_SPEED_FULL);
+  HCD_SIM_Run(&_hhcd, 1);
+  HOST_TEST_CHECK_EQUAL(1, _NumConnects);
+  HAL_HCD_ResetPort(&_hhcd);
+  HCD_SIM_Run(&_hhcd, 2);
+  HOST_TEST_CHECK_EQUAL(2, _NumConnects);
+  HOST_TEST_CHECK_EQUAL(HCD_SPEED_FULL, HAL_HCD_GetCurrentSpeed(&_hhcd));
+}
+
+/*********************************************************************
+*
+*       _TestBulkIn
+*
+*  Function description
+*    512 bytes in 8 packets, the device NAKs the first IN tokens and
+*    one in between.
+*/
+static void _TestBulkIn(void) {
+  unsigned i;
+  int      IsEqual;
+
+  HCD_SIM_SetScript(DEV_ADDR, 0x81, _aBulkIn, COUNTOF(_aBulkIn));
+  memset(_abBuffer, 0xEE, sizeof(_abBuffer));
+  HCD_SIM_ResetStat();
+  _Submit(1, 0x81, EP_TYPE_BULK, _abBuffer, 512);
+  HCD_SIM_Run(&_hhcd, 100);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[1]);
+  HOST_TEST_CHECK_EQUAL(1, _aNumNotify[1]);
+  HOST_TEST_CHECK_EQUAL(512, HAL_HCD_HC_GetXferCount(&_hhcd, 1));
+  IsEqual = 1;
+  for (i = 0; i < 512u; i++) {
+    if (_abBuffer[i] != (uint8_t)(i % MAX_PACKET)) {
+      IsEqual = 0;
+    }
+  }
+  HOST_TEST_CHECK(IsEqual);
+  HOST_TEST_CHECK_EQUAL(0xEE, _abBuffer[512]);
+  _PrintStat("Bulk IN 512 bytes, 4 NAKs:", 8);
+}
+
+/*********************************************************************
+*
+*       _TestShortIn
+*
+*  Function description
+*    A short packet ends the transfer early, into a buffer at an odd
+*    address.
+*/
+static void _TestShortIn(void) {
+  unsigned i;
+  int      IsEqual;
+
+  HCD_SIM_SetScript(DEV_ADDR, 0x81, _aShortIn, COUNTOF(_aShortIn));
+  memset(_abBuffer, 0xEE, sizeof(_abBuffer));
+  HCD_SIM_ResetStat();
+  _Submit(1, 0x81, EP_TYPE_BULK, &_abBuffer[1], 256);
+  HCD_SIM_Run(&_hhcd, 20);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[1]);
+  HOST_TEST_CHECK_EQUAL(MAX_PACKET + sizeof(_abShort), HAL_HCD_HC_GetXferCount(&_hhcd, 1));
+  IsEqual = 1;
+  for (i = 0; i < MAX_PACKET; i++) {
+    if (_abBuffer[1 + i] != (uint8_t)i) {
+      IsEqual = 0;
+    }
+  }
+  HOST_TEST_CHECK(IsEqual);
+  HOST_TEST_CHECK(memcmp(&_abBuffer[1 + MAX_PACKET], _abShort, sizeof(_abShort)) == 0);
+  HOST_TEST_CHECK_EQUAL(0xEE, _abBuffer[0]);
+  HOST_TEST_CHECK_EQUAL(0xEE, _abBuffer[1 + MAX_PACKET + sizeof(_abShort)]);
+  _PrintStat("Bulk IN 77 bytes, unaligned:", 2);
+}
+
+/*********************************************************************
+*
+*       _TestErrors
+*/
+static void _TestErrors(void) {
+  HCD_SIM_SetScript(DEV_ADDR, 0x82, _aStall, COUNTOF(_aStall));
+  _Submit(2, 0x82, EP_TYPE_BULK, _abBuffer, 64);
+  HCD_SIM_Run(&_hhcd, 10);
+  HOST_TEST_CHECK_EQUAL(URB_STALL, _aURBState[2]);
+  HOST_TEST_CHECK_EQUAL(1, _aNumNotify[2]);
+  HCD_SIM_SetScript(DEV_ADDR, 0x83, _aBabble, COUNTOF(_aBabble));
+  _Submit(3, 0x83, EP_TYPE_BULK, _abBuffer, 64);
+  HCD_SIM_Run(&_hhcd, 10);
+  HOST_TEST_CHECK_EQUAL(URB_ERROR, _aURBState[3]);
+  HOST_TEST_CHECK_EQUAL(1, _aNumNotify[3]);
+}
+
+/*********************************************************************
+*
+*       _TestRxOverrun
+*
+*  Function description
+*    The device returns more bytes than submitted, which is rounded up
+*    to full packets by USB_HC_StartXfer(). The packet is
+*    dropped, the buffer is left untouched and the transfer ends with
+*    URB_ERROR instead of waiting for data that never comes.
+*/
+static void _TestRxOverrun(void) {
+  uint32_t NumOverruns;
+
+  NumOverruns = _hhcd.FifoStats.RxOverrunCount;
+  HCD_SIM_SetScript(DEV_ADDR, 0x85, _aOverrun, COUNTOF(_aOverrun));
+  memset(_abBuffer, 0xEE, sizeof(_abBuffer));
+  HCD_SIM_ResetStat();
+  _Submit(5, 0x85, EP_TYPE_BULK, _abBuffer, MAX_PACKET);
+  HCD_SIM_Run(&_hhcd, 10);
+  HOST_TEST_CHECK_EQUAL(URB_ERROR, _aURBState[5]);
+  HOST_TEST_CHECK_EQUAL(1, _aNumNotify[5]);
+  HOST_TEST_CHECK_EQUAL(NumOverruns + 1u, _hhcd.FifoStats.RxOverrunCount);
+  HOST_TEST_CHECK_EQUAL(0, HAL_HCD_HC_GetXferCount(&_hhcd, 5));
+  HOST_TEST_CHECK_EQUAL(0xEE, _abBuffer[0]);
+  _PrintStat("Bulk IN 80 bytes into 64:", 1);
+}
+
+/*********************************************************************
+*
+*       _TestBulkOut
+*
+*  Function description
+*    300 bytes in 5 packets, written to the Tx FIFO at the start. The
+*    first attempt is NAKed and submitted again, as emUSB-Host does on
+*    URB_NOTREADY.
+*/
+static void _TestBulkOut(void) {
+  uint8_t  abOut[300];
+  uint8_t  abRecv[sizeof(abOut)];
+  unsigned i;
+
+  for (i = 0; i < sizeof(abOut); i++) {
+    abOut[i] = (uint8_t)(i * 7u);
+  }
+  HCD_SIM_SetScript(DEV_ADDR, 0x02, _aBulkOut, COUNTOF(_aBulkOut));
+  _Submit(4, 0x02, EP_TYPE_BULK, abOut, sizeof(abOut));
+  HCD_SIM_Run(&_hhcd, 10);
+  HOST_TEST_CHECK_EQUAL(URB_NOTREADY, _aURBState[4]);
+  HCD_SIM_ResetStat();
+  _Submit(4, 0x02, EP_TYPE_BULK, abOut, sizeof(abOut));
+  HCD_SIM_Run(&_hhcd, 20);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[4]);
+  HOST_TEST_CHECK_EQUAL(sizeof(abOut), HCD_SIM_GetOutData(DEV_ADDR, 0x02, abRecv, sizeof(abRecv)));
+  HOST_TEST_CHECK(memcmp(abOut, abRecv, sizeof(abOut)) == 0);
+  _PrintStat("Bulk OUT 300 bytes:", 5);
+}
+
+/*********************************************************************
+*
+*       _TestBulkOutRefill
+*
+*  Function description
+*    1024 bytes in 16 packets, twice the 128 words of the non-periodic
+*    Tx FIFO of the balanced profile. The first 8 packets are written at
+*    the start, the others from the NPTXFE interrupt. NPTXFEM has to be
+*    unmasked exactly while packets are left to write.
+*/
+static void _TestBulkOutRefill(void) {
+  HCD_SIM_STAT    Stat;
+  HCD_HCTypeDef * pHC;
+  uint8_t         abRecv[1024];
+  uint32_t        FifoCount;
+  unsigned        NumRefills;
+  unsigned        i;
+  int             IsUnmasked;
+
+  pHC = &_hhcd.hc[4];
+  for (i = 0; i < sizeof(_abBuffer); i++) {
+    _abBuffer[i] = (uint8_t)(i * 3u);
+  }
+  HCD_SIM_SetScript(DEV_ADDR, 0x03, _aBulkOutLarge, COUNTOF(_aBulkOutLarge));
+  HCD_SIM_ResetStat();
+  _Submit(4, 0x03, EP_TYPE_BULK, _abBuffer, sizeof(abRecv));
+  FifoCount = pHC->fifo_count;
+  HOST_TEST_CHECK_EQUAL((_hhcd.Instance->DIEPTXF0_HNPTXFSIZ >> 16) * 4u, FifoCount);
+  HOST_TEST_CHECK(_hhcd.Instance->GINTMSK & USB_OTG_GINTMSK_NPTXFEM);
+  NumRefills = 0;
+  for (i = 0; (i < 40u) && (_aNumNotify[4] == 0u); i++) {
+    HCD_SIM_Run(&_hhcd, 1);
+    if (pHC->fifo_count != FifoCount) {
+      FifoCount = pHC->fifo_count;
+      NumRefills++;
+    }
+    IsUnmasked = (_hhcd.Instance->GINTMSK & USB_OTG_GINTMSK_NPTXFEM) ? 1 : 0;
+    HOST_TEST_CHECK_EQUAL(pHC->fifo_count < pHC->xfer_len, IsUnmasked);
+  }
+  HOST_TEST_CHECK(NumRefills > 0u);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[4]);
+  HOST_TEST_CHECK_EQUAL(sizeof(abRecv), HCD_SIM_GetOutData(DEV_ADDR, 0x03, abRecv, sizeof(abRecv)));
+  HOST_TEST_CHECK(memcmp(_abBuffer, abRecv, sizeof(abRecv)) == 0);
+  HCD_SIM_GetStat(&Stat);
+  HOST_TEST_CHECK_EQUAL(sizeof(abRecv) / 4u, Stat.NumFifoWrites);
+  HOST_TEST_CHECK_EQUAL(0, Stat.NumFifoErrors);
+}
+
+/*********************************************************************
+*
+*       _TestPeriodic
+*
+*  Function description
+*    Interrupt IN with bInterval 5, armed from the SOF interrupt. Over
+*    32 frames the endpoint is polled once per 4 frames, with no
+*    resubmit by the test. A NAK ends a poll without a notification.
+*    HAL_HCD_HC_StopPeriodic() halts the armed channel without a
+*    notification and the endpoint is not polled anymore.
+*/
+static void _TestPeriodic(void) {
+  HCD_SIM_STAT Stat;
+  uint32_t     NumPolls;
+  unsigned     LastPoll;
+  unsigned     i;
+
+  HCD_SIM_SetScript(DEV_ADDR, 0x86, _aInterruptIn, COUNTOF(_aInterruptIn));
+  memset(_abBuffer, 0xEE, sizeof(_abBuffer));
+  _aNumNotify[6] = 0;
+  _aURBState[6]  = URB_IDLE;
+  HAL_HCD_HC_Init(&_hhcd, 6, 0x86, DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_INTR, INT_PACKET);
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_HC_StartPeriodic(&_hhcd, 6, 5, _abBuffer, INT_PACKET));
+  HOST_TEST_CHECK_EQUAL(HAL_ERROR, HAL_HCD_HC_StartPeriodic(&_hhcd, 6, 5, _abBuffer, INT_PACKET));
+  HCD_SIM_ResetStat();
+  NumPolls = 0;
+  LastPoll = 0;
+  for (i = 1; i <= 8u * INT_INTERVAL; i++) {
+    HCD_SIM_Run(&_hhcd, 1);
+    HCD_SIM_GetStat(&Stat);
+    if (Stat.NumTransactions != NumPolls) {
+      HOST_TEST_CHECK_EQUAL(NumPolls + 1u, Stat.NumTransactions);
+      if (NumPolls != 0u) {
+        HOST_TEST_CHECK_EQUAL(INT_INTERVAL, i - LastPoll);
+      }
+      NumPolls = Stat.NumTransactions;
+      LastPoll = i;
+    }
+  }
+  HOST_TEST_CHECK_EQUAL(8, NumPolls);
+  HOST_TEST_CHECK_EQUAL(4, _aNumNotify[6]);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[6]);
+  HOST_TEST_CHECK_EQUAL(INT_PACKET - 1u, _abBuffer[INT_PACKET - 1u]);
+  HOST_TEST_CHECK_EQUAL(0xEE, _abBuffer[INT_PACKET]);
+  _PrintStat("Interrupt IN, 8 polls:", 8);
+  for (i = 0; (i < INT_INTERVAL) && (_hhcd.Periodic.ActiveMask == 0u); i++) {
+    HCD_SIM_Run(&_hhcd, 1);
+  }
+  HOST_TEST_CHECK_EQUAL(1u << 6, _hhcd.Periodic.ActiveMask);         // Armed for the next frame.
+  HCD_SIM_GetStat(&Stat);
+  NumPolls = Stat.NumTransactions;
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_HC_StopPeriodic(&_hhcd, 6));
+  HCD_SIM_Run(&_hhcd, 2u * INT_INTERVAL);
+  HCD_SIM_GetStat(&Stat);
+  HOST_TEST_CHECK_EQUAL(NumPolls, Stat.NumTransactions);
+  HOST_TEST_CHECK_EQUAL(4, _aNumNotify[6]);
+  HOST_TEST_CHECK_EQUAL(0, _hhcd.Periodic.ActiveMask);
+}
+
+/*********************************************************************
+*
+*       _TestNakBackoff
+*
+*  Function description
+*    Bulk IN with HCD_NAK_RETRY_BACKOFF. The device NAKs 6 times, then
+*    delivers. After each NAK the channel stays disabled until the SOF
+*    interrupt re-enables it, the wait doubles up to NAK_MAX_FRAMES.
+*    The simulator handles the NAK and the SOF of its frame together,
+*    so a wait of n SOFs puts n frames between two IN tokens.
+*/
+static void _TestNakBackoff(void) {
+  static const unsigned _aGap[] = { 1, 2, 4, NAK_MAX_FRAMES, NAK_MAX_FRAMES, NAK_MAX_FRAMES };
+  HCD_SIM_STAT Stat;
+  uint32_t     NumTokens;
+  unsigned     LastToken;
+  unsigned     i;
+
+  HCD_SIM_SetScript(DEV_ADDR, 0x87, _aSlowIn, COUNTOF(_aSlowIn));
+  _aNumNotify[7] = 0;
+  _aURBState[7]  = URB_IDLE;
+  HAL_HCD_HC_Init(&_hhcd, 7, 0x87, DEV_ADDR, HCD_SPEED_FULL, EP_TYPE_BULK, MAX_PACKET);
+  HOST_TEST_CHECK_EQUAL(HAL_ERROR, HAL_HCD_HC_SetNakPolicy(&_hhcd, 7, HCD_NAK_RETRY_BACKOFF, 0));
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_HC_SetNakPolicy(&_hhcd, 7, HCD_NAK_RETRY_BACKOFF, NAK_MAX_FRAMES));
+  HCD_SIM_ResetStat();
+  HAL_HCD_HC_SubmitRequest(&_hhcd, 7, 1u, EP_TYPE_BULK, 1u, _abBuffer, MAX_PACKET, 0u);
+  NumTokens = 0;
+  LastToken = 0;
+  for (i = 1; (i <= 50u) && (_aNumNotify[7] == 0u); i++) {
+    HCD_SIM_Run(&_hhcd, 1);
+    HCD_SIM_GetStat(&Stat);
+    if (Stat.NumTransactions != NumTokens) {
+      HOST_TEST_CHECK_EQUAL(NumTokens + 1u, Stat.NumTransactions);
+      if ((NumTokens != 0u) && (NumTokens <= COUNTOF(_aGap))) {
+        HOST_TEST_CHECK_EQUAL(_aGap[NumTokens - 1u], i - LastToken);
+      }
+      NumTokens = Stat.NumTransactions;
+      LastToken = i;
+    }
+  }
+  HOST_TEST_CHECK_EQUAL(COUNTOF(_aSlowIn), NumTokens);
+  HOST_TEST_CHECK_EQUAL(URB_DONE, _aURBState[7]);
+  HOST_TEST_CHECK_EQUAL(1, _aNumNotify[7]);
+  HOST_TEST_CHECK_EQUAL(MAX_PACKET, HAL_HCD_HC_GetXferCount(&_hhcd, 7));
+  HOST_TEST_CHECK_EQUAL(6, HAL_HCD_HC_GetNakCount(&_hhcd, 7));
+  HOST_TEST_CHECK_EQUAL(1, _hhcd.nak[7].Delay);                      // Reset by the completed transfer.
+  HOST_TEST_CHECK_EQUAL(0, _hhcd.NakWaitMask);
+  _PrintStat("Bulk IN 64 bytes, 6 NAKs:", 1);
+}
+
+/*********************************************************************
+*
+*       _TestDisconnect
+*/
+static void _TestDisconnect(void) {
+  HCD_SIM_Disconnect();
+  HCD_SIM_Run(&_hhcd, 2);
+  HOST_TEST_CHECK_EQUAL(1, _NumDisconnects);
+}
+
+/*********************************************************************
+*
+*       _TestFifoConfig
+*
+*  Function description
+*    A partition larger than the 320 words of the OTG_FS FIFO RAM is
+*    rejected and leaves the registers and the statistics alone. The
+*    bulk profile is applied and resets the statistics, which still
+*    hold the overrun of _TestRxOverrun().
+*/
+static void _TestFifoConfig(void) {
+  static const HCD_FifoCfgTypeDef _CfgTooLarge = { 0x90, 0xA0, 0x40 };
+  static const HCD_FifoCfgTypeDef _CfgBulk     = { 0x90, 0xA0, 0x10 };
+  USB_OTG_GlobalTypeDef * pUSB;
+  HCD_FifoCfgTypeDef      Cfg;
+  HCD_FifoStatTypeDef     Stat;
+
+  pUSB = _hhcd.Instance;
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_Stop(&_hhcd));
+  HAL_HCD_GetFifoStatistics(&_hhcd, &Stat);
+  HOST_TEST_CHECK_EQUAL(1, Stat.RxOverrunCount);
+  //
+  // Balanced profile programmed by HAL_HCD_Init().
+  //
+  HOST_TEST_CHECK_EQUAL(0x80u, pUSB->GRXFSIZ);
+  HOST_TEST_CHECK_EQUAL((0x80u << 16) | 0x80u, pUSB->DIEPTXF0_HNPTXFSIZ);
+  HOST_TEST_CHECK_EQUAL((0x40u << 16) | 0x100u, pUSB->HPTXFSIZ);
+  HOST_TEST_CHECK_EQUAL(HAL_ERROR, HAL_HCD_SetFifoConfig(&_hhcd, &_CfgTooLarge));
+  HOST_TEST_CHECK_EQUAL(0x80u, pUSB->GRXFSIZ);
+  HOST_TEST_CHECK_EQUAL((0x80u << 16) | 0x80u, pUSB->DIEPTXF0_HNPTXFSIZ);
+  HOST_TEST_CHECK_EQUAL((0x40u << 16) | 0x100u, pUSB->HPTXFSIZ);
+  HAL_HCD_GetFifoStatistics(&_hhcd, &Stat);
+  HOST_TEST_CHECK_EQUAL(1, Stat.RxOverrunCount);
+  HOST_TEST_CHECK_EQUAL(HAL_OK, HAL_HCD_SetFifoConfig(&_hhcd, &_CfgBulk));
+  HOST_TEST_CHECK_EQUAL(0x90u, pUSB->GRXFSIZ);
+  HOST_TEST_CHECK_EQUAL((0xA0u << 16) | 0x90u, pUSB->DIEPTXF0_HNPTXFSIZ);
+  HOST_TEST_CHECK_EQUAL((0x10u << 16) | 0x130u, pUSB->HPTXFSIZ);
+  HAL_HCD_GetFifoConfig(&_hhcd, &Cfg);
+  HOST_TEST_CHECK(memcmp(&Cfg, &_CfgBulk, sizeof(Cfg)) == 0);
+  HAL_HCD_GetFifoStatistics(&_hhcd, &Stat);
+  HOST_TEST_CHECK_EQUAL(0, Stat.RxOverrunCount);
+  HOST_TEST_CHECK_EQUAL(0, Stat.FrameOverrunCount);
+  HOST_TEST_CHECK_EQUAL(0, Stat.IncompletePeriodicCount);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  HCD_SIM_Init();
+  _TestConnect();
+  _TestBulkIn();
+  _TestShortIn();
+  _TestErrors();
+  _TestRxOverrun();
+  _TestBulkOut();
+  _TestBulkOutRefill();
+  _TestPeriodic();
+  _TestNakBackoff();
+  _TestDisconnect();
+  _TestFifoConfig();
+  return HOST_TEST_END("HCD_SIM_Test");
+}
+
+/*************************** End of file ****************************/
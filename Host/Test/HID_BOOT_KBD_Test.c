@@ -0,0 +1,77 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_BOOT_KBD_Test.c
+Purpose : Test of the boot protocol report comparison of HID_BOOT_KBD.c.
+
+Additional information:
+  Checks presses and releases, a key moving to another slot, a report
+  which only reorders the keys, the reserved byte and the roll-over
+  error report.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <string.h>
+#include "SEGGER.h"
+#include "HID_BOOT_KBD.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  static const U8 _abEmpty[]     = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  static const U8 _abAB[]        = { 0x00, 0x00, 0x04, 0x05, 0x00, 0x00, 0x00, 0x00 };
+  static const U8 _abBA[]        = { 0x00, 0x00, 0x05, 0x04, 0x00, 0x00, 0x00, 0x00 };
+  static const U8 _abB[]         = { 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  static const U8 _abShiftB[]    = { 0x02, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  static const U8 _abReserved[]  = { 0x02, 0x5A, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  static const U8 _abRollOver[]  = { 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01 };
+  HID_BOOT_KBD_DELTA Delta;
+
+  HOST_TEST_CHECK_EQUAL(0, HID_BOOT_KBD_Diff(_abEmpty, _abEmpty, &Delta));
+  //
+  // Two keys pressed at once.
+  //
+  memset(&Delta, 0xEE, sizeof(Delta));
+  HOST_TEST_CHECK_EQUAL(1, HID_BOOT_KBD_Diff(_abEmpty, _abAB, &Delta));
+  HOST_TEST_CHECK_EQUAL(0, Delta.ModifiersChanged);
+  HOST_TEST_CHECK_EQUAL(2, Delta.NumPressed);
+  HOST_TEST_CHECK_EQUAL(0, Delta.NumReleased);
+  HOST_TEST_CHECK_EQUAL(0x04, Delta.aPressed[0]);
+  HOST_TEST_CHECK_EQUAL(0x05, Delta.aPressed[1]);
+  //
+  // Only the order changed.
+  //
+  HOST_TEST_CHECK_EQUAL(0, HID_BOOT_KBD_Diff(_abAB, _abBA, &Delta));
+  //
+  // 'a' released, 'b' moves to slot 0 and is not reported.
+  //
+  HOST_TEST_CHECK_EQUAL(1, HID_BOOT_KBD_Diff(_abAB, _abB, &Delta));
+  HOST_TEST_CHECK_EQUAL(0, Delta.NumPressed);
+  HOST_TEST_CHECK_EQUAL(1, Delta.NumReleased);
+  HOST_TEST_CHECK_EQUAL(0x04, Delta.aReleased[0]);
+  //
+  // Modifier only.
+  //
+  HOST_TEST_CHECK_EQUAL(1, HID_BOOT_KBD_Diff(_abB, _abShiftB, &Delta));
+  HOST_TEST_CHECK_EQUAL(0x02, Delta.Modifiers);
+  HOST_TEST_CHECK_EQUAL(0x02, Delta.ModifiersChanged);
+  HOST_TEST_CHECK_EQUAL(0, Delta.NumPressed);
+  HOST_TEST_CHECK_EQUAL(0, Delta.NumReleased);
+  //
+  // The reserved byte is ignored, the roll-over report is rejected.
+  //
+  HOST_TEST_CHECK_EQUAL(0, HID_BOOT_KBD_Diff(_abShiftB, _abReserved, &Delta));
+  HOST_TEST_CHECK_EQUAL(-1, HID_BOOT_KBD_Diff(_abAB, _abRollOver, &Delta));
+  return HOST_TEST_END("HID_BOOT_KBD_Test");
+}
+
+/*************************** End of file ****************************/
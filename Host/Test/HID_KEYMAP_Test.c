@@ -0,0 +1,238 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_KEYMAP_Test.c
+Purpose : Cross-check of the keyboard layout tables of HID_KEYMAP.c.
+
+Additional information:
+  For every layout:
+    - Each printable ASCII character is produced by a key or a dead key.
+    - No entry exceeds a character or'ed with HID_KEYMAP_FLAG_DEAD,
+      Shift + AltGr is not used.
+    - Shift gives the upper case letter of the letter keys.
+    - Enter gives '\n', Caps Lock and codes beyond the table give
+      nothing.
+  Text is typed through a reverse lookup of the tables, including the
+  dead keys. Keys at the same position are compared across the
+  layouts (QWERTY, QWERTZ, AZERTY), and the per interface selection
+  of a layout is checked.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <string.h>
+#include "SEGGER.h"
+#include "HID_KEYMAP.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define MOD_LEFT_SHIFT     0x02u
+#define MOD_RIGHT_ALT      0x40u     // AltGr
+#define DEAD               '\x01'    // In _Type(), the next character is typed with its dead key.
+
+/*********************************************************************
+*
+*       Static const data
+*
+**********************************************************************
+*/
+static const HID_KEYMAP_LAYOUT * const _apLayout[] = { &HID_KEYMAP_US, &HID_KEYMAP_DE, &HID_KEYMAP_FR };
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _FindKey
+*
+*  Function description
+*    Finds the key and level of a table entry.
+*
+*  Return value
+*    1: Found.
+*    0: The layout has no such entry.
+*/
+static int _FindKey(const HID_KEYMAP_LAYOUT * pLayout, unsigned Entry, unsigned * pCode, unsigned * pLevel) {
+  unsigned i;
+
+  for (i = 0; i < HID_KEYMAP_NUM_CODES * HID_KEYMAP_NUM_LEVELS; i++) {
+    if (pLayout->paEntry[i] == Entry) {
+      *pCode  = i / HID_KEYMAP_NUM_LEVELS;
+      *pLevel = i % HID_KEYMAP_NUM_LEVELS;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*********************************************************************
+*
+*       _Type
+*
+*  Function description
+*    Types the characters of sKeys and compares the translation with sExpected.
+*/
+static void _Type(const HID_KEYMAP_LAYOUT * pLayout, const char * sKeys, const char * sExpected) {
+  HID_KEYMAP_STATE State;
+  char             acText[64];
+  unsigned         NumChars;
+  unsigned         Entry;
+  unsigned         Code;
+  unsigned         Level;
+  unsigned         Modifiers;
+
+  memset(&State, 0, sizeof(State));
+  NumChars = 0;
+  while (*sKeys != '\0') {
+    Entry = (U8)*sKeys++;
+    if (Entry == (U8)DEAD) {
+      Entry = HID_KEYMAP_FLAG_DEAD | (U8)*sKeys++;
+    }
+    if (_FindKey(pLayout, Entry, &Code, &Level) == 0) {
+      printf("%s: no key for 0x%03X\n", pLayout->sName, Entry);
+      HOST_TEST_CHECK(0);
+      return;
+    }
+    Modifiers  = (Level & 1u) ? MOD_LEFT_SHIFT : 0u;
+    Modifiers |= (Level & 2u) ? MOD_RIGHT_ALT  : 0u;
+    NumChars  += HID_KEYMAP_Translate(pLayout, &State, Code, Modifiers, &acText[NumChars]);
+  }
+  acText[NumChars] = '\0';
+  if (strcmp(acText, sExpected) != 0) {
+    printf("%s: typed \"%s\", expected \"%s\"\n", pLayout->sName, acText, sExpected);
+    HOST_TEST_CHECK(0);
+  }
+}
+
+/*********************************************************************
+*
+*       _CheckTable
+*/
+static void _CheckTable(const HID_KEYMAP_LAYOUT * pLayout) {
+  HID_KEYMAP_STATE State;
+  char             ac[HID_KEYMAP_MAX_CHARS];
+  unsigned         Code;
+  unsigned         Level;
+  unsigned         Normal;
+  unsigned         Shift;
+  unsigned         c;
+  unsigned         i;
+
+  for (c = 0x20; c < 0x7F; c++) {
+    if ((_FindKey(pLayout, c, &Code, &Level) == 0) && (_FindKey(pLayout, HID_KEYMAP_FLAG_DEAD | c, &Code, &Level) == 0)) {
+      printf("%s: '%c' cannot be typed\n", pLayout->sName, c);
+      HOST_TEST_CHECK(0);
+    }
+  }
+  for (i = 0; i < HID_KEYMAP_NUM_CODES * HID_KEYMAP_NUM_LEVELS; i++) {
+    if ((pLayout->paEntry[i] > (HID_KEYMAP_FLAG_DEAD | 0xFFu)) || ((i % HID_KEYMAP_NUM_LEVELS == 3u) && (pLayout->paEntry[i] != 0u))) {
+      printf("%s: invalid entry %u\n", pLayout->sName, i);
+      HOST_TEST_CHECK(0);
+    }
+  }
+  for (Code = 0x04; Code <= 0x1D; Code++) {                             // Keys A to Z.
+    Normal = pLayout->paEntry[Code * HID_KEYMAP_NUM_LEVELS];
+    Shift  = pLayout->paEntry[Code * HID_KEYMAP_NUM_LEVELS + 1u];
+    if ((Normal >= 'a') && (Normal <= 'z')) {
+      HOST_TEST_CHECK_EQUAL(Normal - 0x20u, Shift);
+    }
+  }
+  memset(&State, 0, sizeof(State));
+  HOST_TEST_CHECK_EQUAL(1, HID_KEYMAP_Translate(pLayout, &State, 0x28, 0, ac));   // Enter
+  HOST_TEST_CHECK_EQUAL('\n', ac[0]);
+  HOST_TEST_CHECK_EQUAL(0, HID_KEYMAP_Translate(pLayout, &State, 0x39, 0, ac));   // Caps Lock
+  HOST_TEST_CHECK_EQUAL(0, HID_KEYMAP_Translate(pLayout, &State, HID_KEYMAP_NUM_CODES, 0, ac));
+  HOST_TEST_CHECK_EQUAL(0, HID_KEYMAP_Translate(pLayout, &State, 0xFF, 0, ac));
+}
+
+/*********************************************************************
+*
+*       _CheckPositions
+*
+*  Function description
+*    Compares keys at the same position across the layouts.
+*/
+static void _CheckPositions(void) {
+  static const struct {
+    U8           Code;
+    const char * sChar;               // Character of US, DE, FR.
+  } _aKey[] = {
+    { 0x04, "aaq"      },
+    { 0x10, "mm,"      },
+    { 0x14, "qqa"      },
+    { 0x1C, "yzy"      },
+    { 0x1D, "zyw"      },
+    { 0x33, ";\xF6m"   },
+  };
+  HID_KEYMAP_STATE State;
+  char             ac[HID_KEYMAP_MAX_CHARS];
+  unsigned         i;
+  unsigned         j;
+
+  for (i = 0; i < SEGGER_COUNTOF(_aKey); i++) {
+    for (j = 0; j < SEGGER_COUNTOF(_apLayout); j++) {
+      memset(&State, 0, sizeof(State));
+      HOST_TEST_CHECK_EQUAL(1, HID_KEYMAP_Translate(_apLayout[j], &State, _aKey[i].Code, 0, ac));
+      HOST_TEST_CHECK_EQUAL(_aKey[i].sChar[j], ac[0]);
+    }
+  }
+}
+
+/*********************************************************************
+*
+*       _CheckSelection
+*/
+static void _CheckSelection(void) {
+  unsigned i;
+
+  HOST_TEST_CHECK(HID_KEYMAP_GetLayout(5) == &HID_KEYMAP_US);
+  HOST_TEST_CHECK_EQUAL(0, HID_KEYMAP_SetLayout(5, &HID_KEYMAP_DE));
+  HOST_TEST_CHECK_EQUAL(0, HID_KEYMAP_SetLayout(6, &HID_KEYMAP_FR));
+  HOST_TEST_CHECK(HID_KEYMAP_GetLayout(5) == &HID_KEYMAP_DE);
+  HOST_TEST_CHECK(HID_KEYMAP_GetLayout(6) == &HID_KEYMAP_FR);
+  HOST_TEST_CHECK(HID_KEYMAP_GetLayout(7) == &HID_KEYMAP_US);
+  HOST_TEST_CHECK_EQUAL(0, HID_KEYMAP_SetLayout(5, NULL));
+  HOST_TEST_CHECK(HID_KEYMAP_GetLayout(5) == &HID_KEYMAP_US);
+  for (i = 0; i < HID_KEYMAP_MAX_INTERFACES - 1u; i++) {                // Interface 6 holds one entry.
+    HOST_TEST_CHECK_EQUAL(0, HID_KEYMAP_SetLayout(100 + i, &HID_KEYMAP_FR));
+  }
+  HOST_TEST_CHECK_EQUAL(-1, HID_KEYMAP_SetLayout(200, &HID_KEYMAP_FR));
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  unsigned i;
+
+  for (i = 0; i < SEGGER_COUNTOF(_apLayout); i++) {
+    _CheckTable(_apLayout[i]);
+  }
+  _Type(&HID_KEYMAP_US, "Hello, World! 123", "Hello, World! 123");
+  _Type(&HID_KEYMAP_DE, "M\xFCnchen", "M\xFCnchen");
+  _Type(&HID_KEYMAP_DE, "a@b\x80", "a@b\x80");
+  _Type(&HID_KEYMAP_DE, "\x01^e" "\x01^ " "\x01\xB4" "a" "\x01`E" "\x01^x", "\xEA^\xE1\xC8^x");
+  _Type(&HID_KEYMAP_FR, "azerty\xE9\xE7\xE0", "azerty\xE9\xE7\xE0");
+  _Type(&HID_KEYMAP_FR, "\x01^e" "\x01\xA8i" "\x01~n" "\x01`a", "\xEA\xEF\xF1\xE0");
+  _Type(&HID_KEYMAP_FR, "\x01^\x01^a", "^\xE2");
+  _CheckPositions();
+  _CheckSelection();
+  return HOST_TEST_END("HID_KEYMAP_Test");
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,119 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : MOUSE_Test.c
+Purpose : Test of the mouse movement merging of USBH_HID_Start.c.
+
+Additional information:
+  Two mice report at 1 kHz while MainTask takes the queued events
+  only every 50 ms. The movement received by MainTask has to add up
+  to the movement reported, with fewer events than reports.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#define MainTask  MainTask_Sample
+#include "../../Application/USBH_HID_Start.c"
+#undef  MainTask
+
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#define NUM_REPORTS        10000    // Per mouse.
+#define DRAIN_INTERVAL     50       // [ms]
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static long     _xSent;
+static long     _ySent;
+static long     _WheelSent;
+static long     _xRecv;
+static long     _yRecv;
+static long     _WheelRecv;
+static unsigned _NumEvents;
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _Drain
+*/
+static void _Drain(void) {
+  HID_EVENT HidEvent;
+
+  while (_GetEvent(&HidEvent)) {
+    HOST_TEST_CHECK_EQUAL(MOUSE_EVENT, HidEvent.Event);
+    _xRecv     += HidEvent.Data.Mouse.xChange;
+    _yRecv     += HidEvent.Data.Mouse.yChange;
+    _WheelRecv += HidEvent.Data.Mouse.WheelChange;
+    _NumEvents++;
+  }
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  USBH_HID_MOUSE_DATA MouseData;
+  HID_QUEUE_STAT      Stat;
+  unsigned            i;
+  unsigned            Mouse;
+  int                 Step;
+
+  OS_InitKern();
+  HID_QUEUE_Create(&_HIDQueue, _aHIDEvents, sizeof(HID_EVENT), MAX_DATA_ITEMS, TASK_EVENT_HID);
+  for (i = 0; i < NUM_REPORTS; i++) {
+    for (Mouse = 0; Mouse < 2u; Mouse++) {
+      memset(&MouseData, 0, sizeof(MouseData));
+      Step = (i & 1u) ? -1 : 1;
+      MouseData.xChange     = Step + 1 + (int)Mouse;
+      MouseData.yChange     = Step;
+      MouseData.WheelChange = ((i & 63u) == 0u);
+      MouseData.ButtonState = (i >> 6) & 1u;
+      MouseData.InterfaceID = 7 + Mouse;
+      _xSent     += MouseData.xChange;
+      _ySent     += MouseData.yChange;
+      _WheelSent += MouseData.WheelChange;
+      _OnMouseChange(&MouseData);
+    }
+    OS_HOST_AdvanceTime(1);
+    if ((i % DRAIN_INTERVAL) == 0u) {
+      _Drain();
+    }
+  }
+  OS_HOST_AdvanceTime(MOUSE_FLUSH_INTERVAL);
+  _Drain();
+  HID_QUEUE_GetStat(&_HIDQueue, &Stat);
+  HOST_TEST_CHECK_EQUAL(_xSent, _xRecv);
+  HOST_TEST_CHECK_EQUAL(_ySent, _yRecv);
+  HOST_TEST_CHECK_EQUAL(_WheelSent, _WheelRecv);
+  //
+  // One event per interval and mouse, plus one per button change.
+  //
+  HOST_TEST_CHECK(_NumEvents <= 2u * (NUM_REPORTS / MOUSE_FLUSH_INTERVAL + NUM_REPORTS / 64u + 1u));
+  HOST_TEST_CHECK(_IsMousePending() == 0);
+  printf("%u reports, %u events, %u dropped, %u of %u queue entries used\n", 2u * NUM_REPORTS, _NumEvents, Stat.NumDropped, Stat.MaxUsed, MAX_DATA_ITEMS);
+  return HOST_TEST_END("MOUSE_Test");
+}
+
+/*************************** End of file ****************************/
@@ -0,0 +1,240 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : RTT_MP_Test.c
+Purpose : Stress test of the multi-producer mode of SEGGER_RTT.c.
+
+Additional information:
+  NUM_PRODUCERS threads write NUM_MESSAGES messages each to up-buffer 1
+  in SEGGER_RTT_MODE_MULTI_PRODUCER, half of them through
+  SEGGER_RTT_WriteMP, the others through SEGGER_RTT_WriteSkipNoLock,
+  which has to take the same lock-free path. The buffer is small, so
+  the producers keep running into each other and into the wrap-around.
+  The main thread reads the buffer as J-Link would and checks that no
+  message is torn, lost, duplicated or reordered per producer.
+  Before, the character and terminal functions are checked on the
+  terminal buffer 0, switched to multi-producer mode as USBH_ConfigIO.c
+  does with USE_RTT_MP.
+
+  Message layout:
+    [0]      Length, including this byte
+    [1]      Producer Id
+    [2..5]   Sequence number of the producer
+    [6..n-2] Payload, derived from Id, sequence number and position
+    [n-1]    0xA5
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include "SEGGER_RTT.h"
+#include "HOST_TEST.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#define NUM_PRODUCERS      8
+#define NUM_MESSAGES       20000      // Per producer.
+#define BUFFER_SIZE        61         // Odd size, messages wrap at varying offsets.
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define MIN_MSG_LEN        8u
+#define MAX_MSG_LEN        (MIN_MSG_LEN + 16u)
+#define MSG_END            0xA5u
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static char _acBuffer[BUFFER_SIZE];
+
+/*********************************************************************
+*
+*       Static code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       _GetMsgLen
+*/
+static unsigned _GetMsgLen(unsigned Seq) {
+  return MIN_MSG_LEN + (Seq % 17u);
+}
+
+/*********************************************************************
+*
+*       _Producer
+*/
+static void * _Producer(void * p) {
+  unsigned char ac[MAX_MSG_LEN];
+  unsigned      Id;
+  unsigned      Seq;
+  unsigned      Len;
+  unsigned      i;
+  unsigned      r;
+
+  Id  = (unsigned)(long)p;
+  Seq = 0;
+  while (Seq < NUM_MESSAGES) {
+    Len   = _GetMsgLen(Seq);
+    ac[0] = (unsigned char)Len;
+    ac[1] = (unsigned char)Id;
+    memcpy(&ac[2], &Seq, 4);
+    for (i = 6; i < Len - 1u; i++) {
+      ac[i] = (unsigned char)(Id + Seq + i);
+    }
+    ac[Len - 1u] = MSG_END;
+    if (Id & 1u) {
+      r = SEGGER_RTT_WriteSkipNoLock(1, ac, Len);
+    } else {
+      r = SEGGER_RTT_WriteMP(1, ac, Len);
+    }
+    if (r != 0u) {
+      Seq++;
+    } else {
+      sched_yield();                    // Buffer full, let the reader run.
+    }
+  }
+  return NULL;
+}
+
+/*********************************************************************
+*
+*       _ReadByte
+*
+*  Function description
+*    Takes one byte from an up-buffer the way the host does, waits
+*    while the buffer is empty.
+*/
+static unsigned char _ReadByte(unsigned BufferIndex) {
+  SEGGER_RTT_BUFFER_UP * pRing;
+  unsigned               RdOff;
+  unsigned char          c;
+
+  pRing = &_SEGGER_RTT.aUp[BufferIndex];
+  RdOff = pRing->RdOff;
+  while (__atomic_load_n(&pRing->WrOff, __ATOMIC_ACQUIRE) == RdOff) {
+    sched_yield();
+  }
+  c = (unsigned char)pRing->pBuffer[RdOff];
+  __atomic_store_n(&pRing->RdOff, (RdOff + 1u) % pRing->SizeOfBuffer, __ATOMIC_RELEASE);
+  return c;
+}
+
+/*********************************************************************
+*
+*       _ReadMessage
+*
+*  Return value
+*    1: Message is valid and the next one of its producer.
+*    0: Corrupted.
+*/
+static int _ReadMessage(unsigned * paSeq) {
+  unsigned char ac[MAX_MSG_LEN];
+  unsigned      Len;
+  unsigned      Id;
+  unsigned      Seq;
+  unsigned      i;
+
+  Len = _ReadByte(1);
+  if ((Len < MIN_MSG_LEN) || (Len > MAX_MSG_LEN)) {
+    printf("Invalid length %u\n", Len);
+    return 0;
+  }
+  for (i = 1; i < Len; i++) {
+    ac[i] = _ReadByte(1);
+  }
+  Id = ac[1];
+  memcpy(&Seq, &ac[2], 4);
+  if ((Id >= NUM_PRODUCERS) || (Seq != paSeq[Id]) || (Len != _GetMsgLen(Seq)) || (ac[Len - 1u] != MSG_END)) {
+    printf("Producer %u: message %u, expected %u\n", Id, Seq, (Id < NUM_PRODUCERS) ? paSeq[Id] : 0u);
+    return 0;
+  }
+  for (i = 6; i < Len - 1u; i++) {
+    if (ac[i] != (unsigned char)(Id + Seq + i)) {
+      printf("Producer %u: message %u, payload corrupted\n", Id, Seq);
+      return 0;
+    }
+  }
+  paSeq[Id]++;
+  return 1;
+}
+
+/*********************************************************************
+*
+*       _TestTerminal
+*
+*  Function description
+*    The single byte and terminal functions on the terminal buffer
+*    in multi-producer mode.
+*/
+static void _TestTerminal(void) {
+  static const unsigned char _abExpected[] = { 'a', 0xFF, '2', 'x', 'y', 0xFF, '0', 0xFF, '1', 'b', 'c' };
+  unsigned i;
+
+  HOST_TEST_CHECK_EQUAL(SEGGER_RTT_MODE_NO_BLOCK_SKIP, _SEGGER_RTT.aUp[0].Flags);
+  HOST_TEST_CHECK_EQUAL(0, SEGGER_RTT_SetFlagsUpBuffer(0, SEGGER_RTT_MODE_MULTI_PRODUCER));
+  HOST_TEST_CHECK_EQUAL(1, SEGGER_RTT_PutChar(0, 'a'));
+  HOST_TEST_CHECK_EQUAL(2, SEGGER_RTT_TerminalOut(2, "xy"));
+  HOST_TEST_CHECK_EQUAL(0, SEGGER_RTT_SetTerminal(1));
+  HOST_TEST_CHECK_EQUAL(1, SEGGER_RTT_PutCharSkip(0, 'b'));
+  HOST_TEST_CHECK_EQUAL(1, SEGGER_RTT_PutCharSkipNoLock(0, 'c'));
+  for (i = 0; i < sizeof(_abExpected); i++) {
+    HOST_TEST_CHECK_EQUAL(_abExpected[i], _ReadByte(0));
+  }
+  HOST_TEST_CHECK_EQUAL(_SEGGER_RTT.aUp[0].WrOff, _SEGGER_RTT.aUp[0].RdOff);
+  SEGGER_RTT_SetTerminal(0);
+}
+
+/*********************************************************************
+*
+*       Public code
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       main
+*/
+int main(void) {
+  pthread_t aThread[NUM_PRODUCERS];
+  unsigned  aSeq[NUM_PRODUCERS];
+  unsigned  NumMessages;
+  unsigned  i;
+
+  SEGGER_RTT_Init();
+  _TestTerminal();
+  HOST_TEST_CHECK_EQUAL(0, SEGGER_RTT_ConfigUpBuffer(1, "MP", _acBuffer, sizeof(_acBuffer), SEGGER_RTT_MODE_MULTI_PRODUCER));
+  memset(aSeq, 0, sizeof(aSeq));
+  for (i = 0; i < NUM_PRODUCERS; i++) {
+    pthread_create(&aThread[i], NULL, _Producer, (void *)(long)i);
+  }
+  for (NumMessages = 0; NumMessages < NUM_PRODUCERS * NUM_MESSAGES; NumMessages++) {
+    if (_ReadMessage(aSeq) == 0) {
+      HOST_TEST_CHECK(0);
+      return HOST_TEST_END("RTT_MP_Test");    // Stream out of sync, the producers are left blocked.
+    }
+  }
+  for (i = 0; i < NUM_PRODUCERS; i++) {
+    pthread_join(aThread[i], NULL);
+    HOST_TEST_CHECK_EQUAL(NUM_MESSAGES, aSeq[i]);
+  }
+  HOST_TEST_CHECK_EQUAL(_SEGGER_RTT.aUp[1].WrOff, _SEGGER_RTT.aUp[1].RdOff);
+  printf("%u producers, %u messages\n", NUM_PRODUCERS, NumMessages);
+  return HOST_TEST_END("RTT_MP_Test");
+}
+
+/*************************** End of file ****************************/
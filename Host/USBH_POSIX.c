@@ -0,0 +1,214 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : USBH_POSIX.c
+Purpose : Stand-in for the emUSB-Host library in the Linux host build.
+          Log output and filters behave as in the library, the
+          USB functions report that no device is connected.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+/*********************************************************************
+*
+*       #include section
+*
+**********************************************************************
+*/
+#include <stdarg.h>
+#include "RTOS.h"
+#include "USBH_Int.h"
+#include "USBH_HID.h"
+#include "HID_LED.h"
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Defines non-configurable
+*
+**********************************************************************
+*/
+#define MAX_MESSAGE_LEN         256
+
+/*********************************************************************
+*
+*       Static data
+*
+**********************************************************************
+*/
+static U32 _LogFilter  = USBH_MTYPE_INIT;
+static U32 _WarnFilter = 0xFFFFFFFFuL;
+
+/*********************************************************************
+*
+*       Public code, log and warn
+*
+**********************************************************************
+*/
+void USBH_SetLogFilter(U32 FilterMask) {
+  _LogFilter = FilterMask;
+}
+
+void USBH_AddLogFilter(U32 FilterMask) {
+  _LogFilter |= FilterMask;
+}
+
+void USBH_SetWarnFilter(U32 FilterMask) {
+  _WarnFilter = FilterMask;
+}
+
+void USBH_AddWarnFilter(U32 FilterMask) {
+  _WarnFilter |= FilterMask;
+}
+
+/*********************************************************************
+*
+*       USBH_Logf_Application
+*
+*  Function description
+*    Formats the message only if USBH_MTYPE_APPLICATION passes the
+*    log filter and outputs it with USBH_Log() of USBH_ConfigIO.c.
+*/
+void USBH_Logf_Application(const char * sFormat, ...) {
+  char    ac[MAX_MESSAGE_LEN];
+  va_list ParamList;
+
+  if (_LogFilter & USBH_MTYPE_APPLICATION) {
+    va_start(ParamList, sFormat);
+    SEGGER_vsnprintf(ac, sizeof(ac), sFormat, ParamList);
+    va_end(ParamList);
+    USBH_Log(ac);
+  }
+}
+
+void USBH_Warnf_Application(const char * sFormat, ...) {
+  char    ac[MAX_MESSAGE_LEN];
+  va_list ParamList;
+
+  if (_WarnFilter & USBH_MTYPE_APPLICATION) {
+    va_start(ParamList, sFormat);
+    SEGGER_vsnprintf(ac, sizeof(ac), sFormat, ParamList);
+    va_end(ParamList);
+    USBH_Warn(ac);
+  }
+}
+
+/*********************************************************************
+*
+*       Public code, OS abstraction
+*
+**********************************************************************
+*/
+U32 USBH_OS_GetTime32(void) {
+  return (U32)OS_GetTime32();
+}
+
+void USBH_OS_DisableInterrupt(void) {
+  OS_IncDI();
+}
+
+void USBH_OS_EnableInterrupt(void) {
+  OS_DecRI();
+}
+
+/*********************************************************************
+*
+*       Public code, stack
+*
+**********************************************************************
+*/
+void USBH_Init(void) {
+}
+
+/*********************************************************************
+*
+*       USBH_Task
+*
+*  Function description
+*    No host controller, nothing to do.
+*/
+void USBH_Task(void) {
+  for (;;) {
+    OS_Delay(1000);
+  }
+}
+
+void USBH_ISRTask(void) {
+  for (;;) {
+    OS_Delay(1000);
+  }
+}
+
+/*********************************************************************
+*
+*       Public code, HID class
+*
+**********************************************************************
+*/
+U8 USBH_HID_Init(void) {
+  return 1;
+}
+
+void USBH_HID_SetOnMouseStateChange(USBH_HID_ON_MOUSE_FUNC * pfOnChange) {
+  SEGGER_USE_PARA(pfOnChange);
+}
+
+void USBH_HID_SetOnKeyboardStateChange(USBH_HID_ON_KEYBOARD_FUNC * pfOnChange) {
+  SEGGER_USE_PARA(pfOnChange);
+}
+
+void USBH_HID_SetOnGenericEvent(U32 NumUsages, const U32 * pUsages, USBH_HID_ON_GENERIC_FUNC * pfOnEvent) {
+  SEGGER_USE_PARA(NumUsages);
+  SEGGER_USE_PARA(pUsages);
+  SEGGER_USE_PARA(pfOnEvent);
+}
+
+void USBH_HID_RegisterNotification(USBH_NOTIFICATION_FUNC * pfNotification, void * pContext) {
+  SEGGER_USE_PARA(pfNotification);
+  SEGGER_USE_PARA(pContext);
+}
+
+void USBH_HID_ConfigureAllowLEDUpdate(unsigned AllowLEDUpdate) {
+  SEGGER_USE_PARA(AllowLEDUpdate);
+}
+
+int USBH_HID_GetNumDevices(USBH_HID_DEVICE_INFO * pDevInfo, U32 NumItems) {
+  SEGGER_USE_PARA(pDevInfo);
+  SEGGER_USE_PARA(NumItems);
+  return 0;
+}
+
+USBH_HID_HANDLE USBH_HID_Open(unsigned Index) {
+  SEGGER_USE_PARA(Index);
+  return 0;
+}
+
+USBH_STATUS USBH_HID_Close(USBH_HID_HANDLE hDevice) {
+  SEGGER_USE_PARA(hDevice);
+  return USBH_STATUS_SUCCESS;
+}
+
+USBH_STATUS USBH_HID_GetReport(USBH_HID_HANDLE hDevice, U8 * pBuffer, U32 BufferSize, USBH_HID_USER_FUNC * pfFunc, USBH_HID_RW_CONTEXT * pRWContext) {
+  SEGGER_USE_PARA(hDevice);
+  SEGGER_USE_PARA(pBuffer);
+  SEGGER_USE_PARA(BufferSize);
+  SEGGER_USE_PARA(pfFunc);
+  SEGGER_USE_PARA(pRWContext);
+  return USBH_STATUS_DEVICE_REMOVED;
+}
+
+USBH_STATUS USBH_HID_SetIndicators(USBH_HID_HANDLE hDevice, U8 IndicatorMask) {
+  SEGGER_USE_PARA(hDevice);
+  SEGGER_USE_PARA(IndicatorMask);
+  return USBH_STATUS_DEVICE_REMOVED;
+}
+
+/*********************************************************************
+*
+*       Public code, hardware configuration
+*
+**********************************************************************
+*/
+int HID_LED_X_IsControlIdle(void) {
+  return 1;
+}
+
+/*************************** End of file ****************************/
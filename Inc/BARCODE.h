@@ -0,0 +1,139 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BARCODE.h
+Purpose : Assembles the characters typed by a barcode scanner into
+          complete scans and passes them to a consumer task.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef BARCODE_H                       /* Avoid multiple inclusion */
+#define BARCODE_H
+
+#include "RTOS.h"
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   BARCODE_CHUNK_SIZE
+  #define BARCODE_CHUNK_SIZE        128u    // Bytes per chunk, a scan is stored in as many chunks as required.
+#endif
+
+#ifndef   BARCODE_NUM_CHUNKS
+  #define BARCODE_NUM_CHUNKS        128u    // Chunks shared by all scans, in assembly and queued.
+#endif
+
+#ifndef   BARCODE_MAX_SCANS
+  #define BARCODE_MAX_SCANS         16u     // Complete scans queued for the consumer.
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+typedef struct BARCODE_CHUNK BARCODE_CHUNK;
+
+struct BARCODE_CHUNK {
+  BARCODE_CHUNK * pNext;
+  U8              abData[BARCODE_CHUNK_SIZE];
+};
+
+/*********************************************************************
+*
+*       BARCODE_CONFIG
+*
+*  Description
+*    Describes how the characters of a scanner are split into scans.
+*    A scan ends with Enter (CR or LF) or when no character has been
+*    received for Timeout ms.
+*/
+typedef struct {
+  const char * sPrefix;          // Removed from the start of a scan, NULL for none.
+  const char * sSuffix;          // Removed from the end of a scan, NULL for none.
+  U32          Timeout;          // Gap between two characters in ms which ends a scan, 0 to end scans with Enter only.
+} BARCODE_CONFIG;
+
+/*********************************************************************
+*
+*       BARCODE_ASM
+*
+*  Description
+*    Assembly of the scans of one scanner. The members are private.
+*/
+typedef struct {
+  const BARCODE_CONFIG * pConfig;
+  U32                    Id;             // Passed on in BARCODE_SCAN.Id.
+  BARCODE_CHUNK        * pFirst;
+  BARCODE_CHUNK        * pLast;
+  U32                    NumBytes;
+  U32                    NumChunks;
+  U32                    LastTime;       // OS_GetTime32() of the last character.
+  U8                     IsOverflow;     // Out of chunks, the scan is discarded when it ends.
+} BARCODE_ASM;
+
+/*********************************************************************
+*
+*       BARCODE_SCAN
+*
+*  Description
+*    A complete scan. The data stays in the chunks it has been
+*    assembled in, read it with BARCODE_GetData() and return the
+*    chunks with BARCODE_FreeScan().
+*/
+typedef struct {
+  BARCODE_CHUNK * pFirst;
+  U32             Off;           // Offset of the first byte, behind the prefix.
+  U32             NumBytes;      // Number of bytes without prefix and suffix.
+  U32             Time;          // OS_GetTime32() of the last character.
+  U32             Id;            // Id of the assembly, for example the interface of the scanner.
+} BARCODE_SCAN;
+
+/*********************************************************************
+*
+*       BARCODE_STAT
+*
+*  Description
+*    Counters of the scan assembly.
+*/
+typedef struct {
+  U32 NumScans;                  // Scans passed to the consumer.
+  U32 NumDropped;                // Scans dropped because BARCODE_MAX_SCANS scans were queued.
+  U32 NumOverflows;              // Scans dropped because all chunks were in use.
+  U32 MaxChunksUsed;             // High-water mark of the chunks in use.
+} BARCODE_STAT;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void       BARCODE_Init      (void);
+void       BARCODE_Create    (BARCODE_ASM * pAsm, const BARCODE_CONFIG * pConfig, U32 Id);
+void       BARCODE_AddChar   (BARCODE_ASM * pAsm, char c);
+void       BARCODE_End       (BARCODE_ASM * pAsm);
+void       BARCODE_Discard   (BARCODE_ASM * pAsm);
+I32        BARCODE_GetTimeout(const BARCODE_ASM * pAsm);
+void       BARCODE_Poll      (BARCODE_ASM * pAsm);
+int        BARCODE_GetScan   (BARCODE_SCAN * pScan);
+void       BARCODE_WaitScan  (BARCODE_SCAN * pScan);
+const U8 * BARCODE_GetData   (const BARCODE_SCAN * pScan, U32 Off, unsigned * pNumBytes);
+void       BARCODE_FreeScan  (BARCODE_SCAN * pScan);
+void       BARCODE_GetStat   (BARCODE_STAT * pStat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
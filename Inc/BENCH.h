@@ -0,0 +1,101 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BENCH.h
+Purpose : Micro benchmark runner for hot paths of the application,
+          the RTT terminal and the emUSB-Host log output.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef BENCH_H                         /* Avoid multiple inclusion */
+#define BENCH_H
+
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   USE_BENCH
+  #define USE_BENCH            0        // Set to 1 to run the benchmarks on start-up of MainTask.
+#endif
+
+#ifndef   BENCH_NUM_OPS
+  #define BENCH_NUM_OPS        10000u   // Default number of operations per benchmark case.
+#endif
+
+#ifndef   BENCH_RTT_CHANNEL
+  #define BENCH_RTT_CHANNEL    1u       // RTT up-buffer used as sink for the RTT write benchmarks.
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       BENCH_FUNC
+*
+*  Description
+*    Performs exactly one operation of a benchmark case.
+*
+*  Parameters
+*    pContext : Context as given in BENCH_CASE.
+*    Index    : Running index of the operation, can be used to vary the input.
+*/
+typedef void (BENCH_FUNC)(void * pContext, unsigned Index);
+
+/*********************************************************************
+*
+*       BENCH_CASE
+*
+*  Description
+*    Describes one benchmark case.
+*/
+typedef struct {
+  const char * sName;            // Name printed in the result line.
+  BENCH_FUNC * pfOp;             // Function performing one operation.
+  void       * pContext;         // Passed to pfOp.
+  U32          NumBytesPerOp;    // Payload processed per operation, 0 if throughput is not relevant.
+  U32          NumOps;           // Number of operations, 0 to use BENCH_NUM_OPS.
+} BENCH_CASE;
+
+/*********************************************************************
+*
+*       BENCH_RESULT
+*
+*  Description
+*    Result of one benchmark case.
+*/
+typedef struct {
+  U32 NumOps;                    // Number of operations performed.
+  U32 TotalTime_us;              // Total time of all operations in microseconds.
+  U32 Time_ns;                   // Average time of one operation in nanoseconds.
+  U32 BytesPerSec;               // Throughput, 0 if NumBytesPerOp of the case is 0.
+} BENCH_RESULT;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BENCH_Run      (const BENCH_CASE * pCase, BENCH_RESULT * pResult);
+void BENCH_RunList  (const BENCH_CASE * paCase, unsigned NumCases);
+void BENCH_RunCommon(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,115 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BINLOG.h
+Purpose : Binary log output via a dedicated RTT channel.
+          Application messages are sent as format ID plus raw
+          arguments, formatting is deferred to the host.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef BINLOG_H                        /* Avoid multiple inclusion */
+#define BINLOG_H
+
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   USE_BINLOG
+  #define USE_BINLOG              0       // Set to 1 to output the log as binary records instead of text.
+#endif
+
+#ifndef   BINLOG_RTT_CHANNEL
+  #define BINLOG_RTT_CHANNEL      2u      // RTT up-buffer used for the binary records.
+#endif
+
+#ifndef   BINLOG_BUFFER_SIZE
+  #define BINLOG_BUFFER_SIZE      2048u   // Size of the RTT up-buffer.
+#endif
+
+#ifndef   BINLOG_MAX_ARGS
+  #define BINLOG_MAX_ARGS         6u      // Maximum number of arguments of an application message.
+#endif
+
+#ifndef   BINLOG_GET_TIMESTAMP
+  #define BINLOG_GET_TIMESTAMP()  OS_GetTime_Cycles()
+#endif
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+
+//
+// Record types.
+// Each record starts with an 8 byte header, all fields are little endian:
+//   U8  Type
+//   U8  NumBytes    Number of bytes following the header
+//   U16 Id          Format ID for BINLOG_TYPE_APP, 0 otherwise
+//   U32 Timestamp   BINLOG_GET_TIMESTAMP(), CPU cycles by default
+// BINLOG_TYPE_APP is followed by NumBytes / 4 U32 arguments,
+// BINLOG_TYPE_LOG and BINLOG_TYPE_WARN by the characters of the message.
+//
+#define BINLOG_TYPE_LOG           1u      // Text of an emUSB-Host log message.
+#define BINLOG_TYPE_WARN          2u      // Text of an emUSB-Host warning.
+#define BINLOG_TYPE_APP           3u      // Application message, see BINLOG_Formats.h.
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+#define BINLOG_FORMAT(Id, sFormat)  Id,
+enum {
+  #include "BINLOG_Formats.h"
+  BINLOG_NUM_FORMATS
+};
+#undef BINLOG_FORMAT
+
+/*********************************************************************
+*
+*       Macros
+*
+*  BINLOG_LOG(Id, ...)
+*    Logs an application message with 1 to BINLOG_MAX_ARGS integer
+*    arguments as type USBH_MTYPE_APPLICATION, filtered with the log
+*    filter of emUSB-Host. Without USE_BINLOG, the message is formatted
+*    and passed to USBH_Logf_Application().
+*
+**********************************************************************
+*/
+#define BINLOG_LOG(Id, ...)   do {                                          \
+                                const U32 _aBinLogArg[] = { __VA_ARGS__ };  \
+                                BINLOG_LogArgs((unsigned)(Id), _aBinLogArg, \
+                                               SEGGER_COUNTOF(_aBinLogArg));\
+                              } while (0)
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BINLOG_Init         (void);
+void BINLOG_SetLogFilter (U32 FilterMask);
+void BINLOG_AddLogFilter (U32 FilterMask);
+void BINLOG_LogArgs      (unsigned Id, const U32 * paArg, unsigned NumArgs);
+void BINLOG_WriteText    (unsigned Type, const char * s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,20 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : BINLOG_Formats.h
+Purpose : Format strings of the application log messages which are
+          output as binary records by BINLOG_LOG().
+          The position in this list is the ID sent to the host, so
+          the host decoder has to be built from the same list.
+          Add new entries at the end only.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+//
+//          ID                              Format
+//
+BINLOG_FORMAT(BINLOG_ID_DEVICE_ADDED,       "**** Device added [%d]")
+BINLOG_FORMAT(BINLOG_ID_DEVICE_REMOVED,     "**** Device removed [%d]")
+BINLOG_FORMAT(BINLOG_ID_KEYBOARD_RECEIVE,   "**** receive KB  code [%d] Value=[%d] InterfaceID[%d]")
+BINLOG_FORMAT(BINLOG_ID_MOUSE,              "Mouse: xRel: %d, yRel: %d, WheelRel: %d, ButtonState: %d")
+
+/****** End Of File *************************************************/
@@ -0,0 +1,64 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_BOOT_KBD.h
+Purpose : Comparison of two boot protocol keyboard reports, yields
+          all key changes of a report in one delta.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HID_BOOT_KBD_H                  /* Avoid multiple inclusion */
+#define HID_BOOT_KBD_H
+
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define HID_BOOT_KBD_REPORT_SIZE      8u      // Modifier byte, reserved byte, 6 key codes.
+#define HID_BOOT_KBD_NUM_KEYS         6u
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_BOOT_KBD_DELTA
+*
+*  Description
+*    Changes from one boot protocol report to the next.
+*/
+typedef struct {
+  U8 Modifiers;                             // Modifier byte of the new report, bit n is scan code 0xE0 + n.
+  U8 ModifiersChanged;                      // Modifier bits which differ from the previous report.
+  U8 NumPressed;
+  U8 NumReleased;
+  U8 aPressed[HID_BOOT_KBD_NUM_KEYS];       // Key codes which are new in the report.
+  U8 aReleased[HID_BOOT_KBD_NUM_KEYS];      // Key codes which are no longer in the report.
+} HID_BOOT_KBD_DELTA;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int HID_BOOT_KBD_Diff(const U8 * pPrevReport, const U8 * pReport, HID_BOOT_KBD_DELTA * pDelta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,99 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_KEYMAP.h
+Purpose : Translation of keyboard scan codes into characters for
+          several keyboard layouts, selectable per interface.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HID_KEYMAP_H                    /* Avoid multiple inclusion */
+#define HID_KEYMAP_H
+
+#include "SEGGER.h"
+#include "USBH.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   HID_KEYMAP_MAX_INTERFACES
+  #define HID_KEYMAP_MAX_INTERFACES   8u      // Interfaces which can use a layout other than the default one.
+#endif
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define HID_KEYMAP_NUM_CODES          0x65u   // Scan codes 0x00..0x64 (Key Non-US \ and |).
+#define HID_KEYMAP_NUM_LEVELS         4u      // Normal, Shift, AltGr, Shift + AltGr.
+#define HID_KEYMAP_FLAG_DEAD          0x100u  // Entry is a dead key.
+#define HID_KEYMAP_MAX_CHARS          2u      // Characters a key can produce, an accent and a character.
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_KEYMAP_LAYOUT
+*
+*  Description
+*    A keyboard layout. Entry (Code * HID_KEYMAP_NUM_LEVELS + Level)
+*    holds the character in Windows-1252, or'ed with HID_KEYMAP_FLAG_DEAD
+*    for a dead key.
+*/
+typedef struct {
+  const char * sName;
+  const U16  * paEntry;
+} HID_KEYMAP_LAYOUT;
+
+/*********************************************************************
+*
+*       HID_KEYMAP_STATE
+*
+*  Description
+*    Translation state of a keyboard. The members are private.
+*/
+typedef struct {
+  U8 DeadKey;                    // Accent of the dead key typed last, 0 for none.
+} HID_KEYMAP_STATE;
+
+/*********************************************************************
+*
+*       Layouts
+*
+**********************************************************************
+*/
+extern const HID_KEYMAP_LAYOUT HID_KEYMAP_US;
+extern const HID_KEYMAP_LAYOUT HID_KEYMAP_DE;
+extern const HID_KEYMAP_LAYOUT HID_KEYMAP_FR;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned                  HID_KEYMAP_Translate        (const HID_KEYMAP_LAYOUT * pLayout, HID_KEYMAP_STATE * pState, unsigned Code, unsigned Modifiers, char * pChar);
+void                      HID_KEYMAP_SetDefaultLayout (const HID_KEYMAP_LAYOUT * pLayout);
+int                       HID_KEYMAP_SetLayout        (USBH_INTERFACE_ID InterfaceID, const HID_KEYMAP_LAYOUT * pLayout);
+const HID_KEYMAP_LAYOUT * HID_KEYMAP_GetLayout        (USBH_INTERFACE_ID InterfaceID);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
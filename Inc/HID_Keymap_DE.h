@@ -0,0 +1,68 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_Keymap_DE.h
+Purpose : Keyboard layout German (QWERTZ), compiled into a table by HID_KEYMAP.c.
+          Each entry expands KEY(Code, Normal, Shift, AltGr) with the
+          characters of the key in Windows-1252, 0 for none.
+          DEAD(c) marks a dead key which combines with the next
+          character, c is the accent when it is typed alone.
+          Codes which are not listed produce no character.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+KEY(0x04, 'a', 'A', 0)                            // a / A / (none)
+KEY(0x05, 'b', 'B', 0)                            // b / B / (none)
+KEY(0x06, 'c', 'C', 0)                            // c / C / (none)
+KEY(0x07, 'd', 'D', 0)                            // d / D / (none)
+KEY(0x08, 'e', 'E', '\x80')                       // e / E / euro sign
+KEY(0x09, 'f', 'F', 0)                            // f / F / (none)
+KEY(0x0A, 'g', 'G', 0)                            // g / G / (none)
+KEY(0x0B, 'h', 'H', 0)                            // h / H / (none)
+KEY(0x0C, 'i', 'I', 0)                            // i / I / (none)
+KEY(0x0D, 'j', 'J', 0)                            // j / J / (none)
+KEY(0x0E, 'k', 'K', 0)                            // k / K / (none)
+KEY(0x0F, 'l', 'L', 0)                            // l / L / (none)
+KEY(0x10, 'm', 'M', '\xB5')                       // m / M / micro sign
+KEY(0x11, 'n', 'N', 0)                            // n / N / (none)
+KEY(0x12, 'o', 'O', 0)                            // o / O / (none)
+KEY(0x13, 'p', 'P', 0)                            // p / P / (none)
+KEY(0x14, 'q', 'Q', '@')                          // q / Q / @
+KEY(0x15, 'r', 'R', 0)                            // r / R / (none)
+KEY(0x16, 's', 'S', 0)                            // s / S / (none)
+KEY(0x17, 't', 'T', 0)                            // t / T / (none)
+KEY(0x18, 'u', 'U', 0)                            // u / U / (none)
+KEY(0x19, 'v', 'V', 0)                            // v / V / (none)
+KEY(0x1A, 'w', 'W', 0)                            // w / W / (none)
+KEY(0x1B, 'x', 'X', 0)                            // x / X / (none)
+KEY(0x1C, 'z', 'Z', 0)                            // z / Z / (none)
+KEY(0x1D, 'y', 'Y', 0)                            // y / Y / (none)
+KEY(0x1E, '1', '!', 0)                            // 1 / ! / (none)
+KEY(0x1F, '2', '"', '\xB2')                       // 2 / " / superscript 2
+KEY(0x20, '3', '\xA7', '\xB3')                    // 3 / section sign / superscript 3
+KEY(0x21, '4', '$', 0)                            // 4 / $ / (none)
+KEY(0x22, '5', '%', 0)                            // 5 / % / (none)
+KEY(0x23, '6', '&', 0)                            // 6 / & / (none)
+KEY(0x24, '7', '/', '{')                          // 7 / / / {
+KEY(0x25, '8', '(', '[')                          // 8 / ( / [
+KEY(0x26, '9', ')', ']')                          // 9 / ) / ]
+KEY(0x27, '0', '=', '}')                          // 0 / = / }
+KEY(0x28, '\n', '\n', 0)                          // Enter / Enter / (none)
+KEY(0x29, '\x1B', '\x1B', 0)                      // Escape / Escape / (none)
+KEY(0x2A, '\b', '\b', 0)                          // Backspace / Backspace / (none)
+KEY(0x2B, '\t', '\t', 0)                          // Tab / Tab / (none)
+KEY(0x2C, ' ', ' ', 0)                            // Space / Space / (none)
+KEY(0x2D, '\xDF', '?', '\\')                      // sharp s / ? / backslash
+KEY(0x2E, DEAD('\xB4'), DEAD('`'), 0)             // dead acute accent / dead ` / (none)
+KEY(0x2F, '\xFC', '\xDC', 0)                      // u umlaut / U umlaut / (none)
+KEY(0x30, '+', '*', '~')                          // + / * / ~
+KEY(0x31, '#', '\'', 0)                           // # / ' / (none)
+KEY(0x32, '#', '\'', 0)                           // # / ' / (none)
+KEY(0x33, '\xF6', '\xD6', 0)                      // o umlaut / O umlaut / (none)
+KEY(0x34, '\xE4', '\xC4', 0)                      // a umlaut / A umlaut / (none)
+KEY(0x35, DEAD('^'), '\xB0', 0)                   // dead ^ / degree sign / (none)
+KEY(0x36, ',', ';', 0)                            // , / ; / (none)
+KEY(0x37, '.', ':', 0)                            // . / : / (none)
+KEY(0x38, '-', '_', 0)                            // - / _ / (none)
+KEY(0x64, '<', '>', '|')                          // < / > / |
+
+/****** End Of File *************************************************/
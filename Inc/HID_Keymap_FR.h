@@ -0,0 +1,68 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_Keymap_FR.h
+Purpose : Keyboard layout French (AZERTY), compiled into a table by HID_KEYMAP.c.
+          Each entry expands KEY(Code, Normal, Shift, AltGr) with the
+          characters of the key in Windows-1252, 0 for none.
+          DEAD(c) marks a dead key which combines with the next
+          character, c is the accent when it is typed alone.
+          Codes which are not listed produce no character.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+KEY(0x04, 'q', 'Q', 0)                            // q / Q / (none)
+KEY(0x05, 'b', 'B', 0)                            // b / B / (none)
+KEY(0x06, 'c', 'C', 0)                            // c / C / (none)
+KEY(0x07, 'd', 'D', 0)                            // d / D / (none)
+KEY(0x08, 'e', 'E', '\x80')                       // e / E / euro sign
+KEY(0x09, 'f', 'F', 0)                            // f / F / (none)
+KEY(0x0A, 'g', 'G', 0)                            // g / G / (none)
+KEY(0x0B, 'h', 'H', 0)                            // h / H / (none)
+KEY(0x0C, 'i', 'I', 0)                            // i / I / (none)
+KEY(0x0D, 'j', 'J', 0)                            // j / J / (none)
+KEY(0x0E, 'k', 'K', 0)                            // k / K / (none)
+KEY(0x0F, 'l', 'L', 0)                            // l / L / (none)
+KEY(0x10, ',', '?', 0)                            // , / ? / (none)
+KEY(0x11, 'n', 'N', 0)                            // n / N / (none)
+KEY(0x12, 'o', 'O', 0)                            // o / O / (none)
+KEY(0x13, 'p', 'P', 0)                            // p / P / (none)
+KEY(0x14, 'a', 'A', 0)                            // a / A / (none)
+KEY(0x15, 'r', 'R', 0)                            // r / R / (none)
+KEY(0x16, 's', 'S', 0)                            // s / S / (none)
+KEY(0x17, 't', 'T', 0)                            // t / T / (none)
+KEY(0x18, 'u', 'U', 0)                            // u / U / (none)
+KEY(0x19, 'v', 'V', 0)                            // v / V / (none)
+KEY(0x1A, 'z', 'Z', 0)                            // z / Z / (none)
+KEY(0x1B, 'x', 'X', 0)                            // x / X / (none)
+KEY(0x1C, 'y', 'Y', 0)                            // y / Y / (none)
+KEY(0x1D, 'w', 'W', 0)                            // w / W / (none)
+KEY(0x1E, '&', '1', 0)                            // & / 1 / (none)
+KEY(0x1F, '\xE9', '2', DEAD('~'))                 // e acute / 2 / dead ~
+KEY(0x20, '"', '3', '#')                          // " / 3 / #
+KEY(0x21, '\'', '4', '{')                         // ' / 4 / {
+KEY(0x22, '(', '5', '[')                          // ( / 5 / [
+KEY(0x23, '-', '6', '|')                          // - / 6 / |
+KEY(0x24, '\xE8', '7', DEAD('`'))                 // e grave / 7 / dead `
+KEY(0x25, '_', '8', '\\')                         // _ / 8 / backslash
+KEY(0x26, '\xE7', '9', '^')                       // c cedilla / 9 / ^
+KEY(0x27, '\xE0', '0', '@')                       // a grave / 0 / @
+KEY(0x28, '\n', '\n', 0)                          // Enter / Enter / (none)
+KEY(0x29, '\x1B', '\x1B', 0)                      // Escape / Escape / (none)
+KEY(0x2A, '\b', '\b', 0)                          // Backspace / Backspace / (none)
+KEY(0x2B, '\t', '\t', 0)                          // Tab / Tab / (none)
+KEY(0x2C, ' ', ' ', 0)                            // Space / Space / (none)
+KEY(0x2D, ')', '\xB0', ']')                       // ) / degree sign / ]
+KEY(0x2E, '=', '+', '}')                          // = / + / }
+KEY(0x2F, DEAD('^'), DEAD('\xA8'), 0)             // dead ^ / dead diaeresis / (none)
+KEY(0x30, '$', '\xA3', '\xA4')                    // $ / pound sign / currency sign
+KEY(0x31, '*', '\xB5', 0)                         // * / micro sign / (none)
+KEY(0x32, '*', '\xB5', 0)                         // * / micro sign / (none)
+KEY(0x33, 'm', 'M', 0)                            // m / M / (none)
+KEY(0x34, '\xF9', '%', 0)                         // u grave / % / (none)
+KEY(0x35, '\xB2', 0, 0)                           // superscript 2 / (none) / (none)
+KEY(0x36, ';', '.', 0)                            // ; / . / (none)
+KEY(0x37, ':', '/', 0)                            // : / / / (none)
+KEY(0x38, '!', '\xA7', 0)                         // ! / section sign / (none)
+KEY(0x64, '<', '>', 0)                            // < / > / (none)
+
+/****** End Of File *************************************************/
@@ -0,0 +1,68 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_Keymap_US.h
+Purpose : Keyboard layout US (QWERTY), compiled into a table by HID_KEYMAP.c.
+          Each entry expands KEY(Code, Normal, Shift, AltGr) with the
+          characters of the key in Windows-1252, 0 for none.
+          DEAD(c) marks a dead key which combines with the next
+          character, c is the accent when it is typed alone.
+          Codes which are not listed produce no character.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+KEY(0x04, 'a', 'A', 0)                            // a / A / (none)
+KEY(0x05, 'b', 'B', 0)                            // b / B / (none)
+KEY(0x06, 'c', 'C', 0)                            // c / C / (none)
+KEY(0x07, 'd', 'D', 0)                            // d / D / (none)
+KEY(0x08, 'e', 'E', 0)                            // e / E / (none)
+KEY(0x09, 'f', 'F', 0)                            // f / F / (none)
+KEY(0x0A, 'g', 'G', 0)                            // g / G / (none)
+KEY(0x0B, 'h', 'H', 0)                            // h / H / (none)
+KEY(0x0C, 'i', 'I', 0)                            // i / I / (none)
+KEY(0x0D, 'j', 'J', 0)                            // j / J / (none)
+KEY(0x0E, 'k', 'K', 0)                            // k / K / (none)
+KEY(0x0F, 'l', 'L', 0)                            // l / L / (none)
+KEY(0x10, 'm', 'M', 0)                            // m / M / (none)
+KEY(0x11, 'n', 'N', 0)                            // n / N / (none)
+KEY(0x12, 'o', 'O', 0)                            // o / O / (none)
+KEY(0x13, 'p', 'P', 0)                            // p / P / (none)
+KEY(0x14, 'q', 'Q', 0)                            // q / Q / (none)
+KEY(0x15, 'r', 'R', 0)                            // r / R / (none)
+KEY(0x16, 's', 'S', 0)                            // s / S / (none)
+KEY(0x17, 't', 'T', 0)                            // t / T / (none)
+KEY(0x18, 'u', 'U', 0)                            // u / U / (none)
+KEY(0x19, 'v', 'V', 0)                            // v / V / (none)
+KEY(0x1A, 'w', 'W', 0)                            // w / W / (none)
+KEY(0x1B, 'x', 'X', 0)                            // x / X / (none)
+KEY(0x1C, 'y', 'Y', 0)                            // y / Y / (none)
+KEY(0x1D, 'z', 'Z', 0)                            // z / Z / (none)
+KEY(0x1E, '1', '!', 0)                            // 1 / ! / (none)
+KEY(0x1F, '2', '@', 0)                            // 2 / @ / (none)
+KEY(0x20, '3', '#', 0)                            // 3 / # / (none)
+KEY(0x21, '4', '$', 0)                            // 4 / $ / (none)
+KEY(0x22, '5', '%', 0)                            // 5 / % / (none)
+KEY(0x23, '6', '^', 0)                            // 6 / ^ / (none)
+KEY(0x24, '7', '&', 0)                            // 7 / & / (none)
+KEY(0x25, '8', '*', 0)                            // 8 / * / (none)
+KEY(0x26, '9', '(', 0)                            // 9 / ( / (none)
+KEY(0x27, '0', ')', 0)                            // 0 / ) / (none)
+KEY(0x28, '\n', '\n', 0)                          // Enter / Enter / (none)
+KEY(0x29, '\x1B', '\x1B', 0)                      // Escape / Escape / (none)
+KEY(0x2A, '\b', '\b', 0)                          // Backspace / Backspace / (none)
+KEY(0x2B, '\t', '\t', 0)                          // Tab / Tab / (none)
+KEY(0x2C, ' ', ' ', 0)                            // Space / Space / (none)
+KEY(0x2D, '-', '_', 0)                            // - / _ / (none)
+KEY(0x2E, '=', '+', 0)                            // = / + / (none)
+KEY(0x2F, '[', '{', 0)                            // [ / { / (none)
+KEY(0x30, ']', '}', 0)                            // ] / } / (none)
+KEY(0x31, '\\', '|', 0)                           // backslash / | / (none)
+KEY(0x32, '#', '~', 0)                            // # / ~ / (none)
+KEY(0x33, ';', ':', 0)                            // ; / : / (none)
+KEY(0x34, '\'', '"', 0)                           // ' / " / (none)
+KEY(0x35, '`', '~', 0)                            // ` / ~ / (none)
+KEY(0x36, ',', '<', 0)                            // , / < / (none)
+KEY(0x37, '.', '>', 0)                            // . / > / (none)
+KEY(0x38, '/', '?', 0)                            // / / ? / (none)
+KEY(0x64, '\\', '|', 0)                           // backslash / | / (none)
+
+/****** End Of File *************************************************/
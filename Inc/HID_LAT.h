@@ -0,0 +1,96 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_LAT.h
+Purpose : Latency histograms of HID reports from the USB interrupt
+          to the application task.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HID_LAT_H                       /* Avoid multiple inclusion */
+#define HID_LAT_H
+
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   USE_HID_LAT
+  #define USE_HID_LAT               0       // Set to 1 to measure the latency of each HID report.
+#endif
+
+#ifndef   HID_LAT_NUM_BUCKETS
+  #define HID_LAT_NUM_BUCKETS       24u     // Bucket n counts latencies of 2^(n-1) .. 2^n - 1 us, the last one all above.
+#endif
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define HID_LAT_STAGE_IRQ_CALLBACK  0u      // USB interrupt entry to HID callback.
+#define HID_LAT_STAGE_CALLBACK_TASK 1u      // HID callback to dequeue by the application task.
+#define HID_LAT_STAGE_IRQ_TASK      2u      // USB interrupt entry to dequeue, end to end.
+#define HID_LAT_NUM_STAGES          3u
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_LAT_STAMP
+*
+*  Description
+*    Timestamps of one report, queued with the event.
+*/
+typedef struct {
+  U32 IrqTime;                   // Cycles at the last USB channel interrupt before the callback, 0 if none.
+  U32 CallbackTime;              // Cycles in the callback.
+} HID_LAT_STAMP;
+
+/*********************************************************************
+*
+*       HID_LAT_HIST
+*
+*  Description
+*    Latency histogram of one stage.
+*/
+typedef struct {
+  U32 NumReports;
+  U32 Min_us;
+  U32 Max_us;
+  U32 aCount[HID_LAT_NUM_BUCKETS];
+} HID_LAT_HIST;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void HID_LAT_Init     (void);
+void HID_LAT_OnIRQ    (void);
+void HID_LAT_Stamp    (HID_LAT_STAMP * pStamp);
+void HID_LAT_OnDequeue(const HID_LAT_STAMP * pStamp);
+void HID_LAT_GetHist  (unsigned Stage, HID_LAT_HIST * pHist);
+void HID_LAT_Print    (void);
+void HID_LAT_Poll     (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,100 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_LED.h
+Purpose : Coalesced update of the keyboard indicators (LEDs) from a
+          low priority task.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HID_LED_H                       /* Avoid multiple inclusion */
+#define HID_LED_H
+
+#include "RTOS.h"
+#include "SEGGER.h"
+#include "USBH_HID.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   HID_LED_INTERVAL
+  #define HID_LED_INTERVAL          50      // Minimum time in ms between two updates of one keyboard.
+#endif
+
+#ifndef   HID_LED_TASK_PRIO
+  #define HID_LED_TASK_PRIO         100     // Below the USBH tasks and the application task.
+#endif
+
+#ifndef   HID_LED_BUSY_DELAY
+  #define HID_LED_BUSY_DELAY        2       // Time in ms until an update deferred by a busy control pipe is retried.
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_LED
+*
+*  Description
+*    Indicator state of one keyboard. The members are private.
+*/
+typedef struct HID_LED HID_LED;
+
+struct HID_LED {
+  HID_LED         * pNext;
+  USBH_HID_HANDLE   hDevice;
+  volatile U8       Mask;          // Indicators requested, written by the application.
+  U8                MaskSent;      // Indicators sent last, written by the LED task.
+  U32               LastTime;      // OS_GetTime32() of the last update.
+};
+
+/*********************************************************************
+*
+*       HID_LED_STAT
+*
+*  Description
+*    Counters of the LED task.
+*/
+typedef struct {
+  U32 NumRequests;                 // Calls of HID_LED_Set() which changed the mask.
+  U32 NumUpdates;                  // USBH_HID_SetIndicators() calls.
+  U32 NumErrors;                   // Updates which failed and were repeated.
+  U32 NumDeferred;                 // Updates deferred because a control transfer was in progress.
+} HID_LED_STAT;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void HID_LED_Init   (void);
+void HID_LED_Add    (HID_LED * pLed, USBH_HID_HANDLE hDevice);
+void HID_LED_Remove (HID_LED * pLed);
+void HID_LED_Set    (HID_LED * pLed, U8 Mask);
+U8   HID_LED_Get    (const HID_LED * pLed);
+void HID_LED_GetStat(HID_LED_STAT * pStat);
+
+//
+// Implemented by the hardware configuration, see Setup/USBH_Config_*.c.
+//
+int  HID_LED_X_IsControlIdle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,101 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_PLAN.h
+Purpose : Extraction plans for the fields of HID input reports.
+          A plan is compiled once from the field layout reported by
+          USBH_HID_SetOnGenericEvent() and decodes a complete raw
+          report in one pass.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HID_PLAN_H                      /* Avoid multiple inclusion */
+#define HID_PLAN_H
+
+#include "SEGGER.h"
+#include "USBH_HID.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   HID_PLAN_MAX_FIELDS
+  #define HID_PLAN_MAX_FIELDS       64u     // Maximum number of fields of all reports of a plan.
+#endif
+
+#ifndef   HID_PLAN_MAX_REPORTS
+  #define HID_PLAN_MAX_REPORTS      USBH_HID_MAX_REPORTS
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_PLAN_FIELD
+*
+*  Description
+*    One step of a plan. The members are private.
+*/
+typedef struct {
+  U16 ByteOff;                   // Offset of the 32-bit (or 64-bit) word to load.
+  U8  Shift;                     // Position of the field in the word.
+  U8  NumBits;
+  U8  Flags;
+  U8  ValueIndex;                // Index in the array of values, the index of the usage.
+} HID_PLAN_FIELD;
+
+/*********************************************************************
+*
+*       HID_PLAN_REPORT
+*
+*  Description
+*    Fields of one report. The members are private.
+*/
+typedef struct {
+  U8  ReportID;
+  U8  NumFields;
+  U16 FirstField;
+  U16 NumBytes;                  // Minimum size of the report, without report ID.
+} HID_PLAN_REPORT;
+
+/*********************************************************************
+*
+*       HID_PLAN
+*
+*  Description
+*    Extraction plan for all input reports of an interface.
+*/
+typedef struct {
+  unsigned        NumReports;
+  unsigned        NumFields;
+  U8              UsesReportIDs;   // Reports start with the report ID byte.
+  HID_PLAN_REPORT aReport[HID_PLAN_MAX_REPORTS];
+  HID_PLAN_FIELD  aField[HID_PLAN_MAX_FIELDS];
+} HID_PLAN;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int HID_PLAN_Compile(HID_PLAN * pPlan, const USBH_HID_GENERIC_DATA * paData, unsigned NumInfos);
+int HID_PLAN_Decode (const HID_PLAN * pPlan, const U8 * pReport, unsigned NumBytes, I32 * paValue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,100 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_QUEUE.h
+Purpose : Single producer, single consumer event queue between the
+          HID callbacks running in USBH_Task and the application task.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HID_QUEUE_H                     /* Avoid multiple inclusion */
+#define HID_QUEUE_H
+
+#include "RTOS.h"
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_QUEUE
+*
+*  Description
+*    Queue object. The members are private, use the functions below.
+*/
+typedef struct {
+  U8           * pData;
+  unsigned       ItemSize;
+  unsigned       NumItems;
+  volatile U32   WrPos;          // 0..2 * NumItems - 1, written by the producer only.
+  volatile U32   RdPos;          // 0..2 * NumItems - 1, written by the consumer only.
+  OS_TASK      * pTask;          // Consumer task.
+  OS_TASKEVENT   Event;          // Task event signaled when the queue becomes non-empty.
+  U32            NumPut;         // Items queued, written by the producer only.
+  U32            NumDropped;     // Items which did not fit, written by the producer only.
+  U32            MaxUsed;        // High-water mark, written by the producer only.
+} HID_QUEUE;
+
+/*********************************************************************
+*
+*       HID_QUEUE_MUX
+*
+*  Description
+*    Serves several queues of the same consumer task in turn.
+*    The members are private, use the functions below.
+*/
+typedef struct {
+  HID_QUEUE * const * papQueue;
+  unsigned            NumQueues;
+  unsigned            NextQueue;  // Queue asked first by the next HID_QUEUE_MUX_Get().
+  OS_TASKEVENT        Event;      // Task event shared by all queues.
+} HID_QUEUE_MUX;
+
+/*********************************************************************
+*
+*       HID_QUEUE_STAT
+*
+*  Description
+*    Counters of a queue.
+*/
+typedef struct {
+  U32 NumPut;                    // Items queued.
+  U32 NumDropped;                // Items dropped because the queue was full.
+  U32 MaxUsed;                   // Maximum number of items in the queue.
+} HID_QUEUE_STAT;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void HID_QUEUE_Create   (HID_QUEUE * pQueue, void * pBuffer, unsigned ItemSize, unsigned NumItems, OS_TASKEVENT Event);
+int  HID_QUEUE_Put      (HID_QUEUE * pQueue, const void * pItem);
+int  HID_QUEUE_IsFull   (const HID_QUEUE * pQueue);
+int  HID_QUEUE_Get      (HID_QUEUE * pQueue, void * pItem);
+void HID_QUEUE_Wait     (HID_QUEUE * pQueue);
+int  HID_QUEUE_WaitTimed(HID_QUEUE * pQueue, OS_TIME Timeout);
+void HID_QUEUE_Wakeup   (HID_QUEUE * pQueue);
+void HID_QUEUE_GetStat  (const HID_QUEUE * pQueue, HID_QUEUE_STAT * pStat);
+
+void HID_QUEUE_MUX_Create   (HID_QUEUE_MUX * pMux, HID_QUEUE * const * papQueue, unsigned NumQueues);
+int  HID_QUEUE_MUX_Get      (HID_QUEUE_MUX * pMux, void * pItem);
+void HID_QUEUE_MUX_Wait     (HID_QUEUE_MUX * pMux);
+int  HID_QUEUE_MUX_WaitTimed(HID_QUEUE_MUX * pMux, OS_TIME Timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -0,0 +1,135 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_REPLAY.h
+Purpose : Replay of recorded or synthetic keyboard and mouse reports
+          into the HID callbacks of the sample applications.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef HID_REPLAY_H                    /* Avoid multiple inclusion */
+#define HID_REPLAY_H
+
+#include "RTOS.h"
+#include "SEGGER.h"
+#include "USBH_HID.h"
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   USE_HID_REPLAY
+  #define USE_HID_REPLAY              0       // Set to 1 to feed replayed reports to the application instead of waiting for a device.
+#endif
+
+#ifndef   HID_REPLAY_MAX_DEVICES
+  #define HID_REPLAY_MAX_DEVICES      16u     // Maximum number of simulated devices.
+#endif
+
+#ifndef   HID_REPLAY_INTERFACE_ID_BASE
+  #define HID_REPLAY_INTERFACE_ID_BASE 0x100u // InterfaceID of the first simulated device, chosen to not collide with real devices.
+#endif
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define HID_REPLAY_TYPE_KEYBOARD      0u
+#define HID_REPLAY_TYPE_MOUSE         1u
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       HID_REPLAY_ITEM
+*
+*  Description
+*    One recorded report.
+*/
+typedef struct {
+  U8 Type;                       // HID_REPLAY_TYPE_KEYBOARD or HID_REPLAY_TYPE_MOUSE.
+  U8 Code;                       // Keyboard: scan code. Mouse: button state.
+  U8 Value;                      // Keyboard: 1 = pressed, 0 = released. Mouse: unused.
+  I8 xChange;                    // Mouse only.
+  I8 yChange;                    // Mouse only.
+  I8 WheelChange;                // Mouse only.
+} HID_REPLAY_ITEM;
+
+/*********************************************************************
+*
+*       HID_REPLAY_CONFIG
+*
+*  Description
+*    Describes one replay run.
+*    Without a recording, every device alternately presses and releases
+*    the letter keys (keyboard) or moves in a zigzag (mouse).
+*/
+typedef struct {
+  USBH_HID_ON_KEYBOARD_FUNC * pfOnKeyboard;  // Keyboard callback of the application, may be NULL.
+  USBH_HID_ON_MOUSE_FUNC    * pfOnMouse;     // Mouse callback of the application, may be NULL.
+  const HID_REPLAY_ITEM     * paItem;        // Recording, repeated until NumReports are sent. NULL for synthetic reports.
+  unsigned                    NumItems;      // Number of items in the recording.
+  unsigned                    NumDevices;    // Number of simulated devices, each one sends its own stream.
+  unsigned                    ReportsPerSec; // Report rate of each device, 1..1000.
+  U32                         NumReports;    // Number of reports sent per device.
+  U8                          MouseRatio;    // Synthetic reports only: every n-th device is a mouse, 0 for keyboards only.
+  OS_PRIO                     TaskPrio;      // Priority of the replay task, typically the one of USBH_Task.
+} HID_REPLAY_CONFIG;
+
+/*********************************************************************
+*
+*       HID_REPLAY_STAT
+*
+*  Description
+*    Result of a replay run.
+*/
+typedef struct {
+  U32 NumSent;                   // Reports passed to the callbacks.
+  U32 NumDropped;                // Reports the application could not queue (HID_QUEUE_Put() failed).
+  U32 NumReceived;               // Reports dequeued by the application.
+  U32 NumCoalesced;              // Mouse reports merged into another report by the application.
+  U32 LatencyMin_us;             // Time from callback to dequeue.
+  U32 LatencyMax_us;
+  U32 LatencyAvg_us;
+  U32 Duration_ms;               // Time from first to last report sent.
+  I32 xSent;                     // Sum of the mouse movement sent.
+  I32 ySent;
+  I32 WheelSent;
+  I32 xReceived;                 // Sum of the mouse movement received by the application.
+  I32 yReceived;
+  I32 WheelReceived;
+} HID_REPLAY_STAT;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void HID_REPLAY_Start       (const HID_REPLAY_CONFIG * pConfig);
+U32  HID_REPLAY_GetTimestamp(void);
+void HID_REPLAY_OnDropped   (void);
+void HID_REPLAY_OnReceived  (U32 Timestamp);
+void HID_REPLAY_OnCoalesced (void);
+void HID_REPLAY_OnMotion    (int xChange, int yChange, int WheelChange);
+void HID_REPLAY_GetStat     (HID_REPLAY_STAT * pStat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
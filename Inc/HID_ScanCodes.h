@@ -0,0 +1,232 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : HID_ScanCodes.h
+Purpose : Descriptions of the keyboard scan codes (HID usage page 0x07)
+          used by the sample applications.
+          Each entry expands SCANCODE(Code, sDesc), see _ScanCode2String()
+          in USBH_HID_Start.c. Codes which are not listed are
+          reported as unknown.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+SCANCODE(0x00, "Reserved/(no event indicated)")
+SCANCODE(0x01, "Key ErrorRollOver")
+SCANCODE(0x02, "Key POSTFail")
+SCANCODE(0x03, "Key ErrorUndefined")
+SCANCODE(0x04, "Key a/A")
+SCANCODE(0x05, "Key b/B")
+SCANCODE(0x06, "Key c/C")
+SCANCODE(0x07, "Key d/D")
+SCANCODE(0x08, "Key e/E")
+SCANCODE(0x09, "Key f/F")
+SCANCODE(0x0A, "Key g/G")
+SCANCODE(0x0B, "Key h/H")
+SCANCODE(0x0C, "Key i/I")
+SCANCODE(0x0D, "Key j/J")
+SCANCODE(0x0E, "Key k/K")
+SCANCODE(0x0F, "Key l/L")
+SCANCODE(0x10, "Key m/M")
+SCANCODE(0x11, "Key n/N")
+SCANCODE(0x12, "Key o/O")
+SCANCODE(0x13, "Key p/P")
+SCANCODE(0x14, "Key q/Q")
+SCANCODE(0x15, "Key r/R")
+SCANCODE(0x16, "Key s/S")
+SCANCODE(0x17, "Key t/T")
+SCANCODE(0x18, "Key u/U")
+SCANCODE(0x19, "Key v/V")
+SCANCODE(0x1A, "Key w/W")
+SCANCODE(0x1B, "Key x/X")
+SCANCODE(0x1C, "Key y/Y")
+SCANCODE(0x1D, "Key z/Z")
+SCANCODE(0x1E, "Key 1/!")
+SCANCODE(0x1F, "Key 2/@")
+SCANCODE(0x20, "Key 3/#")
+SCANCODE(0x21, "Key 4/$")
+SCANCODE(0x22, "Key 5/%")
+SCANCODE(0x23, "Key 6/^")
+SCANCODE(0x24, "Key 7/&")
+SCANCODE(0x25, "Key 8/*")
+SCANCODE(0x26, "Key 9/(")
+SCANCODE(0x27, "Key 0/)")
+SCANCODE(0x28, "Key Return (ENTER)")
+SCANCODE(0x29, "Key ESCAPE")
+SCANCODE(0x2A, "Key DELETE(Backspace)")
+SCANCODE(0x2B, "Key Tab")
+SCANCODE(0x2C, "Key Spacebar")
+SCANCODE(0x2D, "Key -/(underscore)")
+SCANCODE(0x2E, "Key =/+")
+SCANCODE(0x2F, "Key [/{")
+SCANCODE(0x30, "Key ]/}")
+SCANCODE(0x31, "Key \\/|")
+SCANCODE(0x32, "Key Non-US #/~")
+SCANCODE(0x33, "Key ;/:")
+SCANCODE(0x34, "Key Apostrophe/Quotation mark")
+SCANCODE(0x35, "Key GraveAccent/Tilde")
+SCANCODE(0x36, "Key,/<")
+SCANCODE(0x37, "Key ./>")
+SCANCODE(0x38, "Key //?")
+SCANCODE(0x39, "Key Caps Lock")
+SCANCODE(0x3A, "Key F1")
+SCANCODE(0x3B, "Key F2")
+SCANCODE(0x3C, "Key F3")
+SCANCODE(0x3D, "Key F4")
+SCANCODE(0x3E, "Key F5")
+SCANCODE(0x3F, "Key F6")
+SCANCODE(0x40, "Key F7")
+SCANCODE(0x41, "Key F8")
+SCANCODE(0x42, "Key F9")
+SCANCODE(0x43, "Key F10")
+SCANCODE(0x44, "Key F11")
+SCANCODE(0x45, "Key F12")
+SCANCODE(0x46, "Key PrintScreen")
+SCANCODE(0x47, "Key Scroll Lock")
+SCANCODE(0x48, "Key Pause")
+SCANCODE(0x49, "Key Insert")
+SCANCODE(0x4A, "Key Home")
+SCANCODE(0x4B, "Key PageUp")
+SCANCODE(0x4C, "Key Delete Forward")
+SCANCODE(0x4D, "Key End")
+SCANCODE(0x4E, "Key PageDown")
+SCANCODE(0x4F, "Key RightArrow")
+SCANCODE(0x50, "Key LeftArrow")
+SCANCODE(0x51, "Key DownArrow")
+SCANCODE(0x52, "Key UpArrow")
+SCANCODE(0x53, "Keypad NumLock/Clear")
+SCANCODE(0x54, "Keypad /")
+SCANCODE(0x55, "Keypad *")
+SCANCODE(0x56, "Keypad -")
+SCANCODE(0x57, "Keypad +")
+SCANCODE(0x58, "Keypad ENTER")
+SCANCODE(0x59, "Keypad 1/End")
+SCANCODE(0x5A, "Keypad 2/Down Arrow")
+SCANCODE(0x5B, "Keypad 3/PageDn")
+SCANCODE(0x5C, "Keypad 4/Left Arrow")
+SCANCODE(0x5D, "Keypad 5")
+SCANCODE(0x5E, "Keypad 6/Right Arrow")
+SCANCODE(0x5F, "Keypad 7/Home")
+SCANCODE(0x60, "Keypad 8/Up Arrow")
+SCANCODE(0x61, "Keypad 9/PageUp")
+SCANCODE(0x62, "Keypad 0/Insert")
+SCANCODE(0x63, "Keypad ./Delete")
+SCANCODE(0x64, "Key Non-US \\/|")
+SCANCODE(0x65, "Key Application")
+SCANCODE(0x66, "Key Power")
+SCANCODE(0x67, "Keypad =")
+SCANCODE(0x68, "Key F13")
+SCANCODE(0x69, "Key F14")
+SCANCODE(0x6A, "Key F15")
+SCANCODE(0x6B, "Key F16")
+SCANCODE(0x6C, "Key F17")
+SCANCODE(0x6D, "Key F18")
+SCANCODE(0x6E, "Key F19")
+SCANCODE(0x6F, "Key F20")
+SCANCODE(0x70, "Key F21")
+SCANCODE(0x71, "Key F22")
+SCANCODE(0x72, "Key F23")
+SCANCODE(0x73, "Key F24")
+SCANCODE(0x74, "Key Execute")
+SCANCODE(0x75, "Key Help")
+SCANCODE(0x76, "Key Menu")
+SCANCODE(0x77, "Key Select")
+SCANCODE(0x78, "Key Stop")
+SCANCODE(0x79, "Key Again")
+SCANCODE(0x7A, "Key Undo")
+SCANCODE(0x7B, "Key Cut")
+SCANCODE(0x7C, "Key Copy")
+SCANCODE(0x7D, "Key Paste")
+SCANCODE(0x7E, "Key Find")
+SCANCODE(0x7F, "Key Mute")
+SCANCODE(0x80, "Key Volume Up")
+SCANCODE(0x81, "Key Volume Down")
+SCANCODE(0x82, "Key Locking CapsLock")
+SCANCODE(0x83, "Key Locking NumLock")
+SCANCODE(0x84, "Key Locking ScrollLock")
+SCANCODE(0x85, "Keypad Comma")
+SCANCODE(0x86, "Keypad Equal Sign")
+SCANCODE(0x87, "Key International1")
+SCANCODE(0x88, "Key International2")
+SCANCODE(0x89, "Key International3")
+SCANCODE(0x8A, "Key International4")
+SCANCODE(0x8B, "Key International5")
+SCANCODE(0x8C, "Key International6")
+SCANCODE(0x8D, "Key International7")
+SCANCODE(0x8E, "Key International8")
+SCANCODE(0x8F, "Key International9")
+SCANCODE(0x90, "Key LANG1")
+SCANCODE(0x91, "Key LANG2")
+SCANCODE(0x92, "Key LANG3")
+SCANCODE(0x93, "Key LANG4")
+SCANCODE(0x94, "Key LANG5")
+SCANCODE(0x95, "Key LANG6")
+SCANCODE(0x96, "Key LANG7")
+SCANCODE(0x97, "Key LANG8")
+SCANCODE(0x98, "Key LANG9")
+SCANCODE(0x99, "Key Alternate Erase")
+SCANCODE(0x9A, "Key SysReq/Attention")
+SCANCODE(0x9B, "Key Cancel")
+SCANCODE(0x9C, "Key Clear")
+SCANCODE(0x9D, "Key Prior")
+SCANCODE(0x9E, "Key Return")
+SCANCODE(0x9F, "Key Separator")
+SCANCODE(0xA0, "Key Out")
+SCANCODE(0xA1, "Key Oper")
+SCANCODE(0xA2, "Key Clear/Again")
+SCANCODE(0xA3, "Key CrSel/Props")
+SCANCODE(0xA4, "Key ExSel")
+SCANCODE(0xB0, "Keypad 00")
+SCANCODE(0xB1, "Keypad 000")
+SCANCODE(0xB2, "Thousands Separator")
+SCANCODE(0xB3, "Decimal Separator")
+SCANCODE(0xB4, "Currency Unit")
+SCANCODE(0xB5, "Currency Sub-unit")
+SCANCODE(0xB6, "Keypad (")
+SCANCODE(0xB7, "Keypad )")
+SCANCODE(0xB8, "Keypad {")
+SCANCODE(0xB9, "Keypad }")
+SCANCODE(0xBA, "Keypad Tab")
+SCANCODE(0xBB, "Keypad Backspace")
+SCANCODE(0xBC, "Keypad A")
+SCANCODE(0xBD, "Keypad B")
+SCANCODE(0xBE, "Keypad C")
+SCANCODE(0xBF, "Keypad D")
+SCANCODE(0xC0, "Keypad E")
+SCANCODE(0xC1, "Keypad F")
+SCANCODE(0xC2, "Keypad XOR")
+SCANCODE(0xC3, "Keypad ^")
+SCANCODE(0xC4, "Keypad %")
+SCANCODE(0xC5, "Keypad <")
+SCANCODE(0xC6, "Keypad >")
+SCANCODE(0xC7, "Keypad &")
+SCANCODE(0xC8, "Keypad &&")
+SCANCODE(0xC9, "Keypad |")
+SCANCODE(0xCA, "Keypad ||")
+SCANCODE(0xCB, "Keypad :")
+SCANCODE(0xCC, "Keypad #")
+SCANCODE(0xCD, "Keypad Space")
+SCANCODE(0xCE, "Keypad @")
+SCANCODE(0xCF, "Keypad !")
+SCANCODE(0xD0, "Keypad Memory Store")
+SCANCODE(0xD1, "Keypad Memory Recall")
+SCANCODE(0xD2, "Keypad Memory Clear")
+SCANCODE(0xD3, "Keypad Memory Add")
+SCANCODE(0xD4, "Keypad Memory Subtract")
+SCANCODE(0xD5, "Keypad Memory Multiply")
+SCANCODE(0xD6, "Keypad Memory Divide")
+SCANCODE(0xD7, "Keypad +/-")
+SCANCODE(0xD8, "Keypad Clear")
+SCANCODE(0xD9, "Keypad Clear Entry")
+SCANCODE(0xDA, "Keypad Binary")
+SCANCODE(0xDB, "Keypad Octal")
+SCANCODE(0xDC, "Keypad Decimal")
+SCANCODE(0xDD, "Keypad Hexadecimal")
+SCANCODE(0xE0, "Key LeftControl")
+SCANCODE(0xE1, "Key LeftShift")
+SCANCODE(0xE2, "Key LeftAlt")
+SCANCODE(0xE3, "Key Left GUI")
+SCANCODE(0xE4, "Key RightControl")
+SCANCODE(0xE5, "Key RightShift")
+SCANCODE(0xE6, "Key RightAlt")
+SCANCODE(0xE7, "Key Right GUI")
+
+/****** End Of File *************************************************/
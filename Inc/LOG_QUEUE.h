@@ -0,0 +1,92 @@
+/*********************************************************************
+----------------------------------------------------------------------
+File    : LOG_QUEUE.h
+Purpose : Log queue which decouples the log output of emUSB-Host
+          and the application from the terminal I/O.
+--------  END-OF-HEADER  ---------------------------------------------
+*/
+
+#ifndef LOG_QUEUE_H                     /* Avoid multiple inclusion */
+#define LOG_QUEUE_H
+
+#include "RTOS.h"
+#include "SEGGER.h"
+
+/*********************************************************************
+*
+*       Defines, fixed
+*
+**********************************************************************
+*/
+#define LOG_QUEUE_SINK_RTT        0     // RTT terminal, up-buffer 0.
+#define LOG_QUEUE_SINK_EMBOSVIEW  1     // embOSView terminal via OS_COM_SendString() (UART or J-Link, see OS_VIEW_IFSELECT).
+#define LOG_QUEUE_SINK_PUTCHAR    2     // putchar(), semihosting with most debuggers.
+
+/*********************************************************************
+*
+*       Defines, configurable
+*
+**********************************************************************
+*/
+#ifndef   USE_LOG_QUEUE
+  #define USE_LOG_QUEUE           0     // Set to 1 to queue log lines and output them from a low priority task.
+#endif
+
+#ifndef   LOG_QUEUE_SIZE
+  #define LOG_QUEUE_SIZE          2048u // Size of the queue in bytes. Lines which do not fit are dropped.
+#endif
+
+#ifndef   LOG_QUEUE_SINK
+  #if (defined(USE_RTT) && USE_RTT)
+    #define LOG_QUEUE_SINK        LOG_QUEUE_SINK_RTT
+  #else
+    #define LOG_QUEUE_SINK        LOG_QUEUE_SINK_PUTCHAR
+  #endif
+#endif
+
+#ifndef   LOG_QUEUE_TASK_PRIO
+  #define LOG_QUEUE_TASK_PRIO     50    // Below all tasks of the application, the output only runs when the system is idle.
+#endif
+
+/*********************************************************************
+*
+*       Types
+*
+**********************************************************************
+*/
+
+/*********************************************************************
+*
+*       LOG_QUEUE_STAT
+*
+*  Description
+*    Counters of the log queue.
+*/
+typedef struct {
+  U32 NumLines;                  // Lines queued.
+  U32 NumDroppedLines;           // Lines dropped because the queue was full.
+  U32 NumDroppedBytes;           // Bytes of the dropped lines.
+  U32 MaxUsed;                   // High-water mark of the queue in bytes.
+} LOG_QUEUE_STAT;
+
+/*********************************************************************
+*
+*       Prototypes
+*
+**********************************************************************
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void LOG_QUEUE_Init   (void);
+int  LOG_QUEUE_Write  (const char * const * pasPart, unsigned NumParts);
+void LOG_QUEUE_GetStat(LOG_QUEUE_STAT * pStat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif                                  /* Avoid multiple inclusion */
+
+/****** End Of File *************************************************/
@@ -202,6 +202,27 @@ Additional information:
   #define SEGGER_RTT_PUT_BUFFER_SECTION(Var) Var
 #endif
 
+//
+// Atomic primitives for multi-producer mode.
+// Cortex-M3/4/7/33 use LDREX/STREX, other targets and host builds C11 atomics.
+// Without either, the compare-and-swap falls back to SEGGER_RTT_LOCK().
+//
+#if (defined __GNUC__) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__))
+  #define RTT_MP_USE_LDREX  1
+#elif (defined __STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !(defined __STDC_NO_ATOMICS__)
+  #include <stdatomic.h>
+  #define RTT_MP_USE_C11    1
+#endif
+
+//
+// Multi-producer state of an up-buffer:
+// Bits  0..15: Offset up to which space has been claimed.
+// Bits 16..31: Number of producers which claimed space but did not commit yet.
+//
+#define RTT_MP_CLAIM_MASK     0xFFFFu
+#define RTT_MP_PENDING_SHIFT  16u
+#define RTT_MP_PENDING_ONE    (1u << RTT_MP_PENDING_SHIFT)
+
 /*********************************************************************
 *
 *       Static const data
@@ -227,6 +248,8 @@ SEGGER_RTT_PUT_BUFFER_SECTION(SEGGER_RTT_BUFFER_ALIGN(static char _acDownBuffer[
 
 static char _ActiveTerminal;
 
+static volatile unsigned _aMPState[SEGGER_RTT_MAX_NUM_UP_BUFFERS];
+
 /*********************************************************************
 *
 *       Static functions
@@ -271,7 +294,7 @@ static void _DoInit(void) {
   p->aDown[0].SizeOfBuffer  = sizeof(_acDownBuffer);
   p->aDown[0].RdOff         = 0u;
   p->aDown[0].WrOff         = 0u;
-  p->aDown[0].Flags         = SEGGER_RTT_MODE_DEFAULT;
+  p->aDown[0].Flags         = SEGGER_RTT_MODE_DEFAULT & SEGGER_RTT_MODE_MASK;
   //
   // Finish initialization of the control block.
   // Copy Id string in three steps to make sure "SEGGER RTT" is not found
@@ -469,6 +492,173 @@ static unsigned _GetAvailWriteSpace(SEGGER_RTT_BUFFER_UP* pRing) {
   return r;
 }
 
+/*********************************************************************
+*
+*       _GetSpans()
+*
+*  Function description
+*    Describes NumBytes of the ring buffer starting at Off
+*    as one or two spans.
+*/
+static void _GetSpans(SEGGER_RTT_BUFFER_UP* pRing, unsigned Off, unsigned NumBytes, SEGGER_RTT_RESERVATION* pReservation) {
+  unsigned Rem;
+
+  Rem = pRing->SizeOfBuffer - Off;
+  pReservation->pData0 = pRing->pBuffer + Off;
+  if (Rem > NumBytes) {
+    pReservation->NumBytes0 = NumBytes;
+    pReservation->pData1    = NULL;
+    pReservation->NumBytes1 = 0u;
+  } else {
+    pReservation->NumBytes0 = Rem;
+    pReservation->pData1    = pRing->pBuffer;
+    pReservation->NumBytes1 = NumBytes - Rem;
+  }
+}
+
+/*********************************************************************
+*
+*       _CopyToReservation()
+*
+*  Function description
+*    Copies NumBytes to the spans of a reservation, starting
+*    Off bytes into the reservation.
+*/
+static void _CopyToReservation(const SEGGER_RTT_RESERVATION* pReservation, unsigned Off, const char* pData, unsigned NumBytes) {
+  unsigned NumBytes0;
+
+  if (Off < pReservation->NumBytes0) {
+    NumBytes0 = pReservation->NumBytes0 - Off;
+    if (NumBytes0 > NumBytes) {
+      NumBytes0 = NumBytes;
+    }
+    SEGGER_RTT_MEMCPY(pReservation->pData0 + Off, pData, NumBytes0);
+    pData    += NumBytes0;
+    NumBytes -= NumBytes0;
+    Off       = 0u;
+  } else {
+    Off -= pReservation->NumBytes0;
+  }
+  if (NumBytes != 0u) {
+    SEGGER_RTT_MEMCPY(pReservation->pData1 + Off, pData, NumBytes);
+  }
+}
+
+#if RTT_MP_USE_LDREX
+/*********************************************************************
+*
+*       _LoadExclusive()
+*/
+static unsigned _LoadExclusive(volatile unsigned* p) {
+  unsigned v;
+
+  __asm volatile ("ldrex %0, [%1]" : "=r" (v) : "r" (p) : "memory");
+  return v;
+}
+
+/*********************************************************************
+*
+*       _StoreExclusive()
+*
+*  Return value
+*    0: Stored.
+*    1: Not stored, exclusive access has been lost.
+*/
+static unsigned _StoreExclusive(volatile unsigned* p, unsigned v) {
+  unsigned r;
+
+  __asm volatile ("strex %0, %2, [%1]" : "=&r" (r) : "r" (p), "r" (v) : "memory");
+  return r;
+}
+
+/*********************************************************************
+*
+*       _ClearExclusive()
+*/
+static void _ClearExclusive(void) {
+  __asm volatile ("clrex" : : : "memory");
+}
+#endif
+
+/*********************************************************************
+*
+*       _CompareAndSwap()
+*
+*  Function description
+*    Atomically replaces *p by New if it equals Old.
+*
+*  Return value
+*    1: Replaced.
+*    0: *p did not equal Old.
+*/
+static int _CompareAndSwap(volatile unsigned* p, unsigned Old, unsigned New) {
+#if RTT_MP_USE_LDREX
+  do {
+    if (_LoadExclusive(p) != Old) {
+      _ClearExclusive();
+      return 0;
+    }
+  } while (_StoreExclusive(p, New) != 0u);
+  return 1;
+#elif RTT_MP_USE_C11
+  return atomic_compare_exchange_strong((volatile _Atomic unsigned*)p, &Old, New) ? 1 : 0;
+#else
+  int r;
+
+  SEGGER_RTT_LOCK();
+  r = (*p == Old) ? 1 : 0;
+  if (r) {
+    *p = New;
+  }
+  SEGGER_RTT_UNLOCK();
+  return r;
+#endif
+}
+
+/*********************************************************************
+*
+*       _PublishMP()
+*
+*  Function description
+*    Moves the write offset of an up-buffer in multi-producer mode
+*    to the claim offset, provided no producer is writing anymore.
+*    Otherwise the producer committing last publishes the data.
+*
+*  Notes
+*    (1) With LDREX/STREX the state is read inside the exclusive
+*        access to WrOff. An exception in between clears the monitor,
+*        so a successful store always publishes the latest claim.
+*    (2) With compare-and-swap, WrOff is written until it matches a
+*        claim offset read while no producer was pending.
+*/
+static void _PublishMP(SEGGER_RTT_BUFFER_UP* pRing, volatile unsigned* pState) {
+  volatile unsigned* pWrOff;
+  unsigned           WrOff;
+  unsigned           State;
+
+  pWrOff = (volatile unsigned*)&pRing->WrOff;
+  for (;;) {
+#if RTT_MP_USE_LDREX
+    WrOff = _LoadExclusive(pWrOff);
+    State = *pState;
+    if (((State >> RTT_MP_PENDING_SHIFT) != 0u) || ((State & RTT_MP_CLAIM_MASK) == WrOff)) {
+      _ClearExclusive();
+      break;
+    }
+    if (_StoreExclusive(pWrOff, State & RTT_MP_CLAIM_MASK) == 0u) {
+      break;
+    }
+#else
+    State = *pState;
+    WrOff = *pWrOff;
+    if (((State >> RTT_MP_PENDING_SHIFT) != 0u) || ((State & RTT_MP_CLAIM_MASK) == WrOff)) {
+      break;
+    }
+    (void)_CompareAndSwap(pWrOff, WrOff, State & RTT_MP_CLAIM_MASK);
+#endif
+  }
+}
+
 /*********************************************************************
 *
 *       Public code
@@ -635,6 +825,13 @@ void SEGGER_RTT_WriteWithOverwriteNoLock(unsigned BufferIndex, const void* pBuff
   //
   pRing = &_SEGGER_RTT.aUp[BufferIndex];
   //
+  // RdOff must not be moved while other producers hold reservations, skip instead.
+  //
+  if (pRing->Flags == SEGGER_RTT_MODE_MULTI_PRODUCER) {
+    (void)SEGGER_RTT_WriteMP(BufferIndex, pData, NumBytes);
+    return;
+  }
+  //
   // Check if we will overwrite data and need to adjust the RdOff.
   //
   if (pRing->WrOff == pRing->RdOff) {
@@ -733,6 +930,9 @@ unsigned SEGGER_RTT_WriteSkipNoLock(unsigned BufferIndex, const void* pBuffer, u
   // Get "to-host" ring buffer and copy some elements into local variables.
   //
   pRing = &_SEGGER_RTT.aUp[BufferIndex];
+  if (pRing->Flags == SEGGER_RTT_MODE_MULTI_PRODUCER) {
+    return ((NumBytes == 0u) || (SEGGER_RTT_WriteMP(BufferIndex, pData, NumBytes) != 0u)) ? 1u : 0u;
+  }
   RdOff = pRing->RdOff;
   WrOff = pRing->WrOff;
   //
@@ -903,6 +1103,9 @@ unsigned SEGGER_RTT_WriteNoLock(unsigned BufferIndex, const void* pBuffer, unsig
     //
     Status = _WriteBlocking(pRing, pData, NumBytes);
     break;
+  case SEGGER_RTT_MODE_MULTI_PRODUCER:
+    Status = SEGGER_RTT_WriteMP(BufferIndex, pData, NumBytes);
+    break;
   default:
     Status = 0u;
     break;
@@ -949,6 +1152,209 @@ unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void* pBuffer, unsigned Nu
   return Status;
 }
 
+/*********************************************************************
+*
+*       SEGGER_RTT_ReserveNoLock
+*
+*  Function description
+*    Reserves space in an "Up"-buffer which the caller fills in place,
+*    without an intermediate buffer. The data becomes visible to the
+*    host only after SEGGER_RTT_CommitNoLock() has been called.
+*    SEGGER_RTT_ReserveNoLock does not lock the application.
+*
+*  Parameters
+*    BufferIndex  Index of "Up"-buffer to be used (e.g. 0 for "Terminal").
+*    NumBytes     Number of bytes to reserve.
+*    pReservation Receives the one or two spans to write to.
+*
+*  Return value
+*    Number of bytes which have been reserved, 0 if nothing is reserved.
+*
+*  Notes
+*    (1) Space is reserved according to buffer flags. In blocking mode
+*        NumBytes is limited to the size of the buffer - 1.
+*    (2) Reserve and commit have to be called in the same lock, e.g.
+*          SEGGER_RTT_LOCK();
+*          n = SEGGER_RTT_ReserveNoLock(0, 16, &Res);
+*          <write up to n bytes to Res.pData0 / Res.pData1>
+*          SEGGER_RTT_CommitNoLock(0, n);
+*          SEGGER_RTT_UNLOCK();
+*    (3) For performance reasons this function does not call Init()
+*        and may only be called after RTT has been initialized.
+*/
+unsigned SEGGER_RTT_ReserveNoLock(unsigned BufferIndex, unsigned NumBytes, SEGGER_RTT_RESERVATION* pReservation) {
+  unsigned              Avail;
+  SEGGER_RTT_BUFFER_UP* pRing;
+
+  pRing = &_SEGGER_RTT.aUp[BufferIndex];
+  Avail = _GetAvailWriteSpace(pRing);
+  switch (pRing->Flags) {
+  case SEGGER_RTT_MODE_NO_BLOCK_SKIP:
+    if (Avail < NumBytes) {
+      NumBytes = 0u;
+    }
+    break;
+  case SEGGER_RTT_MODE_NO_BLOCK_TRIM:
+    if (Avail < NumBytes) {
+      NumBytes = Avail;
+    }
+    break;
+  case SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL:
+    if (NumBytes > pRing->SizeOfBuffer - 1u) {
+      NumBytes = pRing->SizeOfBuffer - 1u;
+    }
+    while (Avail < NumBytes) {
+      Avail = _GetAvailWriteSpace(pRing);
+    }
+    break;
+  default:
+    NumBytes = 0u;
+    break;
+  }
+  _GetSpans(pRing, pRing->WrOff, NumBytes, pReservation);
+  return NumBytes;
+}
+
+/*********************************************************************
+*
+*       SEGGER_RTT_CommitNoLock
+*
+*  Function description
+*    Publishes data written to space reserved by SEGGER_RTT_ReserveNoLock()
+*    by advancing the write offset of the "Up"-buffer.
+*
+*  Parameters
+*    BufferIndex  Index of "Up"-buffer to be used (e.g. 0 for "Terminal").
+*    NumBytes     Number of bytes written, must not exceed the reserved number of bytes.
+*                 Bytes are taken from the first span first.
+*/
+void SEGGER_RTT_CommitNoLock(unsigned BufferIndex, unsigned NumBytes) {
+  unsigned              WrOff;
+  SEGGER_RTT_BUFFER_UP* pRing;
+
+  pRing = &_SEGGER_RTT.aUp[BufferIndex];
+  WrOff = pRing->WrOff + NumBytes;
+  if (WrOff >= pRing->SizeOfBuffer) {
+    WrOff -= pRing->SizeOfBuffer;
+  }
+  pRing->WrOff = WrOff;
+}
+
+/*********************************************************************
+*
+*       SEGGER_RTT_ReserveMP
+*
+*  Function description
+*    Reserves space in an "Up"-buffer in multi-producer mode.
+*    Space is claimed with a compare-and-swap, so tasks and interrupts
+*    may write concurrently without locking the application.
+*
+*  Parameters
+*    BufferIndex  Index of "Up"-buffer to be used (e.g. 0 for "Terminal").
+*    NumBytes     Number of bytes to reserve.
+*    pReservation Receives the one or two spans to write to.
+*
+*  Return value
+*    NumBytes if the space has been reserved, 0 if there is not enough space.
+*
+*  Notes
+*    (1) A successful reservation has to be followed by SEGGER_RTT_CommitMP(),
+*        the data of all producers becomes visible to the host once the
+*        last pending producer has committed.
+*    (2) The buffer must be in mode SEGGER_RTT_MODE_MULTI_PRODUCER.
+*/
+unsigned SEGGER_RTT_ReserveMP(unsigned BufferIndex, unsigned NumBytes, SEGGER_RTT_RESERVATION* pReservation) {
+  SEGGER_RTT_BUFFER_UP* pRing;
+  volatile unsigned*    pState;
+  unsigned              State;
+  unsigned              Claim;
+  unsigned              NewClaim;
+  unsigned              RdOff;
+  unsigned              Avail;
+
+  if (NumBytes == 0u) {
+    return 0u;
+  }
+  pRing  = &_SEGGER_RTT.aUp[BufferIndex];
+  pState = &_aMPState[BufferIndex];
+  do {
+    State = *pState;
+    Claim = State & RTT_MP_CLAIM_MASK;
+    RdOff = pRing->RdOff;
+    if (RdOff <= Claim) {
+      Avail = pRing->SizeOfBuffer - 1u - Claim + RdOff;
+    } else {
+      Avail = RdOff - Claim - 1u;
+    }
+    if (Avail < NumBytes) {
+      return 0u;
+    }
+    NewClaim = Claim + NumBytes;
+    if (NewClaim >= pRing->SizeOfBuffer) {
+      NewClaim -= pRing->SizeOfBuffer;
+    }
+  } while (_CompareAndSwap(pState, State, ((State & ~RTT_MP_CLAIM_MASK) + RTT_MP_PENDING_ONE) | NewClaim) == 0);
+  _GetSpans(pRing, Claim, NumBytes, pReservation);
+  return NumBytes;
+}
+
+/*********************************************************************
+*
+*       SEGGER_RTT_CommitMP
+*
+*  Function description
+*    Marks the data of a reservation done by SEGGER_RTT_ReserveMP()
+*    as written. The last pending producer publishes the data of
+*    all producers.
+*
+*  Parameters
+*    BufferIndex  Index of "Up"-buffer to be used (e.g. 0 for "Terminal").
+*/
+void SEGGER_RTT_CommitMP(unsigned BufferIndex) {
+  volatile unsigned* pState;
+  unsigned           State;
+
+  pState = &_aMPState[BufferIndex];
+  do {
+    State = *pState;
+  } while (_CompareAndSwap(pState, State, State - RTT_MP_PENDING_ONE) == 0);
+  if (((State - RTT_MP_PENDING_ONE) >> RTT_MP_PENDING_SHIFT) == 0u) {
+    _PublishMP(&_SEGGER_RTT.aUp[BufferIndex], pState);
+  }
+}
+
+/*********************************************************************
+*
+*       SEGGER_RTT_WriteMP
+*
+*  Function description
+*    Stores a specified number of characters in an "Up"-buffer
+*    in multi-producer mode without locking the application.
+*
+*  Parameters
+*    BufferIndex  Index of "Up"-buffer to be used (e.g. 0 for "Terminal").
+*    pBuffer      Pointer to character array. Does not need to point to a \0 terminated string.
+*    NumBytes     Number of bytes to be stored in the SEGGER RTT control block.
+*
+*  Return value
+*    Number of bytes which have been stored in the "Up"-buffer, 0 if it did not fit.
+*/
+unsigned SEGGER_RTT_WriteMP(unsigned BufferIndex, const void* pBuffer, unsigned NumBytes) {
+  SEGGER_RTT_RESERVATION Res;
+  const char*            pData;
+
+  NumBytes = SEGGER_RTT_ReserveMP(BufferIndex, NumBytes, &Res);
+  if (NumBytes != 0u) {
+    pData = (const char*)pBuffer;
+    SEGGER_RTT_MEMCPY(Res.pData0, pData, Res.NumBytes0);
+    if (Res.NumBytes1 != 0u) {
+      SEGGER_RTT_MEMCPY(Res.pData1, pData + Res.NumBytes0, Res.NumBytes1);
+    }
+    SEGGER_RTT_CommitMP(BufferIndex);
+  }
+  return NumBytes;
+}
+
 /*********************************************************************
 *
 *       SEGGER_RTT_WriteString
@@ -1007,6 +1413,9 @@ unsigned SEGGER_RTT_PutCharSkipNoLock(unsigned BufferIndex, char c) {
   // Get "to-host" ring buffer.
   //
   pRing = &_SEGGER_RTT.aUp[BufferIndex];
+  if (pRing->Flags == SEGGER_RTT_MODE_MULTI_PRODUCER) {
+    return SEGGER_RTT_WriteMP(BufferIndex, &c, 1u);
+  }
   //
   // Get write position and handle wrap-around if necessary
   //
@@ -1054,11 +1463,14 @@ unsigned SEGGER_RTT_PutCharSkip(unsigned BufferIndex, char c) {
   // Prepare
   //
   INIT();
-  SEGGER_RTT_LOCK();
   //
   // Get "to-host" ring buffer.
   //
   pRing = &_SEGGER_RTT.aUp[BufferIndex];
+  if (pRing->Flags == SEGGER_RTT_MODE_MULTI_PRODUCER) {
+    return SEGGER_RTT_WriteMP(BufferIndex, &c, 1u);
+  }
+  SEGGER_RTT_LOCK();
   //
   // Get write position and handle wrap-around if necessary
   //
@@ -1110,11 +1522,14 @@ unsigned SEGGER_RTT_PutChar(unsigned BufferIndex, char c) {
   // Prepare
   //
   INIT();
-  SEGGER_RTT_LOCK();
   //
   // Get "to-host" ring buffer.
   //
   pRing = &_SEGGER_RTT.aUp[BufferIndex];
+  if (pRing->Flags == SEGGER_RTT_MODE_MULTI_PRODUCER) {
+    return SEGGER_RTT_WriteMP(BufferIndex, &c, 1u);
+  }
+  SEGGER_RTT_LOCK();
   //
   // Get write position and handle wrap-around if necessary
   //
@@ -1399,6 +1814,7 @@ int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char* sName, void* pBu
       _SEGGER_RTT.aUp[BufferIndex].WrOff        = 0u;
     }
     _SEGGER_RTT.aUp[BufferIndex].Flags          = Flags;
+    _aMPState[BufferIndex]                      = _SEGGER_RTT.aUp[BufferIndex].WrOff;
     SEGGER_RTT_UNLOCK();
     r =  0;
   } else {
@@ -1539,6 +1955,7 @@ int SEGGER_RTT_SetFlagsUpBuffer(unsigned BufferIndex, unsigned Flags) {
   if (BufferIndex < (unsigned)_SEGGER_RTT.MaxNumUpBuffers) {
     SEGGER_RTT_LOCK();
     _SEGGER_RTT.aUp[BufferIndex].Flags = Flags;
+    _aMPState[BufferIndex]             = _SEGGER_RTT.aUp[BufferIndex].WrOff;
     SEGGER_RTT_UNLOCK();
     r =  0;
   } else {
@@ -1619,7 +2036,13 @@ int SEGGER_RTT_SetTerminal (char TerminalId) {
     ac[1] = _aTerminalId[(unsigned char)TerminalId];
     pRing = &_SEGGER_RTT.aUp[0];    // Buffer 0 is always reserved for terminal I/O, so we can use index 0 here, fixed
     SEGGER_RTT_LOCK();    // Lock to make sure that no other task is writing into buffer, while we are and number of free bytes in buffer does not change downwards after checking and before writing
-    if ((pRing->Flags & SEGGER_RTT_MODE_MASK) == SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL) {
+    if (pRing->Flags == SEGGER_RTT_MODE_MULTI_PRODUCER) {                              // Other producers do not lock, claim the 2 bytes
+      if (SEGGER_RTT_WriteMP(0u, ac, 2u) != 0u) {
+        _ActiveTerminal = TerminalId;
+      } else {
+        r = -1;
+      }
+    } else if ((pRing->Flags & SEGGER_RTT_MODE_MASK) == SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL) {
       _ActiveTerminal = TerminalId;
       _WriteBlocking(pRing, (const char*)ac, 2u);
     } else {                                                                            // Skipping mode or trim mode? => We cannot trim this command so handling is the same for both modes
@@ -1656,10 +2079,12 @@ int SEGGER_RTT_SetTerminal (char TerminalId) {
 *
 */
 int SEGGER_RTT_TerminalOut (char TerminalId, const char* s) {
-  int                   Status;
-  unsigned              FragLen;
-  unsigned              Avail;
-  SEGGER_RTT_BUFFER_UP* pRing;
+  int                    Status;
+  unsigned               FragLen;
+  unsigned               Avail;
+  SEGGER_RTT_BUFFER_UP*  pRing;
+  SEGGER_RTT_RESERVATION Res;
+  char                   ac[2];
   //
   INIT();
   //
@@ -1676,6 +2101,23 @@ int SEGGER_RTT_TerminalOut (char TerminalId, const char* s) {
     //
     FragLen = STRLEN(s);
     //
+    // In multi-producer mode, switch, string and switch back are
+    // claimed as one block, so other producers cannot come in between.
+    //
+    if (pRing->Flags == SEGGER_RTT_MODE_MULTI_PRODUCER) {
+      if (SEGGER_RTT_ReserveMP(0u, FragLen + 4u, &Res) == 0u) {
+        return 0;
+      }
+      ac[0] = (char)0xFFu;
+      ac[1] = (char)_aTerminalId[(unsigned char)TerminalId];
+      _CopyToReservation(&Res, 0u, ac, 2u);
+      _CopyToReservation(&Res, 2u, s, FragLen);
+      ac[1] = (char)_aTerminalId[(unsigned char)_ActiveTerminal];
+      _CopyToReservation(&Res, FragLen + 2u, ac, 2u);
+      SEGGER_RTT_CommitMP(0u);
+      return (int)FragLen;
+    }
+    //
     // How we output depends upon the mode...
     //
     SEGGER_RTT_LOCK();
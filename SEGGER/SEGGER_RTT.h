@@ -91,6 +91,19 @@ typedef struct {
   SEGGER_RTT_BUFFER_DOWN  aDown[SEGGER_RTT_MAX_NUM_DOWN_BUFFERS];   // Down buffers, transferring information down from host via debug probe to target
 } SEGGER_RTT_CB;
 
+//
+// Space in an up-buffer handed out by SEGGER_RTT_ReserveNoLock().
+// The caller writes directly into the spans and publishes the data
+// with SEGGER_RTT_CommitNoLock(). A second span is only used if the
+// reserved space wraps around the end of the buffer.
+//
+typedef struct {
+  char*    pData0;                  // First span, starts at the write offset of the buffer
+  unsigned NumBytes0;               // Number of bytes in first span
+  char*    pData1;                  // Second span, start of buffer. NULL if not wrapped around
+  unsigned NumBytes1;               // Number of bytes in second span
+} SEGGER_RTT_RESERVATION;
+
 /*********************************************************************
 *
 *       Global data
@@ -132,6 +145,11 @@ void         SEGGER_RTT_WriteWithOverwriteNoLock(unsigned BufferIndex, const voi
 unsigned     SEGGER_RTT_PutChar                 (unsigned BufferIndex, char c);
 unsigned     SEGGER_RTT_PutCharSkip             (unsigned BufferIndex, char c);
 unsigned     SEGGER_RTT_PutCharSkipNoLock       (unsigned BufferIndex, char c);
+unsigned     SEGGER_RTT_ReserveNoLock           (unsigned BufferIndex, unsigned NumBytes, SEGGER_RTT_RESERVATION* pReservation);
+void         SEGGER_RTT_CommitNoLock            (unsigned BufferIndex, unsigned NumBytes);
+unsigned     SEGGER_RTT_ReserveMP               (unsigned BufferIndex, unsigned NumBytes, SEGGER_RTT_RESERVATION* pReservation);
+void         SEGGER_RTT_CommitMP                (unsigned BufferIndex);
+unsigned     SEGGER_RTT_WriteMP                 (unsigned BufferIndex, const void* pBuffer, unsigned NumBytes);
 //
 // Function macro for performance optimization
 //
@@ -171,6 +189,7 @@ int SEGGER_RTT_printf(unsigned BufferIndex, const char * sFormat, ...);
 #define SEGGER_RTT_MODE_NO_BLOCK_TRIM         (1U)     // Trim: Do not block, output as much as fits.
 #define SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL    (2U)     // Block: Wait until there is space in the buffer.
 #define SEGGER_RTT_MODE_MASK                  (3U)
+#define SEGGER_RTT_MODE_MULTI_PRODUCER        (4U)     // Multi-producer: Skip, space is claimed lock-free. All write functions use SEGGER_RTT_WriteMP, SEGGER_RTT_ReserveNoLock reserves nothing. Buffer size < 64KB.
 
 //
 // Control sequences, based on ANSI.
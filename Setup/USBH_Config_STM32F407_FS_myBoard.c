@@ -11,6 +11,9 @@
 #include "USBH_HW_STM32F2xxFS.h" //// ok
 #include "stm32f4xx.h"
 #include "gpio.h"
+#include "BINLOG.h"
+#include "LOG_QUEUE.h"
+#include "HID_LED.h"
 //#include "usbh_core.h"
 
 /*********************************************************************
@@ -193,6 +196,33 @@ static void _ISR(void)
   USBH_ServiceISR(0);
 }
 
+/*********************************************************************
+*
+*       HID_LED_X_IsControlIdle
+*
+*  Function description
+*    Checks whether a control transfer is in progress on the OTG_FS
+*    core, that is whether a host channel of type control is enabled.
+*    Called by the HID_LED task before it starts a SET_REPORT.
+*
+*  Return value
+*    1: Idle.
+*    0: Control transfer in progress.
+*/
+int HID_LED_X_IsControlIdle(void) {
+  const volatile U32 * pHCCHAR;
+  unsigned             i;
+
+  pHCCHAR = (const volatile U32 *)(STM32_OTG_BASE_ADDRESS + USB_OTG_HOST_CHANNEL_BASE);
+  for (i = 0; i < USB_OTG_FS_HOST_MAX_CHANNEL_NBR; i++) {
+    if ((*pHCCHAR & (USB_OTG_HCCHAR_CHENA | USB_OTG_HCCHAR_EPTYP)) == USB_OTG_HCCHAR_CHENA) {
+      return 0;                                 // Enabled, EPTYP 0 is control.
+    }
+    pHCCHAR += USB_OTG_HOST_CHANNEL_SIZE / sizeof(U32);
+  }
+  return 1;
+}
+
 /*********************************************************************
 *
 *       USBH_X_Config
@@ -219,7 +249,12 @@ void USBH_X_Config(void)
   // Note: The terminal I/O emulation affects the timing
   // of your communication, since the debugger stops the target
   // for every terminal I/O unless you use RTT!
+  // The log filter also applies to the binary application log,
+  // see BINLOG.c. With USE_LOG_QUEUE the text output is done by a
+  // low priority task, see LOG_QUEUE.c.
   //
+  LOG_QUEUE_Init();
+  BINLOG_Init();
   USBH_SetWarnFilter(0xFFFFFFFF);               // 0xFFFFFFFF: Do not filter: Output all warnings.
   USBH_SetLogFilter(0
                     | USBH_MTYPE_INIT